@@ -0,0 +1,96 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: batch.c
+ * Description:
+ *      The batch expression service. Records are double-buffered: the
+ *      link decoder fills one buffer while the record in the other is
+ *      evaluated, and each result goes out through the transport (the
+ *      UART's TX ring, drained by its ISR) while the next record is
+ *      being worked on. Receiving, evaluating and transmitting therefore
+ *      overlap; the main loop only stops decoding when both buffers are
+ *      full, and the UART's RX ring holds the bytes in the meantime.
+ *      NOTE:
+ *              The evaluation goes through calc_op(), the arithmetic
+ *              behind math_op(), so errors come back as status codes
+ *              instead of setting off the alarm on the display.
+ */
+#include <string.h>
+#include "batch.h"
+#include "calc.h"
+
+/* one expression record */
+typedef struct {
+   uint16_t id;
+   uint8_t length;
+   uint8_t evaluated; // result ready, waiting for room to send it
+   uint8_t status;
+   CALC_TYPE result;
+   char text[BATCH_MAX_TEXT];
+} batch_record_t;
+
+static batch_record_t records[BATCH_SLOTS];
+static uint8_t fill = 0;  // buffer the decoder fills next
+static uint8_t drain = 0; // buffer evaluated next
+static uint8_t used = 0;  // buffers holding a record
+
+uint32_t batch_evaluated = 0;
+uint32_t batch_rejected = 0;
+
+/**
+ * Is there a free buffer for another record?
+ * The main loop stops decoding frames while there isn't.
+ */
+int batch_has_room(void) {
+   return used < BATCH_SLOTS;
+}
+
+/**
+ * Take a LINK_EXPR frame into the free buffer
+ */
+void batch_accept(const link_frame_t * frame) {
+   batch_record_t * record;
+   if (frame->len < 2 || !batch_has_room()) {
+      ++batch_rejected; // the host ignored the flow control
+      return;
+   }
+   record = &records[fill];
+   record->id = frame->payload[0] | (frame->payload[1] << 8);
+   record->length = frame->len - 2;
+   record->evaluated = 0;
+   memcpy(record->text, &frame->payload[2], record->length);
+   fill = (fill + 1) % BATCH_SLOTS;
+   ++used;
+}
+
+/**
+ * Evaluate the oldest record and send its result
+ * Returns 1 if a result went out, 0 if there was nothing to do or the
+ * transport was full (the result is kept and sent on the next call)
+ */
+int batch_service(void) {
+   batch_record_t * record = &records[drain];
+   uint8_t payload[11];
+   int status;
+
+   if (used == 0) {
+      return 0;
+   }
+   if (!record->evaluated) {
+      record->result = calc_eval(record->text, record->length, &status);
+      record->status = status;
+      record->evaluated = 1;
+   }
+
+   payload[0] = record->id;
+   payload[1] = record->id >> 8;
+   payload[2] = record->status;
+   link_put_f64(&payload[3], num_to_double(record->result));
+   if (!link_send(LINK_EXPR_RESULT, payload, sizeof(payload))) {
+      return 0; // try again once the TX ring drains
+   }
+
+   ++batch_evaluated;
+   drain = (drain + 1) % BATCH_SLOTS;
+   --used;
+   return 1;
+}
@@ -0,0 +1,28 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: batch.h
+ * Description:
+ *      Batch expression evaluation over the host link. The host
+ *      pipelines LINK_EXPR records (an id and an expression); each is
+ *      evaluated by calc_eval() and answered with a LINK_EXPR_RESULT
+ *      carrying the same id, a CALC_* status and the result.
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+#include "link.h"
+
+#define BATCH_SLOTS 2 /* record buffers (double-buffered) */
+#define BATCH_MAX_TEXT (LINK_MAX_PAYLOAD - 2) /* expression characters */
+
+/* statistics */
+extern uint32_t batch_evaluated; // results sent
+extern uint32_t batch_rejected;  // records refused, no free buffer
+
+/* prototypes */
+int batch_has_room(void);
+void batch_accept(const link_frame_t *);
+int batch_service(void);
+
+#endif /* BATCH_H */
@@ -0,0 +1,157 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: bigcalc.c
+ * Description:
+ *      The big-integer mode (see bigcalc.h). The key handling follows
+ *      calc_key() so both modes behave the same way.
+ */
+#include "bigcalc.h"
+#include "calc.h"
+
+int bigcalc_mode = 0; // start in the normal mode
+bigint_t big_lhs;
+bigint_t big_rhs;
+char big_operation = '\0';
+static bigint_t * big_focus = &big_lhs;
+int big_status = BIGINT_OK;
+int big_page = -1;
+static char text[BIGCALC_TEXT]; // the current text, for the display
+
+/**
+ * Give the operands their limbs in the arena
+ */
+int bigcalc_init(void) {
+   int status = bigint_init(&big_lhs, BIGINT_LIMBS);
+   if (status == BIGINT_OK) {
+      status = bigint_init(&big_rhs, BIGINT_LIMBS);
+   }
+   return status;
+}
+
+/*
+ * Combine the operands into big_lhs; on an error big_lhs keeps its
+ * value and the alarm goes off
+ */
+static void big_op(void) {
+   switch (big_operation) {
+      case '+':
+         big_status = bigint_add(&big_lhs, &big_lhs, &big_rhs);
+         break;
+      case '-':
+         big_status = bigint_sub(&big_lhs, &big_lhs, &big_rhs);
+         break;
+      case '*':
+         big_status = bigint_mul(&big_lhs, &big_lhs, &big_rhs);
+         break;
+      case '/':
+         big_status = bigint_divmod(&big_lhs, 0, &big_lhs, &big_rhs);
+         break;
+      case '%':
+         big_status = bigint_divmod(0, &big_lhs, &big_lhs, &big_rhs);
+         break;
+   }
+   assert(big_status != BIGINT_DIV_BY_ZERO, "DIV BY ZERO");
+   assert(big_status != BIGINT_OVERFLOW, "TOO BIG");
+   bigint_zero(&big_rhs);
+}
+
+/**
+ * Update the big-integer state for one decoded key
+ * Returns 1 if the key combined the operands, else 0
+ */
+int bigcalc_key(uint8_t key) {
+   int computed = 0;
+   int page = -1; // the page being typed on, unless paging a result
+
+   // an operation combines a pending one first, then moves to the rhs
+   if ((key >= KEY_ADD && key <= KEY_DIVIDE) || key == KEY_DECIMAL) {
+      if (big_operation != '\0' && big_focus == &big_rhs) {
+         big_op();
+         computed = 1;
+      }
+      big_focus = &big_rhs;
+   }
+
+   switch (key) {
+      case KEY_ADD:
+         big_operation = '+';
+         break;
+      case KEY_SUBTRACT:
+         big_operation = '-';
+         break;
+      case KEY_MULTIPLY:
+         big_operation = '*';
+         break;
+      case KEY_DIVIDE:
+         big_operation = '/';
+         break;
+      case KEY_DECIMAL: /* no fractions here: "*" is modulo */
+         big_operation = '%';
+         break;
+      case KEY_EQUALS:
+         if (big_focus == &big_rhs) {
+            big_op();
+            big_operation = '=';
+            computed = 1;
+            page = 0; // show the result from its first digits
+         }
+         // page through a long result, then clear
+         else if (big_page >= 0 && (big_page + 1) * BIGCALC_PAGE
+                                   < bigcalc_text(text, sizeof(text))) {
+            page = big_page + 1;
+         }
+         else {
+            bigint_zero(&big_lhs);
+            bigint_zero(&big_rhs);
+            big_operation = '\0';
+         }
+         big_focus = &big_lhs;
+         break;
+      default: /* a digit */
+         if (bigint_digit(big_focus, key) != BIGINT_OK) {
+            assert(0, "TOO BIG");
+         }
+         break;
+   }
+   big_page = page;
+   return computed;
+}
+
+/**
+ * Write "lhs", or "lhs op rhs" while an operation is pending, into text
+ * Returns its length, or -1 if size is too small
+ */
+int bigcalc_text(char * text, int size) {
+   int length = bigint_to_decimal(&big_lhs, text, size);
+   if (length >= 0 && big_operation != '\0' && big_operation != '=') {
+      int rhs_length;
+      if (length + 2 >= size) {
+         return -1;
+      }
+      text[length++] = big_operation;
+      rhs_length = bigint_to_decimal(&big_rhs, &text[length], size - length);
+      length = (rhs_length < 0) ? -1 : length + rhs_length;
+   }
+   return length;
+}
+
+/**
+ * The page of the current text to show and its number of characters
+ * (at most BIGCALC_PAGE). While typing, that's the last page.
+ */
+const char * bigcalc_page(int * count) {
+   int length = bigcalc_text(text, sizeof(text));
+   int page = big_page;
+   if (length <= 0) {
+      *count = 0;
+      return text;
+   }
+   if (page < 0 || page * BIGCALC_PAGE >= length) {
+      page = (length - 1) / BIGCALC_PAGE; // the last page
+   }
+   *count = length - page * BIGCALC_PAGE;
+   if (*count > BIGCALC_PAGE) {
+      *count = BIGCALC_PAGE;
+   }
+   return &text[page * BIGCALC_PAGE];
+}
@@ -0,0 +1,35 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: bigcalc.h
+ * Description:
+ *      The big-integer mode of the calculator: the same keys as the
+ *      normal mode, but the operands are arbitrary-precision integers
+ *      (see bigint.h) and the "*" key is modulo instead of the decimal
+ *      point. Results longer than one screen are paged: "#" on a result
+ *      shows its next page, and clears once the last page was shown.
+ */
+#ifndef BIGCALC_H
+#define BIGCALC_H
+
+#include <stdint.h>
+#include "bigint.h"
+
+#define BIGCALC_PAGE 84 /* characters per screen: 14 per bank, 6 banks */
+/* lhs, operation and rhs in decimal, plus the '\0' */
+#define BIGCALC_TEXT (2 * (BIGINT_DIGITS + 1) + 2)
+
+/* state */
+extern int bigcalc_mode; // 1 while the big-integer mode is on
+extern bigint_t big_lhs;
+extern bigint_t big_rhs;
+extern char big_operation; // null-char means no-operation
+extern int big_status;     // BIGINT_OK or the error of the last operation
+extern int big_page;       // page shown, -1 for the one being typed on
+
+/* prototypes */
+int bigcalc_init(void);
+int bigcalc_key(uint8_t);
+int bigcalc_text(char *, int);
+const char * bigcalc_page(int *);
+
+#endif /* BIGCALC_H */
@@ -0,0 +1,658 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: bigint.c
+ * Description:
+ *      Arbitrary-precision integer arithmetic (see bigint.h).
+ *      Multiplication is schoolbook below KARATSUBA_THRESHOLD limbs and
+ *      Karatsuba above it; division is Knuth's algorithm D; conversion
+ *      to decimal peels off 9 digits at a time by dividing by 10^9, so
+ *      a 385-digit number takes 43 single-limb divisions instead of 385.
+ *      Division truncates toward zero and the remainder takes the sign
+ *      of the dividend, as in C.
+ */
+#include <string.h>
+#include "bigint.h"
+
+#define BASE10_CHUNK 1000000000u /* 10^9, the largest power of 10 in a limb */
+
+static uint32_t arena[BIGINT_ARENA_LIMBS];
+static uint16_t arena_top = 0;  // first free limb
+static uint16_t arena_peak = 0; // most limbs ever in use
+
+/*
+ * Take limbs from the arena; NULL if it's exhausted
+ */
+static uint32_t * arena_alloc(uint16_t limbs) {
+   uint32_t * p;
+   if (limbs > BIGINT_ARENA_LIMBS - arena_top) {
+      return 0;
+   }
+   p = &arena[arena_top];
+   arena_top += limbs;
+   if (arena_top > arena_peak) {
+      arena_peak = arena_top;
+   }
+   return p;
+}
+
+/**
+ * Give a number its own limbs for good
+ */
+int bigint_init(bigint_t * a, uint16_t capacity) {
+   a->limb = arena_alloc(capacity);
+   a->capacity = a->limb ? capacity : 0;
+   a->length = 0;
+   a->negative = 0;
+   return a->limb ? BIGINT_OK : BIGINT_OVERFLOW;
+}
+
+/**
+ * Remember the top of the arena, to free temporaries with bigint_release()
+ */
+uint16_t bigint_mark(void) {
+   return arena_top;
+}
+
+void bigint_release(uint16_t mark) {
+   arena_top = mark;
+}
+
+/**
+ * The most arena limbs in use so far (to size BIGINT_ARENA_LIMBS)
+ */
+uint16_t bigint_arena_peak(void) {
+   return arena_peak;
+}
+
+/* ---- magnitudes: little-endian limb arrays ---- */
+
+/*
+ * Drop the leading zero limbs
+ */
+static uint16_t mag_trim(const uint32_t * a, uint16_t n) {
+   while (n > 0 && a[n - 1] == 0) {
+      --n;
+   }
+   return n;
+}
+
+static int mag_compare(const uint32_t * a, uint16_t na,
+                       const uint32_t * b, uint16_t nb) {
+   if (na != nb) {
+      return na < nb ? -1 : 1;
+   }
+   while (na-- > 0) {
+      if (a[na] != b[na]) {
+         return a[na] < b[na] ? -1 : 1;
+      }
+   }
+   return 0;
+}
+
+/*
+ * r = a + b for na >= nb; r has room for na limbs, returns the carry
+ * (r may be a or b)
+ */
+static uint32_t mag_add(uint32_t * r, const uint32_t * a, uint16_t na,
+                        const uint32_t * b, uint16_t nb) {
+   uint64_t sum = 0;
+   uint16_t k;
+   for (k = 0; k < nb; ++k) {
+      sum += (uint64_t)a[k] + b[k];
+      r[k] = (uint32_t)sum;
+      sum >>= 32;
+   }
+   for (; k < na; ++k) {
+      sum += a[k];
+      r[k] = (uint32_t)sum;
+      sum >>= 32;
+   }
+   return (uint32_t)sum;
+}
+
+/*
+ * r = a - b for a >= b (so na >= nb), returns the borrow
+ * (r may be a or b)
+ */
+static uint32_t mag_sub(uint32_t * r, const uint32_t * a, uint16_t na,
+                        const uint32_t * b, uint16_t nb) {
+   int64_t diff = 0;
+   uint16_t k;
+   for (k = 0; k < nb; ++k) {
+      diff += (int64_t)a[k] - b[k];
+      r[k] = (uint32_t)diff;
+      diff >>= 32; // 0 or -1
+   }
+   for (; k < na; ++k) {
+      diff += a[k];
+      r[k] = (uint32_t)diff;
+      diff >>= 32;
+   }
+   return (uint32_t)-diff;
+}
+
+/*
+ * r += a * m over na limbs, returns the carry out of the top limb
+ */
+static uint32_t mag_mul_add_small(uint32_t * r, const uint32_t * a,
+                                  uint16_t na, uint32_t m) {
+   uint64_t carry = 0;
+   uint16_t k;
+   for (k = 0; k < na; ++k) {
+      carry += (uint64_t)a[k] * m + r[k];
+      r[k] = (uint32_t)carry;
+      carry >>= 32;
+   }
+   return (uint32_t)carry;
+}
+
+/*
+ * r = a * b, schoolbook; r has na + nb limbs and is not a or b
+ */
+static void mag_mul_school(uint32_t * r, const uint32_t * a, uint16_t na,
+                           const uint32_t * b, uint16_t nb) {
+   uint16_t k;
+   memset(r, 0, (na + nb) * sizeof(uint32_t));
+   for (k = 0; k < nb; ++k) {
+      r[na + k] = mag_mul_add_small(&r[k], a, na, b[k]);
+   }
+}
+
+/*
+ * r[offset..] += a, carrying as far as needed within n limbs of r
+ */
+static void mag_add_at(uint32_t * r, uint16_t n, uint16_t offset,
+                       const uint32_t * a, uint16_t na) {
+   uint32_t carry = mag_add(&r[offset], &r[offset], na, a, na);
+   uint16_t k;
+   for (k = offset + na; carry && k < n; ++k) {
+      r[k] += 1;
+      carry = (r[k] == 0);
+   }
+}
+
+/*
+ * r = a * b for na >= nb; r has na + nb limbs and is not a or b.
+ * Returns BIGINT_OVERFLOW if the arena ran out of scratch space.
+ */
+static int mag_mul(uint32_t * r, const uint32_t * a, uint16_t na,
+                   const uint32_t * b, uint16_t nb) {
+   uint16_t mark = bigint_mark();
+   uint16_t m, n0, n1;
+   uint32_t * t;
+   int status = BIGINT_OK;
+
+   if (nb < KARATSUBA_THRESHOLD) {
+      if (nb == 0) {
+         memset(r, 0, na * sizeof(uint32_t));
+      }
+      else {
+         mag_mul_school(r, a, na, b, nb);
+      }
+      return BIGINT_OK;
+   }
+
+   m = (na + 1) / 2; // split a = a1 * B^m + a0
+   if (nb <= m) {
+      // b is short: a * b = a0 * b + (a1 * b) * B^m
+      t = arena_alloc(na - m + nb);
+      if (!t) {
+         return BIGINT_OVERFLOW;
+      }
+      status = mag_mul(r, a, m, b, nb);
+      memset(&r[m + nb], 0, (na - m) * sizeof(uint32_t));
+      if (status == BIGINT_OK) {
+         status = (na - m >= nb) ? mag_mul(t, &a[m], na - m, b, nb)
+                                 : mag_mul(t, b, nb, &a[m], na - m);
+      }
+      if (status == BIGINT_OK) {
+         mag_add_at(r, na + nb, m, t, na - m + nb);
+      }
+      bigint_release(mark);
+      return status;
+   }
+
+   // Karatsuba: a * b = z2 * B^2m + z1 * B^m + z0 where
+   // z0 = a0 * b0, z2 = a1 * b1, z1 = (a0 + a1)(b0 + b1) - z0 - z2
+   n0 = na - m; // limbs in a1
+   n1 = nb - m; // limbs in b1 (n1 <= n0)
+   {
+      uint32_t * sa = arena_alloc(m + 1);
+      uint32_t * sb = arena_alloc(m + 1);
+      uint32_t * z1 = arena_alloc(2 * m + 2);
+      if (!sa || !sb || !z1) {
+         bigint_release(mark);
+         return BIGINT_OVERFLOW;
+      }
+      // z0 and z2 go straight into their places in r
+      status = mag_mul(r, a, m, b, m);
+      if (status == BIGINT_OK) {
+         status = mag_mul(&r[2 * m], &a[m], n0, &b[m], n1);
+      }
+      // sums of the halves (a0, b0 have m >= n0 >= n1 limbs)
+      sa[m] = mag_add(sa, a, m, &a[m], n0);
+      sb[m] = mag_add(sb, b, m, &b[m], n1);
+      if (status == BIGINT_OK) {
+         status = mag_mul(z1, sa, m + 1, sb, m + 1);
+      }
+      if (status == BIGINT_OK) {
+         uint16_t nz = mag_trim(z1, 2 * m + 2);
+         mag_sub(z1, z1, nz, r, mag_trim(r, 2 * m));
+         mag_sub(z1, z1, nz, &r[2 * m], mag_trim(&r[2 * m], n0 + n1));
+         mag_add_at(r, na + nb, m, z1, mag_trim(z1, nz));
+      }
+   }
+   bigint_release(mark);
+   return status;
+}
+
+/*
+ * Divide a magnitude by one limb in place, returns the remainder
+ */
+static uint32_t mag_div_small(uint32_t * a, uint16_t na, uint32_t d) {
+   uint64_t rem = 0;
+   while (na-- > 0) {
+      rem = (rem << 32) | a[na];
+      a[na] = (uint32_t)(rem / d);
+      rem %= d;
+   }
+   return (uint32_t)rem;
+}
+
+/*
+ * Number of leading zero bits of a nonzero limb
+ */
+static int leading_zeros(uint32_t x) {
+   int n = 0;
+   while (!(x & 0x80000000u)) {
+      x <<= 1;
+      ++n;
+   }
+   return n;
+}
+
+/*
+ * Knuth's algorithm D: q = u / v, r = u % v for nu >= nv >= 2 and
+ * v[nv - 1] != 0; q has nu - nv + 1 limbs and r has nv limbs
+ */
+static int mag_divmod(uint32_t * q, uint32_t * r, const uint32_t * u,
+                      uint16_t nu, const uint32_t * v, uint16_t nv) {
+   uint16_t mark = bigint_mark();
+   uint32_t * un = arena_alloc(nu + 1); // normalized dividend
+   uint32_t * vn = arena_alloc(nv);     // normalized divisor
+   int shift, j, k;
+
+   if (!un || !vn) {
+      bigint_release(mark);
+      return BIGINT_OVERFLOW;
+   }
+
+   // normalize so the divisor's top bit is set
+   shift = leading_zeros(v[nv - 1]);
+   for (k = nv - 1; k > 0; --k) {
+      vn[k] = (v[k] << shift) | (shift ? v[k - 1] >> (32 - shift) : 0);
+   }
+   vn[0] = v[0] << shift;
+   un[nu] = shift ? u[nu - 1] >> (32 - shift) : 0;
+   for (k = nu - 1; k > 0; --k) {
+      un[k] = (u[k] << shift) | (shift ? u[k - 1] >> (32 - shift) : 0);
+   }
+   un[0] = u[0] << shift;
+
+   for (j = nu - nv; j >= 0; --j) {
+      // estimate the quotient limb from the top two limbs
+      uint64_t top = ((uint64_t)un[j + nv] << 32) | un[j + nv - 1];
+      uint64_t qhat = top / vn[nv - 1];
+      uint64_t rhat = top % vn[nv - 1];
+      int64_t borrow;
+      uint64_t product;
+
+      while (qhat > 0xFFFFFFFFu
+             || qhat * vn[nv - 2] > ((rhat << 32) | un[j + nv - 2])) {
+         --qhat;
+         rhat += vn[nv - 1];
+         if (rhat > 0xFFFFFFFFu) {
+            break;
+         }
+      }
+
+      // multiply and subtract
+      borrow = 0;
+      for (k = 0; k < nv; ++k) {
+         int64_t t;
+         product = qhat * vn[k];
+         t = (int64_t)un[k + j] - borrow - (int64_t)(product & 0xFFFFFFFFu);
+         un[k + j] = (uint32_t)t;
+         borrow = (int64_t)(product >> 32) - (t >> 32);
+      }
+      {
+         int64_t t = (int64_t)un[j + nv] - borrow;
+         un[j + nv] = (uint32_t)t;
+         // add back if we took away too much (rare)
+         if (t < 0) {
+            uint64_t carry = 0;
+            --qhat;
+            for (k = 0; k < nv; ++k) {
+               carry += (uint64_t)un[k + j] + vn[k];
+               un[k + j] = (uint32_t)carry;
+               carry >>= 32;
+            }
+            un[j + nv] += (uint32_t)carry;
+         }
+      }
+      q[j] = (uint32_t)qhat;
+   }
+
+   // unnormalize the remainder
+   for (k = 0; k < nv; ++k) {
+      r[k] = (un[k] >> shift) | (shift ? un[k + 1] << (32 - shift) : 0);
+   }
+   bigint_release(mark);
+   return BIGINT_OK;
+}
+
+/* ---- signed numbers ---- */
+
+/**
+ * Set a number to zero
+ */
+void bigint_zero(bigint_t * a) {
+   a->length = 0;
+   a->negative = 0;
+}
+
+/**
+ * r = a
+ */
+int bigint_copy(bigint_t * r, const bigint_t * a) {
+   if (a->length > r->capacity) {
+      return BIGINT_OVERFLOW;
+   }
+   if (r != a) {
+      memcpy(r->limb, a->limb, a->length * sizeof(uint32_t));
+      r->length = a->length;
+      r->negative = a->negative;
+   }
+   return BIGINT_OK;
+}
+
+/**
+ * r = value
+ */
+int bigint_from_ll(bigint_t * r, long long int value) {
+   uint64_t magnitude = value < 0 ? -(uint64_t)value : (uint64_t)value;
+   if (r->capacity < 2) {
+      return BIGINT_OVERFLOW;
+   }
+   r->limb[0] = (uint32_t)magnitude;
+   r->limb[1] = (uint32_t)(magnitude >> 32);
+   r->length = mag_trim(r->limb, 2);
+   r->negative = value < 0;
+   return BIGINT_OK;
+}
+
+/**
+ * Enter one more digit the way the keypad does: r = r * 10 + digit,
+ * so a negative r moves away from zero by the digit (-5 -> -47 for 3)
+ */
+int bigint_digit(bigint_t * r, uint8_t digit) {
+   uint64_t carry = 0;
+   uint16_t n = r->length, k;
+
+   // with the top limb below 2^32 / 10, r * 10 + 9 still fits
+   if (n == r->capacity && r->limb[n - 1] >= 0xFFFFFFFFu / 10) {
+      return BIGINT_OVERFLOW;
+   }
+   // magnitude * 10
+   for (k = 0; k < n; ++k) {
+      carry += (uint64_t)r->limb[k] * 10;
+      r->limb[k] = (uint32_t)carry;
+      carry >>= 32;
+   }
+   if (carry) {
+      r->limb[n++] = (uint32_t)carry;
+   }
+   // then the digit: away from zero for a positive r, toward it for a
+   // negative one (|r| >= 10 > digit, so r stays negative)
+   if (digit) {
+      uint32_t d = digit;
+      if (r->negative) {
+         mag_sub(r->limb, r->limb, n, &d, 1);
+      }
+      else if (n == 0) {
+         r->limb[n++] = d;
+      }
+      else if (mag_add(r->limb, r->limb, n, &d, 1)) {
+         r->limb[n++] = 1;
+      }
+   }
+   r->length = mag_trim(r->limb, n);
+   return BIGINT_OK;
+}
+
+/**
+ * Compare two numbers: -1, 0 or 1
+ */
+int bigint_compare(const bigint_t * a, const bigint_t * b) {
+   int c;
+   if (a->negative != b->negative) {
+      return a->negative ? -1 : 1;
+   }
+   c = mag_compare(a->limb, a->length, b->limb, b->length);
+   return a->negative ? -c : c;
+}
+
+/*
+ * r = a + b where b counts as negative if b_negative
+ * (shared by add and subtract; r may be a or b)
+ */
+static int add_signed(bigint_t * r, const bigint_t * a, const bigint_t * b,
+                      int b_negative) {
+   const bigint_t * big = a, * small = b;
+   int big_negative = a->negative, small_negative = b_negative;
+   int c = mag_compare(a->limb, a->length, b->limb, b->length);
+   uint32_t carry;
+
+   if (c < 0) {
+      big = b;
+      small = a;
+      big_negative = b_negative;
+      small_negative = a->negative;
+   }
+
+   if (big_negative == small_negative) {
+      // same signs add magnitudes
+      if (big->length > r->capacity) {
+         return BIGINT_OVERFLOW;
+      }
+      if (big->length == r->capacity) {
+         // a carry out of the top wouldn't fit; find out before touching r
+         uint16_t mark = bigint_mark();
+         uint32_t * t = arena_alloc(big->length);
+         carry = t ? mag_add(t, big->limb, big->length, small->limb,
+                             small->length) : 1;
+         bigint_release(mark);
+         if (carry) {
+            return BIGINT_OVERFLOW;
+         }
+      }
+      carry = mag_add(r->limb, big->limb, big->length, small->limb,
+                      small->length);
+      r->length = big->length;
+      if (carry) {
+         r->limb[r->length++] = carry;
+      }
+      r->negative = big_negative;
+   }
+   else {
+      // opposite signs subtract the smaller magnitude from the larger
+      if (big->length > r->capacity) {
+         return BIGINT_OVERFLOW;
+      }
+      mag_sub(r->limb, big->limb, big->length, small->limb, small->length);
+      r->length = mag_trim(r->limb, big->length);
+      r->negative = big_negative;
+   }
+   if (r->length == 0) {
+      r->negative = 0; // no negative zero
+   }
+   return BIGINT_OK;
+}
+
+/**
+ * r = a + b (r may be a or b)
+ */
+int bigint_add(bigint_t * r, const bigint_t * a, const bigint_t * b) {
+   return add_signed(r, a, b, b->negative);
+}
+
+/**
+ * r = a - b (r may be a or b)
+ */
+int bigint_sub(bigint_t * r, const bigint_t * a, const bigint_t * b) {
+   return add_signed(r, a, b, b->length ? !b->negative : 0);
+}
+
+/**
+ * r = a * b (r may be a or b)
+ */
+int bigint_mul(bigint_t * r, const bigint_t * a, const bigint_t * b) {
+   uint16_t mark = bigint_mark();
+   uint16_t n = a->length + b->length;
+   uint32_t * t;
+   int status;
+
+   if (a->length == 0 || b->length == 0) {
+      bigint_zero(r);
+      return BIGINT_OK;
+   }
+   t = arena_alloc(n);
+   if (!t) {
+      return BIGINT_OVERFLOW;
+   }
+   status = (a->length >= b->length)
+            ? mag_mul(t, a->limb, a->length, b->limb, b->length)
+            : mag_mul(t, b->limb, b->length, a->limb, a->length);
+   n = mag_trim(t, n);
+   if (status == BIGINT_OK && n > r->capacity) {
+      status = BIGINT_OVERFLOW;
+   }
+   if (status == BIGINT_OK) {
+      r->negative = a->negative != b->negative;
+      memcpy(r->limb, t, n * sizeof(uint32_t));
+      r->length = n;
+   }
+   bigint_release(mark);
+   return status;
+}
+
+/**
+ * q = a / b and rem = a % b, truncating toward zero
+ * Either q or rem may be NULL; they may be a or b.
+ */
+int bigint_divmod(bigint_t * q, bigint_t * rem, const bigint_t * a,
+                  const bigint_t * b) {
+   uint16_t mark = bigint_mark();
+   uint16_t nq, nr;
+   uint32_t * tq, * tr;
+   int a_negative = a->negative, b_negative = b->negative;
+   int status = BIGINT_OK;
+
+   if (b->length == 0) {
+      return BIGINT_DIV_BY_ZERO;
+   }
+   if (mag_compare(a->limb, a->length, b->limb, b->length) < 0) {
+      // |a| < |b|: the quotient is 0 and the remainder is a
+      if (rem && bigint_copy(rem, a) != BIGINT_OK) {
+         return BIGINT_OVERFLOW;
+      }
+      if (q) {
+         bigint_zero(q);
+      }
+      return BIGINT_OK;
+   }
+
+   nq = a->length - b->length + 1;
+   nr = b->length;
+   tq = arena_alloc(nq);
+   tr = arena_alloc(nr);
+   if (!tq || !tr) {
+      bigint_release(mark);
+      return BIGINT_OVERFLOW;
+   }
+   if (b->length == 1) {
+      memcpy(tq, a->limb, a->length * sizeof(uint32_t));
+      tr[0] = mag_div_small(tq, a->length, b->limb[0]);
+   }
+   else {
+      status = mag_divmod(tq, tr, a->limb, a->length, b->limb, b->length);
+   }
+   nq = mag_trim(tq, nq);
+   nr = mag_trim(tr, nr);
+   if (status == BIGINT_OK && ((q && nq > q->capacity)
+                               || (rem && nr > rem->capacity))) {
+      status = BIGINT_OVERFLOW;
+   }
+   if (status == BIGINT_OK) {
+      if (q) {
+         memcpy(q->limb, tq, nq * sizeof(uint32_t));
+         q->length = nq;
+         q->negative = nq ? (a_negative != b_negative) : 0;
+      }
+      if (rem) {
+         memcpy(rem->limb, tr, nr * sizeof(uint32_t));
+         rem->length = nr;
+         rem->negative = nr ? a_negative : 0;
+      }
+   }
+   bigint_release(mark);
+   return status;
+}
+
+/**
+ * Write a number in decimal into text (with a '\0')
+ * Returns the number of characters, or -1 if size is too small
+ */
+int bigint_to_decimal(const bigint_t * a, char * text, int size) {
+   uint16_t mark = bigint_mark();
+   uint16_t n = a->length;
+   uint32_t * t = arena_alloc(n);
+   // base 10^9 digits, low first: a limb holds 9.63 decimal digits
+   uint32_t * chunks = arena_alloc(n + n / 8 + 1);
+   int count = 0, length = 0, k;
+
+   if (!t || !chunks || size < 2) {
+      bigint_release(mark);
+      return -1;
+   }
+   memcpy(t, a->limb, n * sizeof(uint32_t));
+   // peel off 9 decimal digits per division
+   do {
+      chunks[count++] = mag_div_small(t, n, BASE10_CHUNK);
+      n = mag_trim(t, n);
+   } while (n > 0);
+
+   if (a->negative) {
+      text[length++] = '-';
+   }
+   // the top chunk without leading zeros, the rest as 9 digits each
+   for (k = count - 1; k >= 0; --k) {
+      char digits[9];
+      uint32_t chunk = chunks[k];
+      int d = 0;
+      do {
+         digits[d++] = '0' + chunk % 10;
+         chunk /= 10;
+      } while (k == count - 1 ? chunk != 0 : d < 9);
+      if (length + d >= size) {
+         bigint_release(mark);
+         return -1;
+      }
+      while (d > 0) {
+         text[length++] = digits[--d];
+      }
+   }
+   text[length] = '\0';
+   bigint_release(mark);
+   return length;
+}
@@ -0,0 +1,58 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: bigint.h
+ * Description:
+ *      Arbitrary-precision signed integers for the big-integer mode.
+ *      Magnitudes are little-endian arrays of 32-bit limbs carved out of
+ *      one statically sized arena (no heap): long-lived numbers take
+ *      their limbs once with bigint_init(), and temporaries are taken
+ *      and given back in stack order with bigint_mark() and
+ *      bigint_release().
+ *      Every operation returns a BIGINT_* status; on an error the
+ *      result is left unchanged.
+ */
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <stdint.h>
+
+#define BIGINT_LIMBS 40 /* limbs per number: 1280 bits, 385 digits */
+#define BIGINT_ARENA_LIMBS 512 /* limbs in the arena (2 KB) */
+#define BIGINT_DIGITS (BIGINT_LIMBS * 10) /* decimal digits needed */
+#define KARATSUBA_THRESHOLD 16 /* limbs; schoolbook below this */
+
+/* status */
+#define BIGINT_OK          0
+#define BIGINT_DIV_BY_ZERO 1
+#define BIGINT_OVERFLOW    2 /* too big for the number or the arena */
+
+typedef struct {
+   uint32_t * limb;   // magnitude, least significant limb first
+   uint16_t length;   // limbs in use (0 for zero)
+   uint16_t capacity; // limbs owned
+   int8_t negative;   // 1 if below zero (never set for zero)
+} bigint_t;
+
+/* arena */
+int bigint_init(bigint_t *, uint16_t);
+uint16_t bigint_mark(void);
+void bigint_release(uint16_t);
+uint16_t bigint_arena_peak(void);
+
+/* values */
+void bigint_zero(bigint_t *);
+int bigint_copy(bigint_t *, const bigint_t *);
+int bigint_from_ll(bigint_t *, long long int);
+int bigint_digit(bigint_t *, uint8_t);
+int bigint_compare(const bigint_t *, const bigint_t *);
+
+/* arithmetic */
+int bigint_add(bigint_t *, const bigint_t *, const bigint_t *);
+int bigint_sub(bigint_t *, const bigint_t *, const bigint_t *);
+int bigint_mul(bigint_t *, const bigint_t *, const bigint_t *);
+int bigint_divmod(bigint_t *, bigint_t *, const bigint_t *, const bigint_t *);
+
+/* display */
+int bigint_to_decimal(const bigint_t *, char *, int);
+
+#endif /* BIGINT_H */
@@ -0,0 +1,410 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: calc.c
+ * Description:
+ *      The calculator state and the key handling that used to live in
+ *      PORT3_IRQHandler. calc_key() takes one decoded key and updates
+ *      the global state; the caller decides how to show it.
+ */
+#include <stddef.h>
+#include "calc.h"
+
+/* global variables */
+/* the state the display shows: no operation, focus on the whole part */
+/* of the lhs (the operands are zero-initialized, which is 0 in every */
+/* numeric backend) */
+calc_state_t calc = {
+   .operation = '\0',
+   .state = CALC_LHS_WHOLE,
+   .fractional_pow10 = 10, // 10^1 for the fractional divisor
+   .status = CALC_OK,
+};
+
+/**
+ * Put a calculator state back to how it starts: 0, no operation,
+ * focus on the whole part of the lhs
+ */
+void calc_reset(calc_state_t * s) {
+   s->lhs = num_from_int(0);
+   s->rhs = num_from_int(0);
+   s->operation = '\0';
+   s->state = CALC_LHS_WHOLE;
+   s->fractional_pow10 = 10;
+   s->status = CALC_OK;
+}
+
+/***
+ * calc_op: the arithmetic behind math_op(), without the alarm
+ *      status is set to CALC_OK or the error; the result is 0 on error
+ */
+CALC_TYPE calc_op(const CALC_TYPE lhs_operand, const char op,
+               const CALC_TYPE rhs_operand, int * status) {
+   CALC_TYPE result = num_from_int(0);
+   *status = CALC_OK;
+   // the backend sets the status on a division by zero or an overflow
+   switch(op) {
+      case '+': /* add */
+         result = num_add(lhs_operand, rhs_operand, status);
+         break;
+      case '-': /* subtract */
+         result = num_sub(lhs_operand, rhs_operand, status);
+         break;
+      case '*': /* multiply */
+         result = num_mul(lhs_operand, rhs_operand, status);
+         break;
+      case '/': /* divide */
+         result = num_div(lhs_operand, rhs_operand, status);
+         break;
+
+      default: /* not an operation (including '=') */
+         *status = CALC_BAD_OP;
+         break;
+         
+   }
+   return result;
+}
+
+/*
+ * Set off the alarm for the error of an operation, if any
+ */
+static void calc_alarm(int status, char op) {
+   if (status == CALC_DIV_BY_ZERO) {
+      assert(0, "DIV BY ZERO");
+   }
+   else if (status == CALC_BAD_OP) {
+      assert(0, (op == '=') ? "ILLEGAL MATH OP \'=\'" : "UNKOWN OP");
+   }
+   else if (status == CALC_OVERFLOW) {
+      assert(0, "OVERFLOW");
+   }
+}
+
+/***
+ * math_op: An operation function to handle the addition, subtraction, 
+ *      multiplication, or division of a LHS and RHS operand
+ *      calc.status tells whether the result is valid
+ */
+CALC_TYPE math_op(const CALC_TYPE lhs_operand, const char op, 
+               const CALC_TYPE rhs_operand) {
+   CALC_TYPE result = calc_op(lhs_operand, op, rhs_operand, &calc.status);
+   calc_alarm(calc.status, op);
+   return result;
+}
+
+/**
+ * Enter one more digit into an operand, the way the keypad does
+ * In the fractional part, *pow10 is the divisor of this digit and is
+ * moved on to the next one
+ */
+CALC_TYPE calc_digit(CALC_TYPE value, uint8_t digit, int fractional,
+                     long long int * pow10) {
+   // IF we should be focusing on the fractional part, 
+   // add a fractional part to the previous value and
+   // modify the fractional power of 10 for the divisor of the 
+   // next input, e.g. 3 -> 3 + 1/10 = 3.1
+   // else work on the whole part, e.g. 3 -> 3(10) + 4 = 34
+   // (each backend does it its own way; see num_digit())
+   return num_digit(value, digit, fractional, pow10);
+}
+
+/**
+ * Write a number the way the GLCD shows it into text: a '-' if it's
+ * negative, the whole part, and if there's a fractional part, a '.'
+ * and its first precision (up to 9) digits (truncated, not rounded)
+ * Returns the length, or 0 if text has fewer than
+ * CALC_FORMAT_SIZE(precision) characters
+ */
+int calc_format(CALC_TYPE num, int precision, char * text, int size) {
+   char digits[20]; // a 64-bit whole part, backwards
+   unsigned long long whole;
+   unsigned long fraction;
+   int has_fraction;
+   int length = 0, count = 0, k;
+
+   if (size < CALC_FORMAT_SIZE(precision)) {
+      return 0;
+   }
+   num_split(num, precision, &whole, &fraction, &has_fraction);
+   if (num_is_negative(num)) {
+      text[length++] = '-';
+   }
+   do {
+      digits[count++] = '0' + whole % 10;
+      whole /= 10;
+   } while (whole != 0);
+   while (count > 0) {
+      text[length++] = digits[--count];
+   }
+   if (has_fraction) {
+      text[length++] = '.';
+      // the fractional digits, leading zeros included
+      for (k = precision - 1; k >= 0; --k) {
+         text[length + k] = '0' + fraction % 10;
+         fraction /= 10;
+      }
+      length += precision;
+   }
+   text[length] = '\0';
+   return length;
+}
+
+/**
+ * Write the entry line the way the GLCD shows it into text: the lhs,
+ * and while an operation is pending, the operation and the rhs
+ * Returns the length, or 0 if text has fewer than
+ * CALC_ENTRY_SIZE(precision) characters
+ */
+int calc_entry_text(const calc_state_t * s, int precision, char * text,
+                    int size) {
+   int length;
+   if (size < CALC_ENTRY_SIZE(precision)) {
+      return 0;
+   }
+   length = calc_format(s->lhs, precision, text, size);
+   // IF the opeartion is not the null character or the equal sign
+   if (s->operation != '\0' && s->operation != '=') {
+      // add the operation and the rhs
+      text[length++] = s->operation;
+      length += calc_format(s->rhs, precision, &text[length], size - length);
+   }
+   return length;
+}
+
+/*
+ * calc_eval() and calc_eval_x(): x is the value of the operand 'x',
+ * or NULL if there is none
+ */
+static CALC_TYPE eval(const char * text, int length, const CALC_TYPE * x,
+                      int * status) {
+   CALC_TYPE result = num_from_int(0);  // operands combined so far
+   CALC_TYPE operand = num_from_int(0); // operand being entered
+   char op = '\0';        // pending operation
+   int fractional = 0;    // in the fractional part of the operand
+   int digits = 0;        // digits in the operand
+   int variable = 0;      // the operand is 'x'
+   long long int pow10 = 10;
+   int k; // used in for loop
+
+   *status = CALC_OK;
+   for (k = 0; k <= length; ++k) {
+      char c = (k < length) ? text[k] : '\0'; // '\0' ends the last operand
+      if (c >= '0' && c <= '9' && !variable) {
+         operand = calc_digit(operand, c - '0', fractional, &pow10);
+         ++digits;
+      }
+      else if (c == '.' && !fractional && !variable) {
+         fractional = 1;
+      }
+      else if (c == 'x' && x && digits == 0 && !fractional && !variable) {
+         operand = *x;
+         variable = 1;
+         digits = 1;
+      }
+      else if (c == '+' || c == '-' || c == '*' || c == '/' || c == '\0') {
+         if (digits == 0) {
+            break; // an operator needs an operand before it
+         }
+         if (op == '\0') {
+            result = operand; // the first operand
+         }
+         else {
+            result = calc_op(result, op, operand, status);
+            if (*status != CALC_OK) {
+               return num_from_int(0);
+            }
+         }
+         // start the next operand
+         op = c;
+         operand = num_from_int(0);
+         fractional = 0;
+         digits = 0;
+         variable = 0;
+         pow10 = 10;
+      }
+      else {
+         break; // not something the keypad can type
+      }
+   }
+   if (k <= length) {
+      *status = CALC_SYNTAX;
+      return num_from_int(0);
+   }
+   return result;
+}
+
+/**
+ * Evaluate an expression as if it were typed on the keypad:
+ * operands of digits with an optional '.', joined by + - * / and
+ * combined left to right through calc_op() (no precedence)
+ * e.g. "12.5*2-5" = 20
+ * status is set to CALC_OK or the first error; the result is 0 on error
+ */
+CALC_TYPE calc_eval(const char * text, int length, int * status) {
+   return eval(text, length, NULL, status);
+}
+
+/**
+ * Evaluate a function of x the way calc_eval() does, with the letter
+ * 'x' as an operand that stands for the value given
+ * e.g. "x*x-1" at x = 3 is 8; "2x" and "x.5" are syntax errors
+ */
+CALC_TYPE calc_eval_x(const char * text, int length, CALC_TYPE x,
+                      int * status) {
+   return eval(text, length, &x, status);
+}
+
+/*
+ * The actions of the transition table. Each gets the state and the
+ * key, and returns 1 if it combined the operands, else 0; the table
+ * moves the state on afterwards.
+ */
+typedef int (*calc_action_t)(calc_state_t *, uint8_t);
+
+typedef struct {
+   calc_action_t action;
+   uint8_t next; // the state after the action
+} calc_transition_t;
+
+/* the operation characters of KEY_ADD ... KEY_DIVIDE */
+static const char operations[4] = { '+', '-', '*', '/' };
+
+/* the class of each key */
+static const uint8_t key_classes[16] = {
+   CALC_CLASS_DIGIT, CALC_CLASS_DIGIT, CALC_CLASS_DIGIT, CALC_CLASS_DIGIT,
+   CALC_CLASS_DIGIT, CALC_CLASS_DIGIT, CALC_CLASS_DIGIT, CALC_CLASS_DIGIT,
+   CALC_CLASS_DIGIT, CALC_CLASS_DIGIT,
+   CALC_CLASS_OPERATION, CALC_CLASS_OPERATION, /* KEY_ADD, KEY_SUBTRACT */
+   CALC_CLASS_OPERATION, CALC_CLASS_OPERATION, /* KEY_MULTIPLY, KEY_DIVIDE */
+   CALC_CLASS_DECIMAL,                         /* KEY_DECIMAL */
+   CALC_CLASS_EQUALS,                          /* KEY_EQUALS */
+};
+
+/*
+ * Combine the operands into the lhs, e.g. 3 '+' 4 = 7 = lhs, and
+ * start a new rhs
+ */
+static void combine(calc_state_t * s) {
+   s->lhs = calc_op(s->lhs, s->operation, s->rhs, &s->status);
+   calc_alarm(s->status, s->operation);
+   s->rhs = num_from_int(0);
+}
+
+/*
+ * A number was pressed: add the digit to the whole or fractional part
+ * of the focused operand (the fractional power of 10 moves on for the
+ * next input)
+ */
+static int enter_digit(calc_state_t * s, uint8_t key) {
+   CALC_TYPE * operand = CALC_ON_RHS(s->state) ? &s->rhs : &s->lhs;
+   *operand = calc_digit(*operand, key, CALC_IN_FRACTION(s->state),
+                         &s->fractional_pow10);
+   return 0;
+}
+
+/*
+ * "*" was pressed: the next digits are fractional (the state says so)
+ */
+static int start_fraction(calc_state_t * s, uint8_t key) {
+   (void)s;
+   (void)key;
+   return 0;
+}
+
+/*
+ * "A" to "D" with the focus on the lhs: the lhs is done, enter the rhs
+ */
+static int set_operation(calc_state_t * s, uint8_t key) {
+   s->operation = operations[key - KEY_ADD];
+   return 0;
+}
+
+/*
+ * "A" to "D" with the focus on the rhs: combine the pending operation
+ * first, then enter a new rhs
+ */
+static int chain_operation(calc_state_t * s, uint8_t key) {
+   combine(s);
+   s->operation = operations[key - KEY_ADD];
+   return 1;
+}
+
+/*
+ * "#" with the focus on the rhs: combine and show the answer
+ */
+static int equals(calc_state_t * s, uint8_t key) {
+   (void)key;
+   combine(s);
+   s->operation = '='; // the answer is shown on its own
+   return 1;
+}
+
+/*
+ * "#" with the focus on the lhs: hitting equal again clears the
+ * calculator (the display is cleared when it is refreshed)
+ */
+static int clear(calc_state_t * s, uint8_t key) {
+   (void)key;
+   s->lhs = num_from_int(0);
+   s->rhs = num_from_int(0); // for robustness
+   s->operation = '\0';      // no operation currently
+   return 0;
+}
+
+/* the action and the next state, by state and class of key */
+static const calc_transition_t transitions[CALC_STATES][CALC_CLASSES] = {
+   /* CALC_LHS_WHOLE */
+   { { enter_digit,     CALC_LHS_WHOLE },
+     { set_operation,   CALC_RHS_WHOLE },
+     { start_fraction,  CALC_LHS_FRACTION },
+     { clear,           CALC_LHS_WHOLE } },
+   /* CALC_LHS_FRACTION */
+   { { enter_digit,     CALC_LHS_FRACTION },
+     { set_operation,   CALC_RHS_WHOLE },
+     { start_fraction,  CALC_LHS_FRACTION },
+     { clear,           CALC_LHS_WHOLE } },
+   /* CALC_RHS_WHOLE */
+   { { enter_digit,     CALC_RHS_WHOLE },
+     { chain_operation, CALC_RHS_WHOLE },
+     { start_fraction,  CALC_RHS_FRACTION },
+     { equals,          CALC_LHS_WHOLE } },
+   /* CALC_RHS_FRACTION */
+   { { enter_digit,     CALC_RHS_FRACTION },
+     { chain_operation, CALC_RHS_WHOLE },
+     { start_fraction,  CALC_RHS_FRACTION },
+     { equals,          CALC_LHS_WHOLE } },
+};
+
+/**
+ * The class of a decoded key (CALC_CLASS_*)
+ */
+uint8_t calc_key_class(uint8_t key) {
+   return key_classes[key & 0x0F];
+}
+
+/**
+ * Update a calculator state for one decoded key: one table lookup, one
+ * action and the next state, whatever the key and the state
+ * Returns 1 if the key combined the operands (lhs holds the result
+ * and status its status), else 0
+ */
+int calc_step(calc_state_t * s, uint8_t key) {
+   const calc_transition_t * t =
+      &transitions[s->state][key_classes[key & 0x0F]];
+   int computed = t->action(s, key);
+   // a whole part (a new operand, or after '=') starts the fractional
+   // divisor again at 10^1
+   if (!CALC_IN_FRACTION(t->next)) {
+      s->fractional_pow10 = 10;
+   }
+   s->state = t->next;
+   return computed;
+}
+
+/**
+ * Update the calculator state the display shows for one decoded key
+ * Returns 1 if the key combined the operands through calc_op()
+ * (calc.lhs holds the result and calc.status its status), else 0
+ */
+int calc_key(uint8_t key) {
+   return calc_step(&calc, key);
+}
@@ -0,0 +1,91 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: calc.h
+ * Description:
+ *      The calculator itself: the operands, the pending operation,
+ *      the digit-entry focus and the key handling that updates them.
+ *      Nothing in here touches the hardware, so the same code runs on
+ *      the board (driven by PORT3_IRQHandler) and in the host tools.
+ *      The key handling is a state machine: the state is which operand
+ *      has the focus and whether a '.' was entered in it, and a table
+ *      in flash gives the action and the next state for each state and
+ *      class of key (digit, operation, decimal point, equals).
+ *      NOTE:
+ *              assert() is provided by the platform; on the board
+ *              main.c shows the message on the GLCD and lights the
+ *              red LEDs.
+ */
+#ifndef CALC_H
+#define CALC_H
+
+#include <stdint.h>
+
+/* status of the last math_op() */
+#define CALC_OK          0
+#define CALC_DIV_BY_ZERO 1
+#define CALC_BAD_OP      2
+#define CALC_SYNTAX      3 /* calc_eval() only */
+#define CALC_OVERFLOW    4 /* fixed-point and decimal backends only */
+
+/* room calc_format() needs: sign, 20 digits, point, fraction, '\0' */
+#define CALC_FORMAT_SIZE(precision) (23 + (precision))
+/* room calc_entry_text() needs: two numbers and the operation */
+#define CALC_ENTRY_SIZE(precision) (2 * CALC_FORMAT_SIZE(precision) + 1)
+
+/* types */
+#include "num.h" /* the numeric backend, chosen with CALC_BACKEND */
+#define CALC_TYPE num_t
+
+/* keys as decoded by keypad_decode() */
+#define KEY_ADD      0xA /* "A" */
+#define KEY_SUBTRACT 0xB /* "B" */
+#define KEY_MULTIPLY 0xC /* "C" */
+#define KEY_DIVIDE   0xD /* "D" */
+#define KEY_DECIMAL  0xE /* "*" */
+#define KEY_EQUALS   0xF /* "#" */
+
+/* states of the key handling: the focused operand and its part */
+#define CALC_LHS_WHOLE    0
+#define CALC_LHS_FRACTION 1 /* after a '.' */
+#define CALC_RHS_WHOLE    2
+#define CALC_RHS_FRACTION 3
+#define CALC_STATES       4
+
+/* classes of keys, the other index of the transition table */
+#define CALC_CLASS_DIGIT     0
+#define CALC_CLASS_OPERATION 1
+#define CALC_CLASS_DECIMAL   2
+#define CALC_CLASS_EQUALS    3
+#define CALC_CLASSES         4
+
+#define CALC_ON_RHS(state)      ((state) >= CALC_RHS_WHOLE)
+#define CALC_IN_FRACTION(state) ((state) & 1)
+
+/* everything the calculator remembers between keys */
+typedef struct {
+   CALC_TYPE lhs;
+   CALC_TYPE rhs;
+   char operation; // null-char means no-operation
+   uint8_t state;  // CALC_LHS_WHOLE ... CALC_RHS_FRACTION
+   long long int fractional_pow10; // divisor of the next fractional digit
+   int status;     // CALC_OK or the error of the last math_op()
+} calc_state_t;
+
+/* the state the display shows */
+extern calc_state_t calc;
+
+/* prototypes */
+CALC_TYPE math_op(const CALC_TYPE, const char, const CALC_TYPE);
+CALC_TYPE calc_op(const CALC_TYPE, const char, const CALC_TYPE, int *);
+CALC_TYPE calc_digit(CALC_TYPE, uint8_t, int, long long int *);
+CALC_TYPE calc_eval(const char *, int, int *);
+CALC_TYPE calc_eval_x(const char *, int, CALC_TYPE, int *);
+int calc_format(CALC_TYPE, int, char *, int);
+int calc_entry_text(const calc_state_t *, int, char *, int);
+void calc_reset(calc_state_t *);
+uint8_t calc_key_class(uint8_t);
+int calc_step(calc_state_t *, uint8_t);
+int calc_key(uint8_t);
+void assert(const int, char *); // platform provided
+
+#endif /* CALC_H */
@@ -0,0 +1,223 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: clock.c
+ * Description:
+ *      The clock governor (see clock.h).
+ */
+#include "msp.h"
+#include "clock.h"
+#include "timebase.h"
+
+/* statistics */
+uint32_t clock_switches = 0;
+uint32_t clock_ticks[2] = { 0, 0 };
+
+static int policy = CLOCK_LOW;
+static int high = 0;   // MCLK is CLOCK_HIGH_HZ
+static volatile uint8_t switching = 0; // a switch is under way
+static volatile uint8_t holds = 0;     // clock_hold()s not released yet
+static uint32_t since; // timebase_now() when clock_ticks were last counted
+
+/*
+ * Count the time since the last count at the clock it ran at
+ * Call it with interrupts disabled.
+ */
+static void account(void) {
+   uint32_t now = timebase_now();
+   clock_ticks[high] += now - since;
+   since = now;
+}
+
+/*
+ * Set the core voltage (an AMR mode of the PCM) and wait for it
+ */
+static void set_power_mode(uint32_t amr) {
+   while (PCM->CTL1 & PCM_CTL1_PMR_BUSY);
+   PCM->CTL0 = PCM_CTL0_KEY_VAL | amr;
+   while (PCM->CTL1 & PCM_CTL1_PMR_BUSY);
+}
+
+/*
+ * The DIVM field that divides CLOCK_DCO_HZ down to hz
+ */
+static uint32_t divm(uint32_t hz) {
+   uint32_t k = 0;
+   while ((CLOCK_DCO_HZ >> k) > hz) {
+      ++k;
+   }
+   return k << CS_CTL1_DIVM_OFS;
+}
+
+/*
+ * Divide MCLK down from the DCO to hz; what counts MCLK is retuned
+ * for hz in the same breath (SMCLK doesn't change)
+ */
+static void set_mclk(uint32_t hz, int to_high) {
+   unsigned int state = _disable_interrupts();
+   account();
+   clock_retune(hz);    // the frame slots (the platform)
+   timebase_retune(hz);
+   CS->KEY = CS_KEY_VAL;  /* unlock CS module for register access */
+   CS->CTL1 = (CS->CTL1 & ~CS_CTL1_DIVM_MASK) | divm(hz);
+   CS->KEY = 0;
+   SystemCoreClock = hz;
+   high = to_high;
+   _restore_interrupts(state);
+}
+
+/*
+ * Switch to CLOCK_HIGH_HZ or to CLOCK_LOW_HZ, the way SystemInit()
+ * sets each up: the voltage and the wait states always allow the
+ * faster of the clock before and after. Only the MCLK divider is
+ * written with interrupts disabled; the handlers run on through the
+ * wait for the core voltage.
+ */
+static void switch_to(int to_high) {
+   unsigned int state = _disable_interrupts();
+   // a policy change raced PendSV to it, or PendSV came in on one (or
+   // on a hold); either way the clock is fast enough to get on with
+   if (high == to_high || switching || holds) {
+      _restore_interrupts(state);
+      return;
+   }
+   switching = 1;
+   _restore_interrupts(state);
+   if (to_high) {
+      // LDO VCORE1 is mandatory for 48 MHz; 1 flash wait state
+      // (BANK0 VCORE1 max is 16 MHz, BANK1 VCORE1 max is 32 MHz)
+      set_power_mode(PCM_CTL0_AMR_1);
+      FLCTL->BANK0_RDCTL = (FLCTL->BANK0_RDCTL & ~FLCTL_BANK0_RDCTL_WAIT_MASK)
+                         | FLCTL_BANK0_RDCTL_WAIT_1
+                         | FLCTL_BANK0_RDCTL_BUFD | FLCTL_BANK0_RDCTL_BUFI;
+      FLCTL->BANK1_RDCTL = (FLCTL->BANK1_RDCTL & ~FLCTL_BANK1_RDCTL_WAIT_MASK)
+                         | FLCTL_BANK1_RDCTL_WAIT_1
+                         | FLCTL_BANK1_RDCTL_BUFD | FLCTL_BANK1_RDCTL_BUFI;
+      set_mclk(CLOCK_HIGH_HZ, 1);
+   }
+   else {
+      // 3 MHz needs no wait states nor buffering, and runs at VCORE0
+      set_mclk(CLOCK_LOW_HZ, 0);
+      FLCTL->BANK0_RDCTL = FLCTL->BANK0_RDCTL
+                         & ~(FLCTL_BANK0_RDCTL_WAIT_MASK
+                             | FLCTL_BANK0_RDCTL_BUFD | FLCTL_BANK0_RDCTL_BUFI);
+      FLCTL->BANK1_RDCTL = FLCTL->BANK1_RDCTL
+                         & ~(FLCTL_BANK1_RDCTL_WAIT_MASK
+                             | FLCTL_BANK1_RDCTL_BUFD | FLCTL_BANK1_RDCTL_BUFI);
+      set_power_mode(PCM_CTL0_AMR_0);
+   }
+   ++clock_switches;
+   switching = 0;
+}
+
+/**
+ * Run the DCO at CLOCK_DCO_HZ for good, with MCLK divided down to the
+ * clock SystemInit() set and SMCLK (and HSMCLK) to CLOCK_SMCLK_HZ
+ * Call it first thing, before anything SMCLK clocks (the UART, the
+ * SPI) or that counts MCLK is set up.
+ */
+void clock_setup(void) {
+   CS->KEY = CS_KEY_VAL;  /* unlock CS module for register access */
+   // the dividers first, so that nothing runs faster than allowed
+   // while the DCO speeds up
+   CS->CTL1 = (CS->CTL1 & ~(CS_CTL1_DIVM_MASK | CS_CTL1_DIVHS_MASK
+                            | CS_CTL1_DIVS_MASK))
+            | divm(SystemCoreClock) | CS_CTL1_DIVHS__4 | CS_CTL1_DIVS__4;
+   CS->CTL0 = CS_CTL0_DCORSEL_5;
+   CS->KEY = 0;
+}
+
+/**
+ * Start the governor with a policy; MCLK is what SystemInit() set
+ * Call it once clock_setup() ran and the timebase and the frame slots
+ * are set up, since a switch retunes them.
+ */
+void clock_init(int first_policy) {
+   since = timebase_now();
+   high = SystemCoreClock == CLOCK_HIGH_HZ;
+   policy = -1;
+   clock_policy(first_policy);
+}
+
+/**
+ * Change the policy (see clock.h), switching the clock if it says to
+ */
+void clock_policy(int new_policy) {
+   policy = new_policy;
+   if (policy == CLOCK_HIGH && !high) {
+      switch_to(1);
+   }
+   else if (policy != CLOCK_HIGH && high) {
+      switch_to(0); // CLOCK_BURST starts idle
+   }
+}
+
+/**
+ * There is work: go fast if the policy says to
+ */
+void clock_busy(void) {
+   if (policy == CLOCK_BURST && !high) {
+      switch_to(1);
+   }
+}
+
+/**
+ * The work is done: go slow if the policy says to
+ */
+void clock_idle(void) {
+   if (policy == CLOCK_BURST && high) {
+      switch_to(0);
+   }
+}
+
+/**
+ * Keep the clock, and the flash read settings that go with it, as
+ * they are until clock_release(), e.g. while flash is programmed;
+ * switches wanted in the meantime are skipped
+ * Call it from the main loop (never in the middle of a switch).
+ */
+void clock_hold(void) {
+   unsigned int state = _disable_interrupts();
+   ++holds;
+   _restore_interrupts(state);
+}
+
+/**
+ * Undo a clock_hold(); after the last one, go to the clock the policy
+ * wants now that the work a hold kept fast is over
+ */
+void clock_release(void) {
+   unsigned int state = _disable_interrupts();
+   uint8_t left = --holds;
+   _restore_interrupts(state);
+   if (left == 0) {
+      clock_policy(policy);
+   }
+}
+
+/**
+ * Start counting the time at each clock (and the switches) from now
+ */
+void clock_reset_stats(void) {
+   unsigned int state = _disable_interrupts();
+   since = timebase_now();
+   clock_ticks[0] = 0;
+   clock_ticks[1] = 0;
+   clock_switches = 0;
+   _restore_interrupts(state);
+}
+
+/**
+ * The energy the core used since clock_reset_stats(), in nJ, from the
+ * time at each clock and its typical current: uA * V * s * 1000
+ * (the ticks wrap after 2^32 / TIMEBASE_HZ, about 89 seconds)
+ */
+uint32_t clock_energy_nj(void) {
+   unsigned int state = _disable_interrupts();
+   uint64_t energy;
+   account();
+   energy = ((uint64_t)clock_ticks[0] * CLOCK_UA_LOW
+             + (uint64_t)clock_ticks[1] * CLOCK_UA_HIGH)
+            * CLOCK_VOLTS_X10 / (TIMEBASE_HZ / 100);
+   _restore_interrupts(state);
+   return (uint32_t)energy;
+}
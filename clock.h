@@ -0,0 +1,81 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: clock.h
+ * Description:
+ *      The clock governor: MCLK runs fast while there is work and
+ *      slow while there isn't, instead of at the one __SYSTEM_CLOCK
+ *      SystemInit() set at reset.
+ *      clock_setup() runs the DCO at CLOCK_DCO_HZ for good, and the
+ *      governor only changes the MCLK divider. SMCLK, which clocks the
+ *      UART and the GLCD's SPI, stays at CLOCK_SMCLK_HZ, so a switch
+ *      never resets them and no byte on the host link is lost.
+ *      PendSV calls clock_busy() when it starts on the input queue and
+ *      clock_idle() once the queue is empty and nothing is left to
+ *      draw. A switch takes the steps SystemInit() takes for each
+ *      clock, in the safe order: going up, the core voltage (PCM) and
+ *      the flash wait states first and the divider last; going down,
+ *      the other way round. What counts MCLK is retuned with the
+ *      divider: the timebase (see timebase.h) and, through the
+ *      platform's clock_retune(), the SysTick period of the frame
+ *      slots.
+ *      Policies:
+ *              CLOCK_LOW    always CLOCK_LOW_HZ (what SystemInit() sets)
+ *              CLOCK_HIGH   always CLOCK_HIGH_HZ
+ *              CLOCK_BURST  CLOCK_HIGH_HZ while busy, else CLOCK_LOW_HZ
+ *      The governor counts the time spent at each clock, and from it
+ *      estimates the energy the core used, with the typical active
+ *      currents of the LDO modes (CLOCK_UA_LOW, CLOCK_UA_HIGH; change
+ *      them for a measured board).
+ *      NOTE:
+ *              The platform provides clock_retune(), which runs with
+ *              interrupts disabled. A switch waits for the core voltage
+ *              to settle (with interrupts enabled), so it isn't for an
+ *              ISR at a high priority; one that comes in on another
+ *              switch, or between clock_hold() and clock_release(), is
+ *              skipped.
+ */
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+
+#define CLOCK_DCO_HZ   48000000 /* the DCO, always */
+#define CLOCK_SMCLK_HZ 12000000 /* DCO / 4, the most VCORE0 allows */
+#define CLOCK_LOW_HZ   3000000  /* MCLK: DCO / 16 */
+#define CLOCK_HIGH_HZ  48000000 /* MCLK: DCO / 1 */
+
+#ifndef CLOCK_UA_LOW
+#define CLOCK_UA_LOW  800  /* uA at CLOCK_LOW_HZ, LDO VCORE0, DCO at 48 MHz */
+#endif
+#ifndef CLOCK_UA_HIGH
+#define CLOCK_UA_HIGH 6200 /* uA at CLOCK_HIGH_HZ, LDO VCORE1 */
+#endif
+#define CLOCK_VOLTS_X10 33 /* the supply, 3.3 V */
+
+/* policies */
+#define CLOCK_LOW   0
+#define CLOCK_HIGH  1
+#define CLOCK_BURST 2
+#define CLOCK_POLICIES 3
+
+#ifndef CLOCK_POLICY
+#define CLOCK_POLICY CLOCK_BURST /* the policy clock_init() starts with */
+#endif
+
+/* statistics */
+extern uint32_t clock_switches;   // clock changes
+extern uint32_t clock_ticks[2];   // timebase ticks at the low, high clock
+
+/* prototypes */
+void clock_setup(void);
+void clock_init(int);
+void clock_policy(int);
+void clock_busy(void);
+void clock_idle(void);
+void clock_hold(void);
+void clock_release(void);
+void clock_reset_stats(void);
+uint32_t clock_energy_nj(void);
+void clock_retune(uint32_t); // platform provided
+
+#endif /* CLOCK_H */
@@ -0,0 +1,31 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: cycles.h
+ * Description:
+ *      Cycle counting for the benchmarks through the Cortex-M4 DWT cycle
+ *      counter (CYCCNT). The counter runs at MCLK and wraps every
+ *      2^32 cycles (about 89 seconds at 48 MHz), so unsigned subtraction
+ *      of two readings is always the elapsed cycle count.
+ */
+#ifndef CYCLES_H
+#define CYCLES_H
+
+#include "msp.h"
+
+/**
+ * Enable the trace block and start the DWT cycle counter from zero
+ */
+static inline void cycles_init(void) {
+   CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // power the DWT
+   DWT->CYCCNT = 0;                                // start from zero
+   DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;            // start counting
+}
+
+/**
+ * Read the current cycle count
+ */
+static inline uint32_t cycles_now(void) {
+   return DWT->CYCCNT;
+}
+
+#endif /* CYCLES_H */
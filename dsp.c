@@ -0,0 +1,236 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: dsp.c
+ * Description:
+ *      The Q15/Q31 polynomial kernels (see dsp.h).
+ */
+#include <string.h>
+#include "ramfunc.h"
+#include "dsp.h"
+
+#ifdef DSP_PACKED
+#ifdef __TI_COMPILER_VERSION__
+/* the M4's DSP instructions, through the compiler's intrinsics */
+#define SMLABB(a, b, acc) _smlabb(a, b, acc)
+#define SMLABT(a, b, acc) _smlabt(a, b, acc)
+#define SSAT_ASR15(v)     _ssata(v, 15, 16)
+#define PKHBT(lo, hi)     _pkhbt(lo, hi, 16)
+#define SMMULR(a, b)      _smmulr(a, b)
+#define QDADD(a, b)       _qdadd(a, b)
+#define LOAD32(p)         (*(const int32_t *)(p))
+#define STORE32(p, v)     (*(int32_t *)(p) = (v))
+#else
+/* the same instructions in C, to check the packed kernels on a host */
+#define SMLABB(a, b, acc) ((int32_t)(int16_t)(a) * (int16_t)(b) + (acc))
+#define SMLABT(a, b, acc) \
+   ((int32_t)(int16_t)(a) * (int16_t)((uint32_t)(b) >> 16) + (acc))
+#define SSAT_ASR15(v)     sat16((v) >> 15)
+#define PKHBT(lo, hi)     \
+   (int32_t)(((uint32_t)(lo) & 0xFFFF) | ((uint32_t)(hi) << 16))
+#define SMMULR(a, b)      mulr31(a, b)
+#define QDADD(a, b)       sat32((int64_t)(a) + sat32(2 * (int64_t)(b)))
+static int32_t load32(const void * p) {
+   int32_t v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+#define LOAD32(p)         load32(p)
+#define STORE32(p, v)     do { int32_t w = (v); memcpy(p, &w, sizeof(w)); } \
+                          while (0)
+#endif
+#endif
+
+/*
+ * A number saturated to 16 or 32 bits
+ */
+static inline int32_t sat16(int32_t v) {
+   return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v;
+}
+static inline int32_t sat32(int64_t v) {
+   return v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : (int32_t)v;
+}
+
+/*
+ * The Q30 product of two Q31 numbers, rounded to its top word (SMMULR)
+ */
+static inline int32_t mulr31(int32_t a, int32_t b) {
+   return (int32_t)(((int64_t)a * b + 0x80000000LL) >> 32);
+}
+
+/*
+ * A double times 2^bits, rounded to nearest and saturated to
+ * [-2^bits, 2^bits - 1]
+ */
+static int64_t to_fixed(double v, int bits) {
+   double limit = (double)(1LL << bits);
+   v *= limit;
+   if (v >= limit - 0.5) {
+      return (1LL << bits) - 1;
+   }
+   if (v <= -limit) {
+      return -(1LL << bits);
+   }
+   return (int64_t)(v < 0 ? v - 0.5 : v + 0.5);
+}
+
+/**
+ * A double in Q15
+ */
+q15_t dsp_q15(double v) {
+   return (q15_t)to_fixed(v, 15);
+}
+
+/**
+ * A double in Q31
+ */
+q31_t dsp_q31(double v) {
+   return (q31_t)to_fixed(v, 31);
+}
+
+/**
+ * A Q15 number as a double
+ */
+double dsp_from_q15(q15_t v) {
+   return v / 32768.0;
+}
+
+/**
+ * A Q31 number as a double
+ */
+double dsp_from_q31(q31_t v) {
+   return v / 2147483648.0;
+}
+
+/**
+ * Get a polynomial of x over [x0, x1] ready for the kernels:
+ * coeffs[k] is the coefficient of x^k (degree + 1 of them, degree at
+ * most DSP_DEGREE). scaled gets those of u = (x - mid) / half, which
+ * runs over [-1, 1], divided by 2^shift so that no step of Horner's
+ * rule can leave [-1, 1) (convert them with dsp_q15() or dsp_q31()).
+ * Returns the shift: the kernels' results are the polynomial / 2^shift,
+ * or -1 if the degree is too high.
+ */
+int dsp_poly_prepare(const double * coeffs, int degree, double x0, double x1,
+                     double * scaled) {
+   double mid = (x0 + x1) / 2, half = (x1 - x0) / 2;
+   double bound = 0, limit = 0.99, scale = 1;
+   int shift = 0;
+   int j, k; // used in for loops
+
+   if (degree < 0 || degree > DSP_DEGREE) {
+      return -1;
+   }
+   // Horner on polynomials: q = q * (mid + half * u) + coeffs[k]
+   scaled[0] = coeffs[degree];
+   for (k = degree - 1; k >= 0; --k) {
+      scaled[degree - k] = 0;
+      for (j = degree - k; j > 0; --j) {
+         scaled[j] = scaled[j] * mid + scaled[j - 1] * half;
+      }
+      scaled[0] = scaled[0] * mid + coeffs[k];
+   }
+   // every partial sum of Horner's rule is within the sum of the
+   // magnitudes, and so is the result
+   for (k = 0; k <= degree; ++k) {
+      bound += scaled[k] < 0 ? -scaled[k] : scaled[k];
+   }
+   while (bound > limit) {
+      limit *= 2;
+      scale *= 2;
+      ++shift;
+   }
+   for (k = 0; k <= degree; ++k) {
+      scaled[k] /= scale;
+   }
+   return shift;
+}
+
+/**
+ * y[i] = the polynomial at x[i] for n points, all in Q15; coeffs[k] is
+ * the coefficient of x^k, degree at most DSP_DEGREE (see dsp.h)
+ */
+RAMFUNC void dsp_poly_q15(const q15_t * coeffs, int degree, const q15_t * x,
+                          q15_t * y, int n) {
+   int32_t rounded[DSP_DEGREE + 1]; // c * 2^15 + 1/2, the Q30 addends
+   int i = 0, k;
+
+   for (k = 0; k < degree; ++k) {
+      rounded[k] = coeffs[k] * 32768 + 0x4000;
+   }
+#ifdef DSP_PACKED
+   // two points a word, a chain for each; the low halfword of a
+   // saturated sum is the operand of the next step as it is
+   if ((((uintptr_t)x | (uintptr_t)y) & 3) == 0) {
+      for (; i + 1 < n; i += 2) {
+         int32_t xs = LOAD32(&x[i]);
+         int32_t lo = coeffs[degree], hi = coeffs[degree];
+         for (k = degree - 1; k >= 0; --k) {
+            lo = SSAT_ASR15(SMLABB(lo, xs, rounded[k]));
+            hi = SSAT_ASR15(SMLABT(hi, xs, rounded[k]));
+         }
+         STORE32(&y[i], PKHBT(lo, hi));
+      }
+   }
+#endif
+   for (; i < n; ++i) {
+      int32_t v = coeffs[degree];
+      for (k = degree - 1; k >= 0; --k) {
+         v = sat16((v * x[i] + rounded[k]) >> 15);
+      }
+      y[i] = (q15_t)v;
+   }
+}
+
+/**
+ * y[i] = the polynomial at x[i] for n points, all in Q31; coeffs[k] is
+ * the coefficient of x^k (see dsp.h)
+ */
+RAMFUNC void dsp_poly_q31(const q31_t * coeffs, int degree, const q31_t * x,
+                          q31_t * y, int n) {
+   int i = 0, k;
+
+#ifdef DSP_PACKED
+   // two chains at once, so one multiply doesn't wait on the other
+   for (; i + 1 < n; i += 2) {
+      int32_t a = coeffs[degree], b = coeffs[degree];
+      int32_t xa = x[i], xb = x[i + 1];
+      for (k = degree - 1; k >= 0; --k) {
+         a = QDADD(coeffs[k], SMMULR(a, xa));
+         b = QDADD(coeffs[k], SMMULR(b, xb));
+      }
+      y[i] = a;
+      y[i + 1] = b;
+   }
+#endif
+   for (; i < n; ++i) {
+      int32_t v = coeffs[degree];
+      for (k = degree - 1; k >= 0; --k) {
+         v = sat32((int64_t)coeffs[k] + sat32(2 * (int64_t)mulr31(v, x[i])));
+      }
+      y[i] = v;
+   }
+}
+
+/**
+ * y[i] = x[i] * scale + offset for n points in Q15 (a polynomial of
+ * degree 1), e.g. to map table positions onto [-1, 1) or values onto
+ * rows of the display
+ */
+void dsp_affine_q15(const q15_t * x, q15_t * y, int n, q15_t scale,
+                    q15_t offset) {
+   q15_t coeffs[2];
+   coeffs[0] = offset;
+   coeffs[1] = scale;
+   dsp_poly_q15(coeffs, 1, x, y, n);
+}
+
+/**
+ * y[i] = x[i] * scale + offset for n points in Q31
+ */
+void dsp_affine_q31(const q31_t * x, q31_t * y, int n, q31_t scale,
+                    q31_t offset) {
+   q31_t coeffs[2];
+   coeffs[0] = offset;
+   coeffs[1] = scale;
+   dsp_poly_q31(coeffs, 1, x, y, n);
+}
@@ -0,0 +1,53 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: dsp.h
+ * Description:
+ *      Fixed-point kernels that evaluate a polynomial over a whole
+ *      array of x at once, for tables and graphs of a function where
+ *      one calc_eval_x() per point is far too slow.
+ *      Numbers are Q15 (int16_t, -1 to 1 - 2^-15) or Q31 (int32_t,
+ *      -1 to 1 - 2^-31). x must lie in [-1, 1); the coefficients and
+ *      the result share one scale, any power of two, since Horner's
+ *      y = y * x + c doesn't change the scale of y when x is in Q15 or
+ *      Q31. dsp_poly_prepare() moves a polynomial over [x0, x1] onto
+ *      [-1, 1) and picks that scale so nothing saturates.
+ *      Every step rounds to nearest and saturates, the same way in
+ *      each implementation:
+ *        - DSP_PACKED (the default with the TI compiler): the M4's DSP
+ *          instructions. Q15 loads x two at a time and runs a chain per
+ *          lane with SMLABB/SMLABT (16 x 16 + 32) and SSAT, packing the
+ *          results with PKHBT; Q31 takes SMMULR (the rounded top word
+ *          of 32 x 32) and QDADD (saturating c + 2 * product).
+ *        - otherwise (or with DSP_PORTABLE): plain C, a point at a time.
+ *      The host builds the packed kernels too (with the instructions
+ *      written in C), so host/dspbench checks that they give the same
+ *      bits as the portable ones.
+ */
+#ifndef DSP_H
+#define DSP_H
+
+#include <stdint.h>
+
+#if defined(__TI_COMPILER_VERSION__) && !defined(DSP_PORTABLE)
+#define DSP_PACKED
+#endif
+
+#define DSP_DEGREE 8 /* the highest degree dsp_poly_prepare() takes */
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+/* conversions, rounded to nearest and saturated */
+q15_t dsp_q15(double);
+q31_t dsp_q31(double);
+double dsp_from_q15(q15_t);
+double dsp_from_q31(q31_t);
+
+/* prototypes */
+int dsp_poly_prepare(const double *, int, double, double, double *);
+void dsp_poly_q15(const q15_t *, int, const q15_t *, q15_t *, int);
+void dsp_poly_q31(const q31_t *, int, const q31_t *, q31_t *, int);
+void dsp_affine_q15(const q15_t *, q15_t *, int, q15_t, q15_t);
+void dsp_affine_q31(const q31_t *, q31_t *, int, q31_t, q31_t);
+
+#endif /* DSP_H */
@@ -0,0 +1,297 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: fb.c
+ * Description:
+ *      The framebuffers, their blitter and the flush of the changes
+ *      between two frames (see fb.h).
+ */
+#include <string.h>
+#include "ramfunc.h"
+#include "fb.h"
+
+#define FB_SIZE (FB_BANKS * FB_WIDTH)
+
+/* the back buffer (drawn) and the front buffer (on the display) */
+static uint8_t buffers[2][FB_BANKS][FB_WIDTH];
+uint8_t (*fb)[FB_WIDTH] = buffers[0];
+static uint8_t (*front)[FB_WIDTH] = buffers[1];
+
+/* the runs of bytes of the front buffer the flush sends */
+typedef struct {
+   uint16_t start;  // bank * FB_WIDTH + column
+   uint16_t length; // the PCD8544 moves on to the next bank by itself
+} run_t;
+static run_t runs[FB_RUNS];
+static int run_count = 0;
+static int run_index = 0; // the run being sent
+static int position = 0;  // -2 and -1: its cursor commands, then its data
+
+static volatile uint8_t flushing = 0; // a flush is going
+static volatile uint8_t pending = 0;  // a frame waits for the flush
+static volatile uint8_t stale = 0;    // the display isn't the front buffer
+
+/* statistics */
+volatile uint32_t fb_frames = 0;
+volatile uint32_t fb_flushes = 0;
+volatile uint32_t fb_replaced = 0;
+volatile uint32_t fb_bytes = 0;
+
+/**
+ * Clear every pixel of the back buffer
+ */
+void fb_clear(void) {
+   memset(fb, 0, FB_SIZE);
+}
+
+/*
+ * Combine one column byte of a bitmap into a framebuffer byte; mask
+ * marks the bits inside the bitmap's box
+ */
+static inline uint8_t combine(uint8_t dst, uint8_t src, uint8_t mask,
+                              uint8_t mode) {
+   switch (mode) {
+      case FB_AND:  return dst & (src | (uint8_t)~mask);
+      case FB_XOR:  return dst ^ src;
+      case FB_COPY: return (dst & (uint8_t)~mask) | src;
+      default:      return dst | src;
+   }
+}
+
+/**
+ * Draw a bitmap of width x height pixels with its top left corner at
+ * (x, y), which may be partly (or wholly) off the screen
+ * The bitmap is (height + 7) / 8 rows of width column bytes, bit 0 at
+ * the top, like font_table; the bits below height are ignored.
+ */
+RAMFUNC void fb_blit(const uint8_t * bitmap, int width, int height,
+                     int x, int y, uint8_t mode) {
+   int rows = (height + 7) / 8;
+   int first = 0, last = width;  // columns of the bitmap on the screen
+   int bank, shift, row, col;
+
+   if (x < 0) {
+      first = -x;
+   }
+   if (x + last > FB_WIDTH) {
+      last = FB_WIDTH - x;
+   }
+   if (first >= last || height <= 0) {
+      return; // nothing on the screen
+   }
+   // the bank of the bitmap's first row and how far down in it it
+   // starts (floor division, y may be negative)
+   bank = y >= 0 ? y / 8 : -((7 - y) / 8);
+   shift = y - 8 * bank;
+
+   for (row = 0; row < rows; ++row, ++bank) {
+      // the bits of this row inside the bitmap, then in the two banks
+      uint8_t bits = (row == rows - 1 && (height & 7))
+                     ? (uint8_t)((1u << (height & 7)) - 1) : 0xFF;
+      uint16_t mask = (uint16_t)bits << shift;
+      uint8_t mask_lo = (uint8_t)mask, mask_hi = (uint8_t)(mask >> 8);
+      const uint8_t * src = &bitmap[row * width];
+      uint8_t * lo = (bank >= 0 && bank < FB_BANKS) ? fb[bank] : 0;
+      uint8_t * hi = (bank + 1 >= 0 && bank + 1 < FB_BANKS && mask_hi)
+                     ? fb[bank + 1] : 0;
+      if (lo == 0 && hi == 0) {
+         continue; // this row is above or below the screen
+      }
+      for (col = first; col < last; ++col) {
+         uint16_t word = (uint16_t)(src[col] & bits) << shift;
+         if (lo) {
+            lo[x + col] = combine(lo[x + col], (uint8_t)word, mask_lo, mode);
+         }
+         if (hi) {
+            hi[x + col] = combine(hi[x + col], (uint8_t)(word >> 8), mask_hi,
+                                  mode);
+         }
+      }
+   }
+}
+
+/**
+ * Draw a line from (x0, y0) to (x1, y1) with Bresenham's algorithm,
+ * setting its pixels; the parts off the screen are skipped
+ * The pixels depend on the direction, so draw a line shared by two
+ * drawings the same way round in both.
+ */
+RAMFUNC void fb_line(int x0, int y0, int x1, int y1) {
+   int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+   int dy = y1 > y0 ? y0 - y1 : y1 - y0; // -|y1 - y0|
+   int sx = x0 < x1 ? 1 : -1;
+   int sy = y0 < y1 ? 1 : -1;
+   int error = dx + dy;
+
+   for (;;) {
+      if (x0 >= 0 && x0 < FB_WIDTH && y0 >= 0 && y0 < FB_HEIGHT) {
+         fb[y0 >> 3][x0] |= 1 << (y0 & 7);
+      }
+      if (x0 == x1 && y0 == y1) {
+         break;
+      }
+      if (2 * error >= dy) { // a step along x
+         error += dy;
+         x0 += sx;
+      }
+      if (2 * error <= dx) { // a step along y
+         error += dx;
+         y0 += sy;
+      }
+   }
+}
+
+/**
+ * Move the whole back buffer right by columns pixels (left if
+ * negative); the columns it uncovers are cleared
+ */
+void fb_scroll(int columns) {
+   int bank; // used in for loop
+
+   if (columns >= FB_WIDTH || columns <= -FB_WIDTH) {
+      fb_clear();
+      return;
+   }
+   for (bank = 0; bank < FB_BANKS; ++bank) {
+      if (columns > 0) {
+         memmove(&fb[bank][columns], fb[bank], FB_WIDTH - columns);
+         memset(fb[bank], 0, columns);
+      }
+      else if (columns < 0) {
+         memmove(fb[bank], &fb[bank][-columns], FB_WIDTH + columns);
+         memset(&fb[bank][FB_WIDTH + columns], 0, -columns);
+      }
+   }
+}
+
+/*
+ * Find the runs of bytes in which the back buffer differs from the
+ * front one, all of it if the display is stale
+ */
+static void diff(void) {
+   const uint8_t * drawn = &fb[0][0];
+   const uint8_t * shown = &front[0][0];
+   int index; // used in for loops
+
+   run_count = 0;
+   if (stale) {
+      runs[0].start = 0;
+      runs[0].length = FB_SIZE;
+      run_count = 1;
+      stale = 0;
+      return;
+   }
+   for (index = 0; index < FB_SIZE; ++index) {
+      if (drawn[index] != shown[index]) {
+         run_t * last = run_count ? &runs[run_count - 1] : 0;
+         // a short gap is cheaper to send again than a new cursor, and
+         // once the runs are used up the last one takes the rest
+         if (last && (index - (last->start + last->length) <= FB_RUN_GAP
+                      || run_count == FB_RUNS)) {
+            last->length = index + 1 - last->start;
+         }
+         else {
+            runs[run_count].start = index;
+            runs[run_count].length = 1;
+            ++run_count;
+         }
+      }
+   }
+}
+
+/*
+ * Make the back buffer the front one and start sending its changes;
+ * the new back buffer starts as a copy of it
+ * Returns 1 if there is anything to send
+ */
+static int swap(void) {
+   uint8_t (*shown)[FB_WIDTH] = front;
+   pending = 0;
+   diff();
+   front = fb;
+   fb = shown;
+   memcpy(fb, front, FB_SIZE);
+   if (run_count == 0) {
+      return 0; // the same frame again
+   }
+   run_index = 0;
+   position = -2;
+   flushing = 1;
+   ++fb_flushes;
+   return 1;
+}
+
+/**
+ * Start drawing a frame into the back buffer; a frame still waiting
+ * for the flush is taken back (and counted in fb_replaced)
+ */
+void fb_begin(void) {
+   if (pending) {
+      pending = 0;
+      ++fb_replaced;
+   }
+}
+
+/**
+ * The back buffer holds a finished frame: swap it in and start the
+ * flush, or leave it for the flush in progress to swap in at its end
+ * Returns 1 if a flush started (the platform starts sending), else 0
+ */
+int fb_present(void) {
+   ++fb_frames;
+   if (flushing) {
+      pending = 1;
+      return 0;
+   }
+   return swap();
+}
+
+/**
+ * The next byte of the flush for the PCD8544, in *byte
+ * Returns FB_SEND_COMMAND or FB_SEND_DATA, or FB_SEND_NONE when the
+ * flush is done (and no frame waits to follow it)
+ */
+RAMFUNC int fb_flush_next(uint8_t * byte) {
+   while (flushing) {
+      if (run_index < run_count) {
+         const run_t * run = &runs[run_index];
+         ++fb_bytes;
+         if (position == -2) {
+            ++position;
+            *byte = 0x80 | (run->start % FB_WIDTH); // column
+            return FB_SEND_COMMAND;
+         }
+         if (position == -1) {
+            ++position;
+            *byte = 0x40 | (run->start / FB_WIDTH); // bank
+            return FB_SEND_COMMAND;
+         }
+         *byte = (&front[0][0])[run->start + position];
+         if (++position == run->length) {
+            ++run_index;
+            position = -2;
+         }
+         return FB_SEND_DATA;
+      }
+      // this frame is on the display; the next one may be waiting
+      flushing = 0;
+      if (pending) {
+         swap();
+      }
+   }
+   return FB_SEND_NONE;
+}
+
+/**
+ * Returns 1 while a flush is going
+ */
+int fb_flushing(void) {
+   return flushing;
+}
+
+/**
+ * Something other than the flush wrote to the display (GLCD_clear()),
+ * so the next flush sends every byte
+ */
+void fb_invalidate(void) {
+   stale = 1;
+}
@@ -0,0 +1,73 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: fb.h
+ * Description:
+ *      A framebuffer in SRAM laid out like the PCD8544's memory: six
+ *      banks of 84 column bytes, bit 0 at the top of each byte. Bitmaps
+ *      (glyphs of any width and height, in the same layout) are blitted
+ *      at any pixel position, combined with what's there by OR, AND,
+ *      XOR or COPY, and clipped to the screen. A bitmap at a y that
+ *      isn't a multiple of 8 straddles two banks; each of its column
+ *      bytes is shifted into a 16-bit word and masked into both banks
+ *      at once, never a pixel at a time. Lines (for the graphs of
+ *      plot.h) are drawn a pixel at a time, and the whole buffer can
+ *      be moved sideways.
+ *      There are two buffers. Drawing goes to the back buffer (fb)
+ *      while the front one is sent to the display; fb_present() swaps
+ *      them, and the flush sends only the runs of bytes that differ
+ *      from the frame before. If the last flush is still going, the
+ *      finished frame waits and is swapped in by the flush itself when
+ *      it's done, so drawing never waits for the display.
+ *      The platform moves the bytes: fb_flush_next() hands it the next
+ *      command or data byte for the PCD8544 (EUSCIB0_IRQHandler() in
+ *      main.c). GLCD_flush() in main.c sends the whole back buffer
+ *      instead, waiting for each byte.
+ *      NOTE:
+ *              fb_present() and fb_flush_next() must not preempt each
+ *              other; main.c masks the SPI interrupt around
+ *              fb_present(). fb_begin() takes back a waiting frame, so
+ *              it isn't swapped in half redrawn.
+ */
+#ifndef FB_H
+#define FB_H
+
+#include <stdint.h>
+
+#define FB_WIDTH  84
+#define FB_HEIGHT 48
+#define FB_BANKS  (FB_HEIGHT / 8)
+
+/* how a bitmap combines with the framebuffer */
+#define FB_OR   0 /* set the bitmap's pixels */
+#define FB_AND  1 /* clear the pixels the bitmap doesn't set, in its box */
+#define FB_XOR  2 /* invert the bitmap's pixels */
+#define FB_COPY 3 /* replace the bitmap's box with the bitmap */
+
+/* what fb_flush_next() hands the platform */
+#define FB_SEND_NONE    0 /* the flush is done */
+#define FB_SEND_COMMAND 1 /* a byte for the command register */
+#define FB_SEND_DATA    2 /* a byte for the display memory */
+
+#define FB_RUNS 32   /* runs of changed bytes one flush sends at most */
+#define FB_RUN_GAP 2 /* unchanged bytes a run sends rather than stop (a
+                        new run costs two cursor commands) */
+
+extern uint8_t (*fb)[FB_WIDTH]; // the back buffer, to draw in
+
+/* statistics */
+extern volatile uint32_t fb_frames;   // frames presented
+extern volatile uint32_t fb_flushes;  // frames sent to the display
+extern volatile uint32_t fb_replaced; // waiting frames drawn over
+extern volatile uint32_t fb_bytes;    // bytes sent, commands included
+
+void fb_clear(void);
+void fb_blit(const uint8_t *, int, int, int, int, uint8_t);
+void fb_line(int, int, int, int);
+void fb_scroll(int);
+void fb_begin(void);
+int fb_present(void);
+int fb_flush_next(uint8_t *);
+int fb_flushing(void);
+void fb_invalidate(void);
+
+#endif /* FB_H */
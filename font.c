@@ -0,0 +1,264 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: font.c
+ * Description:
+ *      The proportional font and its layout (see font.h). The glyphs are
+ *      font_table's with the blank columns taken off, and narrower
+ *      digits, '-' and space.
+ */
+#include "font.h"
+#include "fb.h"
+
+/* the glyphs' column bytes, bit 0 at the top, one after the other */
+const uint8_t font_columns[] = {
+   0x00, 0x00,                    /*   */
+   0x5f,                          /* ! */
+   0x23, 0x13, 0x08, 0x64, 0x62,  /* % */
+   0x44, 0x28, 0x10, 0x28, 0x44,  /* * */
+   0x08, 0x08, 0x7f, 0x08, 0x08,  /* + */
+   0x08, 0x08, 0x08,              /* - */
+   0x60, 0x60,                    /* . */
+   0x60, 0x30, 0x18, 0x0c, 0x06,  /* / */
+   0x3e, 0x41, 0x41, 0x3e,        /* 0 */
+   0x42, 0x7f, 0x40,              /* 1 */
+   0x62, 0x51, 0x49, 0x46,        /* 2 */
+   0x22, 0x41, 0x49, 0x36,        /* 3 */
+   0x0f, 0x08, 0x08, 0x7f,        /* 4 */
+   0x27, 0x45, 0x45, 0x39,        /* 5 */
+   0x3e, 0x49, 0x49, 0x32,        /* 6 */
+   0x01, 0x71, 0x0d, 0x03,        /* 7 */
+   0x36, 0x49, 0x49, 0x36,        /* 8 */
+   0x26, 0x49, 0x49, 0x3e,        /* 9 */
+   0x24, 0x24, 0x24, 0x24,        /* = */
+   0x7e, 0x11, 0x11, 0x11, 0x7e,  /* A */
+   0x7f, 0x49, 0x49, 0x49, 0x36,  /* B */
+   0x3e, 0x41, 0x41, 0x41, 0x22,  /* C */
+   0x7f, 0x41, 0x41, 0x41, 0x3e,  /* D */
+   0x7f, 0x49, 0x49, 0x49, 0x41,  /* E */
+   0x7f, 0x09, 0x09, 0x09, 0x01,  /* F */
+   0x3e, 0x41, 0x49, 0x49, 0x7a,  /* G */
+   0x7f, 0x08, 0x08, 0x08, 0x7f,  /* H */
+   0x41, 0x41, 0x7f, 0x41, 0x41,  /* I */
+   0x20, 0x40, 0x40, 0x40, 0x3f,  /* J */
+   0x7f, 0x08, 0x14, 0x22, 0x41,  /* K */
+   0x7f, 0x40, 0x40, 0x40, 0x40,  /* L */
+   0x7f, 0x02, 0x0c, 0x02, 0x7f,  /* M */
+   0x7f, 0x04, 0x08, 0x10, 0x7f,  /* N */
+   0x3e, 0x41, 0x41, 0x41, 0x3e,  /* O */
+   0x7f, 0x09, 0x09, 0x09, 0x06,  /* P */
+   0x3e, 0x41, 0x51, 0x61, 0x7e,  /* Q */
+   0x7f, 0x09, 0x19, 0x29, 0x46,  /* R */
+   0x26, 0x49, 0x49, 0x49, 0x32,  /* S */
+   0x01, 0x01, 0x7f, 0x01, 0x01,  /* T */
+   0x3f, 0x40, 0x40, 0x40, 0x3f,  /* U */
+   0x1f, 0x20, 0x40, 0x20, 0x1f,  /* V */
+   0x3f, 0x40, 0x38, 0x40, 0x3f,  /* W */
+   0x63, 0x14, 0x08, 0x14, 0x63,  /* X */
+   0x03, 0x04, 0x78, 0x04, 0x03,  /* Y */
+   0x61, 0x51, 0x49, 0x45, 0x43,  /* Z */
+};
+
+/* the offset and width of each glyph, Space through _ */
+const font_glyph_t font_glyphs[FONT_LAST - FONT_FIRST + 1] = {
+   {   0, 2 },  /*   */
+   {   2, 1 },  /* ! */
+   {   3, 0 },  /* " */
+   {   3, 0 },  /* # */
+   {   3, 0 },  /* $ */
+   {   3, 5 },  /* % */
+   {   8, 0 },  /* & */
+   {   8, 0 },  /* ' */
+   {   8, 0 },  /* ( */
+   {   8, 0 },  /* ) */
+   {   8, 5 },  /* * */
+   {  13, 5 },  /* + */
+   {  18, 0 },  /* , */
+   {  18, 3 },  /* - */
+   {  21, 2 },  /* . */
+   {  23, 5 },  /* / */
+   {  28, 4 },  /* 0 */
+   {  32, 3 },  /* 1 */
+   {  35, 4 },  /* 2 */
+   {  39, 4 },  /* 3 */
+   {  43, 4 },  /* 4 */
+   {  47, 4 },  /* 5 */
+   {  51, 4 },  /* 6 */
+   {  55, 4 },  /* 7 */
+   {  59, 4 },  /* 8 */
+   {  63, 4 },  /* 9 */
+   {  67, 0 },  /* : */
+   {  67, 0 },  /* ; */
+   {  67, 0 },  /* < */
+   {  67, 4 },  /* = */
+   {  71, 0 },  /* > */
+   {  71, 0 },  /* ? */
+   {  71, 0 },  /* @ */
+   {  71, 5 },  /* A */
+   {  76, 5 },  /* B */
+   {  81, 5 },  /* C */
+   {  86, 5 },  /* D */
+   {  91, 5 },  /* E */
+   {  96, 5 },  /* F */
+   { 101, 5 },  /* G */
+   { 106, 5 },  /* H */
+   { 111, 5 },  /* I */
+   { 116, 5 },  /* J */
+   { 121, 5 },  /* K */
+   { 126, 5 },  /* L */
+   { 131, 5 },  /* M */
+   { 136, 5 },  /* N */
+   { 141, 5 },  /* O */
+   { 146, 5 },  /* P */
+   { 151, 5 },  /* Q */
+   { 156, 5 },  /* R */
+   { 161, 5 },  /* S */
+   { 166, 5 },  /* T */
+   { 171, 5 },  /* U */
+   { 176, 5 },  /* V */
+   { 181, 5 },  /* W */
+   { 186, 5 },  /* X */
+   { 191, 5 },  /* Y */
+   { 196, 5 },  /* Z */
+   { 201, 0 },  /* [ */
+   { 201, 0 },  /* \ */
+   { 201, 0 },  /* ] */
+   { 201, 0 },  /* ^ */
+   { 201, 0 },  /* _ */
+};
+
+/**
+ * The columns of a character's glyph, and its width in *width (0 when
+ * the font has no glyph for it)
+ */
+const uint8_t * font_glyph(char c, int * width) {
+   const font_glyph_t * glyph;
+   if (c < FONT_FIRST || c > FONT_LAST) {
+      *width = 0;
+      return font_columns;
+   }
+   glyph = &font_glyphs[c - FONT_FIRST];
+   *width = glyph->width;
+   return &font_columns[glyph->offset];
+}
+
+/**
+ * The change to FONT_GAP between two glyphs: -FONT_GAP when the right
+ * edge of the left one and the left edge of the right one don't touch,
+ * not even diagonally, so they can sit side by side; 0 otherwise
+ */
+int font_kern(char left, char right) {
+   int left_width, right_width;
+   const uint8_t * a = font_glyph(left, &left_width);
+   const uint8_t * b = font_glyph(right, &right_width);
+   uint8_t edge, reach;
+   if (left_width == 0 || right_width == 0 || left == ' ' || right == ' ') {
+      return 0;
+   }
+   edge = a[left_width - 1];
+   // the pixels of the right glyph's edge that would touch it
+   reach = edge | (uint8_t)(edge << 1) | (edge >> 1);
+   return (reach & b[0]) ? 0 : -FONT_GAP;
+}
+
+/*
+ * The columns from the start of one glyph to the start of the next:
+ * its width, then the gap to next unless next is the end of the text
+ */
+static int advance(char c, char next) {
+   int width, next_width;
+   font_glyph(c, &width);
+   font_glyph(next, &next_width);
+   if (width == 0 || next_width == 0) {
+      return width; // no glyph on one side, no gap either
+   }
+   return width + FONT_GAP + font_kern(c, next);
+}
+
+/*
+ * The next character with a glyph from text[index] on, or '\0'
+ */
+static char next_glyph(const char * text, int index, int length) {
+   int width;
+   for (; index < length && text[index] != '\0'; ++index) {
+      font_glyph(text[index], &width);
+      if (width) {
+         return text[index];
+      }
+   }
+   return '\0';
+}
+
+/**
+ * The width in pixels of the first length characters of text (or all
+ * of it, up to its '\0')
+ */
+int font_measure(const char * text, int length) {
+   int pixels = 0;
+   int k; // used in for loops
+   for (k = 0; k < length && text[k] != '\0'; ++k) {
+      pixels += advance(text[k], next_glyph(text, k + 1, length));
+   }
+   return pixels;
+}
+
+/**
+ * How many characters of text fit in width pixels; their width is put
+ * in *pixels (if pixels isn't NULL)
+ * The line ends between two glyphs, never in the middle of one.
+ */
+int font_fit(const char * text, int width, int * pixels) {
+   int used = 0;
+   int k; // used in for loops
+   for (k = 0; text[k] != '\0'; ++k) {
+      int glyph_width;
+      font_glyph(text[k], &glyph_width);
+      if (used + glyph_width > width) {
+         break;
+      }
+      // the gap (and its kerning) only counts when a glyph follows
+      used += advance(text[k], next_glyph(text, k + 1, 0x7FFF));
+      if (used > width) {
+         used = width; // the gap after the last glyph falls off the line
+      }
+   }
+   if (pixels) {
+      *pixels = k ? font_measure(text, k) : 0;
+   }
+   return k;
+}
+
+/**
+ * Lay the first length characters of text out as column bytes, ready
+ * to send to one bank of the GLCD; columns must have room for
+ * font_measure(text, length) of them, which is also what's returned
+ */
+int font_render(const char * text, int length, uint8_t * columns) {
+   int count = 0;
+   int k, col; // used in for loops
+   for (k = 0; k < length && text[k] != '\0'; ++k) {
+      int width;
+      const uint8_t * glyph = font_glyph(text[k], &width);
+      int step = advance(text[k], next_glyph(text, k + 1, length));
+      for (col = 0; col < step; ++col) {
+         columns[count++] = col < width ? glyph[col] : 0x00;
+      }
+   }
+   return count;
+}
+
+/**
+ * Draw text into the framebuffer (see fb.h) with the top left corner
+ * of its first glyph at pixel (x, y); returns the x after it
+ */
+int font_draw(const char * text, int x, int y, uint8_t mode) {
+   int k; // used in for loops
+   for (k = 0; text[k] != '\0'; ++k) {
+      int width;
+      const uint8_t * glyph = font_glyph(text[k], &width);
+      if (width) {
+         fb_blit(glyph, width, FONT_HEIGHT, x, y, mode);
+      }
+      x += advance(text[k], next_glyph(text, k + 1, 0x7FFF));
+   }
+   return x;
+}
@@ -0,0 +1,41 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: font.h
+ * Description:
+ *      A proportional font for the GLCD. Where font_table in main.c
+ *      gives every character 6 columns, each glyph here is only as wide
+ *      as its ink (a '1' or a '.' takes 2-3 columns, a digit 4), found
+ *      through an index of offsets into one packed array of column
+ *      bytes. A column of space (FONT_GAP) goes between two glyphs,
+ *      except where kerning takes it out: when the facing edges of the
+ *      two glyphs don't touch, not even diagonally ("7." or "-1").
+ *      Text is laid out before it's drawn: font_measure() gives its
+ *      width in pixels and font_fit() how much of it fits on a line.
+ */
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+
+#define FONT_FIRST  ' ' /* the font covers Space through _ in ASCII */
+#define FONT_LAST   '_'
+#define FONT_HEIGHT 8   /* one bank of the GLCD */
+#define FONT_GAP    1   /* columns between two glyphs */
+
+/* where a glyph's columns are in font_columns */
+typedef struct {
+   uint16_t offset;
+   uint8_t width; // 0: the font has no glyph for this character
+} font_glyph_t;
+
+extern const font_glyph_t font_glyphs[FONT_LAST - FONT_FIRST + 1];
+extern const uint8_t font_columns[];
+
+const uint8_t * font_glyph(char, int *);
+int font_kern(char, char);
+int font_measure(const char *, int);
+int font_fit(const char *, int, int *);
+int font_render(const char *, int, uint8_t *);
+int font_draw(const char *, int, int, uint8_t);
+
+#endif /* FONT_H */
@@ -0,0 +1,212 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/batchbench.c
+ * Description:
+ *      Streams expressions through the batch service (see batch.h) and
+ *      reports the sustained expressions per second. Every result is
+ *      checked bit for bit against calc_eval() run locally.
+ *
+ *      usage: batchbench [-n count] [-w window] [-f file] [serial port]
+ *             -f evaluates the expressions in file (one per line) and
+ *                prints "id status result" for each; otherwise count
+ *                random keypad expressions are generated
+ *             -w is the number of records in flight; the default keeps
+ *                them within the device's 256-byte RX ring
+ *             without a serial port the board stand-in runs on a pty
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "standin.h"
+#include "linkio.h"
+#include "../batch.h"
+#include "../calc.h"
+#include "../link.h"
+
+#define TIMEOUT_MS 2000
+#define LINE_BAUD 115200 /* the board's UART */
+
+/* one expression of the run */
+typedef struct {
+   char text[BATCH_MAX_TEXT + 1];
+   uint64_t sent_at;
+} expr_t;
+
+/*
+ * A random expression the keypad could type, e.g. "41.5*7-0.25/3",
+ * that fits in one record
+ */
+static void random_expression(char * text) {
+   static const char ops[] = "+-*/";
+   int operands = 1 + rand() % 4;
+   int n = 0, k, d;
+   for (k = 0; k < operands; ++k) {
+      char operand[16];
+      int length = 0;
+      int digits = 1 + rand() % 5;
+      if (k > 0) {
+         operand[length++] = ops[rand() % 4];
+      }
+      for (d = 0; d < digits; ++d) {
+         operand[length++] = '0' + rand() % 10;
+      }
+      if (rand() % 3 == 0) {
+         operand[length++] = '.';
+         operand[length++] = '0' + rand() % 10;
+         operand[length++] = '0' + rand() % 10;
+      }
+      if (n + length > BATCH_MAX_TEXT) {
+         break; // keep it to one record
+      }
+      memcpy(&text[n], operand, length);
+      n += length;
+   }
+   text[n] = '\0';
+}
+
+int main(int argc, char ** argv) {
+   int count = 20000, window = 6;
+   const char * file = NULL;
+   int opt, fd, k;
+   pid_t child = 0;
+   linkio_t io;
+   link_frame_t frame;
+   expr_t * exprs;
+   uint64_t * latency;
+   uint64_t start, elapsed;
+   int sent = 0, received = 0, mismatches = 0, errors = 0;
+   long wire_out = 0, wire_in = 0; // encoded bytes each way
+
+   while ((opt = getopt(argc, argv, "n:w:f:")) != -1) {
+      switch (opt) {
+         case 'n': count = atoi(optarg); break;
+         case 'w': window = atoi(optarg); break;
+         case 'f': file = optarg; break;
+         default:
+            fprintf(stderr, "usage: %s [-n count] [-w window] [-f file] "
+                            "[serial port]\n", argv[0]);
+            return 2;
+      }
+   }
+
+   /* the expressions */
+   if (file) {
+      FILE * in = fopen(file, "r");
+      char line[256];
+      if (!in) {
+         perror(file);
+         return 1;
+      }
+      exprs = NULL;
+      count = 0;
+      while (fgets(line, sizeof(line), in)) {
+         line[strcspn(line, "\r\n")] = '\0';
+         exprs = realloc(exprs, (count + 1) * sizeof(*exprs));
+         // longer expressions are cut to one record
+         strncpy(exprs[count].text, line, BATCH_MAX_TEXT);
+         exprs[count++].text[BATCH_MAX_TEXT] = '\0';
+      }
+      fclose(in);
+   }
+   else {
+      exprs = calloc(count, sizeof(*exprs));
+      srand(1);
+      for (k = 0; k < count; ++k) {
+         random_expression(exprs[k].text);
+      }
+   }
+   latency = calloc(count > 0 ? count : 1, sizeof(*latency));
+
+   if (optind < argc) {
+      fd = link_open(argv[optind]);
+   }
+   else {
+      child = standin_spawn(&fd);
+   }
+   linkio_init(&io, fd);
+
+   start = now_ns();
+   while (received < count) {
+      while (sent < count && sent - received < window) {
+         uint8_t payload[LINK_MAX_PAYLOAD], frame_bytes[LINK_MAX_FRAME];
+         int length = strlen(exprs[sent].text);
+         payload[0] = sent;
+         payload[1] = sent >> 8;
+         memcpy(&payload[2], exprs[sent].text, length);
+         wire_out += link_encode(frame_bytes, LINK_EXPR, 0, payload, 2 + length);
+         exprs[sent].sent_at = now_ns();
+         linkio_send(&io, LINK_EXPR, payload, 2 + length);
+         ++sent;
+      }
+      int got = linkio_read(&io, &frame, TIMEOUT_MS);
+      if (got != 1) {
+         fprintf(stderr, "batchbench: lost the device after %d results\n",
+                 received);
+         return 1;
+      }
+      if (frame.type != LINK_EXPR_RESULT) {
+         continue; // hello, key or display frames
+      }
+      {
+         uint8_t frame_bytes[LINK_MAX_FRAME];
+         wire_in += link_encode(frame_bytes, frame.type, frame.seq,
+                                frame.payload, frame.len);
+      }
+
+      /* results come back in order; the id holds the low 16 bits */
+      uint16_t id = frame.payload[0] | (frame.payload[1] << 8);
+      int status = frame.payload[2], expected_status;
+      double result = link_get_f64(&frame.payload[3]);
+      double expected;
+      const char * text = exprs[received].text;
+
+      if (id != (uint16_t)received) {
+         fprintf(stderr, "batchbench: result %u out of order (expected %u)\n",
+                 id, (uint16_t)received);
+         return 1;
+      }
+      latency[received] = now_ns() - exprs[received].sent_at;
+      expected = num_to_double(calc_eval(text, strlen(text),
+                                         &expected_status));
+      if (status != expected_status
+          || memcmp(&result, &expected, sizeof(result)) != 0) {
+         ++mismatches;
+         fprintf(stderr, "MISMATCH %d '%s': device %d %.17g, local %d %.17g\n",
+                 received, text, status, result, expected_status, expected);
+      }
+      if (status != CALC_OK) {
+         ++errors;
+      }
+      if (file) {
+         printf("%d %d %.17g\n", received, status, result);
+      }
+      ++received;
+   }
+   elapsed = now_ns() - start;
+
+   fprintf(stderr, "%d expressions in %.3f s = %.0f expr/s "
+           "(%d with error status, %d mismatches)\n", count, elapsed / 1e9,
+           count / (elapsed / 1e9), errors, mismatches);
+   fprintf(stderr, "request -> result: p50 %.1f us, p99 %.1f us\n",
+           percentile(latency, count, 50) / 1e3,
+           percentile(latency, count, 99) / 1e3);
+   if (count > 0) {
+      /* 10 bits per byte on an 8N1 line; the busier direction limits */
+      double per_expr = (wire_out > wire_in ? wire_out : wire_in)
+                        / (double)count;
+      fprintf(stderr, "wire: %.1f bytes/expr out, %.1f in; line-rate bound "
+              "at %d baud = %.0f expr/s\n", wire_out / (double)count,
+              wire_in / (double)count, LINE_BAUD,
+              LINE_BAUD / 10.0 / per_expr);
+   }
+
+   if (child) {
+      close(fd);
+      kill(child, SIGTERM);
+      waitpid(child, NULL, 0);
+   }
+   return mismatches != 0;
+}
@@ -0,0 +1,316 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/calcbatch.c
+ * Description:
+ *      Runs lines of keys through the calculator library (calclib.h)
+ *      on a pool of threads, to check in bulk what operators will key
+ *      in. Each line starts from a reset calculator, e.g. "12.5*4=",
+ *      and gives one line of output, "<entry line>\t<status>", the
+ *      entry line being what the GLCD would show after those keys (a
+ *      line with a character that isn't a key has status -1,
+ *      CALCLIB_BAD_KEY).
+ *      The input is cut into chunks of whole lines that the threads
+ *      take in turn; each chunk's output goes to its own buffer, and
+ *      the buffers are written in order, so the output is the same
+ *      bytes whatever the number of threads.
+ *
+ *      usage: calcbatch [-j threads] [-n lines] [-s] [-m threads] [file]
+ *             -j  threads (default: the cores online)
+ *             -n  without a file, evaluate this many random lines
+ *                 (default 1000000)
+ *             -s  scaling: run with 1, 2, 4 ... up to -m threads
+ *                 (default: the cores, at least 4), print lines per
+ *                 second, speedup and a checksum of the output for
+ *                 each (they must all match), and no results
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "calclib.h"
+
+#define CHUNK_LINES 4096
+#define LINE_OUT (CALCLIB_TEXT + 8) /* an output line at most */
+
+/* a piece of the input and its output */
+typedef struct {
+   const char * start;
+   const char * end;
+   char * out;
+   size_t length;
+} chunk_t;
+
+static chunk_t * chunks;
+static int chunk_count;
+static volatile int next_chunk; // the next one a thread takes
+
+static uint64_t now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*
+ * realloc() (malloc() for NULL) that gives up on the run, with a
+ * message, if there is no memory
+ */
+static void * resize(void * p, size_t size) {
+   p = realloc(p, size);
+   if (p == NULL) {
+      perror("calcbatch");
+      exit(2);
+   }
+   return p;
+}
+
+/*
+ * FNV-1a over bytes, for the checksums
+ */
+static uint32_t fnv(uint32_t hash, const void * data, size_t length) {
+   const uint8_t * p = data;
+   while (length--) {
+      hash = (hash ^ *p++) * 16777619u;
+   }
+   return hash;
+}
+
+/*
+ * Random lines of keys the keypad could type, e.g. "41.5*7-0.25/3="
+ * (a division by zero now and then)
+ */
+static char * random_input(long lines, size_t * size) {
+   static const char ops[] = "+-*/";
+   char * text = resize(NULL, (size_t)lines * 48 + 1);
+   size_t n = 0;
+   long line;
+   int k, d;
+
+   srand(1);
+   for (line = 0; line < lines; ++line) {
+      int operands = 1 + rand() % 4;
+      for (k = 0; k < operands; ++k) {
+         int digits = 1 + rand() % 6;
+         if (k > 0) {
+            text[n++] = ops[rand() % 4];
+         }
+         for (d = 0; d < digits; ++d) {
+            text[n++] = rand() % 50 == 0 ? '0' : '0' + rand() % 10;
+         }
+         if (rand() % 3 == 0) {
+            text[n++] = '.';
+            text[n++] = '0' + rand() % 10;
+            text[n++] = '0' + rand() % 10;
+         }
+      }
+      text[n++] = '=';
+      text[n++] = '\n';
+   }
+   text[n] = '\0';
+   *size = n;
+   return text;
+}
+
+/*
+ * The whole of a file (or stdin for "-")
+ */
+static char * read_input(const char * name, size_t * size) {
+   FILE * f = strcmp(name, "-") ? fopen(name, "rb") : stdin;
+   size_t capacity = 1 << 20, n = 0, got;
+   char * text;
+
+   if (f == NULL) {
+      perror(name);
+      exit(2);
+   }
+   text = resize(NULL, capacity + 1);
+   while ((got = fread(&text[n], 1, capacity - n, f)) > 0) {
+      n += got;
+      if (n == capacity) {
+         capacity *= 2;
+         text = resize(text, capacity + 1);
+      }
+   }
+   if (f != stdin) {
+      fclose(f);
+   }
+   text[n] = '\0';
+   *size = n;
+   return text;
+}
+
+/*
+ * Cut the input into chunks of CHUNK_LINES whole lines
+ * Returns the number of lines
+ */
+static long cut(const char * text, size_t size) {
+   const char * p = text, * end = text + size;
+   long lines = 0;
+   int capacity = 64;
+
+   chunks = resize(NULL, capacity * sizeof(chunk_t));
+   chunk_count = 0;
+   while (p < end) {
+      chunk_t * c;
+      int k;
+      if (chunk_count == capacity) {
+         capacity *= 2;
+         chunks = resize(chunks, capacity * sizeof(chunk_t));
+      }
+      c = &chunks[chunk_count++];
+      c->start = p;
+      for (k = 0; k < CHUNK_LINES && p < end; ++k) {
+         const char * nl = memchr(p, '\n', end - p);
+         p = nl ? nl + 1 : end;
+         ++lines;
+      }
+      c->end = p;
+      c->out = resize(NULL, (size_t)k * LINE_OUT);
+      c->length = 0;
+   }
+   return lines;
+}
+
+/*
+ * One thread of the pool: take chunks until there are none left
+ */
+static void * worker(void * arg) {
+   calclib_t calc;
+   (void)arg;
+   for (;;) {
+      int index = __sync_fetch_and_add(&next_chunk, 1);
+      chunk_t * c;
+      const char * p;
+      if (index >= chunk_count) {
+         return NULL;
+      }
+      c = &chunks[index];
+      c->length = 0;
+      for (p = c->start; p < c->end; ) {
+         const char * nl = memchr(p, '\n', c->end - p);
+         const char * eol = nl ? nl : c->end;
+         int length = (int)(eol - p);
+         char * out = &c->out[c->length];
+         if (length > 0 && p[length - 1] == '\r') {
+            --length;
+         }
+         calclib_reset(&calc);
+         calclib_keys(&calc, p, length);
+         length = calclib_display(&calc, out, CALCLIB_TEXT);
+         length += sprintf(&out[length], "\t%d\n", calclib_status(&calc));
+         c->length += length;
+         p = eol + 1;
+      }
+   }
+}
+
+/*
+ * Evaluate every chunk with a pool of threads
+ * Returns the time it took in ns
+ */
+static uint64_t run(int threads) {
+   pthread_t * pool = resize(NULL, threads * sizeof(pthread_t));
+   uint64_t start = now_ns();
+   int k; // used in for loops
+
+   next_chunk = 0;
+   for (k = 0; k < threads; ++k) {
+      pthread_create(&pool[k], NULL, worker, NULL);
+   }
+   for (k = 0; k < threads; ++k) {
+      pthread_join(pool[k], NULL);
+   }
+   free(pool);
+   return now_ns() - start;
+}
+
+/*
+ * The checksum of the whole output, chunk by chunk in order
+ */
+static uint32_t checksum(void) {
+   uint32_t hash = 2166136261u;
+   int k; // used in for loop
+   for (k = 0; k < chunk_count; ++k) {
+      hash = fnv(hash, chunks[k].out, chunks[k].length);
+   }
+   return hash;
+}
+
+int main(int argc, char ** argv) {
+   long cores = sysconf(_SC_NPROCESSORS_ONLN);
+   int threads = cores > 0 ? (int)cores : 1;
+   int scaling = 0, max_threads = 0;
+   long lines = 1000000;
+   char * text;
+   size_t size;
+   int opt, k;
+
+   while ((opt = getopt(argc, argv, "j:n:sm:")) != -1) {
+      switch (opt) {
+         case 'j': threads = atoi(optarg); break;
+         case 'n': lines = atol(optarg); break;
+         case 's': scaling = 1; break;
+         case 'm': max_threads = atoi(optarg); break;
+         default:
+            fprintf(stderr, "usage: %s [-j threads] [-n lines] [-s] "
+                    "[-m threads] [file]\n", argv[0]);
+            return 2;
+      }
+   }
+   if (threads < 1) {
+      threads = 1;
+   }
+   if (calclib_version() != CALCLIB_VERSION) {
+      fprintf(stderr, "calclib version %d, built for %d\n",
+              calclib_version(), CALCLIB_VERSION);
+      return 2;
+   }
+   if (optind < argc) {
+      text = read_input(argv[optind], &size);
+   }
+   else {
+      text = random_input(lines > 0 ? lines : 1, &size);
+   }
+   lines = cut(text, size);
+
+   if (!scaling) {
+      run(threads);
+      for (k = 0; k < chunk_count; ++k) {
+         fwrite(chunks[k].out, 1, chunks[k].length, stdout);
+      }
+      return 0;
+   }
+
+   if (max_threads < 1) {
+      max_threads = cores > 4 ? (int)cores : 4;
+   }
+   printf("%ld lines, %d chunks, backend %s, %ld cores online\n", lines,
+          chunk_count, calclib_backend(), cores);
+   {
+      double base = 0;
+      uint32_t first = 0;
+      int mismatch = 0;
+      for (k = 1; ; k = k * 2 > max_threads ? max_threads : k * 2) {
+         uint64_t ns = run(k);
+         double rate = lines * 1e9 / ns;
+         uint32_t hash = checksum();
+         if (k == 1) {
+            base = rate;
+            first = hash;
+         }
+         mismatch |= hash != first;
+         printf("  %3d threads %10.2f M lines/s  speedup %5.2f%s  %08x\n", k,
+                rate / 1e6, rate / base, k > cores ? " (over cores)" : "",
+                (unsigned)hash);
+         if (k == max_threads) {
+            break;
+         }
+      }
+      if (mismatch) {
+         printf("output differs between thread counts\n");
+         return 1;
+      }
+   }
+   return 0;
+}
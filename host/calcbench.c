@@ -0,0 +1,258 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/calcbench.c
+ * Description:
+ *      Drives the calculator's state machine (calc_step() in calc.c)
+ *      without a device:
+ *        - every key sequence up to a depth, checked step by step
+ *          against the switch-based key handling it replaced, with
+ *          the number of times each (state, key class) cell was taken
+ *        - the time each cell takes, and the keys per second of a
+ *          random key stream
+ *
+ *      usage: calcbench [-d depth] [-n keys]
+ *             -d  length of the exhaustive sequences (default 6)
+ *             -n  length of the random key stream (default 10000000)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../calc.h"
+
+#define CELL_RUNS 1000000
+
+static const char * state_names[CALC_STATES] = {
+   "lhs whole", "lhs fraction", "rhs whole", "rhs fraction"
+};
+static const char * class_names[CALC_CLASSES] = {
+   "digit", "operation", "decimal", "equals"
+};
+
+/* the key handling before the transition table */
+typedef struct {
+   num_t lhs;
+   num_t rhs;
+   char operation;
+   int on_rhs;     // focus == &rhs
+   int fractional; // focus_on_fractional
+   long long pow10;
+   int status;
+} model_t;
+
+static unsigned long long cells[CALC_STATES][CALC_CLASSES];
+static unsigned long long steps = 0, mismatches = 0;
+
+/**
+ * The firmware's assert() shows the message on the GLCD
+ */
+void assert(const int condition, char * message) {
+   (void)condition;
+   (void)message;
+}
+
+static uint64_t now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void model_focus(model_t * m, int on_rhs) {
+   m->on_rhs = on_rhs;
+   m->fractional = 0;
+   m->pow10 = 10;
+}
+
+/*
+ * calc_key() as it was: an operation combines a pending one when the
+ * focus is on the rhs, then the key's own switch case
+ */
+static int model_key(model_t * m, uint8_t key) {
+   int computed = 0;
+   if (key >= KEY_ADD && key <= KEY_DIVIDE) {
+      if (m->operation != '\0' && m->on_rhs) {
+         m->lhs = calc_op(m->lhs, m->operation, m->rhs, &m->status);
+         m->rhs = num_from_int(0);
+         computed = 1;
+      }
+      model_focus(m, 1);
+   }
+   switch (key) {
+      case KEY_ADD:      m->operation = '+'; break;
+      case KEY_SUBTRACT: m->operation = '-'; break;
+      case KEY_MULTIPLY: m->operation = '*'; break;
+      case KEY_DIVIDE:   m->operation = '/'; break;
+      case KEY_DECIMAL:  m->fractional = 1; break;
+      case KEY_EQUALS:
+         if (m->on_rhs) {
+            m->lhs = calc_op(m->lhs, m->operation, m->rhs, &m->status);
+            m->rhs = num_from_int(0);
+            m->operation = '=';
+            computed = 1;
+         }
+         else {
+            m->lhs = num_from_int(0);
+            m->rhs = num_from_int(0);
+            m->operation = '\0';
+         }
+         model_focus(m, 0);
+         break;
+      default:
+         if (m->on_rhs) {
+            m->rhs = calc_digit(m->rhs, key, m->fractional, &m->pow10);
+         }
+         else {
+            m->lhs = calc_digit(m->lhs, key, m->fractional, &m->pow10);
+         }
+         break;
+   }
+   return computed;
+}
+
+/*
+ * Whether the state machine and the model agree
+ */
+static int same(const calc_state_t * s, const model_t * m) {
+   return num_to_double(s->lhs) == num_to_double(m->lhs)
+          && num_to_double(s->rhs) == num_to_double(m->rhs)
+          && s->operation == m->operation
+          && CALC_ON_RHS(s->state) == m->on_rhs
+          && CALC_IN_FRACTION(s->state) == m->fractional
+          && s->fractional_pow10 == m->pow10;
+}
+
+/*
+ * Every continuation of a state up to depth more keys
+ */
+static void explore(const calc_state_t * s, const model_t * m, int depth,
+                    uint8_t * keys, int length) {
+   uint8_t key;
+   int k;
+   if (depth == 0) {
+      return;
+   }
+   for (key = 0; key < 16; ++key) {
+      calc_state_t next = *s;
+      model_t expected = *m;
+      int computed, expected_computed;
+      ++cells[s->state][calc_key_class(key)];
+      computed = calc_step(&next, key);
+      expected_computed = model_key(&expected, key);
+      ++steps;
+      keys[length] = key;
+      if (computed != expected_computed || !same(&next, &expected)
+          || (computed && next.status != expected.status)) {
+         if (mismatches++ < 5) {
+            printf("MISMATCH after keys");
+            for (k = 0; k <= length; ++k) {
+               printf(" %X", keys[k]);
+            }
+            printf(": lhs %.17g/%.17g, op '%c'/'%c'\n",
+                   num_to_double(next.lhs), num_to_double(expected.lhs),
+                   next.operation ? next.operation : '-',
+                   expected.operation ? expected.operation : '-');
+         }
+         continue;
+      }
+      explore(&next, &expected, depth - 1, keys, length + 1);
+   }
+}
+
+int main(int argc, char ** argv) {
+   int depth = 6, count = 10000000;
+   int opt, k, c, missed = 0;
+   uint8_t keys[32];
+   uint8_t * stream;
+   calc_state_t start_state, s;
+   model_t start_model;
+   uint64_t start;
+   double elapsed, worst = 0;
+   volatile int sink = 0;
+
+   while ((opt = getopt(argc, argv, "d:n:")) != -1) {
+      switch (opt) {
+         case 'd': depth = atoi(optarg); break;
+         case 'n': count = atoi(optarg); break;
+         default:
+            fprintf(stderr, "usage: %s [-d depth] [-n keys]\n", argv[0]);
+            return 2;
+      }
+   }
+   if (depth < 1 || depth > (int)sizeof(keys)) {
+      depth = 6;
+   }
+
+   /* exhaustive sequences against the model */
+   calc_reset(&start_state);
+   memset(&start_model, 0, sizeof(start_model));
+   start_model.lhs = start_model.rhs = num_from_int(0);
+   model_focus(&start_model, 0);
+   start = now_ns();
+   explore(&start_state, &start_model, depth, keys, 0);
+   elapsed = (now_ns() - start) / 1e9;
+   printf("%llu steps of every sequence up to %d keys in %.2f s, "
+          "%llu mismatches\n", steps, depth, elapsed, mismatches);
+
+   /* the time of each cell, from a state reached by typing */
+   printf("\n%-13s", "");
+   for (c = 0; c < CALC_CLASSES; ++c) {
+      printf("  %-19s", class_names[c]);
+   }
+   printf("\n");
+   for (k = 0; k < CALC_STATES; ++k) {
+      // e.g. "12.5+3.25" leaves the focus in the rhs fraction
+      static const uint8_t prefixes[CALC_STATES][8] = {
+         { 1, 2 }, { 1, 2, KEY_DECIMAL, 5 },
+         { 1, 2, KEY_ADD, 3 }, { 1, 2, KEY_ADD, 3, KEY_DECIMAL, 2, 5 },
+      };
+      static const int lengths[CALC_STATES] = { 2, 4, 4, 7 };
+      static const uint8_t sample[CALC_CLASSES] = {
+         7, KEY_MULTIPLY, KEY_DECIMAL, KEY_EQUALS
+      };
+      calc_reset(&s);
+      for (c = 0; c < lengths[k]; ++c) {
+         calc_step(&s, prefixes[k][c]);
+      }
+      printf("%-13s", state_names[k]);
+      for (c = 0; c < CALC_CLASSES; ++c) {
+         calc_state_t copy;
+         double ns;
+         int run;
+         start = now_ns();
+         for (run = 0; run < CELL_RUNS; ++run) {
+            copy = s;
+            sink += calc_step(&copy, sample[c]);
+         }
+         ns = (double)(now_ns() - start) / CELL_RUNS;
+         if (ns > worst) {
+            worst = ns;
+         }
+         printf("  %6.1f ns %9llu", ns, cells[k][c]);
+         missed += cells[k][c] == 0;
+      }
+      printf("\n");
+   }
+   printf("(ns per step and the times each cell was taken above; "
+          "worst %.1f ns)\n", worst);
+   if (missed) {
+      printf("SUSPECT: %d cells were never taken\n", missed);
+   }
+
+   /* a random key stream */
+   stream = malloc(count);
+   srand(1);
+   for (k = 0; k < count; ++k) {
+      stream[k] = rand() % 16;
+   }
+   calc_reset(&s);
+   start = now_ns();
+   for (k = 0; k < count; ++k) {
+      sink += calc_step(&s, stream[k]);
+   }
+   elapsed = (now_ns() - start) / 1e9;
+   printf("\n%d random keys in %.3f s = %.0f keys/s\n", count, elapsed,
+          count / elapsed);
+   free(stream);
+   return mismatches != 0 || missed != 0 || sink < 0;
+}
@@ -0,0 +1,215 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/calclib.c
+ * Description:
+ *      The calculator library (see calclib.h): calc_step() for the
+ *      keys, calc_op() for the arithmetic and calc_format() for the
+ *      text, behind an API that doesn't show the backend.
+ */
+#include <string.h>
+#include "../calc.h"
+#include "calclib.h"
+
+/* what a calclib_t holds */
+typedef struct {
+   calc_state_t calc;
+   int bad_key; // a key it doesn't know came since calclib_reset()
+} state_t;
+
+_Static_assert(sizeof(state_t) <= sizeof(calclib_t),
+               "calc_state_t outgrew calclib_t");
+
+#ifdef CALCLIB_STANDALONE
+/**
+ * The firmware's assert() shows the message on the GLCD; the status
+ * carries the error here, so there is nothing to do
+ */
+void assert(const int condition, char * message) {
+   (void)condition;
+   (void)message;
+}
+#endif
+
+/*
+ * The keypad key of a character, or -1
+ */
+static int decode(char key) {
+   if (key >= '0' && key <= '9') {
+      return key - '0';
+   }
+   switch (key) {
+      case '+': case 'A': return KEY_ADD;
+      case '-': case 'B': return KEY_SUBTRACT;
+      case '*': case 'C': return KEY_MULTIPLY;
+      case '/': case 'D': return KEY_DIVIDE;
+      case '.':           return KEY_DECIMAL;
+      case '=': case '#': return KEY_EQUALS;
+      default:            return -1;
+   }
+}
+
+/*
+ * What a calclib_t holds. Its bytes are copied in and out (an opaque
+ * of uint64_t can't be read as a state_t in place)
+ */
+static state_t load(const calclib_t * c) {
+   state_t s;
+   memcpy(&s, c->opaque, sizeof(s));
+   return s;
+}
+
+static void store(calclib_t * c, const state_t * s) {
+   memcpy(c->opaque, s, sizeof(*s));
+}
+
+/*
+ * Copy the library's text into the caller's, cut short to fit size
+ * (and still ended with '\0')
+ * Returns the length copied
+ */
+static int put(const char * from, char * text, int size) {
+   int length = (int)strlen(from);
+   if (size <= 0) {
+      return 0;
+   }
+   if (length > size - 1) {
+      length = size - 1;
+   }
+   memcpy(text, from, length);
+   text[length] = '\0';
+   return length;
+}
+
+/**
+ * The API version the library implements (CALCLIB_VERSION)
+ */
+int calclib_version(void) {
+   return CALCLIB_VERSION;
+}
+
+/**
+ * The numeric backend the library was built with, e.g. "adaptive"
+ */
+const char * calclib_backend(void) {
+   return NUM_NAME;
+}
+
+/**
+ * Put a calculator in the state the board starts in: 0, no operation
+ */
+void calclib_reset(calclib_t * c) {
+   state_t s;
+   memset(&s, 0, sizeof(s));
+   calc_reset(&s.calc);
+   memset(c, 0, sizeof(*c));
+   store(c, &s);
+}
+
+/**
+ * Press one key (see calclib.h)
+ * Returns 1 if it combined the operands, 0 if not (or it was a
+ * space), CALCLIB_BAD_KEY if it isn't a key; the status is then
+ * CALCLIB_BAD_KEY until calclib_reset(), whatever keys come after
+ */
+int calclib_key(calclib_t * c, char key) {
+   state_t s = load(c);
+   int k = decode(key), combined;
+   if (key == ' ') {
+      return 0;
+   }
+   if (k < 0) {
+      s.bad_key = 1;
+      store(c, &s);
+      return CALCLIB_BAD_KEY;
+   }
+   combined = calc_step(&s.calc, (uint8_t)k);
+   store(c, &s);
+   return combined;
+}
+
+/**
+ * Press the keys of a string, up to length of them or its end
+ * Returns the status after the last (see calclib_status())
+ */
+int calclib_keys(calclib_t * c, const char * keys, int length) {
+   int k; // used in for loop
+   for (k = 0; k < length && keys[k] != '\0'; ++k) {
+      calclib_key(c, keys[k]);
+   }
+   return calclib_status(c);
+}
+
+/**
+ * The status of the last operation (CALC_OK, CALC_DIV_BY_ZERO, ...),
+ * or CALCLIB_BAD_KEY if a key since calclib_reset() wasn't one
+ */
+int calclib_status(const calclib_t * c) {
+   state_t s = load(c);
+   return s.bad_key ? CALCLIB_BAD_KEY : s.calc.status;
+}
+
+/**
+ * Write what the entry line of the GLCD shows: the lhs, and while an
+ * operation is pending, the operation and the rhs
+ * Returns the length, cut short to fit if size is below CALCLIB_TEXT
+ */
+int calclib_display(const calclib_t * c, char * text, int size) {
+   state_t s = load(c);
+   char full[CALCLIB_TEXT];
+   if (size >= CALCLIB_TEXT) {
+      return calc_entry_text(&s.calc, CALCLIB_PRECISION, text, size);
+   }
+   calc_entry_text(&s.calc, CALCLIB_PRECISION, full, sizeof(full));
+   return put(full, text, size);
+}
+
+/**
+ * Write the lhs (after '=', the result) the way the GLCD shows it
+ * Returns the length, cut short to fit if size is below CALCLIB_TEXT
+ */
+int calclib_result(const calclib_t * c, char * text, int size) {
+   char full[CALCLIB_TEXT];
+   if (size >= CALCLIB_TEXT) {
+      return calc_format(load(c).calc.lhs, CALCLIB_PRECISION, text, size);
+   }
+   calc_format(load(c).calc.lhs, CALCLIB_PRECISION, full, sizeof(full));
+   return put(full, text, size);
+}
+
+/**
+ * math_op() on two operands given as keys (digits and '.', with a
+ * leading '-' to negate), the result written as the GLCD shows it
+ * (cut short to fit if size is below CALCLIB_TEXT; "" if an operand
+ * isn't a number)
+ * Returns the status
+ */
+int calclib_op(const char * lhs, char op, const char * rhs, char * text,
+               int size) {
+   calc_state_t s;
+   char full[CALCLIB_TEXT];
+   const char * operands[2];
+   CALC_TYPE values[2];
+   int k; // used in for loop
+
+   operands[0] = lhs;
+   operands[1] = rhs;
+   for (k = 0; k < 2; ++k) {
+      const char * p = operands[k];
+      int negative = *p == '-';
+      calc_reset(&s);
+      for (p += negative; *p != '\0'; ++p) {
+         int key = decode(*p);
+         if (key < 0 || calc_key_class((uint8_t)key) == CALC_CLASS_OPERATION
+             || calc_key_class((uint8_t)key) == CALC_CLASS_EQUALS) {
+            put("", text, size);
+            return CALCLIB_BAD_KEY;
+         }
+         calc_step(&s, (uint8_t)key);
+      }
+      values[k] = negative ? num_negate(s.lhs) : s.lhs;
+   }
+   s.lhs = calc_op(values[0], op, values[1], &s.status);
+   calc_format(s.lhs, CALCLIB_PRECISION, full, sizeof(full));
+   put(full, text, size);
+   return s.status;
+}
@@ -0,0 +1,57 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/calclib.h
+ * Description:
+ *      The calculator as a library with a stable C API, for programs
+ *      off the board (e.g. checking on a server what operators will
+ *      key in). It wraps calc.c and the numeric backend, which touch
+ *      no hardware, so its results are the firmware's, digit for
+ *      digit, when both are built with the same CALC_BACKEND.
+ *      Numbers go in the way the keypad enters them and come out the
+ *      way the GLCD shows them (calc_format() at CALCLIB_PRECISION),
+ *      so no caller depends on how a backend stores a number:
+ *        - keys are characters: '0' - '9', '.', '+', '-', '*', '/'
+ *          and '=' (or the keypad's own 'A' - 'D' and '#'); a space
+ *          is skipped, and any other character makes the status
+ *          CALCLIB_BAD_KEY until calclib_reset()
+ *        - calclib_t is a calculator of its own, the same size in
+ *          every backend; nothing else is shared, so each thread can
+ *          run its own
+ *      A program built against one CALCLIB_VERSION works with any
+ *      library of the same version.
+ *      NOTE:
+ *              Build the library with CALCLIB_STANDALONE defined (the
+ *              Makefile's libcalc.a does) to get a silent assert(), or
+ *              without it next to code with an assert() of its own.
+ *              It is in host/, which the CCS build leaves out, so none
+ *              of it goes into the firmware.
+ */
+#ifndef CALCLIB_H
+#define CALCLIB_H
+
+#include <stdint.h>
+
+#define CALCLIB_VERSION   1
+#define CALCLIB_PRECISION 4  /* fractional digits shown, as on the board */
+#define CALCLIB_TEXT      64 /* room for any text the library writes */
+
+/* status: CALC_OK ... CALC_OVERFLOW of calc.h, or a key it doesn't know */
+#define CALCLIB_BAD_KEY   -1
+
+/* a calculator; what's inside is the library's business */
+typedef struct {
+   uint64_t opaque[8];
+} calclib_t;
+
+/* prototypes */
+int calclib_version(void);
+const char * calclib_backend(void);
+void calclib_reset(calclib_t *);
+int calclib_key(calclib_t *, char);
+int calclib_keys(calclib_t *, const char *, int);
+int calclib_status(const calclib_t *);
+int calclib_display(const calclib_t *, char *, int);
+int calclib_result(const calclib_t *, char *, int);
+int calclib_op(const char *, char, const char *, char *, int);
+
+#endif /* CALCLIB_H */
@@ -0,0 +1,356 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/calcvec.c
+ * Description:
+ *      math_op() over columns (see calcvec.h). A column kernel does
+ *      one operation on n pairs; calcvec_op() picks the kernels once,
+ *      by the CPU, then runs one per column, or one per run of the
+ *      same operation in a column of mixed operations.
+ */
+#include <string.h>
+#include "../calc.h"
+#include "calcvec.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+    && !defined(__TI_COMPILER_VERSION__) \
+    && (CALC_BACKEND == CALC_BACKEND_DOUBLE || CALC_BACKEND == CALC_BACKEND_FIXED)
+#define CALCVEC_AVX2
+#include <immintrin.h>
+#define AVX2 __attribute__((target("avx2")))
+#endif
+
+/* one operation on n pairs */
+typedef void (*column_t)(const CALC_TYPE *, const CALC_TYPE *, CALC_TYPE *,
+                         uint8_t *, int);
+/* a column of mixed operations, all in one pass */
+typedef void (*mixed_t)(const CALC_TYPE *, const char *, const CALC_TYPE *,
+                        CALC_TYPE *, uint8_t *, int);
+
+typedef struct {
+   const char * name;
+   column_t add, sub, mul, div;
+   mixed_t mixed; // NULL: by runs of one operation
+} kernels_t;
+
+/*
+ * The portable kernels: the backend's own operation, with the switch
+ * of calc_op() out of the loop
+ */
+#define COLUMN(name, op) \
+static void name(const CALC_TYPE * lhs, const CALC_TYPE * rhs, \
+                 CALC_TYPE * result, uint8_t * status, int n) { \
+   int i; /* used in for loop */ \
+   for (i = 0; i < n; ++i) { \
+      int s = CALC_OK; \
+      result[i] = op(lhs[i], rhs[i], &s); \
+      status[i] = (uint8_t)s; \
+   } \
+}
+
+COLUMN(add_portable, num_add)
+COLUMN(sub_portable, num_sub)
+COLUMN(mul_portable, num_mul)
+
+#if CALC_BACKEND == CALC_BACKEND_FLOAT || CALC_BACKEND == CALC_BACKEND_DOUBLE
+/*
+ * num_div() without its branch: the quotient (an infinity or NaN for
+ * a 0 divisor, which no one sees), then 0 wherever the divisor is 0
+ */
+static void div_portable(const CALC_TYPE * lhs, const CALC_TYPE * rhs,
+                         CALC_TYPE * result, uint8_t * status, int n) {
+   int i; // used in for loop
+   for (i = 0; i < n; ++i) {
+      CALC_TYPE q = lhs[i] / rhs[i];
+      result[i] = rhs[i] == 0 ? 0 : q;
+      status[i] = rhs[i] == 0 ? CALC_DIV_BY_ZERO : CALC_OK;
+   }
+}
+
+/*
+ * A column of mixed operations: every result of a pair, then the one
+ * its operation picks, with no branch for the compiler to keep
+ */
+static void mixed_portable(const CALC_TYPE * lhs, const char * ops,
+                           const CALC_TYPE * rhs, CALC_TYPE * result,
+                           uint8_t * status, int n) {
+   int i; // used in for loop
+   for (i = 0; i < n; ++i) {
+      CALC_TYPE a = lhs[i], b = rhs[i], q = a / b;
+      char op = ops[i];
+      uint8_t s = op == '/' ? (b == 0 ? CALC_DIV_BY_ZERO : CALC_OK)
+                : op == '+' || op == '-' || op == '*' ? CALC_OK : CALC_BAD_OP;
+      CALC_TYPE r = op == '+' ? a + b : op == '-' ? a - b
+                  : op == '*' ? a * b : op == '/' ? q : 0;
+      result[i] = s == CALC_OK ? r : 0;
+      status[i] = s;
+   }
+}
+
+static const kernels_t portable = {
+   "portable", add_portable, sub_portable, mul_portable, div_portable,
+   mixed_portable
+};
+#else
+COLUMN(div_portable, num_div)
+
+static const kernels_t portable = {
+   "portable", add_portable, sub_portable, mul_portable, div_portable, NULL
+};
+#endif
+
+#ifdef CALCVEC_AVX2
+/* the statuses of 4 pairs from a 4-bit lane mask, for one 32-bit store */
+static uint32_t lane_status(int mask, uint8_t error) {
+   uint8_t s[4];
+   uint32_t word;
+   int k; // used in for loop
+   for (k = 0; k < 4; ++k) {
+      s[k] = mask >> k & 1 ? error : CALC_OK;
+   }
+   memcpy(&word, s, 4);
+   return word;
+}
+
+static uint32_t lane_table[16]; // lane_status(mask, the backend's error)
+
+#if CALC_BACKEND == CALC_BACKEND_DOUBLE
+/*
+ * The double backend, 4 pairs at a time: add, subtract and multiply
+ * have no error, and divide is the portable one's quotient and select
+ */
+#define COLUMN_AVX2(name, intrinsic, op) \
+AVX2 static void name(const CALC_TYPE * lhs, const CALC_TYPE * rhs, \
+                      CALC_TYPE * result, uint8_t * status, int n) { \
+   int i = 0; \
+   for (; i + 4 <= n; i += 4) { \
+      _mm256_storeu_pd(&result[i], intrinsic(_mm256_loadu_pd(&lhs[i]), \
+                                             _mm256_loadu_pd(&rhs[i]))); \
+   } \
+   for (; i < n; ++i) { \
+      result[i] = lhs[i] op rhs[i]; \
+   } \
+   memset(status, CALC_OK, n); \
+}
+
+COLUMN_AVX2(add_avx2, _mm256_add_pd, +)
+COLUMN_AVX2(sub_avx2, _mm256_sub_pd, -)
+COLUMN_AVX2(mul_avx2, _mm256_mul_pd, *)
+
+AVX2 static void div_avx2(const CALC_TYPE * lhs, const CALC_TYPE * rhs,
+                          CALC_TYPE * result, uint8_t * status, int n) {
+   const __m256d zero = _mm256_setzero_pd();
+   int i = 0;
+   for (; i + 4 <= n; i += 4) {
+      __m256d b = _mm256_loadu_pd(&rhs[i]);
+      __m256d by_zero = _mm256_cmp_pd(b, zero, _CMP_EQ_OQ);
+      __m256d q = _mm256_div_pd(_mm256_loadu_pd(&lhs[i]), b);
+      _mm256_storeu_pd(&result[i], _mm256_andnot_pd(by_zero, q));
+      memcpy(&status[i], &lane_table[_mm256_movemask_pd(by_zero)], 4);
+   }
+   div_portable(&lhs[i], &rhs[i], &result[i], &status[i], n - i);
+}
+
+/*
+ * A column of mixed operations: all four results of 4 pairs, kept by
+ * lane masks from the operation bytes; a lane no mask keeps is 0 and
+ * CALC_BAD_OP, as in calc_op()
+ */
+AVX2 static void mixed_avx2(const CALC_TYPE * lhs, const char * ops,
+                            const CALC_TYPE * rhs, CALC_TYPE * result,
+                            uint8_t * status, int n) {
+   const __m256d zero = _mm256_setzero_pd();
+   int i = 0;
+   for (; i + 4 <= n; i += 4) {
+      int32_t bytes;
+      __m256i op;
+      __m256d a, b, is_add, is_sub, is_mul, is_div, by_zero, r;
+      int k, bad, zero_div; // k used in for loop
+      memcpy(&bytes, &ops[i], 4);
+      op = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(bytes));
+      is_add = _mm256_castsi256_pd(_mm256_cmpeq_epi64(op, _mm256_set1_epi64x('+')));
+      is_sub = _mm256_castsi256_pd(_mm256_cmpeq_epi64(op, _mm256_set1_epi64x('-')));
+      is_mul = _mm256_castsi256_pd(_mm256_cmpeq_epi64(op, _mm256_set1_epi64x('*')));
+      is_div = _mm256_castsi256_pd(_mm256_cmpeq_epi64(op, _mm256_set1_epi64x('/')));
+      a = _mm256_loadu_pd(&lhs[i]);
+      b = _mm256_loadu_pd(&rhs[i]);
+      by_zero = _mm256_and_pd(is_div, _mm256_cmp_pd(b, zero, _CMP_EQ_OQ));
+      r = _mm256_and_pd(is_add, _mm256_add_pd(a, b));
+      r = _mm256_or_pd(r, _mm256_and_pd(is_sub, _mm256_sub_pd(a, b)));
+      r = _mm256_or_pd(r, _mm256_and_pd(is_mul, _mm256_mul_pd(a, b)));
+      r = _mm256_or_pd(r, _mm256_and_pd(_mm256_andnot_pd(by_zero, is_div),
+                                        _mm256_div_pd(a, b)));
+      _mm256_storeu_pd(&result[i], r);
+      bad = ~_mm256_movemask_pd(_mm256_or_pd(_mm256_or_pd(is_add, is_sub),
+                                             _mm256_or_pd(is_mul, is_div)));
+      zero_div = _mm256_movemask_pd(by_zero);
+      for (k = 0; k < 4; ++k) {
+         status[i + k] = bad >> k & 1 ? CALC_BAD_OP
+                       : zero_div >> k & 1 ? CALC_DIV_BY_ZERO : CALC_OK;
+      }
+   }
+   for (; i < n; ++i) {
+      int s;
+      result[i] = calc_op(lhs[i], ops[i], rhs[i], &s);
+      status[i] = (uint8_t)s;
+   }
+}
+
+static const kernels_t avx2 = {
+   "avx2", add_avx2, sub_avx2, mul_avx2, div_avx2, mixed_avx2
+};
+
+#else /* CALC_BACKEND_FIXED */
+/*
+ * The fixed-point backend's add and subtract, 4 pairs at a time: the
+ * 64-bit result wrapped past the range when the operands' signs say
+ * it can't have the sign it has, which is num_add()'s and num_sub()'s
+ * comparisons in one go; those lanes are 0 and CALC_OVERFLOW
+ */
+AVX2 static void add_avx2(const CALC_TYPE * lhs, const CALC_TYPE * rhs,
+                          CALC_TYPE * result, uint8_t * status, int n) {
+   const __m256i zero = _mm256_setzero_si256();
+   int i = 0;
+   for (; i + 4 <= n; i += 4) {
+      __m256i a = _mm256_loadu_si256((const __m256i *)&lhs[i]);
+      __m256i b = _mm256_loadu_si256((const __m256i *)&rhs[i]);
+      __m256i sum = _mm256_add_epi64(a, b);
+      __m256i wrapped = _mm256_cmpgt_epi64(zero, _mm256_and_si256(
+            _mm256_xor_si256(a, sum), _mm256_xor_si256(b, sum)));
+      _mm256_storeu_si256((__m256i *)&result[i], _mm256_andnot_si256(wrapped, sum));
+      memcpy(&status[i],
+             &lane_table[_mm256_movemask_pd(_mm256_castsi256_pd(wrapped))], 4);
+   }
+   add_portable(&lhs[i], &rhs[i], &result[i], &status[i], n - i);
+}
+
+AVX2 static void sub_avx2(const CALC_TYPE * lhs, const CALC_TYPE * rhs,
+                          CALC_TYPE * result, uint8_t * status, int n) {
+   const __m256i zero = _mm256_setzero_si256();
+   int i = 0;
+   for (; i + 4 <= n; i += 4) {
+      __m256i a = _mm256_loadu_si256((const __m256i *)&lhs[i]);
+      __m256i b = _mm256_loadu_si256((const __m256i *)&rhs[i]);
+      __m256i difference = _mm256_sub_epi64(a, b);
+      __m256i wrapped = _mm256_cmpgt_epi64(zero, _mm256_and_si256(
+            _mm256_xor_si256(a, b), _mm256_xor_si256(a, difference)));
+      _mm256_storeu_si256((__m256i *)&result[i],
+                          _mm256_andnot_si256(wrapped, difference));
+      memcpy(&status[i],
+             &lane_table[_mm256_movemask_pd(_mm256_castsi256_pd(wrapped))], 4);
+   }
+   sub_portable(&lhs[i], &rhs[i], &result[i], &status[i], n - i);
+}
+
+// multiply and divide go through 128 bits in num.c, one pair at a time
+static const kernels_t avx2 = {
+   "avx2", add_avx2, sub_avx2, mul_portable, div_portable, NULL
+};
+#endif
+#endif /* CALCVEC_AVX2 */
+
+static const kernels_t * kernels; // NULL until the first column
+static int force_portable;
+
+/*
+ * The kernels for this CPU, chosen once
+ */
+static const kernels_t * choose(void) {
+   if (kernels == NULL) {
+      kernels = &portable;
+#ifdef CALCVEC_AVX2
+      if (!force_portable && __builtin_cpu_supports("avx2")) {
+         int mask; // used in for loop
+         for (mask = 0; mask < 16; ++mask) {
+#if CALC_BACKEND == CALC_BACKEND_DOUBLE
+            lane_table[mask] = lane_status(mask, CALC_DIV_BY_ZERO);
+#else
+            lane_table[mask] = lane_status(mask, CALC_OVERFLOW);
+#endif
+         }
+         kernels = &avx2;
+      }
+#endif
+   }
+   return kernels;
+}
+
+/*
+ * One operation on n pairs, by the kernel for it (0 and CALC_BAD_OP
+ * for what isn't an operation, as in calc_op())
+ */
+static void column(const kernels_t * k, char op, const CALC_TYPE * lhs,
+                   const CALC_TYPE * rhs, CALC_TYPE * result, uint8_t * status,
+                   int n) {
+   column_t kernel;
+   int i; // used in for loop
+   switch (op) {
+      case '+': kernel = k->add; break;
+      case '-': kernel = k->sub; break;
+      case '*': kernel = k->mul; break;
+      case '/': kernel = k->div; break;
+      default:
+         for (i = 0; i < n; ++i) {
+            result[i] = num_from_int(0);
+            status[i] = CALC_BAD_OP;
+         }
+         return;
+   }
+   kernel(lhs, rhs, result, status, n);
+}
+
+/**
+ * calc_op() on n pairs: result[i] = lhs[i] (ops[i], or op if ops is
+ * NULL) rhs[i], and status[i] its status
+ */
+void calcvec_op(const CALC_TYPE * lhs, const char * ops, char op,
+                const CALC_TYPE * rhs, CALC_TYPE * result, uint8_t * status,
+                int n) {
+   const kernels_t * k = choose();
+   int i, j; // used in for loops
+
+   if (ops == NULL) {
+      column(k, op, lhs, rhs, result, status, n);
+   }
+   else if (k->mixed != NULL) {
+      k->mixed(lhs, ops, rhs, result, status, n);
+   }
+   else {
+      // blocks of 8 with one operation go to its column kernel, the
+      // rest to calc_op(); one test per block, for random operations
+      // as much as for sorted ones
+      for (i = 0; i < n; i = j) {
+         uint64_t block, same = (uint8_t)ops[i] * 0x0101010101010101u;
+         for (j = i; j + 8 <= n; j += 8) {
+            memcpy(&block, &ops[j], 8);
+            if (block != same) {
+               break;
+            }
+         }
+         if (j > i) {
+            column(k, ops[i], &lhs[i], &rhs[i], &result[i], &status[i], j - i);
+         }
+         else {
+            for (j = i + 8 < n ? i + 8 : n; i < j; ++i) {
+               int s;
+               result[i] = calc_op(lhs[i], ops[i], rhs[i], &s);
+               status[i] = (uint8_t)s;
+            }
+         }
+      }
+   }
+}
+
+/**
+ * The kernels calcvec_op() uses: "avx2" or "portable"
+ */
+const char * calcvec_isa(void) {
+   return choose()->name;
+}
+
+/**
+ * Use the portable kernels (on != 0) or the best the CPU has
+ */
+void calcvec_portable(int on) {
+   force_portable = on;
+   kernels = NULL;
+}
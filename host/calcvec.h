@@ -0,0 +1,37 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/calcvec.h
+ * Description:
+ *      math_op() over columns: n lhs, n rhs, an operation for each
+ *      pair or one for all, n results and n statuses (CALC_OK,
+ *      CALC_DIV_BY_ZERO, ...), for checking millions of operand pairs
+ *      on a host. The results and statuses are calc_op()'s, bit for
+ *      bit; what changes is how they are computed:
+ *        - the operation is looked up once per column (or per run of
+ *          the same operation), not once per pair
+ *        - the binary floating-point backends divide without a branch
+ *          (a quotient, then 0 where the divisor is 0), so every loop
+ *          is one the compiler vectorizes
+ *        - on x86 built with GCC or Clang, the double backend (add,
+ *          subtract, multiply, divide and a mixed column) and the
+ *          fixed-point backend (add and subtract, with the overflow
+ *          check) have AVX2 kernels, used when the CPU has AVX2
+ *      The adaptive and decimal backends keep their number per pair
+ *      (a tag, a normalization), so they only get the first.
+ *      NOTE:
+ *              calcvec_portable(1) turns the AVX2 kernels off, e.g. to
+ *              compare them with the portable ones.
+ */
+#ifndef CALCVEC_H
+#define CALCVEC_H
+
+#include <stdint.h>
+#include "../calc.h"
+
+/* prototypes */
+void calcvec_op(const CALC_TYPE *, const char *, char, const CALC_TYPE *,
+                CALC_TYPE *, uint8_t *, int);
+const char * calcvec_isa(void);
+void calcvec_portable(int);
+
+#endif /* CALCVEC_H */
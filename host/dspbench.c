@@ -0,0 +1,211 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/dspbench.c
+ * Description:
+ *      Evaluates polynomials over a table of x with the Q15 and Q31
+ *      kernels (dsp.c), without a device:
+ *        - points per second for each kernel, for double precision
+ *          Horner, and for calc_eval_x() on the same function as text
+ *          (what plot.c does per point)
+ *        - the largest error of each kernel against double precision
+ *          at the same x, and in units of the result's last bit
+ *        - a checksum of the results: dspbench (the portable kernels)
+ *          and dspbench-packed (the M4 kernels, with the instructions
+ *          written in C) must print the same ones
+ *
+ *      usage: dspbench [-n runs] [-p points]
+ *             -n  how many times to run each table (default 200)
+ *             -p  points in the table (default 4096)
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../calc.h"
+#include "../dsp.h"
+
+#define MAX_POINTS 65536
+
+/* the polynomials: coefficients of x^0 up, the range of x, and the
+   same function for calc_eval_x() (left to right, so Horner's form) */
+static const struct {
+   const char * name;
+   int degree;
+   double coeffs[DSP_DEGREE + 1];
+   double x0, x1;
+   const char * text;
+} polys[] = {
+   { "cubic", 3, { 1, -2, 0, 1 }, -2, 2, "x*x-2*x+1" },
+   { "sin7", 7, { 0, 1, 0, -1.0 / 6, 0, 1.0 / 120, 0, -1.0 / 5040 },
+     -3.14159265, 3.14159265,
+     "0-0.000198412698*x*x+0.00833333333*x*x-0.166666667*x*x+1*x" },
+   { "exp8", 8, { 1, 1, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720,
+                  1.0 / 5040, 1.0 / 40320 },
+     0, 2, "x/8+1*x/7+1*x/6+1*x/5+1*x/4+1*x/3+1*x/2+1*x+1" },
+};
+
+static q15_t x15[MAX_POINTS], y15[MAX_POINTS];
+static q31_t x31[MAX_POINTS], y31[MAX_POINTS];
+static double yd[MAX_POINTS];
+
+/**
+ * The firmware's assert() shows the message on the GLCD
+ */
+void assert(const int condition, char * message) {
+   (void)condition;
+   (void)message;
+}
+
+static uint64_t now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*
+ * The polynomial at x, in double precision
+ */
+static double horner(const double * coeffs, int degree, double x) {
+   double y = coeffs[degree];
+   int k; // used in for loop
+   for (k = degree - 1; k >= 0; --k) {
+      y = y * x + coeffs[k];
+   }
+   return y;
+}
+
+/*
+ * FNV-1a over bytes, for the checksums
+ */
+static uint32_t fnv(uint32_t hash, const void * data, size_t length) {
+   const uint8_t * p = data;
+   while (length--) {
+      hash = (hash ^ *p++) * 16777619u;
+   }
+   return hash;
+}
+
+/*
+ * Print one line of results
+ */
+static void report(const char * kernel, uint64_t ns, long points,
+                   double error, double lsb, uint32_t checksum) {
+   printf("  %-12s %9.2f M points/s", kernel, points * 1e3 / ns);
+   if (lsb > 0) {
+      printf("  max error %.3g (%.2f lsb)  %08x", error, error / lsb,
+             (unsigned)checksum);
+   }
+   printf("\n");
+}
+
+int main(int argc, char ** argv) {
+   long runs = 200;
+   int points = 4096;
+   int opt, k;
+
+   while ((opt = getopt(argc, argv, "n:p:")) != -1) {
+      switch (opt) {
+         case 'n': runs = atol(optarg); break;
+         case 'p': points = atoi(optarg); break;
+         default:
+            fprintf(stderr, "usage: %s [-n runs] [-p points]\n", argv[0]);
+            return 2;
+      }
+   }
+   if (runs < 1) {
+      runs = 1;
+   }
+   if (points < 1 || points > MAX_POINTS) {
+      points = MAX_POINTS;
+   }
+
+#ifdef DSP_PACKED
+   printf("kernels: packed (M4 instructions in C)\n");
+#else
+   printf("kernels: portable C\n");
+#endif
+   // u from -1 up across the table, in both formats
+   for (k = 0; k < points; ++k) {
+      double u = -1 + 2.0 * k / points;
+      x15[k] = dsp_q15(u);
+      x31[k] = dsp_q31(u);
+   }
+
+   for (k = 0; k < (int)(sizeof(polys) / sizeof(polys[0])); ++k) {
+      const double * c = polys[k].coeffs;
+      int degree = polys[k].degree;
+      double mid = (polys[k].x0 + polys[k].x1) / 2;
+      double half = (polys[k].x1 - polys[k].x0) / 2;
+      double scaled[DSP_DEGREE + 1], scale, error;
+      q15_t c15[DSP_DEGREE + 1];
+      q31_t c31[DSP_DEGREE + 1];
+      volatile double sink = 0;
+      uint64_t start, ns;
+      long run, evals;
+      int shift, j, status;
+
+      shift = dsp_poly_prepare(c, degree, polys[k].x0, polys[k].x1, scaled);
+      scale = ldexp(1, shift);
+      for (j = 0; j <= degree; ++j) {
+         c15[j] = dsp_q15(scaled[j]);
+         c31[j] = dsp_q31(scaled[j]);
+      }
+      printf("%s, degree %d over [%g, %g], %d points, results / 2^%d\n",
+             polys[k].name, degree, polys[k].x0, polys[k].x1, points, shift);
+
+      start = now_ns();
+      for (run = 0; run < runs; ++run) {
+         dsp_poly_q15(c15, degree, x15, y15, points);
+      }
+      ns = now_ns() - start;
+      error = 0;
+      for (j = 0; j < points; ++j) {
+         double x = mid + half * dsp_from_q15(x15[j]);
+         double e = fabs(dsp_from_q15(y15[j]) * scale - horner(c, degree, x));
+         error = e > error ? e : error;
+      }
+      report("dsp_poly_q15", ns, points * runs, error, scale / 32768,
+             fnv(2166136261u, y15, points * sizeof(y15[0])));
+
+      start = now_ns();
+      for (run = 0; run < runs; ++run) {
+         dsp_poly_q31(c31, degree, x31, y31, points);
+      }
+      ns = now_ns() - start;
+      error = 0;
+      for (j = 0; j < points; ++j) {
+         double x = mid + half * dsp_from_q31(x31[j]);
+         double e = fabs(dsp_from_q31(y31[j]) * scale - horner(c, degree, x));
+         error = e > error ? e : error;
+      }
+      report("dsp_poly_q31", ns, points * runs, error, scale / 2147483648.0,
+             fnv(2166136261u, y31, points * sizeof(y31[0])));
+
+      start = now_ns();
+      for (run = 0; run < runs; ++run) {
+         for (j = 0; j < points; ++j) {
+            yd[j] = horner(c, degree, mid + half * dsp_from_q31(x31[j]));
+         }
+         sink += yd[run % points];
+      }
+      ns = now_ns() - start;
+      report("double", ns, points * runs, 0, 0, 0);
+
+      // calc_eval_x() is far slower; a tenth of the runs is plenty
+      evals = runs / 10 > 0 ? runs / 10 : 1;
+      start = now_ns();
+      for (run = 0; run < evals; ++run) {
+         for (j = 0; j < points; ++j) {
+            CALC_TYPE x = num_from_double(mid + half * dsp_from_q31(x31[j]));
+            sink += num_to_double(calc_eval_x(polys[k].text,
+                                              strlen(polys[k].text), x,
+                                              &status));
+         }
+      }
+      ns = now_ns() - start;
+      report("calc_eval_x", ns, points * evals, 0, 0, 0);
+   }
+   return 0;
+}
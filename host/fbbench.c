@@ -0,0 +1,410 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/fbbench.c
+ * Description:
+ *      Measures the display path on the PCD8544 emulator (pcd8544.c),
+ *      with a stream of random keys through the calculator and the
+ *      frame slots of render.c, RENDER_HZ a second, two ways:
+ *        - direct: what display_current_state() did before the
+ *          framebuffer, GLCD_clear() and the text, each byte waited for
+ *        - double: the double-buffered framebuffer (fb.c), drawn while
+ *          the last frame is flushed and sending only what changed,
+ *          with only the entry on the display
+ *        - tape: the same with the paper tape (tape.c) above the
+ *          entry, as display_current_state() draws it, scrolling at
+ *          each completed calculation
+ *      For each it prints the frames that reached the display and
+ *      their rate, the SPI bytes per frame, the CPU time per frame,
+ *      the key to display latency percentiles, and how often the
+ *      display didn't show the frame it was sent (which would tear).
+ *      Time is simulated: the SPI clock, and CPU cycles for the work
+ *      between the bytes (see the constants below).
+ *
+ *      usage: fbbench [-n keys] [-g ms] [-f hz] [-s spi hz] [-p]
+ *             -n  keys (default 2000)
+ *             -g  gap between keys (default 5)
+ *             -f  frame slots per second (default 60; 0 redraws as
+ *                 soon as the last frame is out)
+ *             -s  SPI clock (default 1000000, SPI_CLOCK in main.c)
+ *             -p  print the display at the end
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "pcd8544.h"
+#include "../calc.h"
+#include "../fb.h"
+#include "../font.h"
+#include "../tape.h"
+
+#define CPU_HZ 3000000   /* MCLK after SystemInit() */
+#define WAIT_CYCLES 20   /* SPI_write() around each byte it waits for */
+#define ISR_CYCLES 40    /* EUSCIB0_IRQHandler() for each byte */
+#define DRAW_CYCLES 3000 /* fb_clear() and the text into the back buffer */
+#define PRECISION 4      /* fractional digits displayed, as in main.c */
+
+/* ways of displaying */
+#define MODE_DIRECT 0
+#define MODE_DOUBLE 1
+#define MODE_TAPE   2
+
+/* a frame as drawn: what the display should show, and the keys in it */
+typedef struct {
+   uint8_t ram[FB_BANKS][FB_WIDTH];
+   int keys;
+   int shown;
+} frame_t;
+
+typedef struct {
+   int frames;          // frames that reached the display
+   int missed;          // frame slots lost to a busy CPU
+   int replaced;        // finished frames drawn over before the flush
+   int mismatches;      // flushes that left another frame on display
+   unsigned long bytes; // SPI bytes, commands included
+   double cpu_us;       // CPU time spent on the display
+   double end_us;       // when the last frame was on the display
+   double * latency;    // key to display, one per key
+   int shown;           // keys on the display so far
+} result_t;
+
+static int key_count = 2000;
+static double key_gap_us = 5000, slot_us = 1000000.0 / 60;
+static uint32_t spi_hz = 1000000;
+static uint8_t * keys;
+static pcd8544_t lcd;
+
+/**
+ * The firmware's assert() shows the message on the GLCD
+ */
+void assert(const int condition, char * message) {
+   (void)condition;
+   (void)message;
+}
+
+/*
+ * The line display_current_state() shows
+ */
+static void format_line(char * text, int size) {
+   int length = calc_format(calc.lhs, PRECISION, text, size);
+   if (calc.operation != '\0' && calc.operation != '=') {
+      text[length++] = calc.operation;
+      calc_format(calc.rhs, PRECISION, &text[length], size - length);
+   }
+}
+
+/*
+ * Record the latency of the keys a frame on the display shows
+ */
+static void show(result_t * result, frame_t * frame, double at) {
+   for (; result->shown < frame->keys; ++result->shown) {
+      result->latency[result->shown] = at - result->shown * key_gap_us;
+   }
+   frame->shown = 1;
+   ++result->frames;
+   result->end_us = at;
+}
+
+/*
+ * The old way: clear the display and write the text, one byte after
+ * the other, the CPU waiting on each
+ */
+static double draw_direct(result_t * result, frame_t * frame) {
+   char text[2 * CALC_FORMAT_SIZE(PRECISION) + 1];
+   const char * str = text;
+   uint8_t columns[FB_WIDTH];
+   int bytes = 0, bank = 0, k;
+
+   format_line(text, sizeof(text));
+   memset(frame->ram, 0, sizeof(frame->ram));
+   // GLCD_clear()
+   for (k = 0; k < FB_BANKS * FB_WIDTH; ++k) {
+      pcd8544_write(&lcd, 1, 0x00);
+   }
+   pcd8544_write(&lcd, 0, 0x80);
+   pcd8544_write(&lcd, 0, 0x40);
+   bytes += FB_BANKS * FB_WIDTH + 2;
+   // GLCD_putpstr()
+   while (*str != '\0' && bank < FB_BANKS) {
+      int length = font_fit(str, FB_WIDTH, NULL);
+      int count = font_render(str, length, columns);
+      memcpy(frame->ram[bank], columns, count);
+      pcd8544_write(&lcd, 0, 0x80);
+      pcd8544_write(&lcd, 0, 0x40 | bank);
+      for (k = 0; k < count; ++k) {
+         pcd8544_write(&lcd, 1, columns[k]);
+      }
+      bytes += 2 + count;
+      str += length;
+      ++bank;
+   }
+   if (memcmp(lcd.ram, frame->ram, sizeof(frame->ram)) != 0) {
+      ++result->mismatches;
+   }
+   result->bytes += bytes;
+   return bytes * (lcd.spi_us + WAIT_CYCLES * 1e6 / CPU_HZ);
+}
+
+/*
+ * The new ways: the frame into the back buffer, the entry alone or
+ * under the tape like display_current_state()
+ */
+static void draw_buffered(frame_t * frame, int mode) {
+   char text[2 * CALC_FORMAT_SIZE(PRECISION) + 1];
+   const char * str = text;
+   int bank = 0;
+
+   format_line(text, sizeof(text));
+   if (mode == MODE_TAPE) {
+      tape_render();
+      tape_entry(text);
+      memcpy(frame->ram, fb, sizeof(frame->ram));
+      return;
+   }
+   fb_clear();
+   while (*str != '\0' && bank < FB_BANKS) {
+      int length = font_fit(str, FB_WIDTH, NULL);
+      font_render(str, length, fb[bank]);
+      str += length;
+      ++bank;
+   }
+   memcpy(frame->ram, fb, sizeof(frame->ram));
+}
+
+/*
+ * Run the key stream through one way of displaying it
+ */
+static void simulate(int mode, result_t * result) {
+   static frame_t frames[2]; // double: on the way, waiting
+   frame_t * on_way = &frames[0], * waiting = &frames[1];
+   frame_t direct;
+   double draw_us = DRAW_CYCLES * 1e6 / CPU_HZ;
+   double byte_us; // the shifter or the ISR, whichever is slower
+   double t = 0, slot_at = 0, cpu_free = 0, present_at = -1, byte_at = -1;
+   int next_key = 0, processed = 0, dirty = 0, has_waiting = 0;
+   int sending = 0, dc = 0;
+   uint8_t byte = 0;
+
+   memset(result, 0, sizeof(*result));
+   result->latency = calloc(key_count, sizeof(double));
+   pcd8544_init(&lcd, spi_hz);
+   byte_us = lcd.spi_us > ISR_CYCLES * 1e6 / CPU_HZ
+             ? lcd.spi_us : ISR_CYCLES * 1e6 / CPU_HZ;
+   calc_reset(&calc);
+   tape_clear();
+   on_way->shown = 1;
+   fb_invalidate(); // the display starts cleared; send the first frame whole
+
+   while (next_key < key_count || dirty || sending || present_at >= 0) {
+      // the next event: a key, a frame slot, a present, an SPI byte
+      double key_at = next_key < key_count ? next_key * key_gap_us : 1e300;
+      double at = key_at;
+      int event = 0;
+      if (dirty && slot_at < at) {
+         at = slot_at;
+         event = 1;
+      }
+      // a present or a byte goes before a frame slot at the same time
+      if (present_at >= 0 && present_at <= at) {
+         at = present_at;
+         event = 2;
+      }
+      if (sending && byte_at <= at) {
+         at = byte_at;
+         event = 3;
+      }
+      t = at;
+
+      if (event == 0) {
+         calc_state_t before = calc;
+         if (calc_key(keys[next_key++]) && mode == MODE_TAPE) {
+            tape_calculation(&before, &calc, PRECISION);
+         }
+         processed = next_key;
+         dirty = 1;
+         // a slot stays open while nothing changes (see render.h)
+         if (slot_at < t) {
+            slot_at = t;
+         }
+      }
+      else if (event == 1) {
+         // a frame slot
+         // SysTick opens the next one
+         slot_at = slot_us > 0 ? (floor(t / slot_us) + 1) * slot_us : t;
+         if (t < cpu_free || present_at >= 0) {
+            if (slot_us > 0) {
+               ++result->missed;
+            }
+            else {
+               slot_at = present_at >= 0 ? present_at : cpu_free;
+            }
+            continue;
+         }
+         dirty = 0;
+         if (mode == MODE_DIRECT) {
+            double took = draw_direct(result, &direct);
+            direct.keys = processed;
+            cpu_free = t + took;
+            result->cpu_us += took;
+            show(result, &direct, cpu_free);
+            if (slot_us == 0) {
+               slot_at = cpu_free;
+            }
+            continue;
+         }
+         fb_begin();
+         if (has_waiting) {
+            has_waiting = 0;
+            ++result->replaced;
+         }
+         draw_buffered(waiting, mode);
+         waiting->keys = processed;
+         waiting->shown = 0;
+         present_at = t + draw_us;
+         cpu_free = present_at;
+         result->cpu_us += draw_us;
+      }
+      else if (event == 2) {
+         present_at = -1;
+         if (slot_us == 0) {
+            slot_at = t;
+         }
+         if (fb_present()) {
+            frame_t * swap = on_way;
+            on_way = waiting;
+            waiting = swap;
+            sending = 1;
+            byte_at = t;
+            dc = -1; // no byte in the shifter yet
+         }
+         else if (fb_flushing()) {
+            has_waiting = 1;
+         }
+         else {
+            show(result, waiting, t); // the same frame again
+         }
+      }
+      else {
+         // the byte in the shifter is out: it's on the display
+         uint32_t flushes = fb_flushes;
+         int kind;
+         if (dc >= 0) {
+            pcd8544_write(&lcd, dc, byte);
+         }
+         if (!on_way->shown
+             && memcmp(lcd.ram, on_way->ram, sizeof(on_way->ram)) == 0) {
+            show(result, on_way, t);
+         }
+         kind = fb_flush_next(&byte);
+         if (fb_flushes != flushes || kind == FB_SEND_NONE) {
+            // the flush of on_way is done, another may follow
+            if (!on_way->shown) {
+               ++result->mismatches;
+               show(result, on_way, t);
+            }
+            if (has_waiting) {
+               frame_t * swap = on_way;
+               on_way = waiting;
+               waiting = swap;
+               has_waiting = 0;
+               if (kind == FB_SEND_NONE) {
+                  show(result, on_way, t); // the same as the last one
+               }
+            }
+         }
+         if (kind == FB_SEND_NONE) {
+            sending = 0;
+            continue;
+         }
+         dc = kind == FB_SEND_DATA;
+         byte_at = t + byte_us;
+         ++result->bytes;
+         result->cpu_us += ISR_CYCLES * 1e6 / CPU_HZ;
+      }
+   }
+   if (mode != MODE_DIRECT && memcmp(lcd.ram, on_way->ram, sizeof(on_way->ram)) != 0) {
+      ++result->mismatches; // the last frame never made it
+   }
+}
+
+static int compare(const void * a, const void * b) {
+   double x = *(const double *)a, y = *(const double *)b;
+   return x < y ? -1 : x > y;
+}
+
+/*
+ * Print one way's results
+ */
+static void report(const char * name, result_t * result) {
+   double seconds = result->end_us / 1e6;
+   int n = result->shown;
+   qsort(result->latency, n, sizeof(double), compare);
+   printf("%-8s %7d %7.1f %9.1f %8.2f %8.2f %8.2f %8.2f %6.1f %6d %4d\n",
+          name, result->frames, seconds > 0 ? result->frames / seconds : 0,
+          result->frames ? (double)result->bytes / result->frames : 0,
+          result->frames ? result->cpu_us / result->frames / 1000 : 0,
+          n ? result->latency[n / 2] / 1000 : 0,
+          n ? result->latency[n * 99 / 100] / 1000 : 0,
+          n ? result->latency[n - 1] / 1000 : 0,
+          seconds, result->missed, result->replaced);
+}
+
+int main(int argc, char ** argv) {
+   int print = 0;
+   int opt, k;
+   result_t direct, buffered, tape;
+
+   while ((opt = getopt(argc, argv, "n:g:f:s:p")) != -1) {
+      switch (opt) {
+         case 'n': key_count = atoi(optarg); break;
+         case 'g': key_gap_us = atof(optarg) * 1000; break;
+         case 'f': slot_us = atof(optarg) > 0 ? 1e6 / atof(optarg) : 0; break;
+         case 's': spi_hz = atoi(optarg); break;
+         case 'p': print = 1; break;
+         default:
+            fprintf(stderr, "usage: %s [-n keys] [-g ms] [-f hz] "
+                    "[-s spi hz] [-p]\n", argv[0]);
+            return 2;
+      }
+   }
+   if (key_count < 1 || spi_hz < 1) {
+      fprintf(stderr, "fbbench: nothing to do\n");
+      return 2;
+   }
+   keys = malloc(key_count);
+   srand(1);
+   for (k = 0; k < key_count; ++k) {
+      keys[k] = rand() % 16;
+   }
+   simulate(MODE_DIRECT, &direct);
+   simulate(MODE_DOUBLE, &buffered);
+   simulate(MODE_TAPE, &tape);
+
+   printf("%d keys %.1f ms apart, %s, SPI at %u Hz, CPU at %u Hz\n\n",
+          key_count, key_gap_us / 1000,
+          slot_us > 0 ? "frame slots" : "no frame limit", spi_hz, CPU_HZ);
+   if (slot_us > 0) {
+      printf("(%.0f frame slots per second)\n", 1e6 / slot_us);
+   }
+   printf("%-8s %7s %7s %9s %8s %8s %8s %8s %6s %6s %4s\n", "", "frames",
+          "fps", "bytes/f", "cpu ms/f", "p50 ms", "p99 ms", "max ms",
+          "secs", "missed", "repl");
+   report("direct", &direct);
+   report("double", &buffered);
+   report("tape", &tape);
+   printf("(seconds until the last frame; frame slots missed by a busy "
+          "CPU; frames drawn over before their flush)\n");
+   if (direct.mismatches || buffered.mismatches || tape.mismatches) {
+      printf("MISMATCH: the display didn't show %d + %d + %d frames it "
+             "was sent\n", direct.mismatches, buffered.mismatches,
+             tape.mismatches);
+   }
+   else {
+      printf("every frame on the emulated display as drawn\n");
+   }
+   if (print) {
+      pcd8544_print(&lcd);
+   }
+   return 0;
+}
@@ -0,0 +1,185 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/fontbench.c
+ * Description:
+ *      Compares the proportional font (font.c) with the fixed 6-column
+ *      font_table on calculator results formatted like the display
+ *      shows them (calc_format()), without a device:
+ *        - digits per 84-pixel line
+ *        - lines and SPI bytes per number (the proportional font sends
+ *          only its columns, plus a cursor command per line)
+ *        - the host time to measure and lay out a number
+ *      Given some text, it draws the text in the proportional font
+ *      instead, with its width.
+ *
+ *      usage: fontbench [-n numbers] [text ...]
+ *             -n  how many random results to compare (default 100000)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../calc.h"
+#include "../font.h"
+
+#define WIDTH 84         /* pixels on a line of the GLCD */
+#define FIXED_COLUMNS 6  /* columns of a font_table glyph */
+#define PRECISION 4      /* fractional digits displayed, as in main.c */
+
+/**
+ * The firmware's assert() shows the message on the GLCD
+ */
+void assert(const int condition, char * message) {
+   (void)condition;
+   (void)message;
+}
+
+static uint64_t now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*
+ * Draw text in the proportional font, one row of pixels per line
+ */
+static void preview(const char * text) {
+   uint8_t columns[1024];
+   int length = strlen(text);
+   int count, row, col;
+   if (font_measure(text, length) > (int)sizeof(columns)) {
+      length = font_fit(text, sizeof(columns), NULL);
+   }
+   count = font_render(text, length, columns);
+   printf("%s: %d pixels, %d in font_table\n", text, count,
+          FIXED_COLUMNS * length);
+   for (row = 0; row < FONT_HEIGHT; ++row) {
+      for (col = 0; col < count; ++col) {
+         putchar((columns[col] >> row) & 1 ? '#' : '.');
+      }
+      putchar('\n');
+   }
+}
+
+/*
+ * A result like the keypad makes: a whole number, an amount with
+ * cents, or a quotient; a few of them negative
+ */
+static double random_result(void) {
+   double value;
+   switch (rand() % 3) {
+      case 0:
+         value = rand() % 1000000;
+         break;
+      case 1:
+         value = (rand() % 1000000) / 100.0;
+         break;
+      default:
+         value = (double)(rand() % 100000) / (1 + rand() % 999);
+         break;
+   }
+   return (rand() % 8 == 0) ? -value : value;
+}
+
+/*
+ * The lines the GLCD_putpstr() layout takes for text
+ */
+static int proportional_lines(const char * text, int * pixels) {
+   int lines = 0, line_pixels;
+   *pixels = 0;
+   while (*text != '\0') {
+      text += font_fit(text, WIDTH, &line_pixels);
+      *pixels += line_pixels;
+      ++lines;
+   }
+   return lines;
+}
+
+int main(int argc, char ** argv) {
+   int count = 100000;
+   int opt, k, d; // used in for loops
+   char text[CALC_FORMAT_SIZE(PRECISION)];
+   char digits[64];
+   unsigned long long chars = 0, fixed_lines = 0, prop_lines = 0;
+   unsigned long long fixed_bytes = 0, prop_bytes = 0;
+   int fixed_fit = WIDTH / FIXED_COLUMNS, fit_min = WIDTH, fit_max = 0;
+   double fit_sum = 0;
+   uint64_t start;
+   volatile int sink = 0;
+
+   while ((opt = getopt(argc, argv, "n:")) != -1) {
+      switch (opt) {
+         case 'n': count = atoi(optarg); break;
+         default:
+            fprintf(stderr, "usage: %s [-n numbers] [text ...]\n", argv[0]);
+            return 2;
+      }
+   }
+   if (optind < argc) {
+      for (; optind < argc; ++optind) {
+         preview(argv[optind]);
+      }
+      return 0;
+   }
+
+   // digits per line: random digit strings, and each digit on its own
+   srand(1);
+   for (k = 0; k < 10000; ++k) {
+      int fit;
+      for (d = 0; d < (int)sizeof(digits) - 1; ++d) {
+         digits[d] = '0' + rand() % 10;
+      }
+      digits[d] = '\0';
+      fit = font_fit(digits, WIDTH, NULL);
+      fit_sum += fit;
+      fit_min = fit < fit_min ? fit : fit_min;
+      fit_max = fit > fit_max ? fit : fit_max;
+   }
+   printf("digits per line: font_table %d, proportional %.1f "
+          "(%d to %d)\n", fixed_fit, fit_sum / 10000, fit_min, fit_max);
+   printf("  one digit repeated:");
+   for (d = 0; d < 10; ++d) {
+      memset(digits, '0' + d, sizeof(digits) - 1);
+      digits[sizeof(digits) - 1] = '\0';
+      printf(" %d:%d", d, font_fit(digits, WIDTH, NULL));
+   }
+   printf("\n\n");
+
+   // the same results in both fonts
+   srand(2);
+   for (k = 0; k < count; ++k) {
+      int length = calc_format(num_from_double(random_result()), PRECISION,
+                               text, sizeof(text));
+      int pixels, lines = proportional_lines(text, &pixels);
+      chars += length;
+      fixed_lines += (length + fixed_fit - 1) / fixed_fit;
+      fixed_bytes += FIXED_COLUMNS * length; // the GLCD wraps by itself
+      prop_lines += lines;
+      prop_bytes += pixels + 2 * lines;      // columns, cursor commands
+   }
+   printf("%d results, %.1f characters each\n", count,
+          (double)chars / count);
+   printf("%-14s %10s %10s\n", "", "lines", "SPI bytes");
+   printf("%-14s %10.3f %10.1f\n", "font_table",
+          (double)fixed_lines / count, (double)fixed_bytes / count);
+   printf("%-14s %10.3f %10.1f  (%.0f%% fewer bytes)\n", "proportional",
+          (double)prop_lines / count, (double)prop_bytes / count,
+          100.0 - 100.0 * prop_bytes / fixed_bytes);
+
+   // the cost of the layout pass
+   calc_format(num_from_double(-12345.6789), PRECISION, text, sizeof(text));
+   start = now_ns();
+   for (k = 0; k < 1000000; ++k) {
+      sink += font_measure(text, 0x7FFF);
+   }
+   printf("\nfont_measure(\"%s\") %.1f ns\n", text,
+          (now_ns() - start) / 1e6);
+   start = now_ns();
+   for (k = 0; k < 1000000; ++k) {
+      uint8_t columns[WIDTH];
+      sink += font_render(text, font_fit(text, WIDTH, NULL), columns);
+   }
+   printf("font_fit + font_render %.1f ns\n", (now_ns() - start) / 1e6);
+   return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/linkbench.c
+ * Description:
+ *      Exercises the host link (see link.h) and measures it:
+ *        1. round-trip latency of LINK_PING / LINK_PONG
+ *        2. key events per second with keys injected through
+ *           LINK_INJECT, up to a window of keys in flight, plus the
+ *           latency from injection to the device's LINK_KEY event
+ *      The same keys run through a local copy of calc.c, and the final
+ *      display state must match the one the device reports. Last, it
+ *      prints the device's stack usage (LINK_STACK_QUERY).
+ *
+ *      usage: linkbench [-n pings] [-k keys] [-w window] [serial port]
+ *             without a serial port the board stand-in runs on a pty
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "standin.h"
+#include "linkio.h"
+#include "../calc.h"
+#include "../link.h"
+#include "../stackmon.h"
+
+#define TIMEOUT_MS 2000
+
+/* keys typed over and over: 12+34=  5.5*6=  78-9=  96/4=  ## */
+static const uint8_t script[] = {
+   1, 2, KEY_ADD, 3, 4, KEY_EQUALS,
+   5, KEY_DECIMAL, 5, KEY_MULTIPLY, 6, KEY_EQUALS,
+   7, 8, KEY_SUBTRACT, 9, KEY_EQUALS,
+   9, 6, KEY_DIVIDE, 4, KEY_EQUALS, KEY_EQUALS,
+};
+
+/*
+ * Print a LINK_STACK report
+ */
+static void print_stack(const link_frame_t * frame) {
+   static const char * names[STACK_ISR_COUNT] = { "port 1", "port 3", "uart",
+                                                    "pendsv" };
+   const uint8_t * p = frame->payload;
+   int isr; // used in for loop
+   unsigned size = p[0] | (p[1] << 8);
+
+   if (size == 0) {
+      printf("stack: not measured (board stand-in)\n");
+      return;
+   }
+   printf("stack: %u bytes, high water %u bytes, up to %u handlers nested\n",
+          size, p[2] | (p[3] << 8), p[4]);
+   for (isr = 0; isr < STACK_ISR_COUNT; ++isr) {
+      const uint8_t * h = &p[5 + 6 * isr];
+      printf("  %-6s entered %u times, deepest entry %u bytes\n", names[isr],
+             link_get_u32(&h[2]), h[0] | (h[1] << 8));
+   }
+}
+
+int main(int argc, char ** argv) {
+   int pings = 1000, keys = 20000, window = 16;
+   int opt, fd, k;
+   pid_t child = 0;
+   linkio_t io;
+   link_frame_t frame;
+   uint64_t * rtt, * key_latency, * sent_at;
+   uint64_t start, elapsed;
+   int sent = 0, acked = 0, frames = 0, results = 0;
+   double shown_lhs = 0;
+
+   while ((opt = getopt(argc, argv, "n:k:w:")) != -1) {
+      switch (opt) {
+         case 'n': pings = atoi(optarg); break;
+         case 'k': keys = atoi(optarg); break;
+         case 'w': window = atoi(optarg); break;
+         default:
+            fprintf(stderr, "usage: %s [-n pings] [-k keys] [-w window] "
+                            "[serial port]\n", argv[0]);
+            return 2;
+      }
+   }
+   if (optind < argc) {
+      fd = link_open(argv[optind]);
+   }
+   else {
+      child = standin_spawn(&fd);
+   }
+   linkio_init(&io, fd);
+
+   /* the stand-in says hello first; a board may have done so at boot */
+   if (linkio_read(&io, &frame, child ? TIMEOUT_MS : 200) == 1
+       && frame.type == LINK_HELLO) {
+      printf("device: link v%u, %u timestamp ticks/s\n", frame.payload[0],
+             link_get_u32(&frame.payload[1]));
+   }
+
+   /* round-trip latency */
+   rtt = calloc(pings, sizeof(*rtt));
+   for (k = 0; k < pings; ++k) {
+      uint8_t token[4];
+      uint64_t t0 = now_ns();
+      link_put_u32(token, k);
+      linkio_send(&io, LINK_PING, token, sizeof(token));
+      do {
+         if (linkio_read(&io, &frame, TIMEOUT_MS) != 1) {
+            fprintf(stderr, "linkbench: ping %d timed out\n", k);
+            return 1;
+         }
+      } while (frame.type != LINK_PONG || link_get_u32(frame.payload) != k);
+      rtt[k] = now_ns() - t0;
+   }
+   printf("ping rtt over %d: p50 %.1f us, p99 %.1f us, max %.1f us\n", pings,
+          percentile(rtt, pings, 50) / 1e3, percentile(rtt, pings, 99) / 1e3,
+          percentile(rtt, pings, 100) / 1e3);
+
+   /* key injection throughput */
+   key_latency = calloc(keys, sizeof(*key_latency));
+   sent_at = calloc(keys, sizeof(*sent_at));
+   start = now_ns();
+   while (acked < keys) {
+      while (sent < keys && sent - acked < window) {
+         uint8_t key = script[sent % sizeof(script)];
+         sent_at[sent++] = now_ns();
+         linkio_send(&io, LINK_INJECT, &key, 1);
+         calc_key(key); // the local model
+      }
+      if (linkio_read(&io, &frame, TIMEOUT_MS) != 1) {
+         fprintf(stderr, "linkbench: lost the device after %d keys\n", acked);
+         return 1;
+      }
+      ++frames;
+      if (frame.type == LINK_KEY && frame.payload[1] == LINK_SRC_HOST) {
+         key_latency[acked] = now_ns() - sent_at[acked];
+         ++acked;
+      }
+      else if (frame.type == LINK_RESULT) {
+         ++results;
+      }
+      else if (frame.type == LINK_DISPLAY) {
+         shown_lhs = link_get_f64(frame.payload);
+      }
+   }
+   /* drain the result and display frames after the last key event */
+   while (linkio_read(&io, &frame, 100) == 1) {
+      ++frames;
+      if (frame.type == LINK_DISPLAY) {
+         shown_lhs = link_get_f64(frame.payload);
+      }
+      else if (frame.type == LINK_RESULT) {
+         ++results;
+      }
+   }
+   elapsed = now_ns() - start;
+
+   printf("keys: %d in %.3f s = %.0f key events/s, %.0f frames/s "
+          "(%d results)\n", keys, elapsed / 1e9, keys / (elapsed / 1e9),
+          frames / (elapsed / 1e9), results);
+   printf("inject -> key event: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+          percentile(key_latency, keys, 50) / 1e3,
+          percentile(key_latency, keys, 99) / 1e3,
+          percentile(key_latency, keys, 100) / 1e3);
+   printf("crc errors: %u\n", io.rx.crc_errors);
+
+   if (shown_lhs != num_to_double(calc.lhs)) {
+      printf("MISMATCH: device shows %.17g, local calc.c has %.17g\n",
+             shown_lhs, num_to_double(calc.lhs));
+      return 1;
+   }
+   printf("final state matches the local calc.c (lhs %.17g)\n",
+          num_to_double(calc.lhs));
+
+   /* how much stack the run took on the device */
+   linkio_send(&io, LINK_STACK_QUERY, NULL, 0);
+   while (linkio_read(&io, &frame, TIMEOUT_MS) == 1) {
+      if (frame.type == LINK_STACK && frame.len >= 5 + 6 * STACK_ISR_COUNT) {
+         print_stack(&frame);
+         break;
+      }
+   }
+
+   if (child) {
+      close(fd);
+      kill(child, SIGTERM);
+      waitpid(child, NULL, 0);
+   }
+   return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/linkio.c
+ * Description:
+ *      Reads and writes link frames (see link.h) on a pty or serial
+ *      port, and the latency statistics the link tools report.
+ */
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "linkio.h"
+
+static uint8_t host_seq = 0; // sequence number of the next host frame
+
+/**
+ * Start reading frames from fd
+ */
+void linkio_init(linkio_t * io, int fd) {
+   memset(io, 0, sizeof(*io));
+   io->fd = fd;
+}
+
+/**
+ * Wait up to timeout_ms for the next good frame
+ * Returns 1 with the frame filled in, 0 on timeout, -1 if the link
+ * closed
+ */
+int linkio_read(linkio_t * io, link_frame_t * frame, int timeout_ms) {
+   for (;;) {
+      while (io->next < io->count) {
+         if (link_rx_byte(&io->rx, io->buf[io->next++], frame)) {
+            return 1;
+         }
+      }
+      struct pollfd pfd = { io->fd, POLLIN, 0 };
+      int ready = poll(&pfd, 1, timeout_ms);
+      if (ready < 0 && errno == EINTR) {
+         continue;
+      }
+      if (ready <= 0) {
+         return 0;
+      }
+      ssize_t n = read(io->fd, io->buf, sizeof(io->buf));
+      if (n <= 0) {
+         return -1;
+      }
+      io->count = n;
+      io->next = 0;
+   }
+}
+
+/**
+ * Encode and write one frame
+ */
+void linkio_send(linkio_t * io, uint8_t type, const uint8_t * payload,
+                 uint8_t len) {
+   uint8_t frame[LINK_MAX_FRAME];
+   uint16_t n = link_encode(frame, type, host_seq++, payload, len);
+   const uint8_t * p = frame;
+   while (n > 0) {
+      ssize_t w = write(io->fd, p, n);
+      if (w < 0) {
+         if (errno == EINTR) {
+            continue;
+         }
+         perror("link write");
+         exit(1);
+      }
+      p += w;
+      n -= w;
+   }
+}
+
+int percentile_cmp(const void * a, const void * b) {
+   uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+   return (x > y) - (x < y);
+}
+
+/**
+ * The p-th percentile (0-100) of n samples; sorts the samples
+ */
+double percentile(uint64_t * samples, int n, double p) {
+   int index;
+   if (n == 0) {
+      return 0;
+   }
+   qsort(samples, n, sizeof(samples[0]), percentile_cmp);
+   index = (int)(p / 100.0 * (n - 1) + 0.5);
+   return (double)samples[index];
+}
@@ -0,0 +1,28 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/linkio.h
+ * Description:
+ *      Host-side frame I/O over a file descriptor for the link tools.
+ */
+#ifndef LINKIO_H
+#define LINKIO_H
+
+#include <stdint.h>
+#include "../link.h"
+
+/* buffered reader for one link connection */
+typedef struct {
+   int fd;
+   link_rx_t rx;
+   uint8_t buf[4096];
+   int count; // bytes in buf
+   int next;  // next byte of buf to decode
+} linkio_t;
+
+void linkio_init(linkio_t *, int);
+int linkio_read(linkio_t *, link_frame_t *, int);
+void linkio_send(linkio_t *, uint8_t, const uint8_t *, uint8_t);
+int percentile_cmp(const void *, const void *);
+double percentile(uint64_t *, int, double);
+
+#endif /* LINKIO_H */
@@ -0,0 +1,209 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/macrobench.c
+ * Description:
+ *      Replays keystroke macros (see macro.h) through a simulated
+ *      pipeline: the input queue, the calculator, the host link and
+ *      the frame-rate limit of the firmware, driven by the same
+ *      macro.c, so scripts of any length run on the host (e.g. in CI).
+ *      Prints the frames drawn, the link bytes per key and the report:
+ *      keys per second, dropped keys and the post to display latency
+ *      percentiles. host/macroctl replays on the device instead.
+ *
+ *      usage: macrobench [-g ms] [-n keys] [-f hz] [script]
+ *             -g  gap between keys (default 0, as fast as possible)
+ *             -n  random keys when there is no script (default 1000000)
+ *             -f  frames per second at most, e.g. RENDER_HZ (default
+ *                 0, no limit)
+ *             script: keypad keys 0-9, A-D, * and #, or - for stdin;
+ *             anything else is skipped
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../calc.h"
+#include "../link.h"
+#include "../macro.h"
+#include "../ring.h"
+
+#define SIM_HZ 10000000 /* simulated timebase: 0.1 us ticks */
+
+/* the simulated pipeline */
+static ring_t input_queue;
+static int dirty = 0;
+static uint32_t last_frame = 0;
+static uint32_t frame_ticks = 0; // between frames, 0 for no limit
+static unsigned long frames = 0;
+static unsigned long wire_bytes = 0;
+
+static uint64_t now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**
+ * The simulation's timebase_now(): SIM_HZ ticks, wrapping at 2^32
+ */
+uint32_t timebase_now(void) {
+   return (uint32_t)(now_ns() / (1000000000 / SIM_HZ));
+}
+
+/**
+ * The simulation's timebase_hz()
+ */
+uint32_t timebase_hz(void) {
+   return SIM_HZ;
+}
+
+/**
+ * Link hook: the frames only count towards the bytes per key
+ */
+int link_transport_write(const uint8_t * data, uint16_t length) {
+   (void)data;
+   wire_bytes += length;
+   return 1;
+}
+
+/**
+ * Link hook: nothing is received
+ */
+void link_key_injected(uint8_t key) {
+   (void)key;
+}
+
+/**
+ * The firmware's assert() shows the message on the GLCD
+ */
+void assert(const int condition, char * message) {
+   (void)condition;
+   (void)message;
+}
+
+/**
+ * Macro hook: queue the key like post_input() in main.c
+ */
+int macro_post(uint8_t key) {
+   return ring_put(&input_queue, key);
+}
+
+/*
+ * Print a report, the latencies in microseconds
+ */
+static void print_report(const macro_report_t * report, uint32_t hz) {
+   double seconds = (double)report->ticks / hz;
+   printf("%u keys in %.3f s = %.0f keys/s, %u dropped\n", report->keys,
+          seconds, seconds > 0 ? report->keys / seconds : 0.0,
+          report->dropped);
+   printf("post -> shown: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+          report->p50 * 1e6 / hz, report->p99 * 1e6 / hz,
+          report->max * 1e6 / hz);
+}
+
+/*
+ * PendSV of the simulation: drain the queue through the calculator,
+ * then redraw if the frame rate allows
+ */
+static void sim_pendsv(void) {
+   uint8_t key;
+   char text[CALC_FORMAT_SIZE(4)];
+   while (ring_get(&input_queue, &key)) {
+      link_send_key(key, LINK_SRC_MACRO, timebase_now());
+      if (calc_key(key)) {
+         link_send_result(calc.status, calc.lhs, timebase_now());
+      }
+      macro_processed();
+      dirty = 1;
+   }
+   if (dirty && (frame_ticks == 0 || timebase_now() - last_frame >= frame_ticks)) {
+      // formatting the operands stands in for the GLCD
+      calc_format(calc.lhs, 4, text, sizeof(text));
+      calc_format(calc.rhs, 4, text, sizeof(text));
+      link_send_display();
+      last_frame = timebase_now();
+      dirty = 0;
+      ++frames;
+      macro_shown();
+   }
+}
+
+/*
+ * The keys of a script file
+ */
+static macro_key_t * read_script(const char * path, uint32_t * count,
+                                 uint16_t gap) {
+   static const char keys[] = "0123456789ABCD*#";
+   FILE * file = strcmp(path, "-") ? fopen(path, "r") : stdin;
+   macro_key_t * script = NULL;
+   uint32_t size = 0;
+   int c;
+   if (file == NULL) {
+      perror(path);
+      exit(1);
+   }
+   *count = 0;
+   while ((c = fgetc(file)) != EOF) {
+      const char * at = c ? strchr(keys, c) : NULL;
+      if (at == NULL) {
+         continue;
+      }
+      if (*count == size) {
+         size = size ? 2 * size : 1024;
+         script = realloc(script, size * sizeof(*script));
+      }
+      script[*count].gap_ms = gap;
+      script[*count].key = at - keys;
+      ++*count;
+   }
+   if (file != stdin) {
+      fclose(file);
+   }
+   return script;
+}
+
+int main(int argc, char ** argv) {
+   int count = 1000000, hz = 0, gap = 0;
+   int opt;
+   uint32_t k, keys;
+   macro_key_t * script;
+   uint64_t start;
+
+   while ((opt = getopt(argc, argv, "g:n:f:")) != -1) {
+      switch (opt) {
+         case 'g': gap = atoi(optarg); break;
+         case 'n': count = atoi(optarg); break;
+         case 'f': hz = atoi(optarg); break;
+         default:
+            fprintf(stderr, "usage: %s [-g ms] [-n keys] [-f hz] [script]\n",
+                    argv[0]);
+            return 2;
+      }
+   }
+
+   if (optind < argc) {
+      script = read_script(argv[optind], &keys, gap);
+   }
+   else {
+      keys = count;
+      script = malloc(keys * sizeof(*script));
+      srand(1);
+      for (k = 0; k < keys; ++k) {
+         script[k].gap_ms = gap;
+         script[k].key = rand() % 16;
+      }
+   }
+   frame_ticks = hz > 0 ? SIM_HZ / hz : 0;
+   start = now_ns();
+   macro_replay(script, keys, gap ? MACRO_TIMED : MACRO_FAST);
+   while (macro_busy()) {
+      macro_service();
+      sim_pendsv();
+   }
+   printf("%lu frames, %.1f wire bytes per key, %.3f s wall\n", frames,
+          keys ? (double)wire_bytes / keys : 0.0, (now_ns() - start) / 1e9);
+   print_report(macro_result(), SIM_HZ);
+   free(script);
+   return 0;
+}
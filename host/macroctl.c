@@ -0,0 +1,116 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/macroctl.c
+ * Description:
+ *      Records and replays keystroke macros on the device (see
+ *      macro.h) over LINK_MACRO_CTL and prints the replay's report:
+ *      keys per second, dropped keys and the post to display latency
+ *      percentiles. host/macrobench replays on the host instead.
+ *
+ *      usage: macroctl [-t] record|stop|replay|builtin [serial port]
+ *             record   empty the recording and record the keypad
+ *             stop     stop recording
+ *             replay   replay the recording
+ *             builtin  replay the built-in macro
+ *             -t       replay at the recorded gaps (default as fast as
+ *                      the pipeline takes the keys)
+ *             without a serial port the board stand-in runs on a pty
+ *             (it has no keypad, so only builtin shows anything)
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "standin.h"
+#include "linkio.h"
+#include "../calc.h"
+#include "../link.h"
+#include "../macro.h"
+
+#define TIMEOUT_MS 60000 /* a timed replay takes as long as the typing */
+
+/*
+ * Wait for the report of a replay and print it
+ */
+static int print_report(linkio_t * io) {
+   link_frame_t frame;
+   while (linkio_read(io, &frame, TIMEOUT_MS) == 1) {
+      if (frame.type == LINK_MACRO_REPORT && frame.len >= 28) {
+         uint32_t keys = link_get_u32(&frame.payload[0]);
+         uint32_t ticks = link_get_u32(&frame.payload[8]);
+         double hz = link_get_u32(&frame.payload[12]);
+         double seconds = hz ? ticks / hz : 0;
+         printf("%u keys in %.3f s = %.0f keys/s, %u dropped\n", keys,
+                seconds, seconds > 0 ? keys / seconds : 0.0,
+                link_get_u32(&frame.payload[4]));
+         printf("post -> shown: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+                link_get_u32(&frame.payload[16]) * 1e6 / hz,
+                link_get_u32(&frame.payload[20]) * 1e6 / hz,
+                link_get_u32(&frame.payload[24]) * 1e6 / hz);
+         return 0;
+      }
+   }
+   fprintf(stderr, "macroctl: no report from the device\n");
+   return 1;
+}
+
+int main(int argc, char ** argv) {
+   int timed = 0, result = 0;
+   int opt, fd;
+   pid_t child = 0;
+   linkio_t io;
+   uint8_t payload[3];
+   const char * command;
+
+   while ((opt = getopt(argc, argv, "t")) != -1) {
+      switch (opt) {
+         case 't': timed = 1; break;
+         default:
+            optind = argc; // print the usage
+            break;
+      }
+   }
+   if (optind >= argc) {
+      fprintf(stderr, "usage: %s [-t] record|stop|replay|builtin "
+              "[serial port]\n", argv[0]);
+      return 2;
+   }
+   command = argv[optind++];
+   if (optind < argc) {
+      fd = link_open(argv[optind]);
+   }
+   else {
+      child = standin_spawn(&fd);
+   }
+   linkio_init(&io, fd);
+
+   if (strcmp(command, "record") == 0) {
+      payload[0] = MACRO_CMD_RECORD;
+      linkio_send(&io, LINK_MACRO_CTL, payload, 1);
+   }
+   else if (strcmp(command, "stop") == 0) {
+      payload[0] = MACRO_CMD_STOP;
+      linkio_send(&io, LINK_MACRO_CTL, payload, 1);
+   }
+   else if (strcmp(command, "replay") == 0 || strcmp(command, "builtin") == 0) {
+      payload[0] = MACRO_CMD_REPLAY;
+      payload[1] = timed ? MACRO_TIMED : MACRO_FAST;
+      payload[2] = strcmp(command, "builtin") == 0 ? MACRO_SOURCE_BUILTIN
+                                                   : MACRO_SOURCE_RECORDING;
+      linkio_send(&io, LINK_MACRO_CTL, payload, 3);
+      result = print_report(&io);
+   }
+   else {
+      fprintf(stderr, "macroctl: unknown command %s\n", command);
+      result = 2;
+   }
+
+   if (child) {
+      close(fd);
+      kill(child, SIGTERM);
+      waitpid(child, NULL, 0);
+   }
+   return result;
+}
@@ -0,0 +1,189 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/numbench.c
+ * Description:
+ *      Compares the numeric backends (see num.h). The Makefile builds
+ *      this once per backend (numbench-float, numbench-double,
+ *      numbench-fixed, numbench-decimal, numbench-adaptive); each
+ *      prints one row:
+ *        - nanoseconds per add, sub, mul, div and calc_format() on
+ *          this host (bench_numeric() in main.c gives M4 cycles)
+ *        - the largest relative error of add, mul and div against
+ *          long double, over operands keyed in digit by digit
+ *        - how many sums of two amounts with cents display exactly
+ *          as the cents computed in integers would
+ *        - how many operations overflowed
+ *
+ *      usage: numbench-<backend> [-H] [-w] [-n operations]
+ *             -H  print the header line first
+ *             -w  whole numbers only (no cents)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../calc.h"
+
+#define PRECISION 4 /* as on the GLCD */
+
+/* one operand, keyed in and exact */
+typedef struct {
+   num_t value;
+   long long cents; // the same amount in hundredths
+} operand_t;
+
+/**
+ * The firmware's assert() shows the message on the GLCD
+ */
+void assert(const int condition, char * message) {
+   (void)condition;
+   (void)message;
+}
+
+static uint64_t now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*
+ * Key in a random amount of up to 6 whole digits and 2 decimals (or
+ * up to 9 whole digits), through calc_digit() like the keypad
+ */
+static operand_t random_operand(int whole_only) {
+   operand_t operand;
+   long long whole = rand() % (whole_only ? 1000000000 : 1000000);
+   int cents = rand() % 100;
+   long long pow10 = 10;
+   char text[16];
+   int k, length;
+   length = snprintf(text, sizeof(text), "%lld", whole);
+   operand.value = num_from_int(0);
+   for (k = 0; k < length; ++k) {
+      operand.value = calc_digit(operand.value, text[k] - '0', 0, &pow10);
+   }
+   if (whole_only) {
+      cents = 0;
+   }
+   else {
+      operand.value = calc_digit(operand.value, cents / 10, 1, &pow10);
+      operand.value = calc_digit(operand.value, cents % 10, 1, &pow10);
+   }
+   operand.cents = whole * 100 + cents;
+   if (rand() & 1) {
+      operand.value = num_negate(operand.value);
+      operand.cents = -operand.cents;
+   }
+   return operand;
+}
+
+/*
+ * Relative error of a result against the exact value
+ */
+static long double relative_error(num_t result, long double exact) {
+   long double error = (long double)num_to_double(result) - exact;
+   if (error < 0) {
+      error = -error;
+   }
+   return exact != 0 ? error / (exact < 0 ? -exact : exact) : error;
+}
+
+int main(int argc, char ** argv) {
+   int count = 200000, header = 0, whole_only = 0;
+   int opt, k, status = CALC_OK, overflows = 0, exact_sums = 0;
+   operand_t * a, * b;
+   num_t * out;
+   char text[CALC_FORMAT_SIZE(PRECISION)];
+   char expected[CALC_FORMAT_SIZE(PRECISION)];
+   uint64_t start;
+   double ns[5];
+   long double error_add = 0, error_mul = 0, error_div = 0, error;
+   volatile int sink = 0;
+
+   while ((opt = getopt(argc, argv, "Hwn:")) != -1) {
+      switch (opt) {
+         case 'H': header = 1; break;
+         case 'w': whole_only = 1; break;
+         case 'n': count = atoi(optarg); break;
+         default:
+            fprintf(stderr, "usage: %s [-H] [-w] [-n operations]\n", argv[0]);
+            return 2;
+      }
+   }
+   a = malloc(count * sizeof(*a));
+   b = malloc(count * sizeof(*b));
+   out = malloc(count * sizeof(*out));
+   srand(1);
+   for (k = 0; k < count; ++k) {
+      a[k] = random_operand(whole_only);
+      b[k] = random_operand(whole_only);
+   }
+
+   /* speed */
+#define TIME_OP(slot, op)                                        \
+   start = now_ns();                                             \
+   for (k = 0; k < count; ++k) {                                 \
+      out[k] = op(a[k].value, b[k].value, &status);              \
+   }                                                             \
+   ns[slot] = (double)(now_ns() - start) / count;
+   TIME_OP(0, num_add);
+   TIME_OP(1, num_sub);
+   TIME_OP(2, num_mul);
+   TIME_OP(3, num_div);
+   start = now_ns();
+   for (k = 0; k < count; ++k) {
+      sink += calc_format(out[k], PRECISION, text, sizeof(text));
+   }
+   ns[4] = (double)(now_ns() - start) / count;
+
+   /* accuracy */
+   for (k = 0; k < count; ++k) {
+      long double x = a[k].cents / 100.0L, y = b[k].cents / 100.0L;
+      long long cents = a[k].cents + b[k].cents;
+      num_t sum;
+      status = CALC_OK;
+      sum = num_add(a[k].value, b[k].value, &status);
+      overflows += status == CALC_OVERFLOW;
+      if ((error = relative_error(sum, x + y)) > error_add) {
+         error_add = error;
+      }
+      status = CALC_OK;
+      out[k] = num_mul(a[k].value, b[k].value, &status);
+      overflows += status == CALC_OVERFLOW;
+      if (status == CALC_OK
+          && (error = relative_error(out[k], x * y)) > error_mul) {
+         error_mul = error;
+      }
+      status = CALC_OK;
+      out[k] = num_div(a[k].value, b[k].value, &status);
+      overflows += status == CALC_OVERFLOW;
+      if (status == CALC_OK && y != 0
+          && (error = relative_error(out[k], x / y)) > error_div) {
+         error_div = error;
+      }
+      // the sum as the display would show it, from the exact cents
+      if (cents % 100 == 0) {
+         snprintf(expected, sizeof(expected), "%lld", cents / 100);
+      }
+      else {
+         snprintf(expected, sizeof(expected), "%s%lld.%02lld00",
+                  cents < 0 ? "-" : "", llabs(cents) / 100, llabs(cents) % 100);
+      }
+      calc_format(sum, PRECISION, text, sizeof(text));
+      exact_sums += strcmp(text, expected) == 0;
+   }
+
+   if (header) {
+      printf("%-8s %7s %7s %7s %7s %7s  %9s %9s %9s  %7s %s\n", "backend",
+             "add ns", "sub ns", "mul ns", "div ns", "fmt ns", "add err",
+             "mul err", "div err", "exact", "overflows");
+   }
+   printf("%-8s %7.1f %7.1f %7.1f %7.1f %7.1f  %9.2Le %9.2Le %9.2Le  %6.2f%% %d\n",
+          NUM_NAME, ns[0], ns[1], ns[2], ns[3], ns[4], error_add, error_mul,
+          error_div, 100.0 * exact_sums / count, overflows);
+   free(a);
+   free(b);
+   free(out);
+   return sink < 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/pcd8544.c
+ * Description:
+ *      The PCD8544 emulator (see pcd8544.h).
+ */
+#include <stdio.h>
+#include <string.h>
+#include "pcd8544.h"
+
+/**
+ * Reset the controller (memory cleared, as the host tools expect after
+ * GLCD_init() and GLCD_clear()) with an SPI clock of spi_hz
+ */
+void pcd8544_init(pcd8544_t * lcd, uint32_t spi_hz) {
+   memset(lcd, 0, sizeof(*lcd));
+   lcd->powered_down = 1; // until the first function set
+   lcd->spi_us = 8e6 / spi_hz;
+}
+
+/*
+ * A command byte (DC low)
+ */
+static void command(pcd8544_t * lcd, uint8_t byte) {
+   ++lcd->commands;
+   if ((byte & 0xF8) == 0x20) {
+      // function set, in both command sets: PD, V, H
+      lcd->powered_down = (byte >> 2) & 1;
+      lcd->vertical = (byte >> 1) & 1;
+      lcd->extended = byte & 1;
+   }
+   else if (lcd->extended) {
+      ++lcd->ignored; // Vop, bias, temperature coefficient
+   }
+   else if (byte & 0x80) {
+      if ((byte & 0x7F) < PCD8544_WIDTH) {
+         lcd->x = byte & 0x7F;
+      }
+   }
+   else if ((byte & 0xF8) == 0x40) {
+      if ((byte & 0x07) < PCD8544_BANKS) {
+         lcd->y = byte & 0x07;
+      }
+   }
+   else if ((byte & 0xFA) == 0x08) {
+      lcd->display = byte & 0x05; // D and E
+   }
+   else {
+      ++lcd->ignored; // no operation, reserved
+   }
+}
+
+/**
+ * One byte from the SPI bus; dc is the level of the DC pin (1: data)
+ */
+void pcd8544_write(pcd8544_t * lcd, int dc, uint8_t byte) {
+   if (!dc) {
+      command(lcd, byte);
+      return;
+   }
+   ++lcd->data_bytes;
+   lcd->ram[lcd->y][lcd->x] = byte;
+   // the address moves on and wraps around the whole memory
+   if (lcd->vertical) {
+      if (++lcd->y == PCD8544_BANKS) {
+         lcd->y = 0;
+         if (++lcd->x == PCD8544_WIDTH) {
+            lcd->x = 0;
+         }
+      }
+   }
+   else if (++lcd->x == PCD8544_WIDTH) {
+      lcd->x = 0;
+      if (++lcd->y == PCD8544_BANKS) {
+         lcd->y = 0;
+      }
+   }
+}
+
+/**
+ * Draw the display memory, one character per pixel
+ */
+void pcd8544_print(const pcd8544_t * lcd) {
+   int row, col; // used in for loops
+   for (row = 0; row < 8 * PCD8544_BANKS; ++row) {
+      for (col = 0; col < PCD8544_WIDTH; ++col) {
+         putchar((lcd->ram[row / 8][col] >> (row % 8)) & 1 ? '#' : '.');
+      }
+      putchar('\n');
+   }
+}
@@ -0,0 +1,38 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/pcd8544.h
+ * Description:
+ *      An emulator of the GLCD's PCD8544 controller, for the host tools.
+ *      It takes the bytes main.c sends over SPI, each with the level of
+ *      the DC pin, and keeps the display memory the way the controller
+ *      does: the function set, display control and X/Y address
+ *      commands, the data writes that move the address on (across the
+ *      banks, horizontally or vertically), and the extended commands
+ *      (contrast, bias, temperature) that it only counts.
+ *      It also keeps the time the bytes take on an SPI clock, so the
+ *      tools can tell when a byte is on the display.
+ */
+#ifndef PCD8544_H
+#define PCD8544_H
+
+#include <stdint.h>
+
+#define PCD8544_WIDTH 84
+#define PCD8544_BANKS 6
+
+typedef struct {
+   uint8_t ram[PCD8544_BANKS][PCD8544_WIDTH];
+   uint8_t x, y;       // the address of the next data byte
+   uint8_t extended;   // H: the extended command set
+   uint8_t vertical;   // V: data moves down the banks first
+   uint8_t powered_down; // PD
+   uint8_t display;    // D and E of the display control command
+   uint32_t data_bytes, commands, ignored;
+   double spi_us;      // one byte on the SPI clock
+} pcd8544_t;
+
+void pcd8544_init(pcd8544_t *, uint32_t);
+void pcd8544_write(pcd8544_t *, int, uint8_t);
+void pcd8544_print(const pcd8544_t *);
+
+#endif /* PCD8544_H */
@@ -0,0 +1,151 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/plotbench.c
+ * Description:
+ *      Runs the graph mode (plot.c) on the host, without a device:
+ *        - samples per second, and the time to plot all 84 columns
+ *        - the frames a graph takes to fill in, PLOT_BATCH columns a
+ *          frame, and how often the autoscale drew it all again
+ *        - what a pan costs against plotting the view from scratch,
+ *          and that the framebuffer it leaves is the same, pixel for
+ *          pixel, as the whole graph drawn again from its samples
+ *      and draws the graph as text.
+ *
+ *      usage: plotbench [-n runs] [-q] [function of x]
+ *             -n  how many times to plot the function (default 2000)
+ *             -q  don't draw the graph
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../calc.h"
+#include "../fb.h"
+#include "../plot.h"
+
+/**
+ * The firmware's assert() shows the message on the GLCD
+ */
+void assert(const int condition, char * message) {
+   (void)condition;
+   (void)message;
+}
+
+static uint64_t now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**
+ * The device's timebase_now(): here microseconds, wrapping at 2^32
+ */
+uint32_t timebase_now(void) {
+   return (uint32_t)(now_ns() / 1000);
+}
+
+/*
+ * Plot until every column is there; returns the frames it took
+ */
+static int fill(void) {
+   int frames = 1;
+   while (plot_render()) {
+      ++frames;
+   }
+   return frames;
+}
+
+/*
+ * Draw the framebuffer, one character per pixel
+ */
+static void draw(void) {
+   int row, col;
+   for (row = 0; row < FB_HEIGHT; ++row) {
+      for (col = 0; col < FB_WIDTH; ++col) {
+         putchar((fb[row / 8][col] >> (row & 7)) & 1 ? '#' : '.');
+      }
+      putchar('\n');
+   }
+}
+
+int main(int argc, char ** argv) {
+   /* pans tried: the keys, one column, most of the screen, past it */
+   static const int pans[] = { PLOT_PAN, -PLOT_PAN, 1, -1, 40, -60,
+                               2 * FB_WIDTH, -3, PLOT_PAN, PLOT_PAN };
+   static uint8_t panned[FB_BANKS][FB_WIDTH];
+   const char * function = PLOT_FUNCTION;
+   int runs = 2000, quiet = 0;
+   int opt, run, frames = 0, mismatches = 0;
+   uint32_t samples, redraws, pan_samples = 0;
+   uint64_t start, full_ns, pan_ns = 0;
+   unsigned k;
+
+   while ((opt = getopt(argc, argv, "n:q")) != -1) {
+      switch (opt) {
+         case 'n': runs = atoi(optarg); break;
+         case 'q': quiet = 1; break;
+         default:
+            fprintf(stderr, "usage: %s [-n runs] [-q] [function of x]\n",
+                    argv[0]);
+            return 2;
+      }
+   }
+   if (optind < argc) {
+      function = argv[optind];
+   }
+   if (runs < 1) {
+      runs = 1;
+   }
+   if (plot_function(function, strlen(function)) != CALC_OK) {
+      fprintf(stderr, "plotbench: %s isn't a function of x\n", function);
+      return 2;
+   }
+
+   /* the whole view, from scratch */
+   samples = plot_samples;
+   redraws = plot_redraws;
+   start = now_ns();
+   for (run = 0; run < runs; ++run) {
+      plot_reset();
+      frames = fill();
+   }
+   full_ns = now_ns() - start;
+   samples = plot_samples - samples;
+   redraws = plot_redraws - redraws;
+
+   printf("y = %s, %d columns and the 2 off the edges\n", function,
+          FB_WIDTH);
+   printf("samples/s %.0f   view %.1f us   frames to fill %d (%d columns "
+          "each)   full redraws %.1f\n",
+          samples * 1e9 / full_ns, full_ns / 1e3 / runs, frames, PLOT_BATCH,
+          (double)redraws / runs);
+
+   /* pans, each checked against the graph drawn again from scratch */
+   for (k = 0; k < sizeof(pans) / sizeof(pans[0]); ++k) {
+      uint32_t before = plot_samples;
+      start = now_ns();
+      plot_pan(pans[k]);
+      fill();
+      pan_ns += now_ns() - start;
+      pan_samples += plot_samples - before;
+      memcpy(panned, fb, sizeof(panned));
+      plot_invalidate();
+      plot_render();
+      if (memcmp(panned, fb, sizeof(panned)) != 0) {
+         ++mismatches;
+         printf("MISMATCH after a pan of %d\n", pans[k]);
+      }
+   }
+   k = sizeof(pans) / sizeof(pans[0]);
+   printf("pans %u   samples/pan %.1f (%d for the view)   %.1f us/pan   "
+          "mismatches %d\n", k, (double)pan_samples / k, FB_WIDTH + 2,
+          pan_ns / 1e3 / k, mismatches);
+
+   if (!quiet) {
+      plot_reset();
+      fill();
+      draw();
+   }
+   return mismatches ? 1 : 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/progctl.c
+ * Description:
+ *      Sends a key program (see vm.h) to the device over LINK_PROGRAM,
+ *      in as many frames as its source takes, prints what the device's
+ *      compiler made of it, and can then type keys to run it.
+ *
+ *      usage: progctl [-s slot] [-k key] [-t keys] source [serial port]
+ *             -s  the program slot, 0 to 3 (default 0)
+ *             -k  the key that runs it, a hex digit as on the keypad
+ *                 (A + B - C * D /, E . F =; default D)
+ *             -t  keys to type after it's installed, e.g. 12D, and
+ *                 print the results they give
+ *             without a serial port the board stand-in runs on a pty
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "standin.h"
+#include "linkio.h"
+#include "../calc.h"
+#include "../link.h"
+#include "../vm.h"
+
+#define TIMEOUT_MS 2000
+#define CHUNK (LINK_MAX_PAYLOAD - 3) /* characters of source a frame holds */
+
+/*
+ * The key code of a hex digit, or -1
+ */
+static int key_of(char digit) {
+   if (digit >= '0' && digit <= '9') {
+      return digit - '0';
+   }
+   if (digit >= 'A' && digit <= 'F') {
+      return digit - 'A' + 10;
+   }
+   if (digit >= 'a' && digit <= 'f') {
+      return digit - 'a' + 10;
+   }
+   return -1;
+}
+
+/*
+ * Send the source and print the LINK_PROGRAM_STATUS that comes back
+ * Returns 0 if it compiled
+ */
+static int load(linkio_t * io, int slot, int key, const char * source) {
+   uint8_t payload[LINK_MAX_PAYLOAD];
+   link_frame_t frame;
+   int length = strlen(source);
+   int sent = 0;
+
+   do {
+      int chunk = length - sent > CHUNK ? CHUNK : length - sent;
+      payload[0] = slot;
+      payload[1] = key;
+      payload[2] = sent + chunk < length; // more follows
+      memcpy(&payload[3], &source[sent], chunk);
+      linkio_send(io, LINK_PROGRAM, payload, 3 + chunk);
+      sent += chunk;
+   } while (sent < length);
+
+   while (linkio_read(io, &frame, TIMEOUT_MS) == 1) {
+      if (frame.type == LINK_PROGRAM_STATUS && frame.len >= 3) {
+         if (frame.payload[1] == CALC_OK) {
+            printf("slot %d, key %X: %d bytes of code\n", frame.payload[0],
+                   key, frame.payload[2]);
+            return 0;
+         }
+         printf("slot %d: error %d\n  %s\n  %*s^\n", frame.payload[0],
+                frame.payload[1], source, frame.payload[2], "");
+         return 1;
+      }
+   }
+   fprintf(stderr, "progctl: no status from the device\n");
+   return 1;
+}
+
+/*
+ * Type keys and print the results
+ */
+static void type_keys(linkio_t * io, const char * keys) {
+   uint8_t key;
+   link_frame_t frame;
+   for (; *keys; ++keys) {
+      if (key_of(*keys) < 0) {
+         continue;
+      }
+      key = key_of(*keys);
+      linkio_send(io, LINK_INJECT, &key, 1);
+   }
+   while (linkio_read(io, &frame, 200) == 1) {
+      if (frame.type == LINK_RESULT) {
+         if (frame.payload[0] == CALC_OK) {
+            printf("result %.10g\n", link_get_f64(&frame.payload[1]));
+         }
+         else {
+            printf("result: error %d\n", frame.payload[0]);
+         }
+      }
+   }
+}
+
+int main(int argc, char ** argv) {
+   int slot = 0, key = KEY_DIVIDE;
+   const char * keys = NULL;
+   int opt, fd, result;
+   pid_t child = 0;
+   linkio_t io;
+
+   while ((opt = getopt(argc, argv, "s:k:t:")) != -1) {
+      switch (opt) {
+         case 's': slot = atoi(optarg); break;
+         case 'k': key = key_of(optarg[0]); break;
+         case 't': keys = optarg; break;
+         default:
+            optind = argc; // print the usage
+            break;
+      }
+   }
+   if (optind >= argc || key < 0) {
+      fprintf(stderr, "usage: %s [-s slot] [-k key] [-t keys] source "
+              "[serial port]\n", argv[0]);
+      return 2;
+   }
+   if (optind + 1 < argc) {
+      fd = link_open(argv[optind + 1]);
+   }
+   else {
+      child = standin_spawn(&fd);
+   }
+   linkio_init(&io, fd);
+
+   result = load(&io, slot, key, argv[optind]);
+   if (result == 0 && keys) {
+      type_keys(&io, keys);
+   }
+
+   if (child) {
+      close(fd);
+      kill(child, SIGTERM);
+      waitpid(child, NULL, 0);
+   }
+   return result;
+}
@@ -0,0 +1,52 @@
+#!/bin/sh
+#
+# ramfunc_report.sh: report what the linker placed in .TI.ramfunc
+#
+# Reads the TI linker map file and lists every RAMFUNC (see ramfunc.h)
+# function with its flash load address, its SRAM run address and its
+# size, followed by the total SRAM the section costs.
+#
+# usage: host/ramfunc_report.sh [map file]
+#        (defaults to the Debug build's map file)
+#
+map="${1:-Debug/Final Project - Calculator.map}"
+
+if [ ! -f "$map" ]; then
+   echo "ramfunc_report: no map file at '$map'" >&2
+   exit 1
+fi
+
+awk '
+# convert a hexadecimal string (no 0x prefix) to a number
+function hex(s,    i, n) {
+   n = 0
+   s = tolower(s)
+   for (i = 1; i <= length(s); ++i)
+      n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+   return n
+}
+
+# the section header may wrap onto the next line when the name is long
+/^\.TI\.ramfunc/ { insec = 1; if (NF == 1) next }
+insec && /RUN ADDR/ {
+   load = hex($(NF - 5)); size = hex($(NF - 4)); run = hex($NF)
+   printf "%-24s %-10s %-10s %s\n", "function", "load", "run", "bytes"
+   next
+}
+insec && /\(\.TI\.ramfunc/ {
+   name = $NF
+   sub(/^\(\.TI\.ramfunc:?/, "", name); sub(/\)$/, "", name)
+   if (name == "") name = $(NF - 1)
+   printf "%-24s 0x%08x 0x%08x %d\n", name, hex($1), run + hex($1) - load, hex($2)
+   next
+}
+insec && /^[ \t]*$/ { insec = 0 }
+
+END {
+   if (size == "") {
+      print "ramfunc_report: .TI.ramfunc is empty (RAMFUNC_DISABLE build?)"
+      exit 0
+   }
+   printf "total SRAM_CODE used by .TI.ramfunc: %d bytes\n", size
+}
+' "$map"
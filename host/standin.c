@@ -0,0 +1,224 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/standin.c
+ * Description:
+ *      The board stand-in: a pty whose far end is served by the same
+ *      calc.c and link.c the firmware runs, plus the host-side helpers
+ *      to open a real board's serial port.
+ */
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "standin.h"
+#include "../calc.h"
+#include "../link.h"
+#include "../batch.h"
+#include "../timebase.h"
+#include "../trace.h"
+#include "../macro.h"
+#include "../vm.h"
+
+static int board_fd = -1; // the stand-in's end of the pty
+
+/**
+ * Monotonic time in nanoseconds
+ */
+uint64_t now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**
+ * The stand-in's timebase_now(): microseconds, wrapping at 2^32
+ */
+uint32_t timebase_now(void) {
+   return (uint32_t)(now_ns() / 1000);
+}
+
+/**
+ * The stand-in's timebase_hz()
+ */
+uint32_t timebase_hz(void) {
+   return STANDIN_TICK_HZ;
+}
+
+/**
+ * Link hook: write a frame to the pty
+ */
+int link_transport_write(const uint8_t * data, uint16_t length) {
+   while (length > 0) {
+      ssize_t n = write(board_fd, data, length);
+      if (n < 0) {
+         if (errno == EINTR) {
+            continue;
+         }
+         return 0;
+      }
+      data += n;
+      length -= n;
+   }
+   return 1;
+}
+
+/*
+ * The same steps as process_key() in main.c, with sending the display
+ * state standing in for the GLCD flush
+ */
+static void standin_key(uint8_t key, uint8_t source) {
+   char old_operation = calc.operation;
+   int old_on_rhs = CALC_ON_RHS(calc.state);
+   int slot = vm_bound(key);
+
+   link_send_key(key, source, timebase_now());
+   if (slot >= 0) {
+      vm_calc(slot, &calc);
+      link_send_result(calc.status, calc.lhs, timebase_now());
+   }
+   else if (calc_key(key)) {
+      link_send_result(calc.status, calc.lhs, timebase_now());
+   }
+   if (calc.operation != old_operation) {
+      TRACE(TRACE_OPERATION, calc.operation);
+   }
+   if (CALC_ON_RHS(calc.state) != old_on_rhs) {
+      TRACE(TRACE_FOCUS, !old_on_rhs);
+   }
+   TRACE(TRACE_FLUSH_START, 0);
+   link_send_display();
+   TRACE(TRACE_FLUSH_END, 0);
+}
+
+/**
+ * Link hook: a key injected by the host
+ */
+void link_key_injected(uint8_t key) {
+   TRACE(TRACE_KEY, key | TRACE_KEY_HOST);
+   standin_key(key, LINK_SRC_HOST);
+}
+
+/**
+ * Macro hook: a replayed key is handled and shown at once
+ */
+int macro_post(uint8_t key) {
+   standin_key(key, LINK_SRC_MACRO);
+   macro_processed();
+   macro_shown();
+   return 1;
+}
+
+/**
+ * The firmware's assert() shows the message on the GLCD; calc.status
+ * already carries the error to the host, so there is nothing to do
+ */
+void assert(const int condition, char * message) {
+   (void)condition;
+   (void)message;
+}
+
+/*
+ * Put a terminal in raw 8-bit mode at the given speed
+ */
+static int make_raw(int fd, speed_t speed) {
+   struct termios tio;
+   if (tcgetattr(fd, &tio) < 0) {
+      return -1;
+   }
+   cfmakeraw(&tio);
+   cfsetispeed(&tio, speed);
+   cfsetospeed(&tio, speed);
+   tio.c_cc[VMIN] = 1;
+   tio.c_cc[VTIME] = 0;
+   return tcsetattr(fd, TCSANOW, &tio);
+}
+
+/*
+ * The stand-in's main loop, the same as the one in main(): decode
+ * frames while there is room for another batch record, evaluate one
+ * record, repeat until the host end of the pty closes (a timed macro
+ * replay only waits for input for a millisecond at a time)
+ */
+static void standin_run(void) {
+   uint8_t buf[256];
+   ssize_t count = 0, next = 0; // bytes read, bytes decoded
+   link_send_hello(timebase_hz());
+   for (;;) {
+      while (batch_has_room() && next < count) {
+         link_receive(buf[next++]);
+      }
+      if (batch_service() || trace_service() || macro_service()) {
+         continue;
+      }
+      if (vm_ready()) {
+         vm_install(); // PendSV's part, on the device
+      }
+      if (next == count && macro_busy()) {
+         struct pollfd ready = { board_fd, POLLIN, 0 };
+         if (poll(&ready, 1, 1) == 0) {
+            continue;
+         }
+      }
+      if (next == count) {
+         count = read(board_fd, buf, sizeof(buf));
+         next = 0;
+         if (count <= 0) {
+            if (count < 0 && errno == EINTR) {
+               count = 0;
+               continue;
+            }
+            _exit(0);
+         }
+      }
+   }
+}
+
+/**
+ * Start a board stand-in on a new pty
+ * Returns the child's pid and sets *host_fd to the host end
+ */
+pid_t standin_spawn(int * host_fd) {
+   int master = posix_openpt(O_RDWR | O_NOCTTY);
+   pid_t pid;
+   if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+      perror("standin: pty");
+      exit(1);
+   }
+   board_fd = open(ptsname(master), O_RDWR | O_NOCTTY);
+   if (board_fd < 0 || make_raw(board_fd, B115200) < 0) {
+      perror("standin: pty slave");
+      exit(1);
+   }
+   pid = fork();
+   if (pid < 0) {
+      perror("standin: fork");
+      exit(1);
+   }
+   if (pid == 0) {
+      close(master);
+      standin_run();
+   }
+   close(board_fd);
+   board_fd = -1;
+   *host_fd = master;
+   return pid;
+}
+
+/**
+ * Open a board's serial port (e.g. /dev/ttyACM0) for the link
+ */
+int link_open(const char * path) {
+   int fd = open(path, O_RDWR | O_NOCTTY);
+   if (fd < 0 || make_raw(fd, B115200) < 0) {
+      perror(path);
+      exit(1);
+   }
+   return fd;
+}
@@ -0,0 +1,22 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/standin.h
+ * Description:
+ *      A stand-in for the board on a Linux pseudo-terminal. It runs the
+ *      firmware's calculator (calc.c) and host-link (link.c) code in a
+ *      child process, so the host tools can exercise the protocol
+ *      without a LaunchPad attached.
+ */
+#ifndef STANDIN_H
+#define STANDIN_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define STANDIN_TICK_HZ 1000000 /* stand-in timestamps are microseconds */
+
+pid_t standin_spawn(int *);
+int link_open(const char *);
+uint64_t now_ns(void);
+
+#endif /* STANDIN_H */
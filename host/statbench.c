@@ -0,0 +1,149 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/statbench.c
+ * Description:
+ *      Streams a long series of values through the accumulators of the
+ *      statistics mode (stats.c), without a device:
+ *        - values (and pairs) per second
+ *        - the sum, mean and standard deviation against a reference
+ *          in long double, which reads the series twice (it's made
+ *          again from its seed, so nothing is stored either), and
+ *          against the naive sums of the values and of their squares
+ *        - the regression line of pairs around a known one
+ *      The values are offset + uniform noise in [-1, 1), so a large
+ *      offset shows what a sum of squares loses.
+ *
+ *      usage: statbench [-n values] [-o offset]
+ *             -n  how many values (default 10000000)
+ *             -o  the offset of the values (default 1e9)
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "../stats.h"
+
+#define SEED 12345
+
+/**
+ * The firmware's assert() shows the message on the GLCD
+ */
+void assert(const int condition, char * message) {
+   (void)condition;
+   (void)message;
+}
+
+static uint64_t now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*
+ * The noise: a 64-bit LCG, the top 53 bits as a double in [-1, 1)
+ */
+static uint64_t lcg;
+static double noise(void) {
+   lcg = lcg * 6364136223846793005ull + 1442695040888963407ull;
+   return (double)(lcg >> 11) / (1ull << 52) - 1;
+}
+
+/*
+ * The relative error of a result against the reference
+ */
+static double error_of(double value, long double reference) {
+   if (reference == 0) {
+      return fabs(value);
+   }
+   return fabsl((value - reference) / reference);
+}
+
+int main(int argc, char ** argv) {
+   long n = 10000000;
+   double offset = 1e9;
+   stats_t s;
+   stats_pair_t p;
+   double naive_sum = 0, naive_squares = 0, naive_sd;
+   double slope, intercept, r;
+   long double ref_sum = 0, ref_mean, ref_m2 = 0, ref_sd;
+   uint64_t start, add_ns, pair_ns;
+   long k;
+   int opt;
+
+   while ((opt = getopt(argc, argv, "n:o:")) != -1) {
+      switch (opt) {
+         case 'n': n = atol(optarg); break;
+         case 'o': offset = atof(optarg); break;
+         default:
+            fprintf(stderr, "usage: %s [-n values] [-o offset]\n", argv[0]);
+            return 2;
+      }
+   }
+   if (n < 2) {
+      n = 2;
+   }
+
+   /* the accumulators, timed */
+   stats_reset(&s);
+   lcg = SEED;
+   start = now_ns();
+   for (k = 0; k < n; ++k) {
+      stats_add(&s, offset + noise());
+   }
+   add_ns = now_ns() - start;
+
+   stats_pair_reset(&p);
+   lcg = SEED;
+   start = now_ns();
+   for (k = 0; k < n; ++k) {
+      double x = (double)k / n * 100;
+      stats_pair_add(&p, x, 3 * x + 2 + noise());
+   }
+   pair_ns = now_ns() - start;
+
+   /* the naive sums, then the reference in two passes */
+   lcg = SEED;
+   for (k = 0; k < n; ++k) {
+      double v = offset + noise();
+      naive_sum += v;
+      naive_squares += v * v;
+   }
+   naive_sd = (naive_squares - naive_sum * naive_sum / n) / (n - 1);
+   naive_sd = naive_sd > 0 ? sqrt(naive_sd) : 0;
+   lcg = SEED;
+   for (k = 0; k < n; ++k) {
+      ref_sum += offset + noise();
+   }
+   ref_mean = ref_sum / n;
+   lcg = SEED;
+   for (k = 0; k < n; ++k) {
+      long double d = offset + noise() - ref_mean;
+      ref_m2 += d * d;
+   }
+   ref_sd = sqrtl(ref_m2 / (n - 1));
+
+   printf("%ld values of %g + noise in [-1, 1), %u bytes of accumulators\n",
+          n, offset, (unsigned)(sizeof(s) + sizeof(p)));
+   printf("stats_add       %8.2f M values/s  %6.2f ns each\n",
+          n * 1e3 / add_ns, (double)add_ns / n);
+   printf("stats_pair_add  %8.2f M pairs/s   %6.2f ns each\n",
+          n * 1e3 / pair_ns, (double)pair_ns / n);
+   printf("\n%-6s %24s %24s %12s %12s\n", "", "reference", "stats.c",
+          "rel error", "naive error");
+   printf("%-6s %24.6Lf %24.6f %12.2e %12.2e\n", "sum", ref_sum,
+          stats_sum(&s), error_of(stats_sum(&s), ref_sum),
+          error_of(naive_sum, ref_sum));
+   printf("%-6s %24.9Lf %24.9f %12.2e %12.2e\n", "mean", ref_mean,
+          stats_mean(&s), error_of(stats_mean(&s), ref_mean),
+          error_of(naive_sum / n, ref_mean));
+   printf("%-6s %24.9Lf %24.9f %12.2e %12.2e\n", "sd", ref_sd,
+          stats_stddev(&s), error_of(stats_stddev(&s), ref_sd),
+          error_of(naive_sd, ref_sd));
+   printf("min %.9f  max %.9f\n", s.min, s.max);
+   if (stats_fit(&p, &slope, &intercept, &r)) {
+      printf("\nregression of y = 3x + 2 + noise: slope %.6f intercept "
+             "%.6f r %.6f\n", slope, intercept, r);
+   }
+   return 0;
+}
@@ -0,0 +1,317 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/tracedump.c
+ * Description:
+ *      Dumps the device's event trace (see trace.h) and renders it as
+ *      a timeline, one column per kind of event, followed by the
+ *      latencies it implies:
+ *        - time spent in PORT1_IRQHandler and PORT3_IRQHandler
+ *        - key to the end of the display flush it caused
+ *        - how many port 3 interrupts preempted a PendSV redraw
+ *      and a list of the suspicious patterns (a port 3 interrupt that
+ *      decoded no key, a key that was never shown).
+ *
+ *      usage: tracedump [-s] [-k keys] [-q] [serial port]
+ *             -s  empty the ring first (TRACE_CMD_START)
+ *             -k  inject this many keys before the dump (the stand-in
+ *                 has no keypad, so it defaults to 24 there)
+ *             -q  only print the summary
+ *             without a serial port the board stand-in runs on a pty
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "standin.h"
+#include "linkio.h"
+#include "../calc.h"
+#include "../link.h"
+#include "../trace.h"
+
+#define TIMEOUT_MS 2000
+
+/* keys injected with -k: 12+34=  5.5*6=  78-9=  96/4=  ## */
+static const uint8_t script[] = {
+   1, 2, KEY_ADD, 3, 4, KEY_EQUALS,
+   5, KEY_DECIMAL, 5, KEY_MULTIPLY, 6, KEY_EQUALS,
+   7, 8, KEY_SUBTRACT, 9, KEY_EQUALS,
+   9, 6, KEY_DIVIDE, 4, KEY_EQUALS, KEY_EQUALS,
+};
+
+/* the dumped ring */
+static trace_record_t records[TRACE_RECORDS];
+static int count = 0;
+
+/*
+ * Wait for a frame of the given type, skipping the others
+ */
+static int wait_for(linkio_t * io, link_frame_t * frame, uint8_t type) {
+   while (linkio_read(io, frame, TIMEOUT_MS) == 1) {
+      if (frame->type == type) {
+         return 1;
+      }
+   }
+   return 0;
+}
+
+/*
+ * The text of one event, e.g. "key 5" or "op +"
+ */
+static const char * describe(const trace_record_t * record) {
+   static char text[16];
+   switch (record->event) {
+      case TRACE_PORT1_ENTER: return "P1 >";
+      case TRACE_PORT1_EXIT:  return "P1 <";
+      case TRACE_PORT3_ENTER: return "P3 >";
+      case TRACE_PORT3_EXIT:  return "P3 <";
+      case TRACE_KEY:
+         snprintf(text, sizeof(text), "key %X%s", record->arg & 0x0F,
+                  (record->arg & TRACE_KEY_HOST) ? " (host)" : "");
+         return text;
+      case TRACE_OPERATION:
+         snprintf(text, sizeof(text), "op %c",
+                  record->arg ? record->arg : '-');
+         return text;
+      case TRACE_FOCUS:
+         return record->arg ? "focus rhs" : "focus lhs";
+      case TRACE_FLUSH_START: return "flush >";
+      case TRACE_FLUSH_END:   return "flush <";
+      case TRACE_RENDER_ENTER: return "PendSV >";
+      case TRACE_RENDER_EXIT:  return "PendSV <";
+      default:
+         snprintf(text, sizeof(text), "? %u/%u", record->event, record->arg);
+         return text;
+   }
+}
+
+/*
+ * The timeline column of an event
+ */
+static int column(uint8_t event) {
+   switch (event) {
+      case TRACE_PORT1_ENTER: case TRACE_PORT1_EXIT:
+      case TRACE_PORT3_ENTER: case TRACE_PORT3_EXIT:
+      case TRACE_RENDER_ENTER: case TRACE_RENDER_EXIT:
+         return 0;
+      case TRACE_KEY:
+         return 1;
+      case TRACE_OPERATION: case TRACE_FOCUS:
+         return 2;
+      default:
+         return 3;
+   }
+}
+
+/*
+ * Print min, p50, p99 and max of some latencies in microseconds
+ */
+static void print_latency(const char * name, uint64_t * ticks, int n,
+                          double hz) {
+   if (n == 0) {
+      printf("%-22s none\n", name);
+      return;
+   }
+   printf("%-22s n %4d  min %8.1f  p50 %8.1f  p99 %8.1f  max %8.1f us\n",
+          name, n, percentile(ticks, n, 0) * 1e6 / hz,
+          percentile(ticks, n, 50) * 1e6 / hz,
+          percentile(ticks, n, 99) * 1e6 / hz,
+          percentile(ticks, n, 100) * 1e6 / hz);
+}
+
+/*
+ * Render the timeline and the latencies
+ */
+static void render(uint32_t first, uint32_t total, uint32_t hz, int quiet) {
+   static const char * heads[4] = { "isr", "key", "state", "display" };
+   uint64_t p1[TRACE_RECORDS], p3[TRACE_RECORDS], shown[TRACE_RECORDS];
+   int n1 = 0, n3 = 0, nshown = 0;
+   uint32_t p1_at = 0, p3_at = 0, key_at = 0;
+   int in_p1 = 0, in_p3 = 0, key_pending = 0, key_in_p3 = 0;
+   int in_render = 0, preempting = 0;
+   int keyless = 0, unshown = 0;
+   int k, c;
+
+   printf("%u events recorded, %d in the ring", total, count);
+   if (first > 0) {
+      printf(" (%u older ones overwritten)", first);
+   }
+   printf(", %u ticks/s\n", hz);
+   if (count == 0) {
+      return;
+   }
+
+   if (!quiet) {
+      printf("\n%10s %9s", "time us", "+us");
+      for (c = 0; c < 3; ++c) {
+         printf("  %-14s", heads[c]);
+      }
+      printf("  %s\n", heads[3]);
+   }
+   for (k = 0; k < count; ++k) {
+      const trace_record_t * r = &records[k];
+      // unsigned differences survive the 32-bit wrap
+      double at = (uint32_t)(r->time - records[0].time) * 1e6 / hz;
+      double dt = k ? (uint32_t)(r->time - records[k - 1].time) * 1e6 / hz : 0;
+      if (!quiet) {
+         printf("%10.1f %9.1f", at, dt);
+         for (c = 0; c < column(r->event); ++c) {
+            printf("  %-14s", "");
+         }
+         printf("  %s\n", describe(r));
+      }
+
+      switch (r->event) {
+         case TRACE_PORT1_ENTER:
+            p1_at = r->time;
+            in_p1 = 1;
+            break;
+         case TRACE_PORT1_EXIT:
+            if (in_p1) {
+               p1[n1++] = (uint32_t)(r->time - p1_at);
+            }
+            in_p1 = 0;
+            break;
+         case TRACE_PORT3_ENTER:
+            p3_at = r->time;
+            in_p3 = 1;
+            key_in_p3 = 0;
+            if (in_render) {
+               ++preempting; // the keypad didn't wait for the redraw
+            }
+            break;
+         case TRACE_RENDER_ENTER:
+            in_render = 1;
+            break;
+         case TRACE_RENDER_EXIT:
+            in_render = 0;
+            break;
+         case TRACE_PORT3_EXIT:
+            if (in_p3) {
+               p3[n3++] = (uint32_t)(r->time - p3_at);
+               if (!key_in_p3) {
+                  ++keyless; // DA fired, nothing was decoded
+               }
+            }
+            in_p3 = 0;
+            break;
+         case TRACE_KEY:
+            if (key_pending) {
+               ++unshown; // the last key never reached the display
+            }
+            key_at = r->time;
+            key_pending = 1;
+            key_in_p3 = 1;
+            break;
+         case TRACE_FLUSH_END:
+            if (key_pending) {
+               shown[nshown++] = (uint32_t)(r->time - key_at);
+            }
+            key_pending = 0;
+            break;
+         default:
+            break;
+      }
+   }
+
+   printf("\n");
+   print_latency("PORT1_IRQHandler", p1, n1, hz);
+   print_latency("PORT3_IRQHandler", p3, n3, hz);
+   print_latency("key -> flush done", shown, nshown, hz);
+   if (preempting) {
+      printf("%d port 3 interrupts preempted a redraw\n", preempting);
+   }
+   if (keyless) {
+      printf("SUSPECT: %d port 3 interrupts decoded no key\n", keyless);
+   }
+   if (unshown) {
+      printf("SUSPECT: %d keys were followed by another key before a flush\n",
+             unshown);
+   }
+}
+
+int main(int argc, char ** argv) {
+   int keys = -1, start = 0, quiet = 0;
+   int opt, fd, k;
+   pid_t child = 0;
+   linkio_t io;
+   link_frame_t frame;
+   uint8_t command;
+   uint32_t first = 0, total = 0, hz = 1;
+
+   while ((opt = getopt(argc, argv, "sk:q")) != -1) {
+      switch (opt) {
+         case 's': start = 1; break;
+         case 'k': keys = atoi(optarg); break;
+         case 'q': quiet = 1; break;
+         default:
+            fprintf(stderr, "usage: %s [-s] [-k keys] [-q] [serial port]\n",
+                    argv[0]);
+            return 2;
+      }
+   }
+   if (optind < argc) {
+      fd = link_open(argv[optind]);
+   }
+   else {
+      child = standin_spawn(&fd);
+   }
+   if (keys < 0) {
+      keys = child ? 24 : 0;
+   }
+   linkio_init(&io, fd);
+
+   if (start) {
+      command = TRACE_CMD_START;
+      linkio_send(&io, LINK_TRACE_CTL, &command, 1);
+   }
+   /* one key at a time, so each is traced on its own */
+   for (k = 0; k < keys; ++k) {
+      uint8_t key = script[k % sizeof(script)];
+      linkio_send(&io, LINK_INJECT, &key, 1);
+      if (!wait_for(&io, &frame, LINK_DISPLAY)) {
+         fprintf(stderr, "tracedump: lost the device after %d keys\n", k);
+         return 1;
+      }
+   }
+
+   command = TRACE_CMD_DUMP;
+   linkio_send(&io, LINK_TRACE_CTL, &command, 1);
+   for (;;) {
+      if (linkio_read(&io, &frame, TIMEOUT_MS) != 1) {
+         fprintf(stderr, "tracedump: the dump didn't finish\n");
+         return 1;
+      }
+      if (frame.type == LINK_TRACE && frame.len >= 4) {
+         uint32_t number = link_get_u32(frame.payload);
+         int in_frame = (frame.len - 4) / 6;
+         if (count == 0) {
+            first = number;
+         }
+         for (k = 0; k < in_frame && count < TRACE_RECORDS; ++k) {
+            const uint8_t * p = &frame.payload[4 + 6 * k];
+            records[count].time = link_get_u32(p);
+            records[count].event = p[4];
+            records[count].arg = p[5];
+            ++count;
+         }
+      }
+      else if (frame.type == LINK_TRACE_END && frame.len >= 8) {
+         total = link_get_u32(&frame.payload[0]);
+         hz = link_get_u32(&frame.payload[4]);
+         break;
+      }
+   }
+   if (count == 0) {
+      first = total;
+   }
+   render(first, total, hz ? hz : 1, quiet);
+
+   if (child) {
+      close(fd);
+      kill(child, SIGTERM);
+      waitpid(child, NULL, 0);
+   }
+   return 0;
+}
@@ -0,0 +1,214 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/vecbench.c
+ * Description:
+ *      Checks and times calcvec_op() (see calcvec.h) against calc_op()
+ *      one pair at a time. Random operand pairs (some divisors 0, some
+ *      operands near the top of the fixed-point range) go through
+ *      each operation, '=' (not one), a column of mixed operations and
+ *      the same operations sorted (runs of one operation):
+ *        - every result and status of the portable kernels and, when
+ *          the CPU has them, the AVX2 kernels must be calc_op()'s; a
+ *          result must have the same bits as a double and the same
+ *          text at 9 digits
+ *        - M pairs per second for calc_op() in a loop, the portable
+ *          kernels and the AVX2 kernels
+ *      The Makefile builds this for the default backend and as
+ *      vecbench-double and vecbench-fixed, which have AVX2 kernels.
+ *
+ *      usage: vecbench [-n pairs] [-r repeats]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../calc.h"
+#include "calcvec.h"
+
+#define DIGITS 9 /* compare the text of results this far */
+
+/**
+ * The firmware's assert() shows the message on the GLCD
+ */
+void assert(const int condition, char * message) {
+   (void)condition;
+   (void)message;
+}
+
+static uint64_t now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*
+ * An operand of any size the calculator handles: mostly amounts with
+ * cents, some whole numbers, some 0 and some near 2^43
+ */
+static CALC_TYPE random_operand(void) {
+   double value;
+   switch (rand() % 16) {
+      case 0:  value = 0; break;
+      case 1:  value = 8.7e12 - rand() % 1000; break;
+      case 2:  value = rand(); break;
+      default: value = (rand() % 10000000) / 100.0; break;
+   }
+   return num_from_double(rand() & 1 ? -value : value);
+}
+
+/*
+ * Whether two results are the same number, bit for bit as a double
+ * and digit for digit as text
+ */
+static int same(CALC_TYPE a, CALC_TYPE b) {
+   double x = num_to_double(a), y = num_to_double(b);
+   char ta[64], tb[64];
+   if (memcmp(&x, &y, sizeof(x)) != 0) {
+      return 0;
+   }
+   calc_format(a, DIGITS, ta, sizeof(ta));
+   calc_format(b, DIGITS, tb, sizeof(tb));
+   return strcmp(ta, tb) == 0;
+}
+
+/*
+ * calc_op() a pair at a time, the way the columns must come out
+ */
+static void scalar(const CALC_TYPE * lhs, const char * ops, char op,
+                   const CALC_TYPE * rhs, CALC_TYPE * result,
+                   uint8_t * status, int n) {
+   int i; // used in for loop
+   for (i = 0; i < n; ++i) {
+      int s;
+      result[i] = calc_op(lhs[i], ops ? ops[i] : op, rhs[i], &s);
+      status[i] = (uint8_t)s;
+   }
+}
+
+/*
+ * Compare calcvec_op() with calc_op() on one column
+ * Returns the number of pairs that differ
+ */
+static int check(const CALC_TYPE * lhs, const char * ops, char op,
+                 const CALC_TYPE * rhs, CALC_TYPE * want, uint8_t * want_status,
+                 CALC_TYPE * got, uint8_t * got_status, int n) {
+   int i, bad = 0; // i used in for loop
+   scalar(lhs, ops, op, rhs, want, want_status, n);
+   memset(got_status, 0xFF, n);
+   calcvec_op(lhs, ops, op, rhs, got, got_status, n);
+   for (i = 0; i < n; ++i) {
+      if (got_status[i] != want_status[i] || !same(got[i], want[i])) {
+         if (bad++ == 0) {
+            printf("  %s %c: pair %d: status %d, want %d\n", calcvec_isa(),
+                   ops ? ops[i] : op, i, got_status[i], want_status[i]);
+         }
+      }
+   }
+   return bad;
+}
+
+int main(int argc, char ** argv) {
+   // 'm' for the mixed column, 's' for it sorted
+   static const char columns[] = "+-*/ms";
+   int n = 1 << 16, repeats = 200;
+   CALC_TYPE * lhs, * rhs, * want, * got;
+   uint8_t * want_status, * got_status;
+   char * ops, * sorted;
+   int opt, i, c, length, portable, differ = 0, div_by_zero = 0, overflow = 0;
+
+   while ((opt = getopt(argc, argv, "n:r:")) != -1) {
+      switch (opt) {
+         case 'n': n = atoi(optarg); break;
+         case 'r': repeats = atoi(optarg); break;
+         default:
+            fprintf(stderr, "usage: %s [-n pairs] [-r repeats]\n", argv[0]);
+            return 2;
+      }
+   }
+   if (n < 1) {
+      n = 1;
+   }
+   lhs = malloc(n * sizeof(CALC_TYPE));
+   rhs = malloc(n * sizeof(CALC_TYPE));
+   want = malloc(n * sizeof(CALC_TYPE));
+   got = malloc(n * sizeof(CALC_TYPE));
+   want_status = malloc(n);
+   got_status = malloc(n);
+   ops = malloc(n);
+   sorted = malloc(n);
+   srand(1);
+   for (i = 0; i < n; ++i) {
+      lhs[i] = random_operand();
+      rhs[i] = random_operand();
+      ops[i] = rand() % 64 == 0 ? '=' : "+-*/"[rand() % 4];
+   }
+   for (c = 0, length = 0; c < 5; ++c) {
+      for (i = 0; i < n; ++i) {
+         if (ops[i] == "+-*/="[c]) {
+            sorted[length++] = ops[i];
+         }
+      }
+   }
+
+   // the same results and statuses, with both sets of kernels
+   for (portable = 1; portable >= 0; --portable) {
+      calcvec_portable(portable);
+      if (!portable && strcmp(calcvec_isa(), "portable") == 0) {
+         break;
+      }
+      for (c = 0; c < (int)sizeof(columns); ++c) {
+         // the '\0' at the end is a column of what isn't an operation
+         char op = columns[c] ? columns[c] : '=';
+         differ += check(lhs, op == 'm' ? ops : op == 's' ? sorted : NULL, op,
+                         rhs, want, want_status, got, got_status, n);
+         for (i = 0; portable && i < n; ++i) {
+            div_by_zero += want_status[i] == CALC_DIV_BY_ZERO;
+            overflow += want_status[i] == CALC_OVERFLOW;
+         }
+      }
+   }
+   printf("%d pairs, backend %s, best kernels %s: %s "
+          "(%d divisions by zero, %d overflows)\n", n, NUM_NAME,
+          calcvec_isa(), differ ? "DIFFERENT" : "same as calc_op()",
+          div_by_zero, overflow);
+
+   // M pairs per second
+   printf("  column     calc_op   portable       avx2  (M pairs/s)\n");
+   for (c = 0; c < (int)sizeof(columns) - 1; ++c) {
+      char op = columns[c];
+      const char * column_ops = op == 'm' ? ops : op == 's' ? sorted : NULL;
+      char name[2] = { op, '\0' };
+      double rate[3] = { 0, 0, 0 };
+      int k, r; // used in for loops
+      for (k = 0; k < 3; ++k) {
+         uint64_t start;
+         if (k > 0) {
+            calcvec_portable(k == 1);
+            if (k == 2 && strcmp(calcvec_isa(), "avx2") != 0) {
+               break;
+            }
+         }
+         start = now_ns();
+         for (r = 0; r < repeats; ++r) {
+            if (k == 0) {
+               scalar(lhs, column_ops, op, rhs, want, want_status, n);
+            }
+            else {
+               calcvec_op(lhs, column_ops, op, rhs, got, got_status, n);
+            }
+         }
+         rate[k] = (double)n * repeats * 1e3 / (now_ns() - start);
+      }
+      printf("  %-6s %10.1f %10.1f ", op == 'm' ? "mixed" : op == 's' ? "sorted" : name,
+             rate[0], rate[1]);
+      if (rate[2] > 0) {
+         printf("%10.1f\n", rate[2]);
+      }
+      else {
+         printf("%10s\n", "-");
+      }
+   }
+   calcvec_portable(0);
+   return differ ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: host/vmbench.c
+ * Description:
+ *      Runs key programs (vm.c) on the host, without a device: for
+ *      each program its bytes of code, the instructions a run takes,
+ *      and how many million instructions a second the interpreter
+ *      gets through. vmbench dispatches the way GCC builds it for the
+ *      device (computed goto); vmbench-switch is the same built with
+ *      VM_SWITCH, the way a compiler without label addresses runs it.
+ *
+ *      usage: vmbench [-n runs] [source]
+ *             -n  how many times to run each program (default 20000)
+ *             source, if given, is run instead of the built-in programs,
+ *             with a = 5 and b = 3
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../vm.h"
+
+/* the built-in programs, and the lhs and rhs they run on */
+static const struct {
+   const char * name;
+   const char * source;
+   int lhs, rhs;
+} programs[] = {
+   { "squares", "a a * b b * +", 3, 4 },
+   { "horner", "a 3 * 2 - a * 5 + a * 7 -", 2, 0 },
+   { "factorial", "1 =c begin c a * =c a 1 - =a a 1 < until c", 10, 0 },
+   { "sum 1..a", "0 =c 0 =d begin c 1 + =c d c + =d c a < 0 = until d",
+     500, 0 },
+   { "sign", "a 0 < if 1 neg else a 0 > then", -7, 0 },
+};
+
+/**
+ * The firmware's assert() shows the message on the GLCD
+ */
+void assert(const int condition, char * message) {
+   (void)condition;
+   (void)message;
+}
+
+static uint64_t now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*
+ * Compile and time one program
+ * Returns 0, or 1 if it didn't compile or run
+ */
+static int bench(const char * name, const char * source, int lhs, int rhs,
+                 long runs) {
+   vm_program_t p;
+   CALC_TYPE result = num_from_int(0);
+   uint32_t steps;
+   uint64_t start, ns;
+   int status, at;
+   long run;
+
+   status = vm_compile(source, strlen(source), &p, &at);
+   if (status != CALC_OK) {
+      printf("%-10s error %d at %d: %s\n", name, status, at, source);
+      return 1;
+   }
+   steps = vm_steps;
+   start = now_ns();
+   for (run = 0; run < runs; ++run) {
+      result = vm_run(&p, num_from_int(lhs), num_from_int(rhs), &status);
+   }
+   ns = now_ns() - start;
+   steps = vm_steps - steps;
+   if (ns == 0) {
+      ns = 1;
+   }
+   printf("%-10s %5d %7u %10.2f %9.1f  %-10g%s\n", name, p.length,
+          (unsigned)(steps / runs), steps * 1e3 / ns, (double)ns / runs,
+          num_to_double(result), status == CALC_OK ? "" : "  (error)");
+   return status != CALC_OK;
+}
+
+int main(int argc, char ** argv) {
+   long runs = 20000;
+   int failed = 0;
+   int opt, k;
+
+   while ((opt = getopt(argc, argv, "n:")) != -1) {
+      switch (opt) {
+         case 'n': runs = atol(optarg); break;
+         default:
+            fprintf(stderr, "usage: %s [-n runs] [source]\n", argv[0]);
+            return 2;
+      }
+   }
+   if (runs < 1) {
+      runs = 1;
+   }
+
+#ifdef VM_SWITCH
+   printf("dispatch: switch\n");
+#else
+   printf("dispatch: computed goto\n");
+#endif
+   printf("%-10s %5s %7s %10s %9s  %s\n", "program", "bytes", "instr",
+          "M instr/s", "ns/run", "result");
+   if (optind < argc) {
+      return bench("source", argv[optind], 5, 3, runs);
+   }
+   for (k = 0; k < (int)(sizeof(programs) / sizeof(programs[0])); ++k) {
+      failed |= bench(programs[k].name, programs[k].source, programs[k].lhs,
+                      programs[k].rhs, runs);
+   }
+   return failed;
+}
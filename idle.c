@@ -0,0 +1,145 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: idle.c
+ * Description:
+ *      The inactivity manager (see idle.h).
+ */
+#include "msp.h"
+#include "ramfunc.h"
+#include "idle.h"
+#include "timebase.h"
+
+/* statistics */
+volatile uint32_t idle_sleeps = 0;
+volatile uint32_t idle_wake_last = 0;
+volatile uint32_t idle_wake_max = 0;
+
+static volatile uint8_t due = 0;     // the timeout fired, no input since
+static volatile uint8_t asleep = 0;  // the panel is powered down
+static volatile uint8_t waking = 0;  // an input came while it was
+static volatile uint32_t woke_at;    // timebase_now() of that input
+
+/* Timer_A1 from ACLK / 8 / 8, up to CCR0 */
+#define IDLE_TIMER_CTL (TIMER_A_CTL_SSEL__ACLK | TIMER_A_CTL_ID__8)
+
+/**
+ * Start the timeout of the given seconds (1 to 128), its interrupt at
+ * the given priority
+ */
+void idle_init(uint32_t seconds, uint32_t priority) {
+   CS->KEY = CS_KEY_VAL;  /* unlock CS module for register access */
+   CS->CTL1 = (CS->CTL1 & ~CS_CTL1_SELA_MASK)
+            | CS_CTL1_SELA__REFOCLK;  /* ACLK = REFO, 32768 Hz in LPM3 too */
+   CS->KEY = 0;
+
+   TIMER_A1->CTL = TIMER_A_CTL_MC__STOP | TIMER_A_CTL_CLR; /* stop */
+   TIMER_A1->EX0 = TIMER_A_EX0_IDEX__8;     /* with ID__8: 512 Hz */
+   TIMER_A1->CCR[0] = seconds * IDLE_TICK_HZ - 1;
+   TIMER_A1->CCTL[0] = TIMER_A_CCTLN_CCIE;
+   NVIC_SetPriority(TA1_0_IRQn, priority);
+   NVIC_EnableIRQ(TA1_0_IRQn);
+#ifdef IDLE_LPM3
+   // eUSCI clock requests would otherwise keep the MCU out of LPM3
+   PCM->CTL1 = PCM_CTL1_KEY_VAL | PCM_CTL1_FORCE_LPM_ENTRY;
+#endif
+   idle_activity();
+}
+
+/**
+ * An input: start the timeout over, and if the panel is down, note
+ * when for the wake-to-first-pixel time
+ * Called by post_input() with interrupts disabled.
+ */
+RAMFUNC void idle_activity(void) {
+   if (asleep && !waking) {
+      woke_at = timebase_now();
+      waking = 1;
+   }
+   due = 0;
+   TIMER_A1->CTL = IDLE_TIMER_CTL | TIMER_A_CTL_MC__UP | TIMER_A_CTL_CLR;
+}
+
+/**
+ * The timeout: stop the timer (it starts again on the next input) and
+ * have PendSV power the panel down
+ */
+void TA1_0_IRQHandler(void) {
+   TIMER_A1->CCTL[0] &= ~TIMER_A_CCTLN_CCIFG;
+   TIMER_A1->CTL = IDLE_TIMER_CTL | TIMER_A_CTL_MC__STOP;
+   due = 1;
+   idle_post();
+}
+
+/**
+ * Time out now, as if IDLE_TIMEOUT had passed (for benchmarks)
+ */
+void idle_expire(void) {
+   TIMER_A1->CCTL[0] |= TIMER_A_CCTLN_CCIFG;
+}
+
+/**
+ * Power the panel down, unless an input came since the timeout
+ * Call it from PendSV, with nothing left to draw.
+ */
+void idle_sleep(void) {
+   unsigned int state = _disable_interrupts();
+   if (!due || asleep) {
+      _restore_interrupts(state);
+      return;
+   }
+   due = 0;
+   asleep = 1; // an input from here on wakes it
+   _restore_interrupts(state);
+   idle_panel(0);
+   ++idle_sleeps;
+}
+
+/**
+ * Power the panel up if an input came while it was down; its RAM
+ * still holds the last picture, so that shows at once
+ * Call it from PendSV before the input is handled.
+ */
+void idle_wake(void) {
+   unsigned int state;
+   uint32_t took;
+   if (!waking) {
+      return;
+   }
+   idle_panel(1);
+   took = timebase_now() - woke_at;
+   idle_wake_last = took;
+   if (took > idle_wake_max) {
+      idle_wake_max = took;
+   }
+   state = _disable_interrupts();
+   asleep = 0;
+   waking = 0;
+   _restore_interrupts(state);
+}
+
+/**
+ * Whether the panel is powered down
+ */
+int idle_asleep(void) {
+   return asleep;
+}
+
+/**
+ * With IDLE_LPM3, stay in LPM3 while the panel is down, until an
+ * interrupt (a key or S1); otherwise return at once
+ * Call it from the main loop.
+ */
+void idle_lpm3(void) {
+#ifdef IDLE_LPM3
+   unsigned int state = _disable_interrupts();
+   if (asleep && !waking) {
+      PCM->CTL0 = (PCM->CTL0 & ~(PCM_CTL0_KEY_MASK | PCM_CTL0_LPMR_MASK))
+                | PCM_CTL0_KEY_VAL | PCM_CTL0_LPMR__LPM3;
+      SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+      __DSB();
+      __WFI(); // a pending interrupt ends it, even with interrupts disabled
+      SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+   }
+   _restore_interrupts(state);
+#endif
+}
@@ -0,0 +1,54 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: idle.h
+ * Description:
+ *      Inactivity manager. Timer_A1 counts down IDLE_TIMEOUT seconds
+ *      from the last input; then PendSV sets the power-down bit of the
+ *      PCD8544's function set, which blanks the panel and stops its
+ *      voltage generator but keeps the display RAM. The next input
+ *      (a key on the P3.0 DA interrupt, S1, or one from the host)
+ *      clears the bit before anything else, so the old picture is back
+ *      at once without a redraw, and the key's own change follows at
+ *      the next frame slot.
+ *      The timer runs from ACLK (REFO, 32768 Hz), so it keeps counting
+ *      in LPM3. Built with IDLE_LPM3, the main loop puts the MCU in
+ *      LPM3 while the panel is down, until the next key or S1.
+ *      idle_wake_last and idle_wake_max are the wake-to-first-pixel
+ *      times: from the input's interrupt to the panel showing again.
+ *      NOTE:
+ *              Build with IDLE_TIMEOUT defined (in seconds, 1 to 128)
+ *              to change the timeout.
+ *              The platform provides idle_post() (queue a sleep for
+ *              PendSV) and idle_panel() (the function-set command).
+ *              In LPM3 the UART, SysTick and Timer32 stop: the host
+ *              link doesn't wake the MCU, and the sleep doesn't count
+ *              in the timebase.
+ */
+#ifndef IDLE_H
+#define IDLE_H
+
+#include <stdint.h>
+
+#ifndef IDLE_TIMEOUT
+#define IDLE_TIMEOUT 30 /* seconds without input before the panel sleeps */
+#endif
+
+#define IDLE_TICK_HZ 512 /* the timer's rate, ACLK / 64 */
+
+/* statistics */
+extern volatile uint32_t idle_sleeps;    // times the panel went down
+extern volatile uint32_t idle_wake_last; // timebase ticks, input -> panel on
+extern volatile uint32_t idle_wake_max;
+
+/* prototypes */
+void idle_init(uint32_t, uint32_t);
+void idle_activity(void);
+void idle_expire(void);
+void idle_sleep(void);
+void idle_wake(void);
+int idle_asleep(void);
+void idle_lpm3(void);
+void idle_post(void);     // platform provided
+void idle_panel(int);     // platform provided
+
+#endif /* IDLE_H */
@@ -0,0 +1,341 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: link.c
+ * Description:
+ *      Encoding and decoding of host-link frames (see link.h), and the
+ *      device side of the protocol: the messages the calculator sends
+ *      and the dispatch of the frames it receives.
+ */
+#include <string.h>
+#include "link.h"
+#include "batch.h"
+#include "stackmon.h"
+#include "trace.h"
+#include "plot.h"
+#include "vm.h"
+
+#ifdef __TI_COMPILER_VERSION__
+#include "msp.h"
+/* PendSV and the main loop both send frames */
+#define LINK_LOCK(state) (state) = _disable_interrupts()
+#define LINK_UNLOCK(state) _restore_interrupts(state)
+#else
+/* the host stand-in has a single thread */
+#define LINK_LOCK(state) (void)(state)
+#define LINK_UNLOCK(state) (void)(state)
+#endif
+
+link_rx_t link_rx; // receiver used by link_receive()
+static uint8_t tx_seq = 0; // sequence number of the next frame sent
+
+/**
+ * CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF)
+ */
+uint16_t link_crc16(const uint8_t * data, uint16_t length) {
+   uint16_t crc = 0xFFFF;
+   int bit; // used in for loop
+   for (; length > 0; --length) {
+      crc ^= (uint16_t)(*data++) << 8;
+      for (bit = 0; bit < 8; ++bit) {
+         crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+      }
+   }
+   return crc;
+}
+
+/*
+ * Append a byte to an encoded frame, escaping it if needed
+ */
+static uint16_t put_escaped(uint8_t * out, uint16_t n, uint8_t byte) {
+   if (byte == LINK_FLAG || byte == LINK_ESCAPE) {
+      out[n++] = LINK_ESCAPE;
+      byte ^= 0x20;
+   }
+   out[n++] = byte;
+   return n;
+}
+
+/**
+ * Encode a frame into out (at least LINK_MAX_FRAME bytes)
+ * Returns the number of bytes to send
+ */
+uint16_t link_encode(uint8_t * out, uint8_t type, uint8_t seq,
+                     const uint8_t * payload, uint8_t len) {
+   uint8_t body[3 + LINK_MAX_PAYLOAD];
+   uint16_t crc;
+   uint16_t n = 0; // bytes encoded so far
+   int k; // used in for loop
+
+   if (len > LINK_MAX_PAYLOAD) {
+      len = LINK_MAX_PAYLOAD; // never overrun the receiver
+   }
+   body[0] = type;
+   body[1] = seq;
+   body[2] = len;
+   memcpy(&body[3], payload, len);
+   crc = link_crc16(body, 3 + len);
+
+   out[n++] = LINK_FLAG;
+   for (k = 0; k < 3 + len; ++k) {
+      n = put_escaped(out, n, body[k]);
+   }
+   n = put_escaped(out, n, crc & 0xFF);
+   n = put_escaped(out, n, crc >> 8);
+   out[n++] = LINK_FLAG;
+   return n;
+}
+
+/**
+ * Feed one received byte to a receiver
+ * Returns 1 and fills frame once a complete frame with a good CRC has
+ * arrived, else 0. Bad frames are counted and skipped.
+ */
+int link_rx_byte(link_rx_t * rx, uint8_t byte, link_frame_t * frame) {
+   uint16_t crc;
+   uint8_t len;
+
+   if (byte == LINK_FLAG) {
+      // a flag ends the current frame (back-to-back flags are idle)
+      int complete = 0;
+      if (!rx->dropping && rx->count >= 5) {
+         len = rx->buf[2];
+         crc = rx->buf[rx->count - 2] | (rx->buf[rx->count - 1] << 8);
+         if (len <= LINK_MAX_PAYLOAD && rx->count == 5 + len
+             && crc == link_crc16(rx->buf, 3 + len)) {
+            frame->type = rx->buf[0];
+            frame->seq = rx->buf[1];
+            frame->len = len;
+            memcpy(frame->payload, &rx->buf[3], len);
+            ++rx->frames;
+            complete = 1;
+         }
+         else {
+            ++rx->crc_errors;
+         }
+      }
+      else if (rx->dropping || rx->count > 0) {
+         ++rx->crc_errors; // runt or oversized frame
+      }
+      rx->count = 0;
+      rx->escaped = 0;
+      rx->dropping = 0;
+      return complete;
+   }
+
+   if (rx->dropping) {
+      return 0;
+   }
+   if (byte == LINK_ESCAPE) {
+      rx->escaped = 1;
+      return 0;
+   }
+   if (rx->escaped) {
+      byte ^= 0x20;
+      rx->escaped = 0;
+   }
+   if (rx->count >= sizeof(rx->buf)) {
+      rx->dropping = 1; // too long to be one of ours
+      return 0;
+   }
+   rx->buf[rx->count++] = byte;
+   return 0;
+}
+
+/**
+ * Little-endian field helpers
+ */
+void link_put_u32(uint8_t * p, uint32_t value) {
+   p[0] = value;
+   p[1] = value >> 8;
+   p[2] = value >> 16;
+   p[3] = value >> 24;
+}
+
+uint32_t link_get_u32(const uint8_t * p) {
+   return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16)
+          | ((uint32_t)p[3] << 24);
+}
+
+void link_put_f64(uint8_t * p, double value) {
+   memcpy(p, &value, 8); // both ends are little endian
+}
+
+double link_get_f64(const uint8_t * p) {
+   double value;
+   memcpy(&value, p, 8);
+   return value;
+}
+
+/**
+ * Encode and send one frame through the platform transport
+ * Returns 0 if the transport had no room for it
+ */
+int link_send(uint8_t type, const uint8_t * payload, uint8_t len) {
+   uint8_t frame[LINK_MAX_FRAME];
+   unsigned int state;
+   uint8_t seq;
+   uint16_t n;
+   int sent;
+
+   // take a number, encode outside the lock
+   LINK_LOCK(state);
+   seq = tx_seq++;
+   LINK_UNLOCK(state);
+   n = link_encode(frame, type, seq, payload, len);
+   sent = link_transport_write(frame, n);
+   // only frames that went out use up a number (unless another frame
+   // took the next one meanwhile; the host then sees a gap)
+   LINK_LOCK(state);
+   if (!sent && tx_seq == (uint8_t)(seq + 1)) {
+      tx_seq = seq;
+   }
+   LINK_UNLOCK(state);
+   return sent;
+}
+
+/**
+ * Announce the device and its timestamp rate
+ */
+void link_send_hello(uint32_t tick_hz) {
+   uint8_t payload[5];
+   payload[0] = LINK_VERSION;
+   link_put_u32(&payload[1], tick_hz);
+   link_send(LINK_HELLO, payload, sizeof(payload));
+}
+
+/**
+ * Report a decoded key and when it arrived
+ */
+void link_send_key(uint8_t key, uint8_t source, uint32_t timestamp) {
+   uint8_t payload[6];
+   payload[0] = key;
+   payload[1] = source;
+   link_put_u32(&payload[2], timestamp);
+   link_send(LINK_KEY, payload, sizeof(payload));
+}
+
+/**
+ * Report the result of a math operation and its status
+ */
+void link_send_result(uint8_t status, CALC_TYPE result, uint32_t timestamp) {
+   uint8_t payload[13];
+   payload[0] = status;
+   link_put_f64(&payload[1], num_to_double(result));
+   link_put_u32(&payload[9], timestamp);
+   link_send(LINK_RESULT, payload, sizeof(payload));
+}
+
+/**
+ * Report what the display shows: lhs, operation, rhs and the focus
+ * The payload is filled with interrupts off: the main loop calls this
+ * for LINK_QUERY while PendSV changes calc, and 18 bytes on the stack
+ * cost PendSV less than a copy of calc would
+ */
+void link_send_display(void) {
+   uint8_t payload[18];
+   unsigned int state;
+   LINK_LOCK(state); // not torn by a key in PendSV
+   link_put_f64(&payload[0], num_to_double(calc.lhs));
+   payload[8] = calc.operation;
+   link_put_f64(&payload[9], num_to_double(calc.rhs));
+   payload[17] = CALC_ON_RHS(calc.state) ? LINK_FOCUS_RHS : LINK_FOCUS_LHS;
+   LINK_UNLOCK(state);
+   link_send(LINK_DISPLAY, payload, sizeof(payload));
+}
+
+/**
+ * Send the stack usage (see stackmon.h)
+ */
+void link_send_stack(void) {
+   uint8_t payload[5 + 6 * STACK_ISR_COUNT];
+   int isr; // used in for loop
+   payload[0] = stack_size() & 0xFF;
+   payload[1] = stack_size() >> 8;
+   payload[2] = stack_high_water() & 0xFF;
+   payload[3] = stack_high_water() >> 8;
+   payload[4] = stack_nesting_max;
+   for (isr = 0; isr < STACK_ISR_COUNT; ++isr) {
+      payload[5 + 6 * isr] = stack_isr[isr].entry_max & 0xFF;
+      payload[6 + 6 * isr] = stack_isr[isr].entry_max >> 8;
+      link_put_u32(&payload[7 + 6 * isr], stack_isr[isr].count);
+   }
+   link_send(LINK_STACK, payload, sizeof(payload));
+}
+
+/**
+ * Send the report of a macro replay
+ * Returns 1 if it was sent, 0 if the link was busy
+ */
+int link_send_macro_report(const macro_report_t * report, uint32_t hz) {
+   uint8_t payload[28];
+   link_put_u32(&payload[0], report->keys);
+   link_put_u32(&payload[4], report->dropped);
+   link_put_u32(&payload[8], report->ticks);
+   link_put_u32(&payload[12], hz);
+   link_put_u32(&payload[16], report->p50);
+   link_put_u32(&payload[20], report->p99);
+   link_put_u32(&payload[24], report->max);
+   return link_send(LINK_MACRO_REPORT, payload, sizeof(payload));
+}
+
+/*
+ * Compile the source of a LINK_PROGRAM frame, or keep it until the
+ * rest comes, and tell the host how it went
+ */
+static void link_program(const link_frame_t * frame) {
+   uint8_t payload[3];
+   int slot, detail;
+   int status = vm_request(frame->payload, frame->len, &slot, &detail);
+   if (status == VM_MORE) {
+      return;
+   }
+   payload[0] = slot;
+   payload[1] = status;
+   payload[2] = detail;
+   link_send(LINK_PROGRAM_STATUS, payload, sizeof(payload));
+}
+
+/**
+ * Feed one byte from the host; complete frames are acted on here
+ */
+void link_receive(uint8_t byte) {
+   link_frame_t frame;
+   if (!link_rx_byte(&link_rx, byte, &frame)) {
+      return;
+   }
+   switch (frame.type) {
+      case LINK_INJECT: /* remote key press */
+         if (frame.len >= 1 && frame.payload[0] <= KEY_EQUALS) {
+            link_key_injected(frame.payload[0]);
+         }
+         break;
+      case LINK_PING: /* round-trip probe */
+         link_send(LINK_PONG, frame.payload, frame.len);
+         break;
+      case LINK_QUERY: /* display state request */
+         link_send_display();
+         break;
+      case LINK_STACK_QUERY: /* stack usage request */
+         link_send_stack();
+         break;
+      case LINK_TRACE_CTL: /* trace dump, start or stop */
+         if (frame.len >= 1) {
+            trace_control(frame.payload[0]);
+         }
+         break;
+      case LINK_MACRO_CTL: /* macro record, stop or replay */
+         macro_control(frame.payload, frame.len);
+         break;
+      case LINK_EXPR: /* batch expression record */
+         batch_accept(&frame);
+         break;
+      case LINK_PLOT: /* function to plot, for PendSV */
+         plot_request(frame.payload, frame.len);
+         break;
+      case LINK_PROGRAM: /* key program, compiled here */
+         link_program(&frame);
+         break;
+      default: /* ignore what we don't know */
+         break;
+   }
+}
@@ -0,0 +1,123 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: link.h
+ * Description:
+ *      Framed binary protocol between the calculator and a host.
+ *      Every frame on the wire is
+ *
+ *          FLAG | type | seq | len | payload[len] | crc16 (LSB first) | FLAG
+ *
+ *      where FLAG is 0x7E, the CRC is CRC-16/CCITT-FALSE over type
+ *      through payload, and any 0x7E or 0x7D between the flags is sent
+ *      as 0x7D followed by the byte XOR 0x20. Multi-byte fields are
+ *      little endian; numbers are IEEE-754 doubles (whatever the
+ *      numeric backend, see num.h).
+ *      NOTE:
+ *              The platform provides link_transport_write() (the UART
+ *              on the board, a pty in the host tools) and
+ *              link_key_injected() for keys sent by the host.
+ */
+#ifndef LINK_H
+#define LINK_H
+
+#include <stdint.h>
+#include "calc.h"
+#include "macro.h"
+
+#define LINK_VERSION 1
+
+#define LINK_FLAG   0x7E
+#define LINK_ESCAPE 0x7D
+#define LINK_MAX_PAYLOAD 32
+/* FLAG + escaped (type, seq, len, payload, crc) + FLAG */
+#define LINK_MAX_FRAME (2 + 2 * (3 + LINK_MAX_PAYLOAD + 2))
+
+/* frame types: device -> host */
+#define LINK_HELLO   0x01 /* u8 version, u32 timestamp ticks per second */
+#define LINK_KEY     0x02 /* u8 key, u8 source, u32 timestamp */
+#define LINK_RESULT  0x03 /* u8 status, f64 result, u32 timestamp */
+#define LINK_DISPLAY 0x04 /* f64 lhs, u8 operation, f64 rhs, u8 focus */
+#define LINK_PONG    0x05 /* payload of the ping, echoed */
+#define LINK_EXPR_RESULT 0x06 /* u16 id, u8 status, f64 result */
+#define LINK_STACK   0x07 /* u16 size, u16 high water, u8 max nesting,
+                             then per handler (see stackmon.h):
+                             u16 entry depth, u32 count */
+#define LINK_TRACE   0x08 /* u32 number of the first record, then up to
+                             4 records of u32 time, u8 event, u8 arg
+                             (see trace.h) */
+#define LINK_TRACE_END 0x09 /* u32 events recorded, u32 ticks per second */
+#define LINK_MACRO_REPORT 0x0A /* u32 keys, u32 dropped, u32 ticks taken,
+                                  u32 ticks per second, u32 p50, u32 p99,
+                                  u32 max latency ticks (see macro.h) */
+#define LINK_PROGRAM_STATUS 0x0B /* u8 slot, u8 status (CALC_OK or VM_*),
+                                    u8 bytes of code, or where the error
+                                    is in the source */
+/* frame types: host -> device */
+#define LINK_INJECT  0x81 /* u8 key */
+#define LINK_PING    0x82 /* up to LINK_MAX_PAYLOAD bytes */
+#define LINK_QUERY   0x83 /* no payload; answered with LINK_DISPLAY */
+#define LINK_EXPR    0x84 /* u16 id, ASCII expression (see calc_eval()) */
+#define LINK_STACK_QUERY 0x85 /* no payload; answered with LINK_STACK */
+#define LINK_TRACE_CTL 0x86 /* u8 TRACE_CMD_* (see trace.h) */
+#define LINK_MACRO_CTL 0x87 /* u8 MACRO_CMD_*, then for MACRO_CMD_REPLAY
+                               u8 mode, u8 source (see macro.h) */
+#define LINK_PLOT    0x88 /* ASCII function of x (see plot.h); the
+                               device shows its graph */
+#define LINK_PROGRAM 0x89 /* u8 slot, u8 key (or VM_UNBOUND), u8 more
+                               source follows, ASCII source (see vm.h);
+                               answered with LINK_PROGRAM_STATUS */
+
+/* key sources in LINK_KEY */
+#define LINK_SRC_KEYPAD 0
+#define LINK_SRC_HOST   1
+#define LINK_SRC_MACRO  2 /* a replayed macro */
+
+/* focus in LINK_DISPLAY */
+#define LINK_FOCUS_LHS 0
+#define LINK_FOCUS_RHS 1
+
+/* a decoded frame */
+typedef struct {
+   uint8_t type;
+   uint8_t seq;
+   uint8_t len;
+   uint8_t payload[LINK_MAX_PAYLOAD];
+} link_frame_t;
+
+/* receiver state for link_rx_byte() */
+typedef struct {
+   uint8_t buf[3 + LINK_MAX_PAYLOAD + 2]; // unescaped frame body
+   uint8_t count;   // bytes in buf
+   uint8_t escaped; // the last byte was LINK_ESCAPE
+   uint8_t dropping; // frame too long, skip to the next flag
+   uint32_t crc_errors;
+   uint32_t frames;
+} link_rx_t;
+
+/* receive statistics of link_receive() */
+extern link_rx_t link_rx;
+
+/* codec (no platform hooks) */
+uint16_t link_crc16(const uint8_t *, uint16_t);
+uint16_t link_encode(uint8_t *, uint8_t, uint8_t, const uint8_t *, uint8_t);
+int link_rx_byte(link_rx_t *, uint8_t, link_frame_t *);
+void link_put_u32(uint8_t *, uint32_t);
+uint32_t link_get_u32(const uint8_t *);
+void link_put_f64(uint8_t *, double);
+double link_get_f64(const uint8_t *);
+
+/* device side */
+int link_send(uint8_t, const uint8_t *, uint8_t);
+void link_send_hello(uint32_t);
+void link_send_key(uint8_t, uint8_t, uint32_t);
+void link_send_result(uint8_t, CALC_TYPE, uint32_t);
+void link_send_display(void);
+void link_send_stack(void);
+int link_send_macro_report(const macro_report_t *, uint32_t);
+void link_receive(uint8_t);
+
+/* platform hooks */
+int link_transport_write(const uint8_t *, uint16_t);
+void link_key_injected(uint8_t);
+
+#endif /* LINK_H */
@@ -0,0 +1,316 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: macro.c
+ * Description:
+ *      Keystroke macro recording and replay (see macro.h). Keys are
+ *      posted from the main loop (macro_service()), so a replay only
+ *      ever uses the same path as a keypad press. Each posted key's
+ *      time waits in a small FIFO until the redraw that shows it; the
+ *      latencies go into a histogram of four buckets per power of two
+ *      (within 25%), which is where the percentiles come from.
+ */
+#include <stdint.h>
+#include "ramfunc.h"
+#include "timebase.h"
+#include "macro.h"
+#include "link.h"
+#include "calc.h"
+
+#define MACRO_BUCKETS 124 /* 0-3, then 4 per power of two up to 2^32 */
+#define MACRO_MASK (MACRO_INFLIGHT - 1)
+
+volatile uint8_t macro_recording = 0;
+macro_key_t macro_recorded[MACRO_KEYS];
+volatile uint16_t macro_recorded_count = 0;
+
+/* 12+34=  5.5*6=  78-9=  96/4=  ## at about 8 keys a second */
+const macro_key_t macro_builtin[] = {
+   { 0, 1 }, { 125, 2 }, { 125, KEY_ADD }, { 125, 3 }, { 125, 4 },
+   { 125, KEY_EQUALS },
+   { 250, 5 }, { 125, KEY_DECIMAL }, { 125, 5 }, { 125, KEY_MULTIPLY },
+   { 125, 6 }, { 125, KEY_EQUALS },
+   { 250, 7 }, { 125, 8 }, { 125, KEY_SUBTRACT }, { 125, 9 },
+   { 125, KEY_EQUALS },
+   { 250, 9 }, { 125, 6 }, { 125, KEY_DIVIDE }, { 125, 4 },
+   { 125, KEY_EQUALS }, { 250, KEY_EQUALS }, { 125, KEY_EQUALS },
+};
+const uint16_t macro_builtin_count =
+   sizeof(macro_builtin) / sizeof(macro_builtin[0]);
+
+/* recording */
+static uint32_t ticks_per_ms = 1;
+static uint32_t last_key_at;   // timebase_now() of the last recorded key
+
+/* the replay going on */
+static const macro_key_t * script;
+static uint32_t script_count = 0;
+static uint32_t next = 0;      // index of the next key to post
+static uint32_t due;           // when it is due (MACRO_TIMED)
+static uint8_t mode;
+static uint8_t replaying = 0;
+static uint8_t to_link = 0;    // report with LINK_MACRO_REPORT at the end
+static uint8_t report_pending = 0;
+static uint8_t started = 0;    // a key was posted
+static uint32_t first_post_at; // timebase_now() of the first post
+
+/* keys in the pipeline: posted by the main loop, processed and shown */
+/* by PendSV, in order */
+static volatile uint32_t posted = 0;
+static volatile uint32_t processed = 0;
+static volatile uint32_t shown = 0;
+static uint32_t post_at[MACRO_INFLIGHT]; // timebase_now() of each post
+static volatile uint32_t last_shown_at;
+
+/* latencies */
+static uint32_t histogram[MACRO_BUCKETS];
+static uint32_t latency_max;
+static uint32_t dropped;
+static macro_report_t report;
+
+/*
+ * The histogram bucket of a latency: itself below 4, then the power
+ * of two and the next two bits below it
+ */
+static unsigned int bucket_of(uint32_t ticks) {
+   unsigned int shift = 0;
+   if (ticks < 4) {
+      return ticks;
+   }
+   while ((ticks >> shift) >= 8) {
+      ++shift;
+   }
+   return 4 * (shift + 1) + ((ticks >> shift) & 3);
+}
+
+/*
+ * The largest latency that falls in a bucket
+ */
+static uint32_t bucket_top(unsigned int bucket) {
+   unsigned int shift;
+   if (bucket < 4) {
+      return bucket;
+   }
+   shift = bucket / 4 - 1;
+   return (uint32_t)((((uint64_t)(5 + bucket % 4)) << shift) - 1);
+}
+
+/*
+ * The latency that percent of the shown keys didn't exceed
+ */
+static uint32_t percentile(unsigned int percent) {
+   uint32_t rank = (uint32_t)(((uint64_t)shown * percent + 99) / 100);
+   uint32_t seen = 0;
+   unsigned int bucket;
+   for (bucket = 0; bucket < MACRO_BUCKETS; ++bucket) {
+      seen += histogram[bucket];
+      if (seen >= rank && seen > 0) {
+         uint32_t top = bucket_top(bucket);
+         return top < latency_max ? top : latency_max;
+      }
+   }
+   return latency_max;
+}
+
+/*
+ * Timebase ticks per millisecond, at least 1
+ */
+static uint32_t ms_ticks(void) {
+   uint32_t ticks = timebase_hz() / 1000;
+   return ticks ? ticks : 1;
+}
+
+/*
+ * End the replay and fill in the report
+ */
+static void finish(void) {
+   replaying = 0;
+   report.keys = shown;
+   report.dropped = dropped;
+   report.ticks = started ? last_shown_at - first_post_at : 0;
+   report.p50 = percentile(50);
+   report.p99 = percentile(99);
+   report.max = latency_max;
+   report_pending = to_link;
+}
+
+/**
+ * Record a decoded keypad key and the gap since the last one
+ * (use MACRO_RECORD() so it costs nothing while not recording)
+ */
+RAMFUNC void macro_record(uint8_t key) {
+   uint32_t now = timebase_now();
+   uint32_t gap;
+   if (macro_recorded_count >= MACRO_KEYS) {
+      return;
+   }
+   gap = macro_recorded_count ? (now - last_key_at) / ticks_per_ms : 0;
+   macro_recorded[macro_recorded_count].gap_ms = gap > 0xFFFF ? 0xFFFF : gap;
+   macro_recorded[macro_recorded_count].key = key;
+   ++macro_recorded_count;
+   last_key_at = now;
+}
+
+/**
+ * Replay count keys through macro_post(), at their gaps (MACRO_TIMED)
+ * or as fast as the pipeline takes them (MACRO_FAST); the keys must
+ * stay put until macro_busy() says it's over
+ */
+void macro_replay(const macro_key_t * keys, uint32_t count, uint8_t how) {
+   unsigned int bucket;
+   macro_recording = 0;
+   script = keys;
+   script_count = count;
+   next = 0;
+   mode = how;
+   to_link = 0;
+   report_pending = 0;
+   started = 0;
+   dropped = 0;
+   latency_max = 0;
+   for (bucket = 0; bucket < MACRO_BUCKETS; ++bucket) {
+      histogram[bucket] = 0;
+   }
+   // the counters only ever move forward; start them level
+   posted = processed = shown;
+   ticks_per_ms = ms_ticks();
+   due = timebase_now();
+   replaying = 1;
+}
+
+/**
+ * Stop recording, and end a replay early (keys already posted still
+ * go through the pipeline, but aren't waited for)
+ */
+void macro_stop(void) {
+   macro_recording = 0;
+   if (replaying) {
+      finish();
+   }
+}
+
+/**
+ * Whether a replay is going on
+ */
+int macro_busy(void) {
+   return replaying;
+}
+
+/**
+ * The report of the last replay
+ */
+const macro_report_t * macro_result(void) {
+   return &report;
+}
+
+/**
+ * Act on a MACRO_CMD_* from the host
+ */
+void macro_control(const uint8_t * payload, uint8_t length) {
+   if (length < 1) {
+      return;
+   }
+   switch (payload[0]) {
+      case MACRO_CMD_RECORD:
+         macro_stop();
+         ticks_per_ms = ms_ticks();
+         macro_recorded_count = 0;
+         macro_recording = 1;
+         break;
+      case MACRO_CMD_STOP:
+         macro_stop();
+         break;
+      case MACRO_CMD_REPLAY:
+         if (length >= 3 && !replaying) {
+            if (payload[2] == MACRO_SOURCE_BUILTIN) {
+               macro_replay(macro_builtin, macro_builtin_count, payload[1]);
+            }
+            else {
+               macro_replay(macro_recorded, macro_recorded_count, payload[1]);
+            }
+            to_link = 1;
+         }
+         break;
+      default: /* ignore what we don't know */
+         break;
+   }
+}
+
+/**
+ * Post the replayed keys that are due, and finish the replay once
+ * every key was shown; call it from the main loop
+ * Returns 1 if it posted a key or sent the report, else 0
+ */
+int macro_service(void) {
+   int busy = 0;
+   if (!replaying) {
+      if (report_pending && link_send_macro_report(&report, timebase_hz())) {
+         report_pending = 0;
+         return 1;
+      }
+      return 0;
+   }
+   while (next < script_count) {
+      uint32_t now = timebase_now();
+      if (mode == MACRO_TIMED && (int32_t)(now - due) < 0) {
+         break; // not yet
+      }
+      if (posted - shown < MACRO_INFLIGHT) {
+         post_at[posted & MACRO_MASK] = now;
+         // count it first: PendSV may handle it before macro_post returns
+         ++posted;
+         if (macro_post(script[next].key)) {
+            if (!started) {
+               first_post_at = now;
+               started = 1;
+            }
+            busy = 1;
+         }
+         else {
+            --posted;
+            if (mode == MACRO_FAST) {
+               break; // try again once the pipeline has room
+            }
+            ++dropped;
+         }
+      }
+      else if (mode == MACRO_FAST) {
+         break;
+      }
+      else {
+         ++dropped; // the keypad wouldn't wait either
+      }
+      ++next;
+      if (next < script_count) {
+         due += script[next].gap_ms * ticks_per_ms;
+      }
+   }
+   if (next == script_count && shown == posted) {
+      finish();
+   }
+   return busy;
+}
+
+/**
+ * Platform hook: one replayed key went through the calculator
+ */
+void macro_processed(void) {
+   if (processed != posted) {
+      ++processed;
+   }
+}
+
+/**
+ * Platform hook: the display now shows every key processed so far
+ */
+void macro_shown(void) {
+   uint32_t now = timebase_now();
+   while (shown != processed) {
+      uint32_t latency = now - post_at[shown & MACRO_MASK];
+      ++histogram[bucket_of(latency)];
+      if (latency > latency_max) {
+         latency_max = latency;
+      }
+      ++shown;
+   }
+   last_shown_at = now;
+}
@@ -0,0 +1,84 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: macro.h
+ * Description:
+ *      Keystroke macros: a load generator for the input-to-display
+ *      pipeline. Keys decoded by keypad_decode() can be recorded into
+ *      SRAM, with the gap before each one, and a recording, the
+ *      built-in script in flash or any other list of keys is replayed
+ *      through the path a keypad press takes (post it, the calculator
+ *      in PendSV, the next frame). A replay runs either at the
+ *      recorded timing or as fast as the pipeline takes keys, and ends
+ *      with a report: keys, dropped keys, time taken and the post to
+ *      display latency percentiles.
+ *      The host starts and stops macros with LINK_MACRO_CTL (see
+ *      link.h); host/macrobench also replays long scripts through a
+ *      simulated pipeline on the host.
+ *      NOTE:
+ *              The platform provides macro_post() and reports each
+ *              replayed key it handled (macro_processed()) and each
+ *              redraw (macro_shown()).
+ */
+#ifndef MACRO_H
+#define MACRO_H
+
+#include <stdint.h>
+
+#define MACRO_KEYS 128    /* keys a recording holds */
+#define MACRO_INFLIGHT 32 /* replayed keys posted but not shown yet
+                             (a power of two) */
+
+/* replay modes */
+#define MACRO_TIMED 0 /* at the recorded gaps; a full pipeline drops keys */
+#define MACRO_FAST  1 /* as fast as the pipeline takes keys */
+
+/* where a replay from LINK_MACRO_CTL takes its keys */
+#define MACRO_SOURCE_RECORDING 0
+#define MACRO_SOURCE_BUILTIN   1
+
+/* commands of LINK_MACRO_CTL */
+#define MACRO_CMD_RECORD 0 /* empty the recording and record keypad keys */
+#define MACRO_CMD_STOP   1 /* stop recording, or end a replay early */
+#define MACRO_CMD_REPLAY 2 /* u8 mode, u8 source; ends with LINK_MACRO_REPORT */
+
+/* one key of a macro */
+typedef struct {
+   uint16_t gap_ms; // since the previous key (saturates at 65535)
+   uint8_t key;
+} macro_key_t;
+
+/* the outcome of a replay, times in timebase ticks */
+typedef struct {
+   uint32_t keys;    // keys shown
+   uint32_t dropped; // keys the pipeline didn't take
+   uint32_t ticks;   // from the first post to the last redraw
+   uint32_t p50;     // post -> shown latency percentiles
+   uint32_t p99;
+   uint32_t max;
+} macro_report_t;
+
+extern volatile uint8_t macro_recording;
+extern macro_key_t macro_recorded[MACRO_KEYS];
+extern volatile uint16_t macro_recorded_count;
+extern const macro_key_t macro_builtin[];
+extern const uint16_t macro_builtin_count;
+
+void macro_record(uint8_t);
+void macro_control(const uint8_t *, uint8_t);
+void macro_replay(const macro_key_t *, uint32_t, uint8_t);
+void macro_stop(void);
+int macro_busy(void);
+int macro_service(void);
+void macro_processed(void);
+void macro_shown(void);
+const macro_report_t * macro_result(void);
+int macro_post(uint8_t); // platform provided
+
+/* record a decoded keypad key; a load and a branch while not recording */
+#define MACRO_RECORD(key) do {                   \
+      if (macro_recording) {                     \
+         macro_record(key);                      \
+      }                                          \
+   } while (0)
+
+#endif /* MACRO_H */
@@ -14,6 +14,30 @@
  */
 #include "msp.h"
 #include "stdio.h"
+#include "string.h"
+#include "ramfunc.h"
+#include "cycles.h"
+#include "calc.h"
+#include "bigcalc.h"
+#include "uart.h"
+#include "ring.h"
+#include "link.h"
+#include "batch.h"
+#include "timebase.h"
+#include "stackmon.h"
+#include "trace.h"
+#include "render.h"
+#include "macro.h"
+#include "fb.h"
+#include "font.h"
+#include "tape.h"
+#include "plot.h"
+#include "stats.h"
+#include "vm.h"
+#include "dsp.h"
+#include "clock.h"
+#include "idle.h"
+#include "snapshot.h"
 
 /* LEDs */
 #define LED1 BIT0
@@ -32,9 +56,27 @@
 /* constants */
 #define DELAY 5000000
 #define PRECISION 4 /* fractional digits displayed */ 
-
-/* types */
-#define CALC_TYPE long double
+#define SPI_CLOCK 1000000 /* 1 MHz SPI clock to the GLCD */
+#define BENCH_RUNS 64 /* calls averaged per benchmark */
+#define NUM(x) num_from_double(x) /* a literal in the numeric backend */
+
+/* interrupt priorities (0 is the highest, 7 the lowest on the MSP432) */
+#define PRIO_PROBE  0 /* latency probe of bench_input_latency() */
+#define PRIO_INPUT  1 /* port 1 (S1) and port 3 (keypad) capture */
+#define PRIO_LINK   2 /* UART to the host */
+#define PRIO_SPI    5 /* eUSCI_B0: the framebuffer flush (see fb.h) */
+#define PRIO_FRAME  6 /* SysTick: frame slots (see render.h) */
+#define PRIO_IDLE   6 /* Timer_A1: the inactivity timeout (see idle.h) */
+#define PRIO_RENDER 7 /* PendSV: calculator update and display */
+
+/* input events posted to PendSV */
+#define INPUT_HOST 0x80 /* key | INPUT_HOST: injected by the host */
+#define INPUT_S1   0x40 /* S1 was pressed */
+#define INPUT_REDRAW 0x20 /* redraw only (bench_input_latency()) */
+#define INPUT_MACRO 0x10 /* key | INPUT_MACRO: replayed (see macro.h) */
+#define INPUT_PLOT  0x60 /* the host sent a function (see plot.h) */
+#define INPUT_PROGRAM 0x30 /* a key program compiled (see vm.h) */
+#define INPUT_SLEEP 0x50 /* no input for IDLE_TIMEOUT (see idle.h) */
 
 /* define the pixel size of display */
 #define GLCD_WIDTH  84
@@ -48,35 +90,75 @@ void GLCD_data_write(unsigned char);
 void GLCD_command_write(unsigned char);
 void GLCD_putchar(int);
 void GLCD_putstr(char *);
+void GLCD_putint(long long);
+int GLCD_putpstr(const char *, int);
+int GLCD_drawpstr(const char *, int);
+void GLCD_begin(void);
+void GLCD_present(void);
+void GLCD_flush(void);
+void GLCD_blitchar(int, int, int, uint8_t);
 void display_current_state(); // refreshes the display
-void set_focus(const CALC_TYPE *);
+void process_key(uint8_t, uint8_t);
+int post_input(uint8_t);
+void handle_s1(void);
 void SPI_init(void);
 void SPI_write(unsigned char);
+uint8_t keypad_decode(void);
 void blink(const int);
 void error_blink(const int);
-void assert(const int, char *);
 void test_math_op();
+void test_calc_eval();
+void test_bigint();
+void test_blit();
+void test_font();
+void test_flush();
+void test_tape();
+void test_plot();
+void test_stats();
+void test_vm();
+void test_dsp();
+void test_snapshot();
 void test_putnum();
 void test_positive_ints();
 void test_negative_ints();
 void test_positive_floats();
 void test_negative_floats();
 void test_alphabet();
+void bench_ramfunc();
+void show_stack();
+void bench_input_latency();
+void show_render();
+void bench_numeric();
+void bench_macro(uint8_t);
+void bench_blit();
+void bench_font();
+void bench_flush();
+void bench_plot();
+void bench_stats();
+void bench_vm();
+void bench_dsp();
+void bench_clock();
+void bench_idle();
+void show_snapshot();
 
 /* global variables */
-/* variables directly affecting display */
-CALC_TYPE lhs = 0;
-CALC_TYPE rhs = 0;
-char operation = '\0'; // null-char means no-operation
-// start focus on the left hand side (lhs)
-CALC_TYPE * focus = &lhs; // point to the address of lhs
-int focus_on_fractional = 0; // focus on the whole part first until a decimal point
-// 64-bit int for the powers of 10
-long long int fractional_pow10 = 10; // 10^1 for the fractional divisor
-
-/* other variables */
+/* the calculator state lives in calc.c */
+
 int i = 0, ind_formula=0;
 
+/* input events waiting for PendSV (see post_input()) */
+ring_t input_queue;
+uint32_t input_dropped = 0; // events lost to a full queue
+
+/* instant resume (see snapshot.h) */
+int resumed = 0;     // the state came back from flash at boot
+uint32_t boot_ticks; // timebase_now() at the first display
+
+/* latency probe of bench_input_latency() */
+volatile uint8_t probe_armed = 0; // a probe is waiting for port 3
+volatile uint32_t probe_at;       // timebase_now() when it fired
+uint32_t probe_max, probe_sum, probe_count;
+
 /* sample font table */
 /* rows 0-63 correspond to characters Space through _ in ASCII */
 /* Strings using characters in this range 
@@ -87,7 +169,7 @@ const char font_table[][6] = {
    {},  /* " */
    {},  /* # */
    {},  /* $ */
-   {},  /* % */
+   {0x23, 0x13, 0x08, 0x64, 0x62, 0x00},  /* % */
    {},  /* & */
    {},  /* ' */
    {},  /* ( */
@@ -165,6 +247,8 @@ int main(void) {
 
    WDT_A->CTL = WDT_A_CTL_PW | WDT_A_CTL_HOLD;  /* hold the watchdog timer */
 
+   stack_paint(); /* mark the unused stack for stack_high_water() */
+
    /* configure calculator setup */
    P1->DIR |= BIT0;      /* set up pin P1.0 (red LED) as output */
    P2->DIR |= (RGB_LED);  /* set up pins P2.0, P2.1, P2.2 (R, G, and B LEDs) 
@@ -187,39 +271,354 @@ int main(void) {
    P3->IFG &= ~DA; /* clear interrupt flag for pin P3.0 (DA (int pin)) */
    P3->IE |= DA;  /* enable the interrupt for pin P3.0 (DA (interrupt pin)) */
 
+   /* input capture preempts everything but the latency probe; the
+    * calculator and the display run at the lowest level, in PendSV */
+   NVIC_SetPriority(PORT1_IRQn, PRIO_INPUT);
+   NVIC_SetPriority(PORT3_IRQn, PRIO_INPUT);
+   NVIC_SetPriority(EUSCIA0_IRQn, PRIO_LINK);
+   NVIC_SetPriority(EUSCIB0_IRQn, PRIO_SPI);
+   NVIC_SetPriority(PendSV_IRQn, PRIO_RENDER);
+
    NVIC->ISER[1] |= 0x20;  /* enable port 3 interrupts (see p. 89 in text)*/
    NVIC->ISER[1] |= 0x08; /* enable port 1 interrupts (see p. 89 in text)*/
 
+   bigcalc_init(); /* operands of the big-integer mode */
+   stats_clear();  /* accumulators of the statistics mode */
+
+   /* configure the host link */
+   clock_setup();   /* SMCLK for the UART and the SPI, from now on fixed */
+   timebase_init(); /* timestamps for the key events */
+   uart_init(UART_BAUD); /* backchannel UART to the host */
+
+   /* come back where the operator left off, unless S1 is held down */
+   if (P1->IN & S1) {
+      resumed = snapshot_restore(&calc);
+   }
+   else {
+      snapshot_discard();
+   }
+
    _enable_interrupts();
 
+   link_send_hello(timebase_hz()); /* tell the host we're here */
+
    /* configure GLCD */
    GLCD_init();    /* initialize the GLCD controller */
+   NVIC->ISER[0] |= 1 << EUSCIB0_IRQn; /* the flush runs in the background */
    GLCD_clear();   /* clear display and  home the cursor */
 
-   /* start tests */
-   test_math_op();
-   GLCD_clear();   /* clear display and  home the cursor */
-   test_alphabet();
-   GLCD_clear();   /* clear display and  home the cursor */
-   test_putnum();
-   GLCD_clear();   /* clear display and  home the cursor */
+   /* start tests (on a cold boot: a resume goes straight back and
+      skips every one of them; after the first save every boot is a
+      resume, so hold S1 through a reset to run them) */
+   if (!resumed) {
+      test_math_op();
+      test_calc_eval();
+      test_bigint();
+      test_blit();
+      test_font();
+      test_flush();
+      test_tape();
+      test_plot();
+      test_stats();
+      test_vm();
+      test_dsp();
+      test_snapshot();
+      GLCD_clear();   /* clear display and  home the cursor */
+      test_alphabet();
+      GLCD_clear();   /* clear display and  home the cursor */
+      test_putnum();
+      GLCD_clear();   /* clear display and  home the cursor */
+   }
    /* end tests */
 
-   // display the current state (should display lhs = 0)
+   /* start benchmarks (un-comment to run) */
+   //bench_ramfunc();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //show_stack();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //bench_input_latency();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //show_render();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //bench_numeric();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //bench_blit();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //bench_font();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //bench_flush();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //bench_plot();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //bench_stats();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //bench_vm();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //bench_dsp();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   /* end benchmarks */
+
+   // display the current state (lhs = 0, unless resumed)
+   boot_ticks = timebase_now();
    display_current_state();
+   link_send_display();
+
+   render_init(RENDER_HZ, PRIO_FRAME); /* from now on PendSV redraws */
+   clock_init(CLOCK_POLICY); /* from now on MCLK follows the work */
+   idle_init(IDLE_TIMEOUT, PRIO_IDLE); /* the panel sleeps when unused */
+
+   /* replay benchmarks (un-comment to run; they need the frame slots) */
+   //bench_macro(MACRO_FAST);
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //bench_clock();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //bench_idle();
+   //GLCD_clear();   /* clear display and  home the cursor */
+   //show_snapshot();
+
+   while (1) {
+      /* serve the host link between interrupts */
+      uint8_t byte;
+      // decode frames while there is room for another batch record
+      // (the RX ring holds the bytes otherwise)
+      while (batch_has_room() && uart_read(&byte)) {
+         link_receive(byte);
+      }
+      // evaluate one batch record; its result leaves through the TX ring
+      batch_service();
+      // send the next piece of a trace dump, if the host asked for one
+      trace_service();
+      // post the keys of a macro replay that are due
+      macro_service();
+      // a function from the host is plotted in PendSV
+      if (plot_requested()) {
+         post_input(INPUT_PLOT);
+      }
+      // so is a key program, once compiled, put in its slot
+      if (vm_ready()) {
+         post_input(INPUT_PROGRAM);
+      }
+      // save the calculator state once it has settled
+      snapshot_service(&calc);
+      // with IDLE_LPM3, sleep until a key while the panel is down
+      idle_lpm3();
+   }
+}
 
-   while (1) {} /* wait for an interrupt */
+/**
+ * Handle one key, from the keypad or the host: report it, update the
+ * calculator, and mark the display for the next frame
+ */
+void process_key(uint8_t key, uint8_t source) {
+   calc_state_t before = calc; // for the tape
+   char old_operation = calc.operation;
+   int old_on_rhs = CALC_ON_RHS(calc.state);
+   int slot; // of the program bound to the key
+
+   link_send_key(key, source, timebase_now());
+   // big integers don't fit the link's doubles; only report the keys
+   if (bigcalc_mode) {
+      bigcalc_key(key);
+   }
+   // the keys pan and zoom the graph (see plot.h)
+   else if (plot_mode) {
+      plot_key(key);
+   }
+   // the keys enter values into the accumulators (see stats.h)
+   else if (stats_mode) {
+      stats_key(key);
+   }
+   // a key bound to a program runs it on the operands (see vm.h)
+   else if ((slot = vm_bound(key)) >= 0) {
+      vm_calc(slot, &calc);
+      link_send_result(calc.status, calc.lhs, timebase_now());
+   }
+   // report the result whenever the operands were combined
+   else if (calc_key(key)) {
+      link_send_result(calc.status, calc.lhs, timebase_now());
+      tape_calculation(&before, &calc, PRECISION); // scrolls in next frame
+   }
+   if (calc.operation != old_operation) {
+      TRACE(TRACE_OPERATION, calc.operation);
+   }
+   if (CALC_ON_RHS(calc.state) != old_on_rhs) {
+      TRACE(TRACE_FOCUS, !old_on_rhs);
+   }
+   // every input changes what's shown; PendSV redraws once per frame
+   render_invalidate();
+   snapshot_changed(); // saved once the keys stop for a while
+}
+
+/**
+ * Link hook: send the bytes of a frame through the UART
+ */
+int link_transport_write(const uint8_t * data, uint16_t length) {
+   return uart_write(data, length);
+}
+
+/**
+ * Link hook: a key injected by the host
+ * It goes through PendSV like a keypad press, so the calculator state
+ * only ever changes there.
+ */
+void link_key_injected(uint8_t key) {
+   TRACE(TRACE_KEY, key | TRACE_KEY_HOST);
+   post_input(key | INPUT_HOST);
 }
 
 /**
- * Set focus to the given pointer's value
- * Helps to reset the fractional boolean variable each time
+ * Macro hook: a replayed key goes the way of a keypad press
  */
-void set_focus(const CALC_TYPE * f) {
-   focus = f; // assign the global to the given input
-   focus_on_fractional = 0; // a new focus means to focus on the whole part
-   // reset the fractional power of 10
-   fractional_pow10 = 10; // 10^1
+int macro_post(uint8_t key) {
+   return post_input(key | INPUT_MACRO);
+}
+
+/**
+ * Clock hook: MCLK is about to run at hz, so retune what counts it:
+ * the frame slots (SMCLK, and with it the SPI and the UART, stays)
+ * Called by the clock governor with interrupts disabled.
+ */
+void clock_retune(uint32_t hz) {
+   render_retune(hz);
+}
+
+/**
+ * Idle hook: the inactivity timeout fired
+ */
+void idle_post(void) {
+   post_input(INPUT_SLEEP);
+}
+
+/**
+ * Idle hook: power the panel down (0) or up (1) with the power-down
+ * bit of the function set; the display RAM survives it
+ */
+void idle_panel(int on) {
+   GLCD_command_write(on ? 0x20 : 0x24); /* function set, PD = !on */
+}
+
+/**
+ * Queue an input event for PendSV and pend it
+ * Called from the input handlers and the main loop, so the queue is
+ * only touched with interrupts off (a few cycles).
+ * Returns 1 if it was queued, 0 if the queue was full (and it's lost)
+ */
+RAMFUNC int post_input(uint8_t event) {
+   unsigned int state = _disable_interrupts();
+   int queued = ring_put(&input_queue, event);
+   if (!queued) {
+      ++input_dropped;
+   }
+   if (event != INPUT_SLEEP) {
+      idle_activity(); // any input keeps (or brings) the panel on
+   }
+   _restore_interrupts(state);
+   SCB->ICSR = SCB_ICSR_PENDSVSET_Msk; /* run PendSV_Handler when idle */
+   return queued;
+}
+
+/***
+* PendSV handler: the calculator and the display
+* Runs at the lowest priority, so a key or S1 press interrupts a
+* redraw instead of waiting for it. Pended by the input handlers and,
+* when the display is dirty, by the frame tick (see render.c).
+***/
+void PendSV_Handler(void) {
+   uint8_t event;
+
+   STACK_ISR_ENTER(STACK_ISR_RENDER);
+   TRACE(TRACE_RENDER_ENTER, 0);
+   clock_busy(); // an event or a redraw pended us
+   idle_wake();  // the panel first, if an input woke it
+
+   for (;;) {
+      unsigned int state = _disable_interrupts();
+      int got = ring_get(&input_queue, &event);
+      _restore_interrupts(state);
+      if (!got) {
+         break;
+      }
+      if (event == INPUT_S1) {
+         handle_s1();
+      }
+      else if (event == INPUT_REDRAW) {
+         display_current_state();
+      }
+      else if (event == INPUT_PLOT) {
+         if (plot_take_request() == CALC_OK) {
+            bigcalc_mode = 0;
+            stats_mode = 0;
+         }
+         render_invalidate();
+      }
+      else if (event == INPUT_PROGRAM) {
+         vm_install();
+      }
+      else if (event == INPUT_SLEEP) {
+         if (ring_count(&input_queue) == 0 && !render_pending()) {
+            idle_sleep();
+         }
+         else {
+            idle_activity(); // not idle after all: time out again later
+         }
+      }
+      else if (event & INPUT_MACRO) { // after INPUT_PROGRAM and INPUT_SLEEP
+         process_key(event & 0x0F, LINK_SRC_MACRO);
+         macro_processed();
+      }
+      else {
+         process_key(event & 0x0F,
+                     (event & INPUT_HOST) ? LINK_SRC_HOST : LINK_SRC_KEYPAD);
+      }
+   }
+
+   // one redraw for all the changes since the last frame
+   if (render_take_frame()) {
+      display_current_state();
+      link_send_display();
+      macro_shown();
+   }
+
+   // back to the low clock once the keys are in and on the display
+   // (a key posted meanwhile pends PendSV again, which goes fast again)
+   if (ring_count(&input_queue) == 0 && !render_pending()) {
+      clock_idle();
+   }
+
+   TRACE(TRACE_RENDER_EXIT, 0);
+   STACK_ISR_EXIT(STACK_ISR_RENDER);
+}
+
+/**
+ * S1: silence the alarm if it's on, else go on to the next mode:
+ * normal, big-integer, graph, statistics, then normal again
+ */
+void handle_s1(void) {
+   if ((P1->OUT & LED1) || (P2->OUT & (RGB_LED))) {
+      P2->OUT &= ~LED2RED;  /*turn off red LED at pin P2.0 */
+      P1->OUT &= ~LED1; /*turn off red LED at pin P1.0 */
+      P2->OUT &= ~(LED2BLUE | LED2GREEN); /*turn off blue and green LEDs */
+   }
+   // S1 goes from the normal mode to the big-integer mode, to the
+   // graph mode, to the statistics mode, and back to the normal mode
+   else {
+      if (bigcalc_mode) {
+         bigcalc_mode = 0;
+         plot_mode = 1;
+         plot_invalidate();
+      }
+      else if (plot_mode) {
+         plot_mode = 0;
+         stats_mode = 1;
+      }
+      else if (stats_mode) {
+         stats_mode = 0;
+      }
+      else {
+         bigcalc_mode = 1;
+      }
+      render_invalidate();
+   }
 }
 
 /***
@@ -267,44 +666,6 @@ void error_blink(int n) {
    }
 }
 
-/***
- * math_op: An operation function to handle the addition, subtraction, 
- *      multiplication, or division of a LHS and RHS operand
- */
-CALC_TYPE math_op(const CALC_TYPE lhs_operand, const char op, 
-               const CALC_TYPE rhs_operand) {
-   if (op == '=') {
-      assert(0, "ILLEGAL MATH OP \'=\'");
-   }
-   CALC_TYPE result = 0;
-   switch(op) {
-      case '+': /* add */
-         result = lhs_operand + rhs_operand;
-         break;
-      case '-': /* subtract */
-         result = lhs_operand - rhs_operand;
-         break;
-      case '*': /* multiply */
-         result = lhs_operand * rhs_operand;
-         break;
-      case '/': /* divide */
-         if (rhs_operand != 0) {
-            result = lhs_operand / rhs_operand;
-         }
-         // else simulate a division-by-zero error
-         else {
-            assert(0, "DIV BY ZERO");
-         }
-         break;
-
-      default: /* set off an alarm */
-         assert(0, "UNKOWN OP");
-         break;
-         
-   }
-   return result;
-}
-
 /***
 * IRQ handler for port 1
 ***/
@@ -312,14 +673,18 @@ void PORT1_IRQHandler(void){
 
   uint32_t status;
 
+  STACK_ISR_ENTER(STACK_ISR_PORT1);
+  TRACE(TRACE_PORT1_ENTER, 0);
+
   status = P1->IFG;    /* get the interrupt status for port 1 */
   P1->IFG &= ~BIT1;    /* clear the interrupt for port 1, pin 1 */
 
   if(status & BIT1){   /* if SW was pressed */
-     P2->OUT &= ~LED2RED;  /*turn off red LED at pin P2.0 */
-     P1->OUT &= ~LED1; /*turn off red LED at pin P1.0 */
-     P2->OUT &= ~(LED2BLUE | LED2GREEN); /*turn off blue and green LEDs */
+     post_input(INPUT_S1); /* handled in PendSV (see handle_s1()) */
   }
+
+  TRACE(TRACE_PORT1_EXIT, 0);
+  STACK_ISR_EXIT(STACK_ISR_PORT1);
 }
 
 /***
@@ -333,119 +698,41 @@ void PORT3_IRQHandler(void){
   // which key was pressed
   uint8_t key = 0;
 
+  STACK_ISR_ENTER(STACK_ISR_PORT3);
+  TRACE(TRACE_PORT3_ENTER, 0);
+
   // first, get the status of the interrupt
   status = P3->IFG;   /* get the interrupt status for port 3 */
   P3->IFG &= ~DA;    /* clear the interrupt for port 3, pin 0 */
 
-  if(status & BIT0){  /* if any key was pressed */
-     key = keypad_decode();  /* determine which key was pressed */
-     // determine how to update the global state
-     // check if the key was an opeartion 
-     if (key >= 0xA && key <= 0xD) { 
-        // check if the previous operation was the null character
-        // if the focus is already pointing to the rhs
-        if (operation != '\0' && focus == &rhs) {
-           // then we have a math operation to perform
-           // combine operands
-           lhs = math_op(lhs, operation, rhs); // e.g. 3 '+' 4 = 7 = lhs
-           rhs = 0;
-           // operations are reset later in the switch statement
-        }
-        // else we're adding a rhs operand
-        // operations are reset later in the switch statement
-        // operation isn't the null character and we're focusing on the lhs
-        // always set the focus on the rhs
-        set_focus(&rhs);
+  // a probe of bench_input_latency() rather than a key
+  if (probe_armed) {
+     uint32_t waited = timebase_now() - probe_at;
+     probe_sum += waited;
+     ++probe_count;
+     if (waited > probe_max) {
+        probe_max = waited;
      }
+     probe_armed = 0;
+     status = 0;
+  }
 
-     // perform the key's function
-     // SWITCH on the key
-     switch (key) {
-        /* handle addition: operation = '+' */
-        case 0xA: /* “A” was pressed */
-           operation = '+';
-           break;
-        /* handle subtraction: operation = '-' */
-        case 0xB: /* if “B” was pressed */
-           operation = '-';
-           break;
-        /* handle multiplication: operation = '*' */
-        case 0xC:  /* if “C” was pressed */
-           operation = '*';
-           break;
-        /* handle division: operation = '/' */
-        case 0xD:  /* if "D" was pressed */
-           operation = '/';
-           break;
-        /* handle decimal point */
-        case 0xE:  /* if "*" was pressed */
-           focus_on_fractional = 1; // focus on the fractional part
-           break;
-        /* handle equality: operation = '=' */
-        case 0xF:  /* if "#" was pressed */
-           // is the focus on the rhs
-           if (focus == &rhs) {
-              // combine operands
-              lhs = math_op(lhs, operation, rhs); // e.g. 3 '-' 4 = -1 = lhs
-              rhs = 0; // reset rhs
-              operation = '='; // initially set operation to the equal sign
-           }
-           // else focus is on the lhs and we're hitting equal again
-           // simulate a clear on the device (reset to zero)
-           else {
-              assert(focus == &lhs, "ERROR IN LOGIC");
-              lhs = 0; // reset lhs
-              rhs = 0; // for robustness
-              // reset the operation 
-              operation = '\0'; // no operation currently
-              GLCD_clear(); // clear the screen
-           }
-           // an equality seeks to always show the answer
-           // refocus on the lhs
-           set_focus(&lhs); // for robustness, reset focus and boolean
-
-           break;
-        /* handle numbers */
-        default: /* a number was pressed */
-           /* modify the value of the focus */
-
-           // if the focus was zero
-           // make sure the focus was pointing to NULL (zero)
-           if (focus != 0) {
-              // IF we should be focusing on the fractional part, 
-              // add a fractional part to the previous value and
-              // modify the fractional power of 10 for the divisor of the 
-              // next input
-              if (focus_on_fractional) {
-                 // dereference focus to assign its value to
-                 // itself plus the new input divided by 10
-                 // e.g. 3 -> 3 + 1/10 = 3.1
-                 *focus = (*focus) + (CALC_TYPE)key / (CALC_TYPE)fractional_pow10; 
-                 // increase the power of 10
-                 // to take 10^2 to 10^3 just multiply the left by 10
-                 fractional_pow10 *= 10; // 10 -> 10*10 = 10^2  
-              }
-              // work on the whole part
-              else {
-                 // dereference focus to assign its value to
-                 // itself times 10 plus the new input
-                 *focus = (*focus) * 10 + key; // e.g. 3 -> 3(10) + 4 = 34
-              }
-
-           }
-           break;
-     }
+  if(status & BIT0){  /* if any key was pressed */
+     key = keypad_decode();  /* determine which key was pressed */
+     TRACE(TRACE_KEY, key);
+     MACRO_RECORD(key);
+     post_input(key);  /* PendSV updates the calculator and display */
   }
 
-  // always refresh the display on every input
-  display_current_state();
+  TRACE(TRACE_PORT3_EXIT, 0);
+  STACK_ISR_EXIT(STACK_ISR_PORT3);
 }
 
 
 /***
 * keypad decoder function
 ***/
-uint8_t keypad_decode() {
+RAMFUNC uint8_t keypad_decode(void) {
   uint8_t key = 0;
   uint8_t port = 0;
 
@@ -504,36 +791,477 @@ void assert(const int condition, char * message) {
 void test_math_op() {
    // add 
    //   integers
-   assert(math_op(4,'+',5) == 4+5,"MATH OP ASSERT 1");
-   assert(math_op(5,'+',4) == 5+4,"MATH OP ASSERT 2");
-   assert(math_op(292,'+',123) == 292+123,"MATH OP ASSERT 3");
-   assert(math_op(-233,'+',343) == -233+343,"MATH OP ASSERT 4");
-   assert(math_op(-233,'+',-233) == -233+(-233),"MATH OP ASSERT 5");
-   assert(math_op(9898,'+',-9899) == 9898+(-9899),"MATH OP ASSERT 6");
-   assert(math_op(9898,'+',-9897) == 9898+(-9897),"MATH OP ASSERT 7");
+   assert(num_to_double(math_op(NUM(4),'+',NUM(5))) == 4+5,
+          "MATH OP ASSERT 1");
+   assert(num_to_double(math_op(NUM(5),'+',NUM(4))) == 5+4,
+          "MATH OP ASSERT 2");
+   assert(num_to_double(math_op(NUM(292),'+',NUM(123))) == 292+123,
+          "MATH OP ASSERT 3");
+   assert(num_to_double(math_op(NUM(-233),'+',NUM(343))) == -233+343,
+          "MATH OP ASSERT 4");
+   assert(num_to_double(math_op(NUM(-233),'+',NUM(-233))) == -233+(-233),
+          "MATH OP ASSERT 5");
+   assert(num_to_double(math_op(NUM(9898),'+',NUM(-9899))) == 9898+(-9899),
+          "MATH OP ASSERT 6");
+   assert(num_to_double(math_op(NUM(9898),'+',NUM(-9897))) == 9898+(-9897),
+          "MATH OP ASSERT 7");
    //   float
-   assert(math_op(9898.5,'+',-9897.5) == 9898.5+(-9897.5),"MATH OP ASSERT 8");
-   assert(math_op(9898.5,'+',-9897) == 9898.5+(-9897),"MATH OP ASSERT 9");
-   assert(math_op(9898.5,'+',-9898) == 9898.5+(-9898),"MATH OP ASSERT 10");
-   assert(math_op(-9898.5,'+',-9898.5) == -9898.5+(-9898.5),"MATH OP ASSERT 11");
-   assert(math_op(-9898.75,'+',-9898.5) == -9898.75+(-9898.5),"MATH OP ASSERT 12");
-   assert(math_op(9898.75,'+',9898.5) == 9898.75+9898.5,"MATH OP ASSERT 13");
+   assert(num_to_double(math_op(NUM(9898.5),'+',NUM(-9897.5))) == 9898.5+(-9897.5),
+          "MATH OP ASSERT 8");
+   assert(num_to_double(math_op(NUM(9898.5),'+',NUM(-9897))) == 9898.5+(-9897),
+          "MATH OP ASSERT 9");
+   assert(num_to_double(math_op(NUM(9898.5),'+',NUM(-9898))) == 9898.5+(-9898),
+          "MATH OP ASSERT 10");
+   assert(num_to_double(math_op(NUM(-9898.5),'+',NUM(-9898.5))) == -9898.5+(-9898.5),
+          "MATH OP ASSERT 11");
+   assert(num_to_double(math_op(NUM(-9898.75),'+',NUM(-9898.5))) == -9898.75+(-9898.5),
+          "MATH OP ASSERT 12");
+   assert(num_to_double(math_op(NUM(9898.75),'+',NUM(9898.5))) == 9898.75+9898.5,
+          "MATH OP ASSERT 13");
    //   long double
 
    // subtract
-   assert(math_op(4,'-',5) == 4-5,"MATH OP ASSERT 14");
-   assert(math_op(292,'-',123) == 292-123,"MATH OP ASSERT 15");
+   assert(num_to_double(math_op(NUM(4),'-',NUM(5))) == 4-5,
+          "MATH OP ASSERT 14");
+   assert(num_to_double(math_op(NUM(292),'-',NUM(123))) == 292-123,
+          "MATH OP ASSERT 15");
    // multiply
-   assert(math_op(2,'*',2) == 2*2,"MATH OP ASSERT 16");
-   assert(math_op(4,'*',2) == 4*2,"MATH OP ASSERT 17");
-   assert(math_op(4,'*',5) == 4*5,"MATH OP ASSERT 18");
-   assert(math_op(123,'*',13) == 123*13,"MATH OP ASSERT 19");
+   assert(num_to_double(math_op(NUM(2),'*',NUM(2))) == 2*2,
+          "MATH OP ASSERT 16");
+   assert(num_to_double(math_op(NUM(4),'*',NUM(2))) == 4*2,
+          "MATH OP ASSERT 17");
+   assert(num_to_double(math_op(NUM(4),'*',NUM(5))) == 4*5,
+          "MATH OP ASSERT 18");
+   assert(num_to_double(math_op(NUM(123),'*',NUM(13))) == 123*13,
+          "MATH OP ASSERT 19");
    // divide
-   assert(math_op(10,'/',5) == 10.0/5.0,"MATH OP ASSERT 20");
-   assert(math_op(20,'/',5) == 20.0/5.0,"MATH OP ASSERT 21");
-   assert(math_op(14,'/',4) == (CALC_TYPE)14/(CALC_TYPE)4,"MATH OP ASSERT 22");
-   assert(math_op(12,'/',8) == (CALC_TYPE)12/(CALC_TYPE)8,"MATH OP ASSERT 23");
-   //assert(math_op(0,'/',0) == 0,"MATH OP ASSERT 24"); // should set the alarm off
+   assert(num_to_double(math_op(NUM(10),'/',NUM(5))) == 10.0/5.0,
+          "MATH OP ASSERT 20");
+   assert(num_to_double(math_op(NUM(20),'/',NUM(5))) == 20.0/5.0,
+          "MATH OP ASSERT 21");
+   assert(num_to_double(math_op(NUM(14),'/',NUM(4))) == 14.0/4.0,
+          "MATH OP ASSERT 22");
+   assert(num_to_double(math_op(NUM(12),'/',NUM(8))) == 12.0/8.0,
+          "MATH OP ASSERT 23");
+   //assert(num_to_double(math_op(NUM(0),'/',NUM(0))) == 0,"MATH OP ASSERT 24"); // should set the alarm off
+}
+
+/**
+ * Test the batch expression evaluator
+ */
+void test_calc_eval() {
+   int status;
+   // left to right, like the keypad
+   assert(num_to_double(calc_eval("4+5", 3, &status))
+          == num_to_double(math_op(NUM(4),'+',NUM(5))) && status == CALC_OK,
+          "CALC EVAL ASSERT 1");
+   assert(num_to_double(calc_eval("2+3*4", 5, &status)) == 20
+          && status == CALC_OK, "CALC EVAL ASSERT 2");
+   assert(num_to_double(calc_eval("12.5*2-5", 8, &status)) == 20
+          && status == CALC_OK, "CALC EVAL ASSERT 3");
+   // errors come back as a status
+   calc_eval("7/0", 3, &status);
+   assert(status == CALC_DIV_BY_ZERO, "CALC EVAL ASSERT 4");
+   calc_eval("3+", 2, &status);
+   assert(status == CALC_SYNTAX, "CALC EVAL ASSERT 5");
+   calc_eval("1..2", 4, &status);
+   assert(status == CALC_SYNTAX, "CALC EVAL ASSERT 6");
+   // x is an operand only for calc_eval_x()
+   assert(num_to_double(calc_eval_x("x*x-1", 5, NUM(3), &status)) == 8
+          && status == CALC_OK, "CALC EVAL ASSERT 7");
+   calc_eval("x+1", 3, &status);
+   assert(status == CALC_SYNTAX, "CALC EVAL ASSERT 8");
+   calc_eval_x("2x", 2, NUM(3), &status);
+   assert(status == CALC_SYNTAX, "CALC EVAL ASSERT 9");
+}
+
+/**
+ * Test the big integers past the reach of long long
+ */
+void test_bigint() {
+   static char text[BIGINT_DIGITS + 2];
+   uint16_t mark = bigint_mark();
+   bigint_t a, b;
+   const char * digits = "18446744073709551615"; // 2^64 - 1
+   const char * p;
+
+   bigint_init(&a, BIGINT_LIMBS);
+   bigint_init(&b, BIGINT_LIMBS);
+   // type 2^64 - 1 digit by digit
+   bigint_zero(&a);
+   for (p = digits; *p != '\0'; ++p) {
+      bigint_digit(&a, *p - '0');
+   }
+   bigint_to_decimal(&a, text, sizeof(text));
+   assert(strcmp(text, digits) == 0, "BIGINT ASSERT 1");
+   // (2^64 - 1)^2
+   bigint_mul(&b, &a, &a);
+   bigint_to_decimal(&b, text, sizeof(text));
+   assert(strcmp(text, "340282366920938463426481119284349108225") == 0,
+          "BIGINT ASSERT 2");
+   // and back
+   bigint_divmod(&b, 0, &b, &a);
+   assert(bigint_compare(&a, &b) == 0, "BIGINT ASSERT 3");
+   // -(2^32) % 7 takes the sign of the dividend
+   bigint_from_ll(&a, -4294967296LL);
+   bigint_to_decimal(&a, text, sizeof(text));
+   assert(strcmp(text, "-4294967296") == 0, "BIGINT ASSERT 4");
+   bigint_from_ll(&b, 7);
+   bigint_divmod(0, &a, &a, &b);
+   bigint_to_decimal(&a, text, sizeof(text));
+   assert(strcmp(text, "-4") == 0, "BIGINT ASSERT 5");
+   // dividing by zero is an error, not a crash
+   bigint_zero(&b);
+   assert(bigint_divmod(&a, 0, &a, &b) == BIGINT_DIV_BY_ZERO,
+          "BIGINT ASSERT 6");
+   bigint_release(mark); // give the test's limbs back
+}
+
+/**
+ * Test the framebuffer blitter: a glyph straddling two banks, drawn
+ * and erased with XOR, clipped at the top left corner, then a few
+ * glyphs at odd pixel positions on the display
+ */
+void test_blit() {
+   const uint8_t * eight = (const uint8_t *)font_table['8' - 32];
+   int col; // used in for loops
+
+   // 3 pixels down: the top 5 rows in bank 0, the bottom 3 in bank 1
+   fb_clear();
+   fb_blit(eight, 6, 8, 2, 3, FB_OR);
+   for (col = 0; col < 6; ++col) {
+      assert(fb[0][2 + col] == (uint8_t)(eight[col] << 3)
+             && fb[1][2 + col] == (eight[col] >> 5), "BLIT ASSERT 1");
+   }
+   // the same again with XOR takes it off
+   fb_blit(eight, 6, 8, 2, 3, FB_XOR);
+   for (col = 0; col < 6; ++col) {
+      assert(fb[0][2 + col] == 0 && fb[1][2 + col] == 0, "BLIT ASSERT 2");
+   }
+   // 3 columns and 4 rows off the top left corner
+   fb_blit(eight, 6, 8, -3, -4, FB_COPY);
+   for (col = 0; col < 3; ++col) {
+      assert(fb[0][col] == (eight[3 + col] >> 4), "BLIT ASSERT 3");
+   }
+   assert(fb[0][3] == 0 && fb[FB_BANKS - 1][FB_WIDTH - 1] == 0,
+          "BLIT ASSERT 4");
+
+   // glyphs on no particular bank or column, one inverted by a bar
+   fb_clear();
+   GLCD_blitchar(3, 2, 'B' - 32, FB_OR);
+   GLCD_blitchar(10, 5, 'L' - 32, FB_OR);
+   GLCD_blitchar(17, 9, 'I' - 32, FB_OR);
+   GLCD_blitchar(24, 13, 'T' - 32, FB_OR);
+   for (col = 0; col < 8; ++col) {
+      static const uint8_t bar[2] = { 0xFF, 0x0F }; // 1 x 12 pixels
+      fb_blit(bar, 1, 12, 22 + col, 11, FB_XOR);
+   }
+   GLCD_flush();
+   __delay_cycles(DELAY);
+}
+
+/**
+ * Test the proportional font: widths, kerning, a line filled to the
+ * last column, and rendering that matches the measurement; then the
+ * same number in both fonts on the display
+ */
+void test_font() {
+   static const char digits[] = "888888888888888888888888";
+   uint8_t columns[GLCD_WIDTH];
+   int pixels;
+
+   // a '1' is 3 columns; two of them touch, so the gap stays
+   assert(font_measure("1", 1) == 3 && font_measure("11", 2) == 7,
+          "FONT ASSERT 1");
+   // the top of a 7 doesn't reach down to the '.', which moves in
+   assert(font_kern('7', '.') == -FONT_GAP
+          && font_measure("7.", 2) == 6, "FONT ASSERT 2");
+   // 17 digits of 4 columns and 16 gaps: exactly 84
+   assert(font_fit(digits, GLCD_WIDTH, &pixels) == 17
+          && pixels == GLCD_WIDTH, "FONT ASSERT 3");
+   assert(font_render("-1.5", 4, columns) == font_measure("-1.5", 4),
+          "FONT ASSERT 4");
+
+   GLCD_clear();
+   GLCD_putstr("3.14159265358979");
+   GLCD_putpstr("3.14159265358979", 2);
+   __delay_cycles(DELAY);
+}
+
+/**
+ * Test the paper tape: a completed calculation is drawn in the bank
+ * above the entry, the next one scrolls it up a bank as it was, and a
+ * line too long for a bank takes two
+ */
+void test_tape() {
+   uint8_t columns[FB_WIDTH];
+   uint8_t moved[FB_WIDTH];
+   int count;
+
+   tape_clear();
+   fb_clear();
+   tape_push("1+1=2");
+   tape_render();
+   count = font_render("1+1=2", 5, columns);
+   assert(memcmp(fb[TAPE_BANKS - 1], columns, count) == 0
+          && fb[TAPE_BANKS - 1][count] == 0, "TAPE ASSERT 1");
+   memcpy(moved, fb[TAPE_BANKS - 1], FB_WIDTH);
+   tape_push("2*3=6");
+   tape_render();
+   assert(memcmp(fb[TAPE_BANKS - 2], moved, FB_WIDTH) == 0,
+          "TAPE ASSERT 2");
+   count = font_render("2*3=6", 5, columns);
+   assert(memcmp(fb[TAPE_BANKS - 1], columns, count) == 0, "TAPE ASSERT 3");
+   // 24 digits don't fit 84 pixels: two banks, the older lines go up two
+   memcpy(moved, fb[TAPE_BANKS - 1], FB_WIDTH);
+   tape_push("123456789012+345678901234");
+   tape_render();
+   assert(memcmp(fb[TAPE_BANKS - 3], moved, FB_WIDTH) == 0,
+          "TAPE ASSERT 4");
+   tape_clear();
+}
+
+/**
+ * Test the graph mode: a bad function is refused, a graph samples
+ * every column once, and a pan samples only the columns it uncovers
+ * but draws what the whole graph would
+ */
+void test_plot() {
+   static uint8_t panned[FB_BANKS][FB_WIDTH];
+   uint32_t samples;
+
+   // not a function of x: the one before stays
+   assert(plot_function("x*", 2) == CALC_SYNTAX, "PLOT ASSERT 1");
+   assert(plot_function("x*x-3", 5) == CALC_OK, "PLOT ASSERT 2");
+   fb_clear();
+   samples = plot_samples;
+   while (plot_render());
+   assert(plot_samples - samples == FB_WIDTH + 2, "PLOT ASSERT 3");
+   // a pan evaluates only the columns it uncovers...
+   plot_pan(PLOT_PAN);
+   samples = plot_samples;
+   while (plot_render());
+   assert(plot_samples - samples == PLOT_PAN, "PLOT ASSERT 4");
+   // ...and draws what the whole graph would
+   memcpy(panned, fb, sizeof(panned));
+   plot_invalidate();
+   plot_render();
+   assert(memcmp(panned, fb, sizeof(panned)) == 0, "PLOT ASSERT 5");
+   plot_function(PLOT_FUNCTION, sizeof(PLOT_FUNCTION) - 1);
+   fb_clear();
+}
+
+/**
+ * Test the statistics mode: the mean, variance and range of a
+ * sample, a variance far from 0, an exact line fit, and values and
+ * pairs entered from the keys
+ */
+void test_stats() {
+   static const double values[] = { 2, 4, 4, 4, 5, 5, 7, 9 };
+   stats_t s;
+   stats_pair_t p;
+   double slope, intercept, r;
+   int k; // used in for loop
+
+   stats_reset(&s);
+   for (k = 0; k < 8; ++k) {
+      stats_add(&s, values[k]);
+   }
+   assert(s.count == 8 && stats_sum(&s) == 40 && stats_mean(&s) == 5,
+          "STATS ASSERT 1");
+   // a sample variance of 32/7
+   assert(stats_variance(&s) > 4.5714285 && stats_variance(&s) < 4.5714286
+          && s.min == 2 && s.max == 9, "STATS ASSERT 2");
+   // far from 0, a sum of squares loses the deviations; m2 doesn't
+   stats_reset(&s);
+   for (k = 0; k < 8; ++k) {
+      stats_add(&s, 1e9 + values[k]);
+   }
+   assert(s.m2 > 31.99999 && s.m2 < 32.00001, "STATS ASSERT 3");
+   // y = 3x - 2, exactly
+   stats_pair_reset(&p);
+   assert(!stats_fit(&p, &slope, &intercept, &r), "STATS ASSERT 4");
+   for (k = 0; k < 8; ++k) {
+      stats_pair_add(&p, values[k], 3 * values[k] - 2);
+   }
+   assert(stats_fit(&p, &slope, &intercept, &r) && slope == 3
+          && intercept == -2 && r > 0.9999999, "STATS ASSERT 5");
+   // from the keys: 1.5 #  A 2 #  (x = 2, y = 2)
+   stats_clear();
+   stats_key(1);
+   stats_key(KEY_DECIMAL);
+   stats_key(5);
+   assert(stats_key(KEY_EQUALS) == 1 && stats.count == 1
+          && stats_mean(&stats) == 1.5, "STATS ASSERT 6");
+   stats_key(2);
+   stats_key(KEY_ADD);
+   stats_key(2);
+   stats_key(KEY_EQUALS);
+   assert(stats.count == 2 && stats_pairs.count == 1, "STATS ASSERT 7");
+   stats_clear();
+}
+
+/**
+ * Test the key programs: a few programs and their results, the
+ * errors the compiler finds, the step limit and a division by zero
+ */
+void test_vm() {
+   static const char squares[] = "a a * b b * +";
+   static const char factorial[] =
+      "1 =c begin c a * =c a 1 - =a a 1 < until c";
+   static const char sign[] = "a 0 < if 1 neg else a 0 > then";
+   vm_program_t p;
+   CALC_TYPE result;
+   int status, at;
+
+   assert(vm_compile(squares, sizeof(squares) - 1, &p, &at) == CALC_OK
+          && p.length == 12, "VM ASSERT 1");
+   result = vm_run(&p, num_from_int(3), num_from_int(4), &status);
+   assert(num_to_double(result) == 25 && status == CALC_OK, "VM ASSERT 2");
+   vm_compile(factorial, sizeof(factorial) - 1, &p, &at);
+   result = vm_run(&p, num_from_int(5), num_from_int(0), &status);
+   assert(num_to_double(result) == 120 && status == CALC_OK, "VM ASSERT 3");
+   vm_compile(sign, sizeof(sign) - 1, &p, &at);
+   result = vm_run(&p, num_from_int(-7), num_from_int(0), &status);
+   assert(num_to_double(result) == -1, "VM ASSERT 4");
+   // the errors the compiler finds, and where
+   assert(vm_compile("1 +", 3, &p, &at) == VM_DEPTH && at == 2,
+          "VM ASSERT 5");
+   assert(vm_compile("a if 1 then", 11, &p, &at) == VM_DEPTH,
+          "VM ASSERT 6");
+   assert(vm_compile("begin 1", 7, &p, &at) == VM_NESTING
+          && vm_compile("a sqrt", 6, &p, &at) == VM_UNKNOWN && at == 2,
+          "VM ASSERT 7");
+   // a loop that never ends stops at the limit
+   vm_compile("begin 0 until", 13, &p, &at);
+   vm_run(&p, num_from_int(0), num_from_int(0), &status);
+   assert(status == VM_LIMIT, "VM ASSERT 8");
+   vm_compile("a 0 /", 5, &p, &at);
+   vm_run(&p, num_from_int(1), num_from_int(0), &status);
+   assert(status == CALC_DIV_BY_ZERO, "VM ASSERT 9");
+}
+
+/**
+ * Test the polynomial table kernels: Q15 conversion, the scaling of
+ * a cubic, Q15 and Q31 tables against single points and the double
+ * result, and the affine kernel
+ */
+void test_dsp() {
+   static const double cubic[] = { 1, -2, 0, 1 }; // x^3 - 2x + 1
+   double scaled[4], x, p, error;
+   q15_t c15[4], x15[8], y15[8], one15;
+   q31_t c31[4], x31[8], y31[8], one31;
+   int k; // used in for loops
+
+   assert(dsp_q15(0.5) == 16384 && dsp_q15(1) == 32767
+          && dsp_q15(-1) == -32768, "DSP ASSERT 1");
+   // over [-2, 2] the cubic is within 13, so the results are / 2^4
+   assert(dsp_poly_prepare(cubic, 3, -2, 2, scaled) == 4, "DSP ASSERT 2");
+   for (k = 0; k < 4; ++k) {
+      c15[k] = dsp_q15(scaled[k]);
+      c31[k] = dsp_q31(scaled[k]);
+   }
+   for (k = 0; k < 8; ++k) {
+      x15[k] = dsp_q15(-1 + k / 4.0);
+      x31[k] = dsp_q31(-1 + k / 4.0);
+   }
+   dsp_poly_q15(c15, 3, x15, y15, 8);
+   dsp_poly_q31(c31, 3, x31, y31, 8);
+   for (k = 0; k < 8; ++k) {
+      // a table and a point alone (never packed) give the same bits
+      dsp_poly_q15(c15, 3, &x15[k], &one15, 1);
+      dsp_poly_q31(c31, 3, &x31[k], &one31, 1);
+      assert(one15 == y15[k] && one31 == y31[k], "DSP ASSERT 3");
+      // within two of the last bit of x^3 - 2x + 1 at x = 2u
+      x = -2 + k / 2.0;
+      p = x * x * x - 2 * x + 1;
+      error = dsp_from_q15(y15[k]) * 16 - p;
+      assert(error < 0.001 && error > -0.001, "DSP ASSERT 4");
+      error = dsp_from_q31(y31[k]) * 16 - p;
+      assert(error < 1e-7 && error > -1e-7, "DSP ASSERT 5");
+   }
+   // x / 2 + 1/4
+   dsp_affine_q15(x15, y15, 8, dsp_q15(0.5), dsp_q15(0.25));
+   assert(y15[0] == dsp_q15(-0.25) && y15[6] == dsp_q15(0.5),
+          "DSP ASSERT 6");
+}
+
+/**
+ * Test the snapshot records: a state encodes and decodes back with
+ * its sequence number, and a damaged record or one of another
+ * version is refused
+ */
+void test_snapshot() {
+   calc_state_t s, back;
+   uint8_t record[SNAPSHOT_SLOT];
+   uint32_t seq;
+
+   calc_reset(&s);
+   s.lhs = num_from_double(-12.5);
+   s.rhs = num_from_int(7);
+   s.operation = '/';
+   s.state = CALC_RHS_FRACTION;
+   s.fractional_pow10 = 1000;
+   calc_reset(&back);
+   assert(snapshot_encode(&s, 42, record) == SNAPSHOT_SLOT
+          && snapshot_decode(record, &back, &seq) && seq == 42,
+          "SNAPSHOT ASSERT 1");
+   assert(num_to_double(back.lhs) == -12.5 && num_to_double(back.rhs) == 7
+          && back.operation == '/' && back.state == CALC_RHS_FRACTION
+          && back.fractional_pow10 == 1000 && back.status == CALC_OK,
+          "SNAPSHOT ASSERT 2");
+   // a damaged record, or one of another version, is refused
+   record[10] ^= 0x01;
+   assert(!snapshot_decode(record, &back, &seq), "SNAPSHOT ASSERT 3");
+   snapshot_encode(&s, 42, record);
+   record[1] = SNAPSHOT_VERSION + 1;
+   assert(!snapshot_decode(record, &back, &seq), "SNAPSHOT ASSERT 4");
+}
+
+/*
+ * Take the bytes of the flush fb_present() started, without sending
+ * them (the SPI interrupt stays off); returns how many
+ */
+static int drain_flush(void) {
+   uint8_t byte;
+   int count = 0;
+   while (fb_flush_next(&byte) != FB_SEND_NONE) {
+      ++count;
+   }
+   return count;
+}
+
+/**
+ * Test the double-buffered flush: the first frame after GLCD_clear()
+ * goes whole, the same frame again sends nothing, one changed pixel
+ * sends one byte and its cursor, and a waiting frame is taken back by
+ * fb_begin() (nothing reaches the display; GLCD_clear() resets it)
+ */
+void test_flush() {
+   static const uint8_t dot[1] = { 0x01 };
+
+   GLCD_clear(); // the display isn't the front buffer any more
+   fb_begin();
+   fb_clear();
+   font_draw("42", 10, 10, FB_OR);
+   assert(fb_present() == 1 && drain_flush() == 2 + FB_BANKS * FB_WIDTH,
+          "FLUSH ASSERT 1");
+   // the back buffer starts as the frame just presented
+   fb_begin();
+   assert(fb_present() == 0 && !fb_flushing(), "FLUSH ASSERT 2");
+   fb_begin();
+   fb_blit(dot, 1, 1, 50, 20, FB_XOR);
+   assert(fb_present() == 1 && drain_flush() == 3, "FLUSH ASSERT 3");
+   // a frame presented during a flush waits; fb_begin() takes it back
+   fb_begin();
+   fb_blit(dot, 1, 1, 50, 20, FB_XOR);
+   assert(fb_present() == 1, "FLUSH ASSERT 4");
+   fb_begin();
+   fb_blit(dot, 1, 1, 60, 30, FB_XOR);
+   assert(fb_present() == 0 && fb_flushing(), "FLUSH ASSERT 5");
+   fb_begin();
+   assert(drain_flush() == 3 && !fb_flushing(), "FLUSH ASSERT 6");
+   GLCD_clear();
 }
 
 /*
@@ -563,100 +1291,71 @@ void GLCD_putstr(char * str) {
 
 /**
  * Display a number on the GLCD
+ * Up to PRECISION fractional digits are shown, truncated (see
+ * calc_format())
  */
 void GLCD_putnum(CALC_TYPE num) {
-   /* variables */
-   int i;     // floating-point display FOR loop
-   int digit; // range = 0 through 9
-
-   // 64-bit integer
-   long long int pow10 = 1; // 10^0 = 1
-   long long int whole = 0; // must be set later
-   CALC_TYPE fractional_part = 0; // must be set later
-   
-   /* STEP 1 */
-   // check if the number is negative
+   char text[CALC_FORMAT_SIZE(PRECISION)];
+   calc_format(num, PRECISION, text, sizeof(text));
+   GLCD_putstr(text);
+}
+
+/**
+ * Display a whole number on the GLCD (counters and measurements,
+ * whatever the numeric backend)
+ */
+void GLCD_putint(long long num) {
+   char text[21]; // sign and 19 digits
+   int length = sizeof(text) - 1;
+   unsigned long long magnitude = num < 0 ? 0 - (unsigned long long)num : num;
+   text[length] = '\0';
+   do {
+      text[--length] = '0' + magnitude % 10;
+      magnitude /= 10;
+   } while (magnitude != 0);
    if (num < 0) {
-      // display the negative sign
-      GLCD_putstr("-"); 
-      // negate to a positive number
-      // possible loss of data if num is the maximum
-      // negative number possible given the calculation type
-      num = -num; // e.g. -(-5) = 5
-   }
-   // NOT IMPLEMENTED YET
-    
-   /* STEP 2 */ 
-   // extract the whole part from the fractional
-   // 64-bit integer
-   whole = (long long int)num; // whole part of num, e.g. (int)3.14 = 3 
-   fractional_part = num - whole; // e.g. 3.14 - 3 = 0.14
-
-
-   /* STEP 3 */ 
-   // find the greatest power of 10
-   // we can integer-divide the whole part of the
-   // number by that is meaningful to display
-   // (instead of an infinite-trail of leading zeros)
-   // WHILE there is a greater power of 10
-   // that we can integer-divide the
-   // number by and obtain a non-zero answer
-   while (pow10 * 10 <= whole) {
-      pow10 *= 10;
-   } 
-
-   /* STEP 4 */
-   // display the whole part of the number one
-   // digit at a time
-   // WHILE the power of 10 hasn't gone below 10^0 = 1
-   while (pow10 >= 1) {
-      digit = whole / pow10; // e.g. 313 / 10^2 = 3
-      whole %= pow10;         // e.g. 313 % 10^2 = 13
-      // print digit
-      // add 48 to convert the number to its ASCII 
-      // visual representation
-      // subtract 32 to index from 0 (Space) to the underscore
-      // in the font table
-      // 48-32=16 is leftover needing to be added
-      GLCD_putchar(digit + 16); 
-
-      // update the power of 10
-      pow10 /= 10; // e.g. 10^3 / 10 = 10^2
-   }
-   //GLCD_putstr("+");
-   
-   /* STEP 5 */
-   // check if there is a fractional part
-   if (fractional_part != 0.0) {
-      GLCD_putstr("."); // if so, display the decimal point
-
-      // display the fractional part of the number one
-      // digit at a time up to the defined precision
-      // this way of displaying the fractional part of the number
-      // is at the mercy of the precision of floating-point operations 
-      // on the MSP432
-      for (i = 0; i < PRECISION; ++i) {
-         fractional_part *= 10; // e.g. 10(0.314) = 3.14
-         digit = (int)fractional_part; // e.g. (int)3.14 = 3
-         fractional_part -= digit;     // e.g. 3.14 - 3 = 0.14
-
-
-         /* print digit */
-         // add 48 to convert the number to its ASCII 
-         // visual representation
-         // subtract 32 to index from 0 (Space) to the underscore
-         // in the font table
-         // 48-32=16 is leftover needing to be added
-         // under the assumption that multiplying by 10 and casting
-         // that result to an integer should give an integer
-         // in the range 0-9, make sure that is the case
-         // IF digit is in [0, 9]
-         if (digit < 10 && digit >= 0) {
-            GLCD_putchar(digit + 16); 
-         }
+      text[--length] = '-';
+   }
+   GLCD_putstr(&text[length]);
+}
+
+/**
+ * Display a c-string on the GLCD in the proportional font (see font.h)
+ * from column 0 of the given bank. A line ends between two glyphs and
+ * the text goes on at the start of the next bank.
+ * Returns the bank after the text.
+ */
+int GLCD_putpstr(const char * str, int bank) {
+   uint8_t columns[GLCD_WIDTH];
+   int32_t index;
+   while (*str != '\0' && bank < GLCD_HEIGHT / 8) {
+      // measure first: as many glyphs as fit, then only their columns
+      int length = font_fit(str, GLCD_WIDTH, NULL);
+      int count = font_render(str, length, columns);
+      GLCD_setCursor(0, bank);
+      for (index = 0; index < count; index++) {
+         GLCD_data_write(columns[index]);
       }
+      str += length;
+      ++bank;
    }
+   return bank;
+}
 
+/**
+ * Draw a c-string in the proportional font into the framebuffer's
+ * back buffer, laid out like GLCD_putpstr() does on the display
+ * Returns the bank after the text.
+ */
+int GLCD_drawpstr(const char * str, int bank) {
+   while (*str != '\0' && bank < FB_BANKS) {
+      int length = font_fit(str, FB_WIDTH, NULL);
+      // the columns of the line go straight into the bank
+      font_render(str, length, fb[bank]);
+      str += length;
+      ++bank;
+   }
+   return bank;
 }
 
 /**
@@ -664,13 +1363,34 @@ void GLCD_putnum(CALC_TYPE num) {
  * according to the 6 integers at the 
  * given indexed-column in the font table
  */
-void GLCD_putchar(int c)
+RAMFUNC void GLCD_putchar(int c)
 {
     int i;
     for(i = 0; i < 6; i++)
         GLCD_data_write(font_table[c][i]);
 }
 
+/**
+ * Draw a character of the font table with its top left corner at any
+ * pixel (x, y) of the framebuffer (see fb.h); GLCD_flush() shows it
+ */
+void GLCD_blitchar(int x, int y, int c, uint8_t mode) {
+   fb_blit((const uint8_t *)font_table[c], 6, 8, x, y, mode);
+}
+
+/**
+ * Send the whole framebuffer to the GLCD
+ */
+RAMFUNC void GLCD_flush(void) {
+   const uint8_t * byte = &fb[0][0];
+   int32_t index;
+   fb_invalidate(); /* the display shows the back buffer from now on */
+   GLCD_setCursor(0, 0); /* the PCD8544 moves on by itself from here */
+   for (index = 0; index < FB_BANKS * FB_WIDTH; index++) {
+      GLCD_data_write(byte[index]);
+   }
+}
+
 void GLCD_setCursor(unsigned char x, unsigned char y)
 {
     GLCD_command_write(0x80 | x); /* column */
@@ -678,12 +1398,40 @@ void GLCD_setCursor(unsigned char x, unsigned char y)
 }
 
 /* clears the GLCD by writing zeros to the entire screen */
-void GLCD_clear(void)
+RAMFUNC void GLCD_clear(void)
 {
     int32_t index;
     for(index = 0; index < (GLCD_WIDTH * GLCD_HEIGHT / 8); index++)
         GLCD_data_write(0x00);
     GLCD_setCursor(0, 0); /* return to the home position */
+    fb_invalidate(); /* the next flush sends the whole frame */
+}
+
+/**
+ * Start drawing a frame into the framebuffer (see fb.h), taking back
+ * a frame that still waits for the flush
+ */
+void GLCD_begin(void)
+{
+    NVIC_DisableIRQ(EUSCIB0_IRQn); /* not while the flush swaps */
+    fb_begin();
+    NVIC_EnableIRQ(EUSCIB0_IRQn);
+}
+
+/**
+ * Show the frame drawn since GLCD_begin(): EUSCIB0_IRQHandler() sends
+ * its changes in the background, now or when the flush going ends
+ */
+void GLCD_present(void)
+{
+    NVIC_DisableIRQ(EUSCIB0_IRQn); /* not while the flush swaps */
+    if (fb_present()) {
+        EUSCI_B0->IE |= EUSCI_B_IE_TXIE; /* TXIFG is set while TXBUF is empty */
+    }
+    else if (!fb_flushing()) {
+        TRACE(TRACE_FLUSH_END, 0); /* the same frame, nothing to send */
+    }
+    NVIC_EnableIRQ(EUSCIB0_IRQn);
 }
 
 /* send the initialization commands to PCD8544 GLCD controller */
@@ -702,8 +1450,9 @@ void GLCD_init(void)
 }
 
 /* write to GLCD controller data register */
-void GLCD_data_write(unsigned char data)
+RAMFUNC void GLCD_data_write(unsigned char data)
 {
+    while(EUSCI_B0->IE & EUSCI_B_IE_TXIE); /* let a flush finish */
     P6->OUT |= DC;              /* select data register */
     SPI_write(data);            /* send data via SPI */
 }
@@ -711,6 +1460,7 @@ void GLCD_data_write(unsigned char data)
 /* write to GLCD controller command register */
 void GLCD_command_write(unsigned char data)
 {
+    while(EUSCI_B0->IE & EUSCI_B_IE_TXIE); /* let a flush finish */
     P6->OUT &= ~DC;             /* select command register */
     SPI_write(data);            /* send data via SPI */
 }
@@ -719,7 +1469,8 @@ void SPI_init(void)
 {
     EUSCI_B0->CTLW0 = 0x0001;   /* put UCB0 in reset mode */
     EUSCI_B0->CTLW0 = 0x69C1;   /* PH=0, PL=1, MSB first, Master, SPI, SMCLK */
-    EUSCI_B0->BRW = 3;          /* 3 MHz / 3 = 1MHz */
+    /* SMCLK stays at CLOCK_SMCLK_HZ (see clock_setup()) */
+    EUSCI_B0->BRW = CLOCK_SMCLK_HZ / SPI_CLOCK; /* 12 MHz / 12 = 1MHz */
     EUSCI_B0->CTLW0 &= ~0x001;   /* enable UCB0 after config */
 
     P1->SEL0 |= 0x60;           /* P1.5, P1.6 for UCB0 */
@@ -730,7 +1481,7 @@ void SPI_init(void)
     P6->OUT &= ~RESET;          /* assert reset */
 }
 
-void SPI_write(unsigned char data)
+RAMFUNC void SPI_write(unsigned char data)
 {
     P6->OUT &= ~CE;             /* assert /CE */
     EUSCI_B0->TXBUF = data;     /* write data */
@@ -738,6 +1489,31 @@ void SPI_write(unsigned char data)
     P6->OUT |= CE;              /* deassert /CE */
 }
 
+/***
+* IRQ handler for eUSCI_B0: the framebuffer flush
+* TXBUF is empty: load the next byte fb_flush_next() hands over. /CE
+* stays low for the whole flush; DC only changes once the byte before
+* is out, and the interrupt turns itself off when the flush is done.
+***/
+RAMFUNC void EUSCIB0_IRQHandler(void)
+{
+    uint8_t byte;
+    int kind = fb_flush_next(&byte);
+    if (kind == FB_SEND_NONE) {
+        EUSCI_B0->IE &= ~EUSCI_B_IE_TXIE;
+        while(EUSCI_B0->STATW & 0x01);/* wait for the last byte */
+        P6->OUT |= CE;          /* deassert /CE */
+        TRACE(TRACE_FLUSH_END, 0);
+        return;
+    }
+    if ((kind == FB_SEND_DATA) != ((P6->OUT & DC) != 0)) {
+        while(EUSCI_B0->STATW & 0x01);/* the byte before goes as it was */
+        P6->OUT ^= DC;          /* switch between data and command */
+    }
+    P6->OUT &= ~CE;             /* assert /CE */
+    EUSCI_B0->TXBUF = byte;     /* clears TXIFG until it moves on */
+}
+
 
 
 /**
@@ -746,16 +1522,50 @@ void SPI_write(unsigned char data)
  * or equal sign, display the operation and RHS
  */
 void display_current_state() {
-   // always clear the display before displaying the
-   // current state
-   GLCD_clear();
-   GLCD_putnum(lhs);
-   // IF the opeartion is not the null character or the equal sign
-   if (operation != '\0' && operation != '=') {
-      // display the operation and the rhs
-      GLCD_putchar(operation - 32); // get operation within index range
-      GLCD_putnum(rhs);       // display the rhs
+   TRACE(TRACE_FLUSH_START, 0);
+   // draw the frame into the back buffer, which starts as the frame
+   // before; the flush sends only what changed (see fb.h)
+   GLCD_begin();
+   // in the big-integer mode, fill the six banks with one page of text
+   // (14 characters of font_table to a bank)
+   if (bigcalc_mode) {
+      int count, k;
+      const char * page = bigcalc_page(&count);
+      fb_clear();
+      for (k = 0; k < count; ++k) {
+         GLCD_blitchar(6 * (k % 14), 8 * (k / 14), page[k] - 32, FB_OR);
+      }
+      tape_invalidate(); // the page covers the tape
+   }
+   // in the graph mode, the next columns of the graph; more frames
+   // follow until every column is evaluated
+   else if (plot_mode) {
+      if (plot_render()) {
+         render_continue(); // not a state change (see render.h)
+      }
+      tape_invalidate(); // the graph covers the tape
+   }
+   // in the statistics mode, a page of results over the value being
+   // typed, one line to a bank (cut at the edge of the display)
+   else if (stats_mode) {
+      char text[CALC_FORMAT_SIZE(PRECISION) + 24];
+      int line;
+      fb_clear();
+      for (line = 0; line < STATS_LINES; ++line) {
+         stats_line(line, text, sizeof(text), PRECISION);
+         font_render(text, font_fit(text, FB_WIDTH, NULL), fb[line]);
+      }
+      tape_invalidate(); // the page covers the tape
    }
+   else {
+      // lhs, operation and rhs in the bottom bank, under the paper
+      // tape of the calculations before (see tape.h)
+      char text[CALC_ENTRY_SIZE(PRECISION)];
+      calc_entry_text(&calc, PRECISION, text, sizeof(text));
+      tape_render(); // scroll in what was completed since the last frame
+      tape_entry(text);
+   }
+   GLCD_present(); // TRACE_FLUSH_END once it's on the display
 }
 
 /**
@@ -775,29 +1585,29 @@ void test_alphabet() {
  */
 void test_positive_ints() {
 
-   GLCD_putnum(0);
+   GLCD_putnum(NUM(0));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(1);
+   GLCD_putnum(NUM(1));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(2);
+   GLCD_putnum(NUM(2));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(10);
+   GLCD_putnum(NUM(10));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(11);
+   GLCD_putnum(NUM(11));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(36);
+   GLCD_putnum(NUM(36));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(313);
+   GLCD_putnum(NUM(313));
    GLCD_putchar(' '); // put a space in between
    // test the biggest int possible: 2^64 - 1
    // should map to -(2^64) + (2^64 - 1) rem 2^64
    // where rem is the modulo
    // this should display the character just before
    // 0 because that is -1 according to the logic in putnum
-   //GLCD_putnum(18446744073709551615);
+   //GLCD_putnum(NUM(18446744073709551615));
    //GLCD_putchar(' '); // put a space in between
    // test the biggest unsigned int possible: 2^32 - 1
-   GLCD_putnum(4294967295);
+   GLCD_putnum(NUM(4294967295));
    GLCD_putchar(' '); // put a space in between
    __delay_cycles(DELAY);
 }
@@ -807,14 +1617,14 @@ void test_positive_ints() {
  */
 void test_negative_ints() {
 
-   GLCD_putnum(-1);
+   GLCD_putnum(NUM(-1));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(-3);
+   GLCD_putnum(NUM(-3));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(-313);
+   GLCD_putnum(NUM(-313));
    GLCD_putchar(' '); // put a space in between
    // test the biggest unsigned int possible: -(2^32)
-   GLCD_putnum(-4294967296);
+   GLCD_putnum(NUM(-4294967296));
    GLCD_putchar(' '); // put a space in between
    __delay_cycles(DELAY);
 }
@@ -822,21 +1632,21 @@ void test_negative_ints() {
  * Test some positive floats
  */
 void test_positive_floats() {
-   GLCD_putnum(3.14);
+   GLCD_putnum(NUM(3.14));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(3.1);
+   GLCD_putnum(NUM(3.1));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(0.3);
+   GLCD_putnum(NUM(0.3));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(0.33333333333);
+   GLCD_putnum(NUM(0.33333333333));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(0.00000000001);
+   GLCD_putnum(NUM(0.00000000001));
    GLCD_putchar(' '); // put a space in between
    // a more precise float
-   GLCD_putnum(0.000000000000000001);
+   GLCD_putnum(NUM(0.000000000000000001));
    GLCD_putchar(' '); // put a space in between
    // big floating point
-   GLCD_putnum(33333.14159265359);
+   GLCD_putnum(NUM(33333.14159265359));
    GLCD_putchar(' '); // put a space in between
    __delay_cycles(DELAY);
 }
@@ -845,21 +1655,21 @@ void test_positive_floats() {
  * Test some negative floats
  */
 void test_negative_floats() {
-   GLCD_putnum(-3.14);
+   GLCD_putnum(NUM(-3.14));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(-3.1);
+   GLCD_putnum(NUM(-3.1));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(-0.3);
+   GLCD_putnum(NUM(-0.3));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(-0.33333333333);
+   GLCD_putnum(NUM(-0.33333333333));
    GLCD_putchar(' '); // put a space in between
-   GLCD_putnum(-0.00000000001);
+   GLCD_putnum(NUM(-0.00000000001));
    GLCD_putchar(' '); // put a space in between
    // a more precise float
-   GLCD_putnum(-0.000000000000000001);
+   GLCD_putnum(NUM(-0.000000000000000001));
    GLCD_putchar(' '); // put a space in between
    // big floating point
-   GLCD_putnum(-33333.14159265359);
+   GLCD_putnum(NUM(-33333.14159265359));
    GLCD_putchar(' '); // put a space in between
    __delay_cycles(DELAY);
 }
@@ -885,3 +1695,788 @@ void test_putnum() {
    GLCD_clear();
 
 }
+
+/**
+ * Benchmark the hot-path functions tagged RAMFUNC.
+ * Displays the SRAM taken by the .TI.ramfunc section followed by the
+ * average cycles per call of each function. Run it once in a normal
+ * build (RAM placement) and once with RAMFUNC_DISABLE defined (flash
+ * placement) and compare. The flash wait states only show up at the
+ * higher clock profiles, so set __SYSTEM_CLOCK in system_msp432p401r.c
+ * to 48000000 for the comparison.
+ */
+void bench_ramfunc() {
+   /* run-time size of the .TI.ramfunc section (see msp432p401r.cmd) */
+   extern uint8_t ramfunc_run_size;
+   uint32_t start; // cycle count before the runs
+   uint32_t clear_cycles, char_cycles, spi_cycles, decode_cycles;
+   int run;        // used in for loops
+
+   cycles_init();
+
+   // time the whole-screen clear
+   start = cycles_now();
+   for (run = 0; run < BENCH_RUNS; ++run) {
+      GLCD_clear();
+   }
+   clear_cycles = (cycles_now() - start) / BENCH_RUNS;
+
+   // time a single glyph ('8' lights the most columns)
+   start = cycles_now();
+   for (run = 0; run < BENCH_RUNS; ++run) {
+      GLCD_putchar('8' - 32);
+   }
+   char_cycles = (cycles_now() - start) / BENCH_RUNS;
+
+   // time a single byte through the SPI
+   start = cycles_now();
+   for (run = 0; run < BENCH_RUNS; ++run) {
+      SPI_write(0x00);
+   }
+   spi_cycles = (cycles_now() - start) / BENCH_RUNS;
+
+   // time the keypad decoder
+   start = cycles_now();
+   for (run = 0; run < BENCH_RUNS; ++run) {
+      keypad_decode();
+   }
+   decode_cycles = (cycles_now() - start) / BENCH_RUNS;
+
+   // one result per bank
+   GLCD_clear();
+   GLCD_putstr("RAM ");
+   GLCD_putint((uint32_t)&ramfunc_run_size);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("MHZ ");
+   GLCD_putint(SystemCoreClock / 1000000);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("CLEAR ");
+   GLCD_putint(clear_cycles);
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("CHAR ");
+   GLCD_putint(char_cycles);
+   GLCD_setCursor(0, 4);
+   GLCD_putstr("SPI ");
+   GLCD_putint(spi_cycles);
+   GLCD_setCursor(0, 5);
+   GLCD_putstr("DECODE ");
+   GLCD_putint(decode_cycles);
+   __delay_cycles(4*DELAY);
+}
+
+/**
+ * Show the stack usage so far: the size, the high-water mark, the most
+ * handlers nested at once and the deepest stack at each handler's entry
+ * (all in bytes). Press keys and S1 for a while first, then call it
+ * (or send LINK_STACK_QUERY over the host link).
+ */
+void show_stack() {
+   GLCD_clear();
+   GLCD_putstr("STACK ");
+   GLCD_putint(stack_size());
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("PEAK ");
+   GLCD_putint(stack_high_water());
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("NEST ");
+   GLCD_putint(stack_nesting_max);
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("P1 ");
+   GLCD_putint(stack_isr[STACK_ISR_PORT1].entry_max);
+   GLCD_putstr(" P3 ");
+   GLCD_putint(stack_isr[STACK_ISR_PORT3].entry_max);
+   GLCD_setCursor(0, 4);
+   GLCD_putstr("UART ");
+   GLCD_putint(stack_isr[STACK_ISR_UART].entry_max);
+   GLCD_setCursor(0, 5);
+   GLCD_putstr("PENDSV ");
+   GLCD_putint(stack_isr[STACK_ISR_RENDER].entry_max);
+   __delay_cycles(4*DELAY);
+}
+
+/***
+* IRQ handler for Timer32 module 2: the latency probe
+* Sets the port 3 flag in software, as if a key had been pressed, and
+* notes the time; PORT3_IRQHandler measures how long it waited.
+***/
+void T32_INT2_IRQHandler(void) {
+   TIMER32_2->INTCLR = 0; /* any write clears the interrupt */
+   if (!probe_armed) {
+      probe_at = timebase_now();
+      probe_armed = 1;
+      P3->IFG |= DA;      /* a software "key press" */
+   }
+}
+
+/*
+ * Redraw BENCH_RUNS times from PendSV while the probe fires
+ * Returns the longest redraw in timestamp ticks
+ */
+static uint32_t redraw_under_probe(void) {
+   uint32_t start, took, longest = 0;
+   int run; // used in for loop
+   probe_max = probe_sum = probe_count = 0;
+   for (run = 0; run < BENCH_RUNS; ++run) {
+      start = timebase_now();
+      post_input(INPUT_REDRAW); // PendSV runs before this returns
+      took = timebase_now() - start;
+      if (took > longest) {
+         longest = took;
+      }
+   }
+   return longest;
+}
+
+/**
+ * Measure the input latency while the display redraws: Timer32 module
+ * 2 fires a software port 3 interrupt about every 0.7 ms, out of step
+ * with the redraws, and PORT3_IRQHandler records how long each waited.
+ * It runs once with PendSV below the input handlers (the normal
+ * scheme) and once with PendSV at their level, which is how rendering
+ * in PORT3_IRQHandler used to behave. The results are in TIMEBASE_HZ
+ * ticks: the longest redraw, then the longest and the average wait of
+ * the probes in each case.
+ */
+void bench_input_latency() {
+   uint32_t render_max;
+   uint32_t low_max, low_avg, same_max, same_avg;
+
+   TIMER32_2->CONTROL = 0;                       /* stop while configuring */
+   TIMER32_2->LOAD = SystemCoreClock / 1429 - 1; /* about 0.7 ms */
+   TIMER32_2->CONTROL = TIMER32_CONTROL_SIZE     /* 32-bit counter */
+                      | TIMER32_CONTROL_MODE     /* periodic */
+                      | TIMER32_CONTROL_IE       /* interrupt on zero */
+                      | TIMER32_CONTROL_ENABLE;
+   NVIC_SetPriority(T32_INT2_IRQn, PRIO_PROBE);
+   NVIC_EnableIRQ(T32_INT2_IRQn);
+
+   // rendering preemptable by the input handlers
+   render_max = redraw_under_probe();
+   low_max = probe_max;
+   low_avg = probe_count ? probe_sum / probe_count : 0;
+
+   // rendering at the input handlers' level
+   NVIC_SetPriority(PendSV_IRQn, PRIO_INPUT);
+   redraw_under_probe();
+   same_max = probe_max;
+   same_avg = probe_count ? probe_sum / probe_count : 0;
+   NVIC_SetPriority(PendSV_IRQn, PRIO_RENDER);
+
+   NVIC_DisableIRQ(T32_INT2_IRQn);
+   TIMER32_2->CONTROL = 0;
+
+   // one result per bank
+   GLCD_clear();
+   GLCD_putstr("RENDER ");
+   GLCD_putint(render_max);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("LOW MAX ");
+   GLCD_putint(low_max);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("LOW AVG ");
+   GLCD_putint(low_avg);
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("SAME MAX ");
+   GLCD_putint(same_max);
+   GLCD_setCursor(0, 4);
+   GLCD_putstr("SAME AVG ");
+   GLCD_putint(same_avg);
+   GLCD_setCursor(0, 5);
+   GLCD_putstr("MHZ ");
+   GLCD_putint(SystemCoreClock / 1000000);
+   __delay_cycles(4*DELAY);
+}
+
+/**
+ * Show the frame-rate limit at work: the state changes so far, the
+ * redraws they took, the changes merged into a later redraw and the
+ * frames that only carried on a graph. Type a fast burst (or inject
+ * keys from the host) first.
+ */
+void show_render() {
+   GLCD_clear();
+   GLCD_putstr("HZ ");
+   GLCD_putint(RENDER_HZ);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("CHANGES ");
+   GLCD_putint(render_updates);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("FRAMES ");
+   GLCD_putint(render_frames);
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("SKIPPED ");
+   GLCD_putint(render_skipped);
+   GLCD_setCursor(0, 4);
+   GLCD_putstr("DROPPED ");
+   GLCD_putint(input_dropped);
+   GLCD_setCursor(0, 5);
+   GLCD_putstr("GRAPH ");
+   GLCD_putint(render_continued);
+   __delay_cycles(4*DELAY);
+}
+
+/**
+ * Benchmark the panel's wake (see idle.h): time out at once, let the
+ * panel go dark for a moment and wake it with an input, 8 times; show
+ * the last and longest wake-to-first-pixel times, from post_input()
+ * to the panel on
+ */
+void bench_idle() {
+   uint64_t hz = timebase_hz();
+   int k; // used in for loop
+
+   for (k = 0; k < 8; ++k) {
+      while (render_pending()); // nothing left to draw
+      idle_expire();
+      while (!idle_asleep());
+      __delay_cycles(DELAY / 8);
+      post_input(INPUT_REDRAW); // wakes it, then redraws
+      while (idle_asleep());
+   }
+
+   // one result per bank
+   GLCD_clear();
+   GLCD_putstr("TIMEOUT S ");
+   GLCD_putint(IDLE_TIMEOUT);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("SLEEPS ");
+   GLCD_putint(idle_sleeps);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("WAKE US ");
+   GLCD_putint(idle_wake_last * 1000000 / hz);
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("MAX US ");
+   GLCD_putint(idle_wake_max * 1000000 / hz);
+   __delay_cycles(4*DELAY);
+   post_input(INPUT_REDRAW); // put the calculator back on the display
+}
+
+/**
+ * Show the snapshot statistics (see snapshot.h): whether this boot
+ * resumed, the cycles snapshot_restore() took and the time from the
+ * timebase's start to the first display, then the saves so far
+ */
+void show_snapshot() {
+   GLCD_clear();
+   GLCD_putstr("RESUMED ");
+   GLCD_putint(resumed);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("RESTORE CYC ");
+   GLCD_putint(snapshot_restore_cycles);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("BOOT US ");
+   GLCD_putint((uint64_t)boot_ticks * 1000000 / timebase_hz());
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("SEQ ");
+   GLCD_putint(snapshot_seq);
+   GLCD_setCursor(0, 4);
+   GLCD_putstr("WRITES ");
+   GLCD_putint(snapshot_writes);
+   GLCD_setCursor(0, 5);
+   GLCD_putstr("ERASES ");
+   GLCD_putint(snapshot_erases);
+   __delay_cycles(4*DELAY);
+}
+
+/**
+ * Benchmark the numeric backend this build was compiled with (see
+ * num.h): the average cycles of each operation and of formatting a
+ * result at PRECISION. Build once per CALC_BACKEND and compare; the
+ * host's numbench compares their accuracy.
+ */
+void bench_numeric() {
+   /* keypad-sized operands, mostly whole numbers, some with cents */
+   static const double operands[8] = {
+      12, 7, 1234, 0.25, 98765, 7.89, 42, 3
+   };
+   CALC_TYPE a[8], b[8];
+   CALC_TYPE result = num_from_int(0);
+   char text[CALC_FORMAT_SIZE(PRECISION)];
+   uint32_t start; // cycle count before the runs
+   uint32_t cycles[5];
+   int status = CALC_OK;
+   int run, k;     // used in for loops
+
+   for (k = 0; k < 8; ++k) {
+      a[k] = NUM(operands[k]);
+      b[k] = NUM(operands[7 - k]);
+   }
+   cycles_init();
+
+   // each operation over the eight pairs
+#define BENCH_OP(slot, op)                                            \
+   start = cycles_now();                                              \
+   for (run = 0; run < BENCH_RUNS; ++run) {                           \
+      for (k = 0; k < 8; ++k) {                                       \
+         result = op(a[k], b[k], &status);                            \
+      }                                                               \
+   }                                                                  \
+   cycles[slot] = (cycles_now() - start) / (8 * BENCH_RUNS);
+   BENCH_OP(0, num_add);
+   BENCH_OP(1, num_sub);
+   BENCH_OP(2, num_mul);
+   BENCH_OP(3, num_div);
+#undef BENCH_OP
+
+   // format the results of the divisions (the longest)
+   start = cycles_now();
+   for (run = 0; run < BENCH_RUNS; ++run) {
+      for (k = 0; k < 8; ++k) {
+         calc_format(num_div(a[k], b[k], &status), PRECISION, text,
+                     sizeof(text));
+      }
+   }
+   cycles[4] = (cycles_now() - start) / (8 * BENCH_RUNS) - cycles[3];
+
+   // one result per bank
+   GLCD_clear();
+   GLCD_putstr("BACKEND ");
+   GLCD_putint(CALC_BACKEND);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("ADD ");
+   GLCD_putint(cycles[0]);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("SUB ");
+   GLCD_putint(cycles[1]);
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("MUL ");
+   GLCD_putint(cycles[2]);
+   GLCD_setCursor(0, 4);
+   GLCD_putstr("DIV ");
+   GLCD_putint(cycles[3]);
+   GLCD_setCursor(0, 5);
+   GLCD_putstr("FORMAT ");
+   GLCD_putint(cycles[4]);
+   (void)result;
+   __delay_cycles(4*DELAY);
+}
+
+/**
+ * Replay the built-in macro (see macro.h) through the keypad's path
+ * and show the keys per second, the keys dropped and the post to
+ * display latency percentiles in microseconds. MACRO_TIMED plays it
+ * at typing speed, MACRO_FAST as fast as PendSV takes the keys.
+ * Call it after render_init(); the replay waits for frame slots.
+ */
+void bench_macro(uint8_t mode) {
+   const macro_report_t * report;
+   uint64_t hz = timebase_hz();
+
+   macro_replay(macro_builtin, macro_builtin_count, mode);
+   while (macro_busy()) {
+      macro_service();
+   }
+   report = macro_result();
+
+   // one result per bank
+   GLCD_clear();
+   GLCD_putstr("KEYS/S ");
+   GLCD_putint(report->ticks
+               ? report->keys * hz / report->ticks : 0);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("DROPPED ");
+   GLCD_putint(report->dropped);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("P50 US ");
+   GLCD_putint(report->p50 * 1000000 / hz);
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("P99 US ");
+   GLCD_putint(report->p99 * 1000000 / hz);
+   GLCD_setCursor(0, 4);
+   GLCD_putstr("MAX US ");
+   GLCD_putint(report->max * 1000000 / hz);
+   __delay_cycles(4*DELAY);
+   post_input(INPUT_REDRAW); // put the calculator back on the display
+}
+
+/**
+ * Benchmark the framebuffer blitter: average cycles per 6x8 glyph on a
+ * bank boundary (ALIGN), 3 pixels below one so it straddles two banks
+ * (SHIFT), the same with XOR, half off the right edge (CLIP), and the
+ * cycles of sending the whole framebuffer (FLUSH)
+ */
+void bench_blit() {
+   const uint8_t * eight = (const uint8_t *)font_table['8' - 32];
+   uint32_t start; // cycle count before the runs
+   uint32_t aligned, shifted, xored, clipped, flush;
+   int run;        // used in for loops
+
+   cycles_init();
+   fb_clear();
+
+#define BENCH_GLYPH(result, x, y, mode)                               \
+   start = cycles_now();                                              \
+   for (run = 0; run < BENCH_RUNS; ++run) {                           \
+      fb_blit(eight, 6, 8, (x), (y), (mode));                         \
+   }                                                                  \
+   result = (cycles_now() - start) / BENCH_RUNS;
+   BENCH_GLYPH(aligned, 12, 8, FB_OR);
+   BENCH_GLYPH(shifted, 12, 11, FB_OR);
+   BENCH_GLYPH(xored, 12, 11, FB_XOR);
+   BENCH_GLYPH(clipped, FB_WIDTH - 3, 11, FB_OR);
+#undef BENCH_GLYPH
+
+   start = cycles_now();
+   GLCD_flush();
+   flush = cycles_now() - start;
+
+   // one result per bank
+   GLCD_clear();
+   GLCD_putstr("ALIGN ");
+   GLCD_putint(aligned);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("SHIFT ");
+   GLCD_putint(shifted);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("XOR ");
+   GLCD_putint(xored);
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("CLIP ");
+   GLCD_putint(clipped);
+   GLCD_setCursor(0, 4);
+   GLCD_putstr("FLUSH ");
+   GLCD_putint(flush);
+   __delay_cycles(4*DELAY);
+}
+
+/**
+ * Benchmark the proportional font against font_table on a formatted
+ * result: the SPI bytes and cycles to show it in each font, and the
+ * digits that fit on a line
+ */
+void bench_font() {
+   static const char digits[] = "8888888888888888888888888888";
+   char text[CALC_FORMAT_SIZE(PRECISION)];
+   uint32_t start; // cycle count before the runs
+   uint32_t fixed_cycles, prop_cycles;
+   int fixed_bytes, prop_bytes, length;
+   int run;        // used in for loops
+
+   length = calc_format(NUM(-12345.6789), PRECISION, text, sizeof(text));
+   fixed_bytes = 6 * length;
+   prop_bytes = 2 + font_measure(text, length); // and a cursor command
+   cycles_init();
+
+   start = cycles_now();
+   for (run = 0; run < BENCH_RUNS; ++run) {
+      GLCD_setCursor(0, 0);
+      GLCD_putstr(text);
+   }
+   fixed_cycles = (cycles_now() - start) / BENCH_RUNS;
+   start = cycles_now();
+   for (run = 0; run < BENCH_RUNS; ++run) {
+      GLCD_putpstr(text, 0);
+   }
+   prop_cycles = (cycles_now() - start) / BENCH_RUNS;
+
+   // one result per bank
+   GLCD_clear();
+   GLCD_putstr("FIX B ");
+   GLCD_putint(fixed_bytes);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("PROP B ");
+   GLCD_putint(prop_bytes);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("FIX CYC ");
+   GLCD_putint(fixed_cycles);
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("PROP CYC ");
+   GLCD_putint(prop_cycles);
+   GLCD_setCursor(0, 4);
+   GLCD_putstr("DIGITS ");
+   GLCD_putint(GLCD_WIDTH / 6);
+   GLCD_putstr(" ");
+   GLCD_putint(font_fit(digits, GLCD_WIDTH, NULL));
+   __delay_cycles(4*DELAY);
+}
+
+/**
+ * Benchmark the double-buffered display: the average cycles to draw a
+ * changing result into the back buffer and present it (DRAW), until
+ * its flush is on the display (ON LCD), and of sending the whole
+ * buffer the old way (FULL); the bytes per flush and the frames the
+ * flush took back (see fb.h); host/fbbench models the same on a
+ * PCD8544 emulator
+ */
+void bench_flush() {
+   char text[CALC_FORMAT_SIZE(PRECISION)];
+   uint32_t start; // cycle count before a run
+   uint32_t draw = 0, shown = 0, full;
+   uint32_t bytes = fb_bytes, flushes = fb_flushes;
+   int run;        // used in for loops
+
+   cycles_init();
+   GLCD_clear();
+   for (run = 0; run < BENCH_RUNS; ++run) {
+      calc_format(NUM(run * 1.25), PRECISION, text, sizeof(text));
+      start = cycles_now();
+      GLCD_begin();
+      fb_clear();
+      GLCD_drawpstr(text, 0);
+      GLCD_present();
+      draw += cycles_now() - start;
+      while (fb_flushing());
+      shown += cycles_now() - start;
+   }
+   bytes = (fb_bytes - bytes) / (fb_flushes - flushes);
+   start = cycles_now();
+   GLCD_flush();
+   full = cycles_now() - start;
+
+   // one result per bank
+   GLCD_clear();
+   GLCD_putstr("DRAW ");
+   GLCD_putint(draw / BENCH_RUNS);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("ON LCD ");
+   GLCD_putint(shown / BENCH_RUNS);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("FULL ");
+   GLCD_putint(full);
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("BYTES/F ");
+   GLCD_putint(bytes);
+   GLCD_setCursor(0, 4);
+   GLCD_putstr("TAKEN BACK ");
+   GLCD_putint(fb_replaced);
+   __delay_cycles(4*DELAY);
+}
+
+/**
+ * Benchmark the graph mode: cycles of a full redraw (FULL) and of a
+ * pan (PAN), cycles per column, samples per second and the redraws
+ * so far (see plot.h)
+ */
+void bench_plot() {
+   uint32_t start; // cycle count before a run
+   uint32_t full = 0, pan = 0;
+   uint32_t samples, ticks;
+   int run;        // used in for loops
+
+   cycles_init();
+   samples = plot_samples;
+   ticks = plot_ticks;
+   for (run = 0; run < BENCH_RUNS / 8; ++run) {
+      plot_reset();
+      start = cycles_now();
+      while (plot_render());
+      full += cycles_now() - start;
+      plot_pan(PLOT_PAN);
+      start = cycles_now();
+      while (plot_render());
+      pan += cycles_now() - start;
+   }
+   samples = plot_samples - samples;
+   ticks = plot_ticks - ticks;
+
+   // one result per bank
+   GLCD_clear();
+   GLCD_putstr("FULL ");
+   GLCD_putint(full / (BENCH_RUNS / 8));
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("PAN ");
+   GLCD_putint(pan / (BENCH_RUNS / 8));
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("CYC/COL ");
+   GLCD_putint(full / (BENCH_RUNS / 8) / (FB_WIDTH + 2));
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("SAMPLES/S ");
+   GLCD_putint((uint32_t)((uint64_t)samples * timebase_hz() / ticks));
+   GLCD_setCursor(0, 4);
+   GLCD_putstr("REDRAWS ");
+   GLCD_putint(plot_redraws);
+   __delay_cycles(4*DELAY);
+}
+
+/**
+ * Benchmark the accumulators (see stats.h): cycles to add a value
+ * and a pair, values per second, and the bytes both take
+ */
+void bench_stats() {
+   uint32_t start; // cycle count before the runs
+   uint32_t add_cycles, pair_cycles;
+   stats_t s;
+   stats_pair_t p;
+   int run;        // used in for loops
+
+   cycles_init();
+   stats_reset(&s);
+   stats_pair_reset(&p);
+   start = cycles_now();
+   for (run = 0; run < BENCH_RUNS; ++run) {
+      stats_add(&s, run * 1.25);
+   }
+   add_cycles = (cycles_now() - start) / BENCH_RUNS;
+   start = cycles_now();
+   for (run = 0; run < BENCH_RUNS; ++run) {
+      stats_pair_add(&p, run, run * 1.25);
+   }
+   pair_cycles = (cycles_now() - start) / BENCH_RUNS;
+
+   // one result per bank
+   GLCD_clear();
+   GLCD_putstr("ADD CYC ");
+   GLCD_putint(add_cycles);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("PAIR CYC ");
+   GLCD_putint(pair_cycles);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("VALUES/S ");
+   GLCD_putint(SystemCoreClock / add_cycles);
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("BYTES ");
+   GLCD_putint(sizeof(s) + sizeof(p));
+   __delay_cycles(4*DELAY);
+}
+
+/**
+ * Benchmark the bytecode VM (see vm.h): the steps of a counting loop,
+ * cycles per step, steps per second and the bytes of code; then the
+ * stack the VM path takes from PendSV (show_stack())
+ */
+void bench_vm() {
+   static const char loop[] = "0 =c begin c 1 + =c c 100 = until c";
+   static vm_program_t slot; // what the first slot held
+   calc_state_t saved;
+   vm_program_t p;
+   uint32_t start, cycles, steps;
+   int status, at;
+
+   vm_compile(loop, sizeof(loop) - 1, &p, &at);
+   cycles_init();
+   steps = vm_steps;
+   start = cycles_now();
+   vm_run(&p, num_from_int(0), num_from_int(0), &status);
+   cycles = cycles_now() - start;
+   steps = vm_steps - steps;
+
+   // one result per bank
+   GLCD_clear();
+   GLCD_putstr("STEPS ");
+   GLCD_putint(steps);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("CYC/STEP ");
+   GLCD_putint(cycles / steps);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("STEPS/S ");
+   GLCD_putint((uint32_t)((uint64_t)steps * SystemCoreClock / cycles));
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("CODE ");
+   GLCD_putint(p.length);
+   __delay_cycles(4*DELAY);
+
+   // the stack of the VM path: the loop bound to "*" and pressed, so
+   // PendSV runs it (process_key() -> vm_calc() -> vm_run())
+   saved = calc;
+   slot = vm_programs[0];
+   vm_programs[0] = p;
+   vm_programs[0].key = KEY_DECIMAL;
+   post_input(KEY_DECIMAL); // PendSV runs before this returns
+   vm_programs[0] = slot;
+   calc = saved;
+   snapshot_changed();
+   show_stack();
+   post_input(INPUT_REDRAW); // put the calculator back on the display
+}
+
+/**
+ * Benchmark the polynomial table kernels (see dsp.h): cycles per
+ * point of a 7th-order sine in Q15 and Q31 and with calc_eval_x(),
+ * as plot.c evaluates it, and Q15 points per second
+ */
+void bench_dsp() {
+   static const double sin7[] = { 0, 1, 0, -1.0 / 6, 0, 1.0 / 120, 0,
+                                  -1.0 / 5040 };
+   static const char text[] =
+      "0-0.000198412698*x*x+0.00833333333*x*x-0.166666667*x*x+1*x";
+   static q15_t x15[BENCH_RUNS], y15[BENCH_RUNS];
+   static q31_t x31[BENCH_RUNS], y31[BENCH_RUNS];
+   double scaled[8];
+   q15_t c15[8];
+   q31_t c31[8];
+   uint32_t start; // cycle count before the runs
+   uint32_t q15_cycles, q31_cycles, eval_cycles;
+   int status;
+   int k; // used in for loops
+
+   dsp_poly_prepare(sin7, 7, -3.14159265, 3.14159265, scaled);
+   for (k = 0; k < 8; ++k) {
+      c15[k] = dsp_q15(scaled[k]);
+      c31[k] = dsp_q31(scaled[k]);
+   }
+   for (k = 0; k < BENCH_RUNS; ++k) {
+      x15[k] = dsp_q15(-1 + 2.0 * k / BENCH_RUNS);
+      x31[k] = dsp_q31(-1 + 2.0 * k / BENCH_RUNS);
+   }
+   cycles_init();
+   start = cycles_now();
+   dsp_poly_q15(c15, 7, x15, y15, BENCH_RUNS);
+   q15_cycles = (cycles_now() - start) / BENCH_RUNS;
+   start = cycles_now();
+   dsp_poly_q31(c31, 7, x31, y31, BENCH_RUNS);
+   q31_cycles = (cycles_now() - start) / BENCH_RUNS;
+   // the way plot.c evaluates a point
+   start = cycles_now();
+   for (k = 0; k < BENCH_RUNS; ++k) {
+      calc_eval_x(text, sizeof(text) - 1,
+                  num_from_double(3.14159265 * dsp_from_q31(x31[k])),
+                  &status);
+   }
+   eval_cycles = (cycles_now() - start) / BENCH_RUNS;
+
+   // one result per bank
+   GLCD_clear();
+   GLCD_putstr("Q15 CYC/PT ");
+   GLCD_putint(q15_cycles);
+   GLCD_setCursor(0, 1);
+   GLCD_putstr("Q31 CYC/PT ");
+   GLCD_putint(q31_cycles);
+   GLCD_setCursor(0, 2);
+   GLCD_putstr("EVAL CYC/PT ");
+   GLCD_putint(eval_cycles);
+   GLCD_setCursor(0, 3);
+   GLCD_putstr("Q15 PT/S ");
+   GLCD_putint(SystemCoreClock / q15_cycles);
+   __delay_cycles(4*DELAY);
+}
+
+/**
+ * Benchmark the clock policies (see clock.h): replay the built-in
+ * macro at its recorded gaps under each, so each covers the same
+ * time, and show the median key-to-display latency (US) and the
+ * core's energy over the replay per key (NJ/KEY), a policy a pair of
+ * banks
+ */
+void bench_clock() {
+   static const char * const names[CLOCK_POLICIES] = { "LOW", "HIGH", "BURST" };
+   uint32_t p50[CLOCK_POLICIES], energy[CLOCK_POLICIES];
+   uint64_t hz = timebase_hz();
+   int k; // used in for loop
+
+   for (k = 0; k < CLOCK_POLICIES; ++k) {
+      const macro_report_t * report;
+      clock_policy(k);
+      clock_reset_stats();
+      macro_replay(macro_builtin, macro_builtin_count, MACRO_TIMED);
+      while (macro_busy()) {
+         macro_service();
+      }
+      report = macro_result();
+      energy[k] = report->keys ? clock_energy_nj() / report->keys : 0;
+      p50[k] = report->p50 * 1000000 / hz;
+   }
+   clock_policy(CLOCK_POLICY);
+
+   GLCD_clear();
+   for (k = 0; k < CLOCK_POLICIES; ++k) {
+      GLCD_setCursor(0, 2 * k);
+      GLCD_putstr((char *)names[k]);
+      GLCD_putstr(" US ");
+      GLCD_putint(p50[k]);
+      GLCD_setCursor(0, 2 * k + 1);
+      GLCD_putstr("NJ/KEY ");
+      GLCD_putint(energy[k]);
+   }
+   __delay_cycles(4*DELAY);
+   post_input(INPUT_REDRAW); // put the calculator back on the display
+}
@@ -44,7 +44,8 @@
 
 MEMORY
 {
-    MAIN       (RX) : origin = 0x00000000, length = 0x00040000
+    /* 0x3E000 - 0x3FFFF, the last two sectors: state snapshots (snapshot.h) */
+    MAIN       (RX) : origin = 0x00000000, length = 0x0003E000
     INFO       (RX) : origin = 0x00200000, length = 0x00004000
 #ifdef  __TI_COMPILER_VERSION__
 #if     __TI_COMPILER_VERSION__ >= 15009000
@@ -128,7 +129,10 @@ SECTIONS
 
 #ifdef  __TI_COMPILER_VERSION__
 #if     __TI_COMPILER_VERSION__ >= 15009000
-    .TI.ramfunc : {} load=MAIN, run=SRAM_CODE, table(BINIT)
+    /* RAMFUNC (see ramfunc.h) functions; the symbols let the firmware */
+    /* report the SRAM they take (see bench_ramfunc() in main.c)        */
+    .TI.ramfunc : {} load=MAIN, run=SRAM_CODE, table(BINIT),
+                  RUN_START(ramfunc_run_start), RUN_SIZE(ramfunc_run_size)
 #endif
 #endif
 }
@@ -0,0 +1,351 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: num.c
+ * Description:
+ *      The out-of-line arithmetic of the fixed-point, decimal and
+ *      adaptive backends (see num.h). Only the selected backend's part
+ *      is compiled; the floating-point backends need nothing from here.
+ */
+#include "calc.h"
+
+#if CALC_BACKEND == CALC_BACKEND_FIXED || CALC_BACKEND == CALC_BACKEND_DECIMAL \
+    || CALC_BACKEND == CALC_BACKEND_ADAPTIVE
+/*
+ * The 128-bit product of two 64-bit magnitudes, in 32-bit pieces (the
+ * M4 multiplies 32 x 32 -> 64 in one instruction)
+ */
+static void mul_64x64(uint64_t a, uint64_t b, uint64_t * hi, uint64_t * lo) {
+   uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+   uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+   uint64_t low = a_lo * b_lo;
+   uint64_t mid1 = a_hi * b_lo;
+   uint64_t mid2 = a_lo * b_hi;
+   uint64_t high = a_hi * b_hi;
+   uint64_t carry = (low >> 32) + (uint32_t)mid1 + (uint32_t)mid2;
+   *lo = (carry << 32) | (uint32_t)low;
+   *hi = high + (mid1 >> 32) + (mid2 >> 32) + (carry >> 32);
+}
+
+/*
+ * The magnitude of a signed 64-bit value (INT64_MIN included)
+ */
+static uint64_t magnitude(int64_t value) {
+   return value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+}
+#endif
+
+#if CALC_BACKEND == CALC_BACKEND_FIXED
+/**
+ * Fixed-point product: (a * b) >> NUM_FIXED_BITS, truncated
+ */
+num_t num_fixed_mul(num_t a, num_t b, int * status) {
+   int negative = (a.q < 0) != (b.q < 0);
+   uint64_t hi, lo, result;
+   mul_64x64(magnitude(a.q), magnitude(b.q), &hi, &lo);
+   // the result has to fit 63 bits after the shift
+   if (hi >> (NUM_FIXED_BITS - 1)) {
+      *status = CALC_OVERFLOW;
+      return num_fixed(0);
+   }
+   result = (hi << (64 - NUM_FIXED_BITS)) | (lo >> NUM_FIXED_BITS);
+   return num_fixed(negative ? -(int64_t)result : (int64_t)result);
+}
+
+/**
+ * Fixed-point quotient: (a << NUM_FIXED_BITS) / b, truncated
+ * The whole part is one 64-bit division; the fractional bits are
+ * long division on the remainder, one bit at a time.
+ */
+num_t num_fixed_div(num_t a, num_t b, int * status) {
+   int negative = (a.q < 0) != (b.q < 0);
+   uint64_t divisor = magnitude(b.q);
+   uint64_t quotient, remainder;
+   int bit; // used in for loop
+   if (divisor == 0) {
+      *status = CALC_DIV_BY_ZERO;
+      return num_fixed(0);
+   }
+   quotient = magnitude(a.q) / divisor;
+   remainder = magnitude(a.q) % divisor;
+   if (quotient >> (63 - NUM_FIXED_BITS)) {
+      *status = CALC_OVERFLOW;
+      return num_fixed(0);
+   }
+   for (bit = NUM_FIXED_BITS - 1; bit >= 0; --bit) {
+      // remainder < divisor <= 2^63, so doubling it can't wrap
+      remainder <<= 1;
+      quotient <<= 1;
+      if (remainder >= divisor) {
+         remainder -= divisor;
+         quotient |= 1;
+      }
+   }
+   return num_fixed(negative ? -(int64_t)quotient : (int64_t)quotient);
+}
+#endif /* CALC_BACKEND_FIXED */
+
+#if CALC_BACKEND == CALC_BACKEND_DECIMAL
+/* 10^0 through 10^18 */
+static const uint64_t pow10_table[19] = {
+   1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+   10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+   100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+   100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+   100000000000000000ULL, 1000000000000000000ULL,
+};
+
+/*
+ * Build a value from a magnitude of at most 19 digits: round it to
+ * 18 digits (half away from zero), drop trailing zeros so each value
+ * has one form, and check the exponent
+ */
+static num_t finish(uint64_t coef, int negative, int exp, int * status) {
+   num_t value;
+   unsigned int dropped = 0; // the last digit rounded off
+   while (coef >= (uint64_t)NUM_DEC_LIMIT) {
+      dropped = coef % 10;
+      coef /= 10;
+      ++exp;
+   }
+   if (dropped >= 5 && ++coef == (uint64_t)NUM_DEC_LIMIT) {
+      coef /= 10;
+      ++exp;
+   }
+   if (coef == 0) {
+      exp = 0;
+   }
+   while (coef != 0 && coef % 10 == 0) {
+      coef /= 10;
+      ++exp;
+   }
+   if (exp > NUM_DEC_MAX_EXP) {
+      *status = CALC_OVERFLOW;
+      coef = 0;
+      exp = 0;
+   }
+   else if (exp < -NUM_DEC_MAX_EXP) {
+      coef = 0; // too small to tell from zero
+      exp = 0;
+   }
+   value.coef = negative ? -(int64_t)coef : (int64_t)coef;
+   value.exp = exp;
+   return value;
+}
+
+/**
+ * coef * 10^exp, rounded to 18 digits
+ */
+num_t num_dec_make(int64_t coef, int exp) {
+   int status = CALC_OK;
+   return finish(magnitude(coef), coef < 0, exp, &status);
+}
+
+/**
+ * Decimal sum, rounded to 18 digits
+ */
+num_t num_dec_add(num_t a, num_t b, int * status) {
+   int64_t big, small; // coefficients with the larger/smaller exponent
+   int exp, shift;
+   if (a.coef == 0) {
+      return b;
+   }
+   if (b.coef == 0) {
+      return a;
+   }
+   if (a.exp < b.exp) {
+      num_t swap = a;
+      a = b;
+      b = swap;
+   }
+   big = a.coef;
+   small = b.coef;
+   exp = a.exp;
+   // line the exponents up: scale the larger one up while it has room
+   // for the carry, then round the smaller one to what's left
+   while (exp > b.exp && magnitude(big) < (uint64_t)NUM_DEC_LIMIT / 10) {
+      big *= 10;
+      --exp;
+   }
+   shift = exp - b.exp;
+   if (shift > 0) {
+      uint64_t m = magnitude(small);
+      if (shift > NUM_DEC_DIGITS) {
+         m = 0; // below half a unit of the result
+      }
+      else {
+         uint64_t rest = m % pow10_table[shift];
+         m /= pow10_table[shift];
+         if (rest >= 5 * pow10_table[shift - 1]) {
+            ++m;
+         }
+      }
+      small = small < 0 ? -(int64_t)m : (int64_t)m;
+   }
+   // both are below 10^18, so the sum fits
+   big += small;
+   return finish(magnitude(big), big < 0, exp, status);
+}
+
+/*
+ * Divide a 128-bit magnitude by d <= 10^9 in place
+ * Returns the remainder
+ */
+static uint32_t div128_small(uint64_t * hi, uint64_t * lo, uint32_t d) {
+   uint32_t words[4];
+   uint64_t rest = 0;
+   int k; // used in for loop
+   words[0] = *hi >> 32;
+   words[1] = (uint32_t)*hi;
+   words[2] = *lo >> 32;
+   words[3] = (uint32_t)*lo;
+   for (k = 0; k < 4; ++k) {
+      uint64_t part = (rest << 32) | words[k];
+      words[k] = (uint32_t)(part / d);
+      rest = part % d;
+   }
+   *hi = ((uint64_t)words[0] << 32) | words[1];
+   *lo = ((uint64_t)words[2] << 32) | words[3];
+   return (uint32_t)rest;
+}
+
+/**
+ * Decimal product, rounded to 18 digits
+ */
+num_t num_dec_mul(num_t a, num_t b, int * status) {
+   int negative = (a.coef < 0) != (b.coef < 0);
+   int exp = a.exp + b.exp;
+   uint32_t dropped = 0; // the leading digit of the part cut off last
+   uint64_t hi, lo;
+   mul_64x64(magnitude(a.coef), magnitude(b.coef), &hi, &lo);
+   // cut nine digits at a time while the product is at least 10^27
+   // (hi >= 54210109 means at least 54210109 * 2^64 > 10^27)
+   while (hi >= 54210109ULL) {
+      dropped = div128_small(&hi, &lo, 1000000000) / 100000000;
+      exp += 9;
+   }
+   // then one at a time down to 19 digits; finish() rounds the rest
+   while (hi != 0) {
+      dropped = div128_small(&hi, &lo, 10);
+      ++exp;
+   }
+   // round for the digits cut off, unless finish() has more to cut
+   // (its cut is the more significant one then)
+   if (lo < (uint64_t)NUM_DEC_LIMIT && dropped >= 5) {
+      ++lo;
+   }
+   return finish(lo, negative, exp, status);
+}
+
+/**
+ * Decimal quotient, rounded to 18 digits
+ * Long division in base ten: exact whenever the quotient has 18
+ * digits or fewer.
+ */
+num_t num_dec_div(num_t a, num_t b, int * status) {
+   int negative = (a.coef < 0) != (b.coef < 0);
+   int exp = a.exp - b.exp;
+   uint64_t divisor = magnitude(b.coef);
+   uint64_t quotient, remainder;
+   if (divisor == 0) {
+      *status = CALC_DIV_BY_ZERO;
+      return num_dec_make(0, 0);
+   }
+   quotient = magnitude(a.coef) / divisor;
+   remainder = magnitude(a.coef) % divisor;
+   while (quotient < (uint64_t)NUM_DEC_LIMIT / 10 && remainder != 0) {
+      // remainder < divisor < 10^18, so ten of it is below 2^64
+      remainder *= 10;
+      quotient = quotient * 10 + remainder / divisor;
+      remainder %= divisor;
+      --exp;
+   }
+   if (remainder != 0 && remainder >= divisor - remainder) {
+      ++quotient; // at least half a unit left
+   }
+   return finish(quotient, negative, exp, status);
+}
+
+/**
+ * The decimal nearest to a double, with at most 17 digits
+ */
+num_t num_from_double(double value) {
+   double scaled = value < 0 ? -value : value;
+   int exp = 0;
+   while (scaled >= 1e17) {
+      scaled /= 10;
+      ++exp;
+   }
+   // the fewest decimals that make it whole
+   while (scaled != (double)(uint64_t)scaled && scaled < 1e16 && exp > -30) {
+      scaled *= 10;
+      --exp;
+   }
+   return num_dec_make(value < 0 ? -(int64_t)(scaled + 0.5)
+                                 : (int64_t)(scaled + 0.5), exp);
+}
+
+/**
+ * The double nearest to a decimal (exact up to 10^22 scaling)
+ */
+double num_to_double(num_t value) {
+   double scale = 1;
+   int exp = value.exp < 0 ? -value.exp : value.exp;
+   for (; exp > 0; --exp) {
+      scale *= 10;
+   }
+   return value.exp < 0 ? (double)value.coef / scale
+                        : (double)value.coef * scale;
+}
+
+/**
+ * The whole part and the first digits of the fractional part of the
+ * magnitude, both exact (truncated)
+ */
+void num_split(num_t value, int digits, unsigned long long * whole,
+               unsigned long * fraction, int * has_fraction) {
+   uint64_t coef = magnitude(value.coef);
+   int exp = value.exp;
+   uint64_t unit, part;
+   int k; // used in for loop
+
+   *fraction = 0;
+   *has_fraction = 0;
+   if (exp >= 0) {
+      // whole; saturate what a 64-bit display value can't hold
+      for (; exp > 0 && coef <= UINT64_MAX / 10; --exp) {
+         coef *= 10;
+      }
+      *whole = exp > 0 ? UINT64_MAX : coef;
+      return;
+   }
+   // keep at most 18 fractional digits (truncating the rest)
+   for (; exp < -NUM_DEC_DIGITS; ++exp) {
+      coef /= 10;
+   }
+   unit = pow10_table[-exp];
+   *whole = coef / unit;
+   part = coef % unit;
+   *has_fraction = part != 0;
+   for (k = 0; k < digits; ++k) {
+      part *= 10; // part < unit <= 10^18
+      *fraction = *fraction * 10 + (unsigned long)(part / unit);
+      part %= unit;
+   }
+}
+#endif /* CALC_BACKEND_DECIMAL */
+
+#if CALC_BACKEND == CALC_BACKEND_ADAPTIVE
+/**
+ * Integer product of factors wider than 32 bits: exact while it fits
+ * 64 bits, real otherwise
+ */
+num_t num_adaptive_mul(num_t a, num_t b) {
+   int negative = (a.as.i < 0) != (b.as.i < 0);
+   uint64_t hi, lo;
+   mul_64x64(magnitude(a.as.i), magnitude(b.as.i), &hi, &lo);
+   if (hi == 0 && lo <= (uint64_t)INT64_MAX + negative) {
+      return num_int(negative ? (int64_t)(0 - lo) : (int64_t)lo);
+   }
+   return num_real((NUM_REAL)a.as.i * (NUM_REAL)b.as.i);
+}
+#endif /* CALC_BACKEND_ADAPTIVE */
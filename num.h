@@ -0,0 +1,113 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: num.h
+ * Description:
+ *      The numeric backend: the type of the operands (num_t, which is
+ *      CALC_TYPE) and the arithmetic on them. The backend is chosen at
+ *      compile time with CALC_BACKEND, and its operations are inline
+ *      functions (or plain operators), so there is no dispatch at run
+ *      time. Every backend provides
+ *
+ *          num_t  num_from_int(long long)
+ *          num_t  num_from_double(double)
+ *          double num_to_double(num_t)
+ *          num_t  num_add(num_t, num_t, int * status)
+ *          num_t  num_sub(num_t, num_t, int * status)
+ *          num_t  num_mul(num_t, num_t, int * status)
+ *          num_t  num_div(num_t, num_t, int * status)
+ *          int    num_is_zero(num_t)
+ *          int    num_is_negative(num_t)
+ *          num_t  num_negate(num_t)
+ *          num_t  num_digit(num_t, uint8_t digit, int fractional,
+ *                           long long * pow10)
+ *          void   num_split(num_t, int digits, unsigned long long * whole,
+ *                           unsigned long * fraction, int * has_fraction)
+ *
+ *      The arithmetic sets *status to a CALC_* error and returns 0 on
+ *      an error, and leaves *status alone otherwise. num_digit() enters
+ *      one keypad digit the way calc_digit() describes. num_split()
+ *      gives the magnitude's whole part and its first fractional
+ *      digits (truncated) for display.
+ *      NOTE:
+ *              Build with e.g. CALC_BACKEND=CALC_BACKEND_FIXED defined to
+ *              change the backend; bench_numeric() in main.c and
+ *              host/numbench compare them.
+ */
+#ifndef NUM_H
+#define NUM_H
+
+#include <stdint.h>
+
+#define CALC_BACKEND_FLOAT   1 /* single precision, on the FPU */
+#define CALC_BACKEND_DOUBLE  2 /* double precision, in software */
+#define CALC_BACKEND_FIXED   3 /* binary fixed point, Q43.20 */
+#define CALC_BACKEND_DECIMAL 4 /* decimal floating point, 18 digits */
+#define CALC_BACKEND_ADAPTIVE 5 /* 64-bit integers, double past them */
+
+#ifndef CALC_BACKEND
+#define CALC_BACKEND CALC_BACKEND_ADAPTIVE
+#endif
+
+#if CALC_BACKEND == CALC_BACKEND_FLOAT
+#define NUM_REAL float
+#elif CALC_BACKEND == CALC_BACKEND_DOUBLE || CALC_BACKEND == CALC_BACKEND_ADAPTIVE
+#ifdef __TI_COMPILER_VERSION__
+#define NUM_REAL long double
+#else
+/* the TI Arm EABI long double is a 64-bit double; match it on hosts */
+#define NUM_REAL double
+#endif
+#endif
+
+#ifdef NUM_REAL
+/*
+ * num_split() of a real value, for the floating-point backends and the
+ * real values of the adaptive one, so their displays come out the same
+ */
+static inline void num_real_split(NUM_REAL value, int digits,
+                                  unsigned long long * whole,
+                                  unsigned long * fraction,
+                                  int * has_fraction) {
+   NUM_REAL part; // what's left of the fractional part
+   int k;         // used in for loop
+   if (value < 0) {
+      value = -value;
+   }
+   *whole = (unsigned long long)value; // e.g. 3.14 -> 3
+   part = value - (NUM_REAL)*whole;    // e.g. 3.14 - 3 = 0.14
+   *has_fraction = part != 0;
+   *fraction = 0;
+   // at the mercy of the rounding of each step
+   for (k = 0; k < digits; ++k) {
+      int digit;
+      part *= 10;         // e.g. 10(0.14) = 1.4
+      digit = (int)part;  // e.g. 1
+      part -= digit;      // e.g. 0.4
+      if (digit < 0 || digit > 9) {
+         digit = 0;
+      }
+      *fraction = *fraction * 10 + digit;
+   }
+}
+#endif
+
+#if CALC_BACKEND == CALC_BACKEND_FLOAT
+#define NUM_NAME "float"
+#include "num_real.h"
+#elif CALC_BACKEND == CALC_BACKEND_DOUBLE
+#define NUM_NAME "double"
+#include "num_real.h"
+#elif CALC_BACKEND == CALC_BACKEND_ADAPTIVE
+#define NUM_NAME "adaptive"
+#include "num_adaptive.h"
+#elif CALC_BACKEND == CALC_BACKEND_FIXED
+#define NUM_NAME "fixed"
+#include "num_fixed.h"
+#elif CALC_BACKEND == CALC_BACKEND_DECIMAL
+#define NUM_NAME "decimal"
+#include "num_decimal.h"
+#else
+#error "unknown CALC_BACKEND"
+#endif
+
+#endif /* NUM_H */
@@ -0,0 +1,154 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: num_adaptive.h
+ * Description:
+ *      The adaptive backend (see num.h), the default: a value stays an
+ *      exact 64-bit integer while it is whole and in range, and becomes
+ *      a NUM_REAL (long double) at its first fractional digit, a
+ *      division that doesn't come out even or an overflow. Whole-number
+ *      addition, subtraction and multiplication are then a few ALU
+ *      instructions instead of software floating point, and whole
+ *      numbers are displayed without working out fractional digits.
+ *      A real value stays real, even when it happens to be whole.
+ */
+#ifndef NUM_ADAPTIVE_H
+#define NUM_ADAPTIVE_H
+
+/* a tagged value: which member is in use is in integral */
+typedef struct {
+   union {
+      int64_t i;  // an exact whole number
+      NUM_REAL r; // anything else
+   } as;
+   uint8_t integral;
+} num_t;
+
+num_t num_adaptive_mul(num_t, num_t);
+
+static inline num_t num_int(int64_t i) {
+   num_t value;
+   value.as.i = i;
+   value.integral = 1;
+   return value;
+}
+
+static inline num_t num_real(NUM_REAL r) {
+   num_t value;
+   value.as.r = r;
+   value.integral = 0;
+   return value;
+}
+
+static inline NUM_REAL num_as_real(num_t value) {
+   return value.integral ? (NUM_REAL)value.as.i : value.as.r;
+}
+
+static inline num_t num_from_int(long long value) {
+   return num_int(value);
+}
+
+static inline num_t num_from_double(double value) {
+   // whole numbers in range come back as integers (2^63 is exact)
+   if (value >= -9223372036854775808.0 && value < 9223372036854775808.0
+       && value == (double)(int64_t)value) {
+      return num_int((int64_t)value);
+   }
+   return num_real(value);
+}
+
+static inline double num_to_double(num_t value) {
+   return (double)num_as_real(value);
+}
+
+static inline num_t num_add(num_t a, num_t b, int * status) {
+   (void)status;
+   if (a.integral && b.integral
+       && !(b.as.i > 0 && a.as.i > INT64_MAX - b.as.i)
+       && !(b.as.i < 0 && a.as.i < INT64_MIN - b.as.i)) {
+      return num_int(a.as.i + b.as.i);
+   }
+   return num_real(num_as_real(a) + num_as_real(b));
+}
+
+static inline num_t num_sub(num_t a, num_t b, int * status) {
+   (void)status;
+   if (a.integral && b.integral
+       && !(b.as.i < 0 && a.as.i > INT64_MAX + b.as.i)
+       && !(b.as.i > 0 && a.as.i < INT64_MIN + b.as.i)) {
+      return num_int(a.as.i - b.as.i);
+   }
+   return num_real(num_as_real(a) - num_as_real(b));
+}
+
+static inline num_t num_mul(num_t a, num_t b, int * status) {
+   (void)status;
+   if (a.integral && b.integral) {
+      // two 32-bit factors can't overflow 64 bits
+      if (a.as.i == (int32_t)a.as.i && b.as.i == (int32_t)b.as.i) {
+         return num_int(a.as.i * b.as.i);
+      }
+      return num_adaptive_mul(a, b);
+   }
+   return num_real(num_as_real(a) * num_as_real(b));
+}
+
+static inline num_t num_div(num_t a, num_t b, int * status) {
+   if (b.integral ? b.as.i == 0 : b.as.r == 0) {
+      *status = CALC_DIV_BY_ZERO;
+      return num_int(0);
+   }
+   // an even division stays whole (INT64_MIN / -1 doesn't fit)
+   if (a.integral && b.integral && !(a.as.i == INT64_MIN && b.as.i == -1)
+       && a.as.i % b.as.i == 0) {
+      return num_int(a.as.i / b.as.i);
+   }
+   return num_real(num_as_real(a) / num_as_real(b));
+}
+
+static inline int num_is_zero(num_t value) {
+   return value.integral ? value.as.i == 0 : value.as.r == 0;
+}
+
+static inline int num_is_negative(num_t value) {
+   return value.integral ? value.as.i < 0 : value.as.r < 0;
+}
+
+static inline num_t num_negate(num_t value) {
+   if (value.integral && value.as.i != INT64_MIN) {
+      return num_int(-value.as.i);
+   }
+   return num_real(-num_as_real(value));
+}
+
+static inline num_t num_digit(num_t value, uint8_t digit, int fractional,
+                              long long * pow10) {
+   if (fractional) {
+      // e.g. 3 -> 3 + 1/10 = 3.1, and the next digit is in 1/100
+      value = num_real(num_as_real(value)
+                       + (NUM_REAL)digit / (NUM_REAL)(*pow10));
+      *pow10 *= 10;
+   }
+   else if (value.integral && value.as.i <= (INT64_MAX - 9) / 10
+            && value.as.i >= (INT64_MIN + 9) / 10) {
+      value = num_int(value.as.i * 10 + digit); // e.g. 3 -> 3(10) + 4 = 34
+   }
+   else {
+      value = num_real(num_as_real(value) * 10 + digit);
+   }
+   return value;
+}
+
+static inline void num_split(num_t value, int digits,
+                             unsigned long long * whole,
+                             unsigned long * fraction, int * has_fraction) {
+   if (value.integral) {
+      // no fractional digits to work out
+      *whole = value.as.i < 0 ? 0 - (uint64_t)value.as.i : (uint64_t)value.as.i;
+      *fraction = 0;
+      *has_fraction = 0;
+      return;
+   }
+   num_real_split(value.as.r, digits, whole, fraction, has_fraction);
+}
+
+#endif /* NUM_ADAPTIVE_H */
@@ -0,0 +1,88 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: num_decimal.h
+ * Description:
+ *      The decimal floating-point backend (see num.h): a value is
+ *      coef * 10^exp with up to 18 decimal digits in coef, so keyed-in
+ *      decimals like 0.1 are exact and 0.1 + 0.2 is 0.3. Results are
+ *      rounded (half away from zero) to 18 digits; the arithmetic is in
+ *      num.c. An exponent out of +-NUM_DEC_MAX_EXP is CALC_OVERFLOW.
+ */
+#ifndef NUM_DECIMAL_H
+#define NUM_DECIMAL_H
+
+#define NUM_DEC_DIGITS 18
+#define NUM_DEC_LIMIT 1000000000000000000LL /* 10^18, coef stays below */
+#define NUM_DEC_MAX_EXP 300
+
+typedef struct {
+   int64_t coef; // |coef| < NUM_DEC_LIMIT
+   int16_t exp;  // power of ten
+} num_t;
+
+num_t num_dec_make(int64_t, int);
+num_t num_dec_add(num_t, num_t, int *);
+num_t num_dec_mul(num_t, num_t, int *);
+num_t num_dec_div(num_t, num_t, int *);
+num_t num_from_double(double);
+double num_to_double(num_t);
+void num_split(num_t, int, unsigned long long *, unsigned long *, int *);
+
+static inline num_t num_from_int(long long value) {
+   return num_dec_make(value, 0);
+}
+
+static inline num_t num_negate(num_t value) {
+   value.coef = -value.coef;
+   return value;
+}
+
+static inline num_t num_add(num_t a, num_t b, int * status) {
+   return num_dec_add(a, b, status);
+}
+
+static inline num_t num_sub(num_t a, num_t b, int * status) {
+   return num_dec_add(a, num_negate(b), status);
+}
+
+static inline num_t num_mul(num_t a, num_t b, int * status) {
+   return num_dec_mul(a, b, status);
+}
+
+static inline num_t num_div(num_t a, num_t b, int * status) {
+   return num_dec_div(a, b, status);
+}
+
+static inline int num_is_zero(num_t value) {
+   return value.coef == 0;
+}
+
+static inline int num_is_negative(num_t value) {
+   return value.coef < 0;
+}
+
+static inline num_t num_digit(num_t value, uint8_t digit, int fractional,
+                              long long * pow10) {
+   int status = 0;
+   num_t next;
+   if (fractional) {
+      // the digit in the place *pow10 stands for, exactly
+      int place = 0;
+      long long p; // used in for loop
+      for (p = *pow10; p > 1; p /= 10) {
+         --place;
+      }
+      next = num_dec_add(value, num_dec_make(digit, place), &status);
+      *pow10 *= 10;
+   }
+   else {
+      // value * 10 is a shift of the exponent
+      next = value;
+      next.exp += next.coef != 0;
+      next = num_dec_add(next, num_dec_make(digit, 0), &status);
+   }
+   // a digit that would overflow is ignored
+   return status ? value : next;
+}
+
+#endif /* NUM_DECIMAL_H */
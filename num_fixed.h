@@ -0,0 +1,123 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: num_fixed.h
+ * Description:
+ *      The binary fixed-point backend (see num.h): a signed 64-bit
+ *      count of 2^-20ths (Q43.20), so about +-8.8e12 with 6 good
+ *      fractional digits. Addition and subtraction are one integer
+ *      instruction pair; multiplication and division (in num.c) work
+ *      on a 128-bit intermediate. Results that don't fit are
+ *      CALC_OVERFLOW. Decimal fractions like 0.1 are not exact.
+ */
+#ifndef NUM_FIXED_H
+#define NUM_FIXED_H
+
+#define NUM_FIXED_BITS 20 /* fractional bits */
+#define NUM_FIXED_ONE ((int64_t)1 << NUM_FIXED_BITS)
+
+/* a struct, so plain numbers can't be mixed in by mistake */
+typedef struct {
+   int64_t q; // value * 2^NUM_FIXED_BITS
+} num_t;
+
+num_t num_fixed_mul(num_t, num_t, int *);
+num_t num_fixed_div(num_t, num_t, int *);
+
+static inline num_t num_fixed(int64_t q) {
+   num_t value;
+   value.q = q;
+   return value;
+}
+
+static inline num_t num_from_int(long long value) {
+   // saturate outside the 43 integer bits
+   if (value > (INT64_MAX >> NUM_FIXED_BITS)) {
+      return num_fixed(INT64_MAX);
+   }
+   if (value < (INT64_MIN >> NUM_FIXED_BITS)) {
+      return num_fixed(INT64_MIN);
+   }
+   return num_fixed((int64_t)value * NUM_FIXED_ONE);
+}
+
+static inline num_t num_from_double(double value) {
+   // round to the nearest 2^-20
+   value *= NUM_FIXED_ONE;
+   return num_fixed((int64_t)(value < 0 ? value - 0.5 : value + 0.5));
+}
+
+static inline double num_to_double(num_t value) {
+   return (double)value.q / NUM_FIXED_ONE;
+}
+
+static inline num_t num_add(num_t a, num_t b, int * status) {
+   if ((b.q > 0 && a.q > INT64_MAX - b.q)
+       || (b.q < 0 && a.q < INT64_MIN - b.q)) {
+      *status = CALC_OVERFLOW;
+      return num_fixed(0);
+   }
+   return num_fixed(a.q + b.q);
+}
+
+static inline num_t num_sub(num_t a, num_t b, int * status) {
+   if ((b.q < 0 && a.q > INT64_MAX + b.q)
+       || (b.q > 0 && a.q < INT64_MIN + b.q)) {
+      *status = CALC_OVERFLOW;
+      return num_fixed(0);
+   }
+   return num_fixed(a.q - b.q);
+}
+
+static inline num_t num_mul(num_t a, num_t b, int * status) {
+   return num_fixed_mul(a, b, status);
+}
+
+static inline num_t num_div(num_t a, num_t b, int * status) {
+   return num_fixed_div(a, b, status);
+}
+
+static inline int num_is_zero(num_t value) {
+   return value.q == 0;
+}
+
+static inline int num_is_negative(num_t value) {
+   return value.q < 0;
+}
+
+static inline num_t num_negate(num_t value) {
+   return num_fixed(-value.q);
+}
+
+static inline num_t num_digit(num_t value, uint8_t digit, int fractional,
+                              long long * pow10) {
+   if (fractional) {
+      // the digit's share of 2^20 in its decimal place, rounded
+      value.q += (digit * NUM_FIXED_ONE + *pow10 / 2) / *pow10;
+      *pow10 *= 10;
+   }
+   // a digit that would overflow is ignored
+   else if (value.q <= (INT64_MAX - 9 * NUM_FIXED_ONE) / 10
+            && value.q >= INT64_MIN / 10) {
+      value.q = value.q * 10 + digit * NUM_FIXED_ONE;
+   }
+   return value;
+}
+
+static inline void num_split(num_t value, int digits,
+                             unsigned long long * whole,
+                             unsigned long * fraction, int * has_fraction) {
+   uint64_t magnitude = value.q < 0 ? 0 - (uint64_t)value.q : (uint64_t)value.q;
+   uint64_t part = magnitude & (NUM_FIXED_ONE - 1);
+   int k; // used in for loop
+   *whole = magnitude >> NUM_FIXED_BITS;
+   *has_fraction = part != 0;
+   *fraction = 0;
+   // exact: each step moves one decimal digit above the binary point
+   for (k = 0; k < digits; ++k) {
+      part *= 10;
+      *fraction = *fraction * 10 + (unsigned long)(part >> NUM_FIXED_BITS);
+      part &= NUM_FIXED_ONE - 1;
+   }
+}
+
+#endif /* NUM_FIXED_H */
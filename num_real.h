@@ -0,0 +1,80 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: num_real.h
+ * Description:
+ *      The binary floating-point backends (see num.h): NUM_REAL is
+ *      float for the FPU or (long) double, which the M4F can only do
+ *      in software. The operations are the C operators.
+ */
+#ifndef NUM_REAL_H
+#define NUM_REAL_H
+
+typedef NUM_REAL num_t;
+
+static inline num_t num_from_int(long long value) {
+   return (num_t)value;
+}
+
+static inline num_t num_from_double(double value) {
+   return (num_t)value;
+}
+
+static inline double num_to_double(num_t value) {
+   return (double)value;
+}
+
+static inline num_t num_add(num_t a, num_t b, int * status) {
+   (void)status;
+   return a + b;
+}
+
+static inline num_t num_sub(num_t a, num_t b, int * status) {
+   (void)status;
+   return a - b;
+}
+
+static inline num_t num_mul(num_t a, num_t b, int * status) {
+   (void)status;
+   return a * b;
+}
+
+static inline num_t num_div(num_t a, num_t b, int * status) {
+   if (b == 0) {
+      *status = CALC_DIV_BY_ZERO;
+      return 0;
+   }
+   return a / b;
+}
+
+static inline int num_is_zero(num_t value) {
+   return value == 0;
+}
+
+static inline int num_is_negative(num_t value) {
+   return value < 0;
+}
+
+static inline num_t num_negate(num_t value) {
+   return -value;
+}
+
+static inline num_t num_digit(num_t value, uint8_t digit, int fractional,
+                              long long * pow10) {
+   if (fractional) {
+      // e.g. 3 -> 3 + 1/10 = 3.1, and the next digit is in 1/100
+      value = value + (num_t)digit / (num_t)(*pow10);
+      *pow10 *= 10;
+   }
+   else {
+      value = value * 10 + digit; // e.g. 3 -> 3(10) + 4 = 34
+   }
+   return value;
+}
+
+static inline void num_split(num_t value, int digits,
+                             unsigned long long * whole,
+                             unsigned long * fraction, int * has_fraction) {
+   num_real_split(value, digits, whole, fraction, has_fraction);
+}
+
+#endif /* NUM_REAL_H */
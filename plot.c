@@ -0,0 +1,365 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: plot.c
+ * Description:
+ *      The graph mode (see plot.h).
+ */
+#include <string.h>
+#include "plot.h"
+#include "timebase.h"
+
+/* the samples: column c (-1 to FB_WIDTH) at index c + 1; the columns
+ * just off the screen give the lines at the edges their slope */
+#define PLOT_SAMPLES (FB_WIDTH + 2)
+#define PLOT_EMPTY 0 /* not evaluated yet */
+#define PLOT_GAP   1 /* f(x) is an error, nothing to draw */
+#define PLOT_VALUE 2
+#define PLOT_UNDRAWN 3 /* a value a pan brought on from off the screen */
+
+/* what a sample can be before it's a gap (a float has room to scale) */
+#define PLOT_LIMIT 1e30f
+
+/* global variables */
+int plot_mode = 0;
+
+/* statistics */
+uint32_t plot_samples = 0;
+uint32_t plot_ticks = 0;
+uint32_t plot_redraws = 0;
+uint32_t plot_kept = 0;
+
+/* the function */
+static char function[PLOT_TEXT] = PLOT_FUNCTION;
+static int length = sizeof(PLOT_FUNCTION) - 1;
+
+/* the view: column c is at x = (first + c) * step */
+static long first = -FB_WIDTH / 2;
+static float step = PLOT_STEP;
+
+/* the samples and the y range they are drawn in */
+static uint8_t state[PLOT_SAMPLES];
+static float value[PLOT_SAMPLES];
+static float y_min, y_max;
+static int have_range = 0;
+
+static int scroll = 0; // columns to move the framebuffer left by
+static int redraw = 1; // the framebuffer doesn't show the graph
+
+/* a function from the host, waiting for PendSV (see plot_request()) */
+static char request[PLOT_TEXT];
+static int request_length;
+static volatile uint8_t requested = 0;
+
+/*
+ * Forget the samples, and the range with them
+ */
+static void forget(void) {
+   memset(state, PLOT_EMPTY, sizeof(state));
+   have_range = 0;
+   scroll = 0;
+   redraw = 1;
+}
+
+/*
+ * Widen the y range to take in y if it's outside; returns 1 if the
+ * range changed, so the graph has to be drawn again
+ */
+static int take_in(float y) {
+   float span = y_max - y_min;
+   if (!have_range) {
+      y_min = y - 1;
+      y_max = y + 1;
+      have_range = 1;
+      return 1;
+   }
+   if (y < y_min) {
+      y_min = y - span / PLOT_MARGIN;
+      return 1;
+   }
+   if (y > y_max) {
+      y_max = y + span / PLOT_MARGIN;
+      return 1;
+   }
+   return 0;
+}
+
+/*
+ * The row of a y inside the range: y_max at the top, y_min at the
+ * bottom
+ */
+static int row_of(float y) {
+   return (int)((y_max - y) * (FB_HEIGHT - 1) / (y_max - y_min) + 0.5f);
+}
+
+/*
+ * Evaluate f at column c; returns 1 if the range grew
+ */
+static int sample(int c) {
+   int status;
+   CALC_TYPE x = num_from_double((double)((first + c) * step));
+   CALC_TYPE y = calc_eval_x(function, length, x, &status);
+   float v = (float)num_to_double(y);
+
+   ++plot_samples;
+   // an error or a value too big to scale leaves a gap in the graph
+   if (status != CALC_OK || !(v > -PLOT_LIMIT && v < PLOT_LIMIT)) {
+      state[c + 1] = PLOT_GAP;
+      return 0;
+   }
+   state[c + 1] = PLOT_VALUE;
+   value[c + 1] = v;
+   return take_in(v);
+}
+
+/*
+ * Draw what column c adds to the graph: the axes in it, and the lines
+ * to the samples on either side that are there already. The lines
+ * always go left to right, so a line comes out the same whichever of
+ * its ends was drawn last.
+ */
+static void draw_column(int c) {
+   int k = c + 1;
+   int row;
+
+   if (state[k] == PLOT_EMPTY) {
+      return;
+   }
+   if (y_min <= 0 && y_max >= 0) {
+      row = row_of(0);
+      fb_line(c, row, c, row); // the x axis
+   }
+   if (first + c == 0) {
+      fb_line(c, 0, c, FB_HEIGHT - 1); // the y axis
+   }
+   if (state[k] != PLOT_VALUE) {
+      return;
+   }
+   row = row_of(value[k]);
+   if (k > 0 && state[k - 1] == PLOT_VALUE) {
+      fb_line(c - 1, row_of(value[k - 1]), c, row);
+   }
+   else {
+      fb_line(c, row, c, row);
+   }
+   if (k < PLOT_SAMPLES - 1 && state[k + 1] == PLOT_VALUE) {
+      fb_line(c, row, c + 1, row_of(value[k + 1]));
+   }
+}
+
+/*
+ * The next column to evaluate, or FB_WIDTH + 1 if they all are; the
+ * columns on the screen come before the two off its edges
+ */
+static int next_column(void) {
+   int c; // used in for loop
+   for (c = 0; c < FB_WIDTH; ++c) {
+      if (state[c + 1] == PLOT_EMPTY) {
+         return c;
+      }
+   }
+   if (state[0] == PLOT_EMPTY) {
+      return -1;
+   }
+   if (state[PLOT_SAMPLES - 1] == PLOT_EMPTY) {
+      return FB_WIDTH;
+   }
+   return FB_WIDTH + 1;
+}
+
+/**
+ * Plot the function in text (length characters, see calc_eval_x())
+ * from the first view
+ * Returns CALC_OK, or CALC_SYNTAX (and keeps the function before) if
+ * it isn't one; an error of the arithmetic (1/x at 0) only leaves a gap
+ */
+int plot_function(const char * text, int count) {
+   int status;
+   if (count >= PLOT_TEXT) {
+      return CALC_SYNTAX;
+   }
+   calc_eval_x(text, count, num_from_int(0), &status);
+   if (status == CALC_SYNTAX) {
+      return status;
+   }
+   memcpy(function, text, count);
+   function[count] = '\0';
+   length = count;
+   plot_reset();
+   return CALC_OK;
+}
+
+/**
+ * Go back to the first view: x = 0 in the middle column, PLOT_STEP
+ * from one column to the next
+ */
+void plot_reset(void) {
+   first = -FB_WIDTH / 2;
+   step = PLOT_STEP;
+   forget();
+}
+
+/**
+ * Move the view right by columns (left if negative); the samples still
+ * in view are kept, and the framebuffer moves with them next frame
+ */
+void plot_pan(int columns) {
+   int kept = PLOT_SAMPLES - (columns < 0 ? -columns : columns);
+   int edge; // the index of the sample that was off the edge
+
+   first += columns;
+   if (kept <= 0) {
+      forget();
+      return;
+   }
+   if (columns > 0) {
+      memmove(state, &state[columns], kept);
+      memmove(value, &value[columns], kept * sizeof(value[0]));
+      memset(&state[kept], PLOT_EMPTY, columns);
+   }
+   else if (columns < 0) {
+      memmove(&state[-columns], state, kept);
+      memmove(&value[-columns], value, kept * sizeof(value[0]));
+      memset(state, PLOT_EMPTY, -columns);
+   }
+   // the sample just off the edge comes into view; the part of its
+   // line on the screen was never drawn (a gap is evaluated again, for
+   // the axis)
+   edge = columns > 0 ? FB_WIDTH - columns + 1 : -columns;
+   if (columns != 0 && edge >= 0 && edge < PLOT_SAMPLES) {
+      if (state[edge] == PLOT_VALUE) {
+         state[edge] = PLOT_UNDRAWN;
+      }
+      else if (state[edge] == PLOT_GAP) {
+         state[edge] = PLOT_EMPTY;
+      }
+   }
+   scroll += columns;
+   plot_kept += kept;
+}
+
+/**
+ * Zoom in (twice the columns per unit of x) if in > 0, else out,
+ * keeping the middle column where it is; every column is evaluated
+ * again and the range starts over
+ */
+void plot_zoom(int in) {
+   long middle = first + FB_WIDTH / 2;
+   if (in > 0 && step > PLOT_STEP / 1024) {
+      step /= 2;
+      first = 2 * middle - FB_WIDTH / 2;
+   }
+   else if (in <= 0 && step < PLOT_STEP * 1024) {
+      step *= 2;
+      first = (middle >= 0 ? middle / 2 : -((1 - middle) / 2))
+              - FB_WIDTH / 2;
+   }
+   forget();
+}
+
+/**
+ * Handle one key of the graph mode (see plot.h)
+ * Returns 1 if the key did something, else 0
+ */
+int plot_key(uint8_t key) {
+   switch (key) {
+      case KEY_ADD:      plot_pan(-PLOT_PAN); return 1;
+      case KEY_SUBTRACT: plot_pan(PLOT_PAN);  return 1;
+      case KEY_MULTIPLY: plot_zoom(1);        return 1;
+      case KEY_DIVIDE:   plot_zoom(-1);       return 1;
+      case KEY_EQUALS:   plot_reset();        return 1;
+      default:           return 0;
+   }
+}
+
+/**
+ * Bring the framebuffer up to date with the graph: apply a pan, then
+ * evaluate and draw the next PLOT_BATCH columns, each as soon as it's
+ * evaluated; draw it all again if the range grew
+ * Returns 1 if columns are left for the next frame, else 0
+ */
+int plot_render(void) {
+   uint32_t start = timebase_now();
+   int batch, c;
+
+   if (redraw) {
+      scroll = 0; // drawn from the samples anyway
+   }
+   else if (scroll) {
+      fb_scroll(-scroll);
+      scroll = 0;
+   }
+   for (c = -1; c <= FB_WIDTH; ++c) {
+      if (state[c + 1] == PLOT_UNDRAWN) {
+         state[c + 1] = PLOT_VALUE;
+         if (!redraw) {
+            draw_column(c);
+         }
+      }
+   }
+   for (batch = 0; batch < PLOT_BATCH; ++batch) {
+      c = next_column();
+      if (c > FB_WIDTH) {
+         break;
+      }
+      if (sample(c)) {
+         redraw = 1;
+      }
+      else if (!redraw) {
+         draw_column(c);
+      }
+   }
+   if (redraw) {
+      fb_clear();
+      for (c = -1; c <= FB_WIDTH; ++c) {
+         draw_column(c);
+      }
+      redraw = 0;
+      ++plot_redraws;
+   }
+   plot_ticks += timebase_now() - start;
+   return next_column() <= FB_WIDTH;
+}
+
+/**
+ * The framebuffer shows something else: draw the whole graph from the
+ * samples next time
+ */
+void plot_invalidate(void) {
+   redraw = 1;
+}
+
+/**
+ * Take a function from the host, for plot_take_request() in PendSV
+ * Returns 1 if it was taken, 0 if the one before is still waiting
+ * (or it's too long)
+ */
+int plot_request(const uint8_t * text, int count) {
+   if (requested || count >= PLOT_TEXT) {
+      return 0;
+   }
+   memcpy(request, text, count);
+   request_length = count;
+   requested = 1;
+   return 1;
+}
+
+/**
+ * Whether a function from the host is waiting
+ */
+int plot_requested(void) {
+   return requested;
+}
+
+/**
+ * Plot the function the host sent and switch to the graph mode
+ * Returns the status of plot_function()
+ */
+int plot_take_request(void) {
+   int status = plot_function(request, request_length);
+   requested = 0;
+   if (status == CALC_OK) {
+      plot_mode = 1;
+      plot_invalidate();
+   }
+   return status;
+}
@@ -0,0 +1,65 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: plot.h
+ * Description:
+ *      The graph mode: y = f(x) across the 84 columns of the GLCD,
+ *      where f is an expression of calc_eval_x(), e.g. "x*x/4-2"
+ *      (left to right, through calc_op() like everything else).
+ *      Column c shows x = (first + c) * step; the y range grows by
+ *      itself to take in every sample (autoscale), and neighbouring
+ *      samples are joined by Bresenham lines (fb_line()).
+ *      Each frame evaluates the next PLOT_BATCH columns and draws them
+ *      as it goes, so the first part of the graph is on the display
+ *      one frame after the function is set; plot_render() says when
+ *      there is more to do. The samples are kept: a pan moves the
+ *      framebuffer sideways (fb_scroll()) and evaluates only the
+ *      columns it uncovered, and a sample outside the y range draws
+ *      the graph again from the kept samples, not from f.
+ *      Keys in the graph mode:
+ *              A, B    pan left, right by PLOT_PAN columns
+ *              C, D    zoom in, out around the middle column
+ *              #       back to the first view
+ *      The host sets the function with LINK_PLOT (see link.h).
+ *      NOTE:
+ *              The graph is only drawn in plot_render(), between
+ *              GLCD_begin() and GLCD_present(); the keys and
+ *              plot_take_request() run in PendSV too. plot_request()
+ *              is the only function for the main loop.
+ */
+#ifndef PLOT_H
+#define PLOT_H
+
+#include <stdint.h>
+#include "calc.h"
+#include "fb.h"
+
+#define PLOT_TEXT  33    /* characters of f, with the '\0' (a LINK_PLOT
+                            payload is at most LINK_MAX_PAYLOAD) */
+#define PLOT_BATCH 12    /* columns evaluated and drawn per frame */
+#define PLOT_PAN   8     /* columns a pan key moves the view */
+#define PLOT_STEP  0.1f  /* x from one column to the next at first */
+#define PLOT_MARGIN 4    /* the y range grows by 1/PLOT_MARGIN more */
+#define PLOT_FUNCTION "x*x/4-2" /* until the host sends one */
+
+/* state */
+extern int plot_mode; // 1 while the graph mode is on
+
+/* statistics */
+extern uint32_t plot_samples; // f(x) evaluated
+extern uint32_t plot_ticks;   // timebase ticks evaluating and drawing them
+extern uint32_t plot_redraws; // graphs drawn again after the range grew
+extern uint32_t plot_kept;    // columns a pan kept rather than evaluated
+
+/* prototypes */
+int plot_function(const char *, int);
+void plot_reset(void);
+void plot_pan(int);
+void plot_zoom(int);
+int plot_key(uint8_t);
+int plot_render(void);
+void plot_invalidate(void);
+int plot_request(const uint8_t *, int);
+int plot_requested(void);
+int plot_take_request(void);
+
+#endif /* PLOT_H */
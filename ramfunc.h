@@ -0,0 +1,26 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: ramfunc.h
+ * Description:
+ *      RAMFUNC tags a hot-path function so the TI linker places it in
+ *      the .TI.ramfunc section. msp432p401r.cmd loads that section from
+ *      MAIN flash and the boot routine copies it to SRAM_CODE (through
+ *      the BINIT copy table) before main() runs, so the tagged function
+ *      executes without flash wait states.
+ *      NOTE:
+ *              Build with RAMFUNC_DISABLE defined to leave every function
+ *              in flash, e.g. to compare the two placements with
+ *              bench_ramfunc() in main.c.
+ *              Host builds (anything that isn't the TI compiler) ignore
+ *              the tag.
+ */
+#ifndef RAMFUNC_H
+#define RAMFUNC_H
+
+#if defined(__TI_COMPILER_VERSION__) && !defined(RAMFUNC_DISABLE)
+#define RAMFUNC __attribute__((ramfunc))
+#else
+#define RAMFUNC
+#endif
+
+#endif /* RAMFUNC_H */
@@ -0,0 +1,109 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: render.c
+ * Description:
+ *      The frame slots of the display (see render.h). SysTick ticks at
+ *      the frame rate; a slot left open while nothing changed stays
+ *      open, so the first key after a pause is drawn right away and
+ *      only bursts are held to the frame rate.
+ */
+#include "msp.h"
+#include "render.h"
+
+volatile uint32_t render_updates = 0;
+volatile uint32_t render_frames = 0;
+volatile uint32_t render_skipped = 0;
+volatile uint32_t render_continued = 0;
+
+static volatile uint8_t dirty = 0;     // the display is behind the state
+static volatile uint8_t slot_open = 1; // a redraw may happen now
+static volatile uint8_t continued = 0; // dirty only to carry on a drawing
+static uint32_t frame_hz;              // of render_init()
+
+/**
+ * Tick SysTick at hz frames per second, at the given priority (it
+ * must be above PendSV's so that slots open during a redraw)
+ */
+void render_init(uint32_t hz, uint32_t priority) {
+   frame_hz = hz;
+   SysTick->CTRL = 0;                              /* stop while configuring */
+   SysTick->LOAD = SystemCoreClock / hz - 1;       /* 24 bits: hz >= 3 at 48 MHz */
+   SysTick->VAL = 0;
+   NVIC_SetPriority(SysTick_IRQn, priority);
+   SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk      /* MCLK */
+                 | SysTick_CTRL_TICKINT_Msk        /* interrupt on zero */
+                 | SysTick_CTRL_ENABLE_Msk;
+}
+
+/**
+ * MCLK now runs at hz (see clock.h): keep the frame rate
+ * The tick under way starts over, so a slot opens up to one frame
+ * late once.
+ */
+void render_retune(uint32_t hz) {
+   SysTick->LOAD = hz / frame_hz - 1;
+   SysTick->VAL = 0;
+}
+
+/**
+ * Whether a redraw is still to come
+ */
+int render_pending(void) {
+   return dirty;
+}
+
+/**
+ * The calculator state changed; redraw at the next open slot
+ * Call it from PendSV.
+ */
+void render_invalidate(void) {
+   ++render_updates;
+   if (dirty && !continued) {
+      ++render_skipped; // the pending redraw will show this change too
+   }
+   continued = 0;
+   dirty = 1;
+}
+
+/**
+ * A drawing isn't finished; go on with it at the next open slot
+ * Unlike render_invalidate(), this is no state change, and the redraw
+ * counts in render_continued instead of render_frames (unless a change
+ * comes before it). Call it from PendSV.
+ */
+void render_continue(void) {
+   if (!dirty) {
+      continued = 1;
+      dirty = 1;
+   }
+}
+
+/**
+ * Whether PendSV should redraw now: the display is dirty and a slot
+ * is open. Returns 1 and closes the slot if so, else 0.
+ */
+int render_take_frame(void) {
+   if (!dirty || !slot_open) {
+      return 0;
+   }
+   slot_open = 0;
+   dirty = 0;
+   if (continued) {
+      ++render_continued;
+      continued = 0;
+   }
+   else {
+      ++render_frames;
+   }
+   return 1;
+}
+
+/***
+* SysTick handler: open the next frame slot
+***/
+void SysTick_Handler(void) {
+   slot_open = 1;
+   if (dirty) {
+      SCB->ICSR = SCB_ICSR_PENDSVSET_Msk; /* the redraw is due */
+   }
+}
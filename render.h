@@ -0,0 +1,37 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: render.h
+ * Description:
+ *      Frame-rate limit for the display. Changes to the calculator
+ *      state only mark the display dirty (render_invalidate()); SysTick
+ *      opens a frame slot RENDER_HZ times a second, and PendSV redraws
+ *      when a slot is open and the display is dirty. Any number of
+ *      changes between two slots cost one redraw. A drawing that takes
+ *      several frames (the graph) asks for the next with
+ *      render_continue(), which the statistics count apart.
+ *      NOTE:
+ *              Build with RENDER_HZ defined (e.g. 30) to change the rate.
+ */
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdint.h>
+
+#ifndef RENDER_HZ
+#define RENDER_HZ 60 /* frames per second at most */
+#endif
+
+/* statistics */
+extern volatile uint32_t render_updates; // state changes
+extern volatile uint32_t render_frames;  // redraws
+extern volatile uint32_t render_skipped; // changes merged into a later redraw
+extern volatile uint32_t render_continued; // redraws that only carry on a drawing
+
+void render_init(uint32_t, uint32_t);
+void render_invalidate(void);
+void render_continue(void);
+int render_take_frame(void);
+void render_retune(uint32_t);
+int render_pending(void);
+
+#endif /* RENDER_H */
@@ -0,0 +1,65 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: ring.h
+ * Description:
+ *      A byte ring buffer shared by one producer and one consumer,
+ *      e.g. an ISR and the main loop. The head is only written by the
+ *      producer and the tail only by the consumer, so neither side has
+ *      to disable interrupts. RING_SIZE must be a power of 2; one slot
+ *      is kept empty to tell a full ring from an empty one.
+ */
+#ifndef RING_H
+#define RING_H
+
+#include <stdint.h>
+
+#define RING_SIZE 256 /* bytes per ring (power of 2) */
+#define RING_MASK (RING_SIZE - 1)
+
+typedef struct {
+   volatile uint16_t head; // next slot to write (producer)
+   volatile uint16_t tail; // next slot to read (consumer)
+   uint8_t data[RING_SIZE];
+} ring_t;
+
+/**
+ * Number of bytes waiting to be read
+ */
+static inline uint16_t ring_count(const ring_t * ring) {
+   return (ring->head - ring->tail) & RING_MASK;
+}
+
+/**
+ * Number of bytes that can still be written
+ */
+static inline uint16_t ring_space(const ring_t * ring) {
+   return RING_MASK - ring_count(ring);
+}
+
+/**
+ * Write a byte; returns 0 (and drops the byte) if the ring is full
+ */
+static inline int ring_put(ring_t * ring, uint8_t byte) {
+   uint16_t head = ring->head;
+   if (((head + 1) & RING_MASK) == ring->tail) {
+      return 0; // full
+   }
+   ring->data[head] = byte;
+   ring->head = (head + 1) & RING_MASK; // publish after the data
+   return 1;
+}
+
+/**
+ * Read a byte; returns 0 if the ring is empty
+ */
+static inline int ring_get(ring_t * ring, uint8_t * byte) {
+   uint16_t tail = ring->tail;
+   if (tail == ring->head) {
+      return 0; // empty
+   }
+   *byte = ring->data[tail];
+   ring->tail = (tail + 1) & RING_MASK; // free the slot after the read
+   return 1;
+}
+
+#endif /* RING_H */
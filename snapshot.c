@@ -0,0 +1,329 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: snapshot.c
+ * Description:
+ *      The calculator state in flash (see snapshot.h).
+ *      A record, little-endian, zero-filled up to the CRC:
+ *              0  'S', SNAPSHOT_VERSION, CALC_BACKEND, body length
+ *              4  u32 sequence number
+ *              8  lhs, rhs (sizeof(CALC_TYPE) each, as in memory)
+ *                 u8 operation, u8 state, u32 x2 fractional_pow10,
+ *                 u32 status
+ *              62 u16 link_crc16() of bytes 0-61
+ */
+#include <string.h>
+#include "msp.h"
+#include "clock.h"
+#include "cycles.h"
+#include "link.h"
+#include "timebase.h"
+#include "snapshot.h"
+
+#define MAGIC  'S'
+#define HEADER 8
+#define BODY   (2 * sizeof(CALC_TYPE) + 14)
+#define CRC_AT (SNAPSHOT_SLOT - 2)
+
+/* a compile error here means the record outgrew its slot */
+typedef char snapshot_fits[HEADER + BODY <= CRC_AT ? 1 : -1];
+
+#define BANK1 0x00020000 /* sectors of bank 1 are protected from here */
+
+/* statistics */
+uint32_t snapshot_writes = 0;
+uint32_t snapshot_erases = 0;
+uint32_t snapshot_failures = 0;
+uint32_t snapshot_seq = 0;
+uint32_t snapshot_restore_cycles = 0;
+
+static volatile uint8_t dirty = 0;  // a change not saved yet
+static volatile uint32_t changed_at; // timebase_now() of the last change
+static uint32_t newest = 0; // address of the newest record, 0 if none
+static uint32_t next = 0;   // the next erased slot, 0 to start a sector
+
+/**
+ * Fill a slot's worth of record with a state and a sequence number
+ * Returns the bytes (SNAPSHOT_SLOT)
+ */
+int snapshot_encode(const calc_state_t * s, uint32_t seq, uint8_t * record) {
+   uint8_t * p = &record[HEADER];
+   uint16_t crc;
+
+   memset(record, 0, SNAPSHOT_SLOT);
+   record[0] = MAGIC;
+   record[1] = SNAPSHOT_VERSION;
+   record[2] = CALC_BACKEND;
+   record[3] = BODY;
+   link_put_u32(&record[4], seq);
+   memcpy(p, &s->lhs, sizeof(CALC_TYPE));
+   p += sizeof(CALC_TYPE);
+   memcpy(p, &s->rhs, sizeof(CALC_TYPE));
+   p += sizeof(CALC_TYPE);
+   *p++ = (uint8_t)s->operation;
+   *p++ = s->state;
+   link_put_u32(p, (uint32_t)s->fractional_pow10);
+   link_put_u32(p + 4, (uint32_t)((uint64_t)s->fractional_pow10 >> 32));
+   link_put_u32(p + 8, (uint32_t)s->status);
+   crc = link_crc16(record, CRC_AT);
+   record[CRC_AT] = crc & 0xFF;
+   record[CRC_AT + 1] = crc >> 8;
+   return SNAPSHOT_SLOT;
+}
+
+/*
+ * Whether a slot starts like a record of this build (cheap: no CRC)
+ */
+static int header_ok(const uint8_t * record) {
+   return record[0] == MAGIC && record[1] == SNAPSHOT_VERSION
+          && record[2] == CALC_BACKEND && record[3] == BODY;
+}
+
+/**
+ * Read a state and its sequence number back from a record
+ * Returns 1, or 0 (leaving them alone) if the record is damaged or of
+ * another version or backend
+ */
+int snapshot_decode(const uint8_t * record, calc_state_t * s, uint32_t * seq) {
+   const uint8_t * p = &record[HEADER];
+   uint16_t crc = record[CRC_AT] | (uint16_t)record[CRC_AT + 1] << 8;
+
+   if (!header_ok(record) || link_crc16(record, CRC_AT) != crc
+       || p[2 * sizeof(CALC_TYPE) + 1] >= CALC_STATES) {
+      return 0;
+   }
+   *seq = link_get_u32(&record[4]);
+   memcpy(&s->lhs, p, sizeof(CALC_TYPE));
+   p += sizeof(CALC_TYPE);
+   memcpy(&s->rhs, p, sizeof(CALC_TYPE));
+   p += sizeof(CALC_TYPE);
+   s->operation = (char)*p++;
+   s->state = *p++;
+   s->fractional_pow10 = (long long)(link_get_u32(p)
+                                     | (uint64_t)link_get_u32(p + 4) << 32);
+   s->status = (int)link_get_u32(p + 8);
+   return 1;
+}
+
+/*
+ * Whether a slot is erased (all ones)
+ */
+static int erased(uint32_t address) {
+   const uint32_t * word = (const uint32_t *)address;
+   int k; // used in for loop
+   for (k = 0; k < SNAPSHOT_SLOT / 4; ++k) {
+      if (word[k] != 0xFFFFFFFF) {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+/*
+ * Bank 1's read buffers off (so a read sees what was just written) or
+ * back to what they were
+ */
+static uint32_t buffers_off(void) {
+   uint32_t rdctl = FLCTL->BANK1_RDCTL;
+   FLCTL->BANK1_RDCTL = rdctl
+                      & ~(FLCTL_BANK1_RDCTL_BUFD | FLCTL_BANK1_RDCTL_BUFI);
+   return rdctl;
+}
+
+/*
+ * Erase one sector and check it
+ * Interrupts stay on; the caller holds the clock (see save()).
+ */
+static int erase(uint32_t sector) {
+   uint32_t bit = 1UL << ((sector - BANK1) / SNAPSHOT_SECTOR);
+   uint32_t rdctl, at;
+   int ok = 1;
+
+   FLCTL->BANK1_MAIN_WEPROT &= ~bit;           /* unprotect the sector */
+   FLCTL->CLRIFG = FLCTL_CLRIFG_ERASE;
+   FLCTL->ERASE_CTLSTAT = FLCTL_ERASE_CTLSTAT_CLR_STAT;
+   FLCTL->ERASE_SECTADDR = sector;
+   FLCTL->ERASE_CTLSTAT = FLCTL_ERASE_CTLSTAT_START; /* main memory, sector */
+   while (!(FLCTL->IFG & FLCTL_IFG_ERASE));
+   FLCTL->CLRIFG = FLCTL_CLRIFG_ERASE;
+   FLCTL->ERASE_CTLSTAT = FLCTL_ERASE_CTLSTAT_CLR_STAT;
+   FLCTL->BANK1_MAIN_WEPROT |= bit;            /* protect it again */
+   ++snapshot_erases;
+
+   rdctl = buffers_off();
+   for (at = sector; at < sector + SNAPSHOT_SECTOR && ok; at += SNAPSHOT_SLOT) {
+      ok = erased(at);
+   }
+   FLCTL->BANK1_RDCTL = rdctl;
+   return ok;
+}
+
+/*
+ * Program a record into an erased slot, a word at a time, and check it
+ * Interrupts stay on; the caller holds the clock (see save()).
+ */
+static int program(uint32_t address, const uint8_t * record) {
+   uint32_t bit = 1UL << ((address - BANK1) / SNAPSHOT_SECTOR);
+   uint32_t rdctl = buffers_off();
+   int k, ok; // k used in for loop
+
+   FLCTL->BANK1_MAIN_WEPROT &= ~bit;           /* unprotect the sector */
+   FLCTL->PRG_CTLSTAT = FLCTL_PRG_CTLSTAT_ENABLE; /* immediate mode */
+   for (k = 0; k < SNAPSHOT_SLOT; k += 4) {
+      uint32_t word;
+      memcpy(&word, &record[k], 4);
+      FLCTL->CLRIFG = FLCTL_CLRIFG_PRG;
+      *(volatile uint32_t *)(address + k) = word;
+      while (!(FLCTL->IFG & FLCTL_IFG_PRG));
+   }
+   FLCTL->CLRIFG = FLCTL_CLRIFG_PRG;
+   FLCTL->PRG_CTLSTAT = 0;
+   FLCTL->BANK1_MAIN_WEPROT |= bit;            /* protect it again */
+   ok = memcmp((const void *)address, record, SNAPSHOT_SLOT) == 0;
+
+   FLCTL->BANK1_RDCTL = rdctl;
+   return ok;
+}
+
+/*
+ * Append a record: to the next erased slot of the sector in use, or
+ * to the other sector, erased, when that one is full
+ * The clock is held meanwhile, so that the governor doesn't turn the
+ * read buffers back on halfway; interrupts stay on, and the UART
+ * keeps up with the host.
+ * Returns 1 if it was written and reads back right
+ */
+static int save(const uint8_t * record) {
+   uint32_t at;
+   int ok = 1;
+
+   clock_hold();
+   if (next == 0) {
+      // start the sector the newest record isn't in
+      uint32_t sector = newest >= SNAPSHOT_BASE + SNAPSHOT_SECTOR
+                      ? SNAPSHOT_BASE : SNAPSHOT_BASE + SNAPSHOT_SECTOR;
+      ok = erase(sector);
+      if (ok) {
+         next = sector;
+      }
+   }
+   if (ok) {
+      at = next;
+      next = (at + SNAPSHOT_SLOT) % SNAPSHOT_SECTOR ? at + SNAPSHOT_SLOT : 0;
+      ok = program(at, record);
+   }
+   clock_release();
+   if (!ok) {
+      return 0; // a spent slot; the newest record stays what it was
+   }
+   newest = at;
+   snapshot_seq = link_get_u32(&record[4]);
+   ++snapshot_writes;
+   return 1;
+}
+
+/*
+ * The newest good record of a sector, the last that checks out since
+ * they are appended in order; its address, or 0 if there is none
+ */
+static uint32_t newest_in(uint32_t sector, calc_state_t * s, uint32_t * seq) {
+   uint32_t at = sector + SNAPSHOT_SECTOR;
+   while (at > sector) {
+      at -= SNAPSHOT_SLOT;
+      if (header_ok((const uint8_t *)at)
+          && snapshot_decode((const uint8_t *)at, s, seq)) {
+         return at;
+      }
+   }
+   return 0;
+}
+
+/**
+ * Put the newest saved state into s, and find where the next save goes
+ * Call it at boot, before the first display_current_state().
+ * Returns 1 if there was one, 0 if s was left alone
+ */
+int snapshot_restore(calc_state_t * s) {
+   calc_state_t found[2];
+   uint32_t seq[2], at[2];
+   uint32_t start;
+   int k, pick; // k used in for loop
+
+   cycles_init();
+   start = cycles_now();
+   for (k = 0; k < 2; ++k) {
+      at[k] = newest_in(SNAPSHOT_BASE + k * SNAPSHOT_SECTOR, &found[k], &seq[k]);
+   }
+   if (at[0] && at[1]) {
+      pick = (int32_t)(seq[1] - seq[0]) > 0; // sequence numbers wrap
+   }
+   else {
+      pick = at[1] != 0;
+   }
+   newest = at[pick];
+   next = 0;
+   if (newest) {
+      *s = found[pick];
+      snapshot_seq = seq[pick];
+      // skip whatever a reset left half-written after it
+      next = newest + SNAPSHOT_SLOT;
+      while (next % SNAPSHOT_SECTOR && !erased(next)) {
+         next += SNAPSHOT_SLOT;
+      }
+      if (next % SNAPSHOT_SECTOR == 0) {
+         next = 0;
+      }
+   }
+   snapshot_restore_cycles = cycles_now() - start;
+   return newest != 0;
+}
+
+/**
+ * The state changed; save it once things have been quiet a while
+ * Called from PendSV.
+ */
+void snapshot_changed(void) {
+   changed_at = timebase_now();
+   dirty = 1;
+}
+
+/**
+ * Save the state if it changed and nothing has changed it for
+ * SNAPSHOT_DELAY_MS, unless it is what the newest record holds
+ * A failed save is tried again after another delay.
+ * Call it from the main loop.
+ */
+void snapshot_service(const calc_state_t * live) {
+   // static: PendSV may come in on top of this frame
+   static uint8_t record[SNAPSHOT_SLOT];
+   static calc_state_t s;
+   unsigned int state;
+
+   if (!dirty || timebase_now() - changed_at
+                 < SNAPSHOT_DELAY_MS * (TIMEBASE_HZ / 1000)) {
+      return;
+   }
+   state = _disable_interrupts(); // PendSV changes it
+   s = *live;
+   dirty = 0;
+   _restore_interrupts(state);
+
+   snapshot_encode(&s, snapshot_seq + 1, record);
+   if (newest && memcmp(&record[HEADER], (const uint8_t *)newest + HEADER,
+                        BODY) == 0) {
+      return;
+   }
+   if (!save(record)) {
+      ++snapshot_failures;
+      snapshot_changed();
+   }
+}
+
+/**
+ * Erase both sectors: the next boot starts from the initial state
+ */
+void snapshot_discard(void) {
+   erase(SNAPSHOT_BASE);
+   erase(SNAPSHOT_BASE + SNAPSHOT_SECTOR);
+   newest = 0;
+   next = 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: snapshot.h
+ * Description:
+ *      The calculator state kept in flash across resets and power
+ *      loss. A record holds lhs, rhs, the operation and the focus
+ *      state, with a version, the numeric backend (CALC_BACKEND) the
+ *      numbers are in, a sequence number and link_crc16() over it all.
+ *      Records are appended to two 4 KB sectors at the end of bank 1
+ *      (left out of MAIN in msp432p401r.cmd), one sector in use at a
+ *      time; only when it is full is the other one erased and started,
+ *      so each erase takes SNAPSHOT_SECTOR / SNAPSHOT_SLOT saves and a
+ *      save interrupted by a reset leaves the one before it intact.
+ *      snapshot_restore() picks the newest record whose CRC, version
+ *      and backend check out. A change (snapshot_changed(), from
+ *      process_key()) is only written once no other has come for
+ *      SNAPSHOT_DELAY_MS, and only if the record differs from the last
+ *      one written, so a burst of keys costs one save.
+ *      NOTE:
+ *              Build with SNAPSHOT_DELAY_MS defined to change the delay.
+ *              The sectors are in bank 1, so the code in bank 0 (and
+ *              the interrupts) keep running while one is programmed.
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include "calc.h"
+
+#define SNAPSHOT_BASE    0x0003E000 /* two sectors up to the end of flash */
+#define SNAPSHOT_SECTOR  4096
+#define SNAPSHOT_SLOT    64  /* bytes a record takes */
+#define SNAPSHOT_VERSION 1   /* change it when the record changes */
+
+#ifndef SNAPSHOT_DELAY_MS
+#define SNAPSHOT_DELAY_MS 2000 /* quiet time before a change is saved */
+#endif
+
+/* statistics */
+extern uint32_t snapshot_writes;         // records written
+extern uint32_t snapshot_erases;         // sectors erased
+extern uint32_t snapshot_failures;       // writes that didn't verify
+extern uint32_t snapshot_seq;            // of the newest record
+extern uint32_t snapshot_restore_cycles; // snapshot_restore() took
+
+/* prototypes */
+int snapshot_encode(const calc_state_t *, uint32_t, uint8_t *);
+int snapshot_decode(const uint8_t *, calc_state_t *, uint32_t *);
+int snapshot_restore(calc_state_t *);
+void snapshot_changed(void);
+void snapshot_service(const calc_state_t *);
+void snapshot_discard(void);
+
+#endif /* SNAPSHOT_H */
@@ -0,0 +1,74 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: stackmon.c
+ * Description:
+ *      Stack painting and high-water mark. The stack grows down from
+ *      __STACK_END to __stack (both set by the linker, see the .stack
+ *      section in msp432p401r.cmd), so the painted words left at the
+ *      bottom are the stack that was never used.
+ */
+#include <stdint.h>
+#include "stackmon.h"
+
+#ifdef __TI_COMPILER_VERSION__
+extern uint32_t __stack;     /* lowest word of the stack */
+extern uint32_t __STACK_END; /* one past the highest word */
+#define STACK_BOTTOM (&__stack)
+#define STACK_TOP    (&__STACK_END)
+#else
+/* no linker-placed stack in the host tools */
+#define STACK_BOTTOM ((uint32_t *)0)
+#define STACK_TOP    ((uint32_t *)0)
+#endif
+
+stack_isr_t stack_isr[STACK_ISR_COUNT];
+volatile uint8_t stack_nesting = 0;
+volatile uint8_t stack_nesting_max = 0;
+
+/**
+ * Fill the stack below the caller with STACK_PAINT
+ * Call it first thing in main(), before any interrupt is enabled;
+ * only the few words the startup code and this frame use stay unpainted.
+ */
+void stack_paint(void) {
+   volatile uint32_t here; // marks (about) the current stack pointer
+   uint32_t * word = STACK_BOTTOM;
+   uint32_t * limit = (uint32_t *)&here - STACK_PAINT_MARGIN;
+
+   if (STACK_BOTTOM == STACK_TOP) {
+      return; // nothing to paint on the host
+   }
+   while (word < limit) {
+      *word++ = STACK_PAINT;
+   }
+}
+
+/**
+ * The size of the stack in bytes
+ */
+uint16_t stack_size(void) {
+   return (uint16_t)((STACK_TOP - STACK_BOTTOM) * sizeof(uint32_t));
+}
+
+/**
+ * The most stack (bytes) used since stack_paint()
+ * Scans up from the bottom for the first word that was overwritten, so
+ * it costs a few cycles per unused word; don't call it from a handler.
+ */
+uint16_t stack_high_water(void) {
+   const uint32_t * word = STACK_BOTTOM;
+   while (word < STACK_TOP && *word == STACK_PAINT) {
+      ++word;
+   }
+   return (uint16_t)((STACK_TOP - word) * sizeof(uint32_t));
+}
+
+/**
+ * The stack in use (bytes) above the given local variable
+ */
+uint16_t stack_depth(const void * local) {
+   if (STACK_BOTTOM == STACK_TOP) {
+      return 0;
+   }
+   return (uint16_t)((const uint8_t *)STACK_TOP - (const uint8_t *)local);
+}
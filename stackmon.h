@@ -0,0 +1,69 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: stackmon.h
+ * Description:
+ *      Stack usage instrumentation. stack_paint() fills the unused
+ *      stack with a known pattern at reset, stack_high_water() finds
+ *      the deepest point the stack has reached since, and the
+ *      STACK_ISR_ENTER()/STACK_ISR_EXIT() pair records how deep the
+ *      stack already was when each interrupt handler was entered and
+ *      how many handlers were nested at once.
+ *      NOTE:
+ *              Define STACKMON_DISABLE to compile the ISR tracking out.
+ *              The stack bounds come from the TI linker; the host tools
+ *              build this file too but report an empty stack.
+ */
+#ifndef STACKMON_H
+#define STACKMON_H
+
+#include <stdint.h>
+
+#define STACK_PAINT 0xC5C5C5C5u /* fill pattern of the unused stack */
+#define STACK_PAINT_MARGIN 8    /* words below stack_paint()'s frame left alone */
+
+/* handlers tracked by STACK_ISR_ENTER() */
+#define STACK_ISR_PORT1 0
+#define STACK_ISR_PORT3 1
+#define STACK_ISR_UART  2
+#define STACK_ISR_RENDER 3 /* PendSV */
+#define STACK_ISR_COUNT 4
+
+/* what one handler has seen */
+typedef struct {
+   uint16_t entry_max; // deepest stack (bytes) at entry
+   uint32_t count;     // times entered
+} stack_isr_t;
+
+extern stack_isr_t stack_isr[STACK_ISR_COUNT];
+extern volatile uint8_t stack_nesting;     // handlers running right now
+extern volatile uint8_t stack_nesting_max; // most handlers running at once
+
+void stack_paint(void);
+uint16_t stack_size(void);
+uint16_t stack_high_water(void);
+uint16_t stack_depth(const void *);
+
+#ifdef STACKMON_DISABLE
+#define STACK_ISR_ENTER(isr)
+#define STACK_ISR_EXIT(isr)
+#else
+/*
+ * First statement of a handler: the address of a local stands in for
+ * the stack pointer right after the hardware pushed its frame
+ */
+#define STACK_ISR_ENTER(isr) do {                                  \
+      uint8_t stack_here_;                                         \
+      uint16_t stack_in_use_ = stack_depth(&stack_here_);          \
+      if (stack_in_use_ > stack_isr[isr].entry_max) {              \
+         stack_isr[isr].entry_max = stack_in_use_;                 \
+      }                                                            \
+      ++stack_isr[isr].count;                                      \
+      if (++stack_nesting > stack_nesting_max) {                   \
+         stack_nesting_max = stack_nesting;                        \
+      }                                                            \
+   } while (0)
+/* last statement of a handler */
+#define STACK_ISR_EXIT(isr) do { --stack_nesting; } while (0)
+#endif
+
+#endif /* STACKMON_H */
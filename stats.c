@@ -0,0 +1,287 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: stats.c
+ * Description:
+ *      The statistics mode and its accumulators (see stats.h).
+ */
+#include <math.h>
+#include <string.h>
+#include "stats.h"
+
+/* global variables */
+int stats_mode = 0;
+stats_t stats = { 0 };
+stats_pair_t stats_pairs = { 0 };
+
+/* the value being typed (stats_clear() empties it first) */
+static CALC_TYPE entry;
+static int entry_digits = 0;  // digits typed, 0 if it's empty
+static int entry_fraction = 0; // after the decimal point
+static int entry_negative = 0;
+static long long int entry_pow10 = 10;
+
+/* the x of a pair, waiting for its y */
+static double pair_x;
+static int have_x = 0;
+
+static int page = 0; // 0 the summary, 1 the regression
+
+/**
+ * Forget every value of a variable
+ */
+void stats_reset(stats_t * s) {
+   memset(s, 0, sizeof(*s));
+}
+
+/**
+ * Take one value into a variable's accumulators
+ */
+void stats_add(stats_t * s, double value) {
+   double delta = value - s->mean;
+   double sum = s->sum + value;
+
+   ++s->count;
+   // Welford: the mean moves by a share of the deviation, and m2 takes
+   // the product of the deviations from the old and the new mean
+   s->mean += delta / s->count;
+   s->m2 += delta * (value - s->mean);
+   // Neumaier: keep what the bigger of the two addends lost
+   if (fabs(s->sum) >= fabs(value)) {
+      s->carry += (s->sum - sum) + value;
+   }
+   else {
+      s->carry += (value - sum) + s->sum;
+   }
+   s->sum = sum;
+   if (s->count == 1 || value < s->min) {
+      s->min = value;
+   }
+   if (s->count == 1 || value > s->max) {
+      s->max = value;
+   }
+}
+
+/**
+ * The sum of the values, with what rounding took out put back
+ */
+double stats_sum(const stats_t * s) {
+   return s->sum + s->carry;
+}
+
+/**
+ * The mean of the values: the compensated sum over the count, closer
+ * than Welford's running mean, which is there for the variance
+ */
+double stats_mean(const stats_t * s) {
+   return s->count ? stats_sum(s) / s->count : 0;
+}
+
+/**
+ * The sample variance (divided by count - 1), 0 below two values
+ */
+double stats_variance(const stats_t * s) {
+   return s->count > 1 ? s->m2 / (s->count - 1) : 0;
+}
+
+/**
+ * The sample standard deviation, 0 below two values
+ */
+double stats_stddev(const stats_t * s) {
+   return sqrt(stats_variance(s));
+}
+
+/**
+ * Forget every pair
+ */
+void stats_pair_reset(stats_pair_t * p) {
+   memset(p, 0, sizeof(*p));
+}
+
+/**
+ * Take one (x, y) pair into the accumulators of the regression
+ */
+void stats_pair_add(stats_pair_t * p, double x, double y) {
+   double dx = x - p->mean_x;
+   double dy = y - p->mean_y;
+
+   ++p->count;
+   p->mean_x += dx / p->count;
+   p->mean_y += dy / p->count;
+   p->m2_x += dx * (x - p->mean_x);
+   p->m2_y += dy * (y - p->mean_y);
+   p->c_xy += dx * (y - p->mean_y);
+}
+
+/**
+ * The least-squares line y = slope * x + intercept through the pairs,
+ * and the correlation r (0 if every y is the same)
+ * Returns 1, or 0 if there is no line (fewer than two distinct x)
+ */
+int stats_fit(const stats_pair_t * p, double * slope, double * intercept,
+              double * r) {
+   if (p->count < 2 || p->m2_x <= 0) {
+      return 0;
+   }
+   *slope = p->c_xy / p->m2_x;
+   *intercept = p->mean_y - *slope * p->mean_x;
+   *r = p->m2_y > 0 ? p->c_xy / sqrt(p->m2_x * p->m2_y) : 0;
+   return 1;
+}
+
+/*
+ * Empty the value being typed
+ */
+static void clear_entry(void) {
+   entry = num_from_int(0);
+   entry_digits = 0;
+   entry_fraction = 0;
+   entry_negative = 0;
+   entry_pow10 = 10;
+}
+
+/**
+ * Forget every value and pair, and the value being typed
+ */
+void stats_clear(void) {
+   stats_reset(&stats);
+   stats_pair_reset(&stats_pairs);
+   have_x = 0;
+   clear_entry();
+}
+
+/**
+ * Handle one key of the statistics mode (see stats.h)
+ * Returns 1 if it entered a value, else 0
+ */
+int stats_key(uint8_t key) {
+   double value = num_to_double(entry);
+   if (entry_negative) {
+      value = -value;
+   }
+   switch (key) {
+      case KEY_EQUALS: /* enter the value */
+         if (entry_digits == 0) {
+            return 0;
+         }
+         stats_add(&stats, value);
+         if (have_x) {
+            stats_pair_add(&stats_pairs, pair_x, value);
+            have_x = 0;
+         }
+         clear_entry();
+         return 1;
+      case KEY_ADD: /* the value is the x of a pair */
+         if (entry_digits > 0) {
+            pair_x = value;
+            have_x = 1;
+            clear_entry();
+         }
+         break;
+      case KEY_SUBTRACT: /* change its sign */
+         entry_negative = !entry_negative;
+         break;
+      case KEY_MULTIPLY: /* the other page */
+         page = (page + 1) % STATS_PAGES;
+         break;
+      case KEY_DIVIDE: /* clear it, or everything */
+         if (entry_digits == 0 && !entry_negative && !have_x) {
+            stats_clear();
+         }
+         clear_entry();
+         have_x = 0;
+         break;
+      case KEY_DECIMAL:
+         entry_fraction = 1;
+         break;
+      default: /* a digit */
+         entry = calc_digit(entry, key, entry_fraction, &entry_pow10);
+         ++entry_digits;
+         break;
+   }
+   return 0;
+}
+
+/*
+ * Write "name value" into text, or "name -" if there is no value
+ * Returns its length.
+ */
+static int put_value(char * text, int size, const char * name, double value,
+                     int valid, int precision) {
+   int length = strlen(name);
+   memcpy(text, name, length);
+   text[length++] = ' ';
+   if (!valid) {
+      text[length++] = '-';
+      text[length] = '\0';
+      return length;
+   }
+   return length + calc_format(num_from_double(value), precision,
+                               &text[length], size - length);
+}
+
+/**
+ * Write line (0 to STATS_LINES - 1) of the page on the display into
+ * text (at least CALC_FORMAT_SIZE(precision) + 24 characters), with
+ * precision fractional digits: the summary or the regression, and
+ * the value being typed on the last line
+ * Returns its length.
+ */
+int stats_line(int line, char * text, int size, int precision) {
+   double slope = 0, intercept = 0, r = 0;
+   int fitted, length;
+
+   if (line == STATS_LINES - 1) {
+      length = 0;
+      if (have_x) {
+         length = put_value(text, size, "X", pair_x, 1, precision);
+         text[length++] = ' ';
+      }
+      memcpy(&text[length], have_x ? "Y " : "IN ", have_x ? 2 : 3);
+      length += have_x ? 2 : 3;
+      if (entry_negative) {
+         text[length++] = '-';
+      }
+      text[length] = '\0';
+      if (entry_digits > 0) {
+         length += calc_format(entry, precision, &text[length],
+                               size - length);
+      }
+      return length;
+   }
+   if (page == 0) {
+      switch (line) {
+         case 0:
+            length = put_value(text, size, "N", stats.count, 1, 0);
+            text[length++] = ' ';
+            return length + put_value(&text[length], size - length, "SUM",
+                                      stats_sum(&stats), stats.count > 0,
+                                      precision);
+         case 1:
+            return put_value(text, size, "MEAN", stats_mean(&stats), stats.count > 0,
+                             precision);
+         case 2:
+            return put_value(text, size, "SD", stats_stddev(&stats),
+                             stats.count > 1, precision);
+         case 3:
+            return put_value(text, size, "MIN", stats.min, stats.count > 0,
+                             precision);
+         default:
+            return put_value(text, size, "MAX", stats.max, stats.count > 0,
+                             precision);
+      }
+   }
+   fitted = stats_fit(&stats_pairs, &slope, &intercept, &r);
+   switch (line) {
+      case 0:
+         return put_value(text, size, "PAIRS", stats_pairs.count, 1, 0);
+      case 1:
+         return put_value(text, size, "SLOPE", slope, fitted, precision);
+      case 2:
+         return put_value(text, size, "ICPT", intercept, fitted, precision);
+      case 3:
+         return put_value(text, size, "R", r, fitted, precision);
+      default:
+         text[0] = '\0';
+         return 0;
+   }
+}
@@ -0,0 +1,81 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: stats.h
+ * Description:
+ *      The statistics mode: a series of values is entered one at a
+ *      time and the display keeps their count, sum, mean, standard
+ *      deviation, minimum and maximum up to date. Values may also be
+ *      entered as (x, y) pairs, which adds the least-squares line
+ *      y = slope * x + intercept and the correlation r.
+ *      Nothing is kept per value. The accumulators are a few numbers
+ *      whatever the count, each updated in one pass:
+ *        - the sum of squared deviations with Welford's update (no
+ *          sum of squares to cancel against the mean)
+ *        - the sum with Kahan-Babuska (Neumaier) compensation, and the
+ *          mean from it
+ *        - for pairs, the means, the sums of squared deviations and
+ *          the co-moment with the two-variable form of Welford's update
+ *      They are in double whatever the numeric backend, since a series
+ *      can be far longer than any one calculation.
+ *      Keys in the statistics mode:
+ *              0-9, *  type a value (* is the decimal point)
+ *              #       enter it
+ *              A       the value is x; the next # enters it with y
+ *              B       change the sign of the value
+ *              C       the summary or the regression on the display
+ *              D       clear the value, or everything if it's empty
+ *      Nothing in here touches the hardware, so host/statbench runs
+ *      the same accumulators.
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include "calc.h"
+
+#define STATS_LINES 6 /* lines of a page, one per bank */
+#define STATS_PAGES 2 /* the summary and the regression */
+
+/* one variable */
+typedef struct {
+   uint32_t count;
+   double mean;   // Welford's running mean
+   double m2;     // sum of the squared deviations from the mean
+   double sum;
+   double carry;  // what the sum lost to rounding
+   double min;
+   double max;
+} stats_t;
+
+/* (x, y) pairs */
+typedef struct {
+   uint32_t count;
+   double mean_x;
+   double mean_y;
+   double m2_x;   // sums of the squared deviations
+   double m2_y;
+   double c_xy;   // sum of the products of the deviations
+} stats_pair_t;
+
+/* state */
+extern int stats_mode;        // 1 while the statistics mode is on
+extern stats_t stats;         // the values entered (the y of pairs too)
+extern stats_pair_t stats_pairs;
+
+/* accumulators */
+void stats_reset(stats_t *);
+void stats_add(stats_t *, double);
+double stats_sum(const stats_t *);
+double stats_mean(const stats_t *);
+double stats_variance(const stats_t *);
+double stats_stddev(const stats_t *);
+void stats_pair_reset(stats_pair_t *);
+void stats_pair_add(stats_pair_t *, double, double);
+int stats_fit(const stats_pair_t *, double *, double *, double *);
+
+/* the mode */
+void stats_clear(void);
+int stats_key(uint8_t);
+int stats_line(int, char *, int, int);
+
+#endif /* STATS_H */
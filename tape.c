@@ -0,0 +1,143 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: tape.c
+ * Description:
+ *      The paper tape (see tape.h).
+ */
+#include <string.h>
+#include "tape.h"
+#include "font.h"
+
+/* the last lines, as text: lines[(newest - k) % TAPE_BANKS] */
+static char lines[TAPE_BANKS][TAPE_TEXT];
+static int count = 0;   // lines pushed, up to TAPE_BANKS
+static int newest = -1; // the slot of the newest line
+static int pending = 0; // lines pushed but not drawn yet
+static int redraw = 1;  // the tape banks don't show the tape
+
+/*
+ * The banks a line takes: its proportional layout, one bank per line
+ * of FB_WIDTH pixels, at most TAPE_BANKS
+ */
+static int banks_of(const char * text) {
+   int banks = 0;
+   while (*text != '\0' && banks < TAPE_BANKS) {
+      text += font_fit(text, FB_WIDTH, NULL);
+      ++banks;
+   }
+   return banks ? banks : 1;
+}
+
+/*
+ * Draw a line into banks bank, bank + 1, ... (already cleared)
+ */
+static void draw_line(const char * text, int bank) {
+   int last = bank + banks_of(text);
+   for (; *text != '\0' && bank < last; ++bank) {
+      int length = font_fit(text, FB_WIDTH, NULL);
+      font_render(text, length, fb[bank]);
+      text += length;
+   }
+}
+
+/**
+ * Put a completed calculation on the tape: before is the state before
+ * the key that combined the operands, after the state it left, e.g.
+ * "12+34=46" (or "12/0=ERR"), with precision fractional digits
+ */
+void tape_calculation(const calc_state_t * before, const calc_state_t * after,
+                      int precision) {
+   char text[3 * CALC_FORMAT_SIZE(9) + 4];
+   int length = calc_format(before->lhs, precision, text, sizeof(text));
+   text[length++] = before->operation;
+   length += calc_format(before->rhs, precision, &text[length],
+                         sizeof(text) - length);
+   text[length++] = '=';
+   if (after->status == CALC_OK) {
+      calc_format(after->lhs, precision, &text[length], sizeof(text) - length);
+   }
+   else {
+      strcpy(&text[length], "ERR");
+   }
+   tape_push(text);
+}
+
+/**
+ * Put a line of text on the tape (the next tape_render() draws it)
+ */
+void tape_push(const char * text) {
+   newest = (newest + 1) % TAPE_BANKS;
+   strncpy(lines[newest], text, TAPE_TEXT - 1);
+   lines[newest][TAPE_TEXT - 1] = '\0';
+   if (count < TAPE_BANKS) {
+      ++count;
+   }
+   // more lines than banks scroll the older ones off anyway
+   if (pending < TAPE_BANKS) {
+      ++pending;
+   }
+}
+
+/**
+ * Bring the tape banks of the back buffer up to date: scroll up and
+ * draw the lines pushed since the last call, or the whole tape again
+ * after tape_invalidate()
+ */
+void tape_render(void) {
+   if (redraw) {
+      // newest at the bottom, as many as fit
+      int bank = TAPE_BANKS, k;
+      memset(fb[0], 0, TAPE_BANKS * FB_WIDTH);
+      for (k = 0; k < count; ++k) {
+         const char * text = lines[(newest - k + TAPE_BANKS) % TAPE_BANKS];
+         bank -= banks_of(text);
+         if (bank < 0) {
+            break; // the oldest doesn't fit whole
+         }
+         draw_line(text, bank);
+      }
+      redraw = 0;
+      pending = 0;
+      return;
+   }
+   for (; pending > 0; --pending) {
+      const char * text =
+         lines[(newest - pending + 1 + TAPE_BANKS) % TAPE_BANKS];
+      int banks = banks_of(text);
+      // the rows move up in RAM; the banks that scrolled off are gone
+      memmove(fb[0], fb[banks], (TAPE_BANKS - banks) * FB_WIDTH);
+      memset(fb[TAPE_BANKS - banks], 0, banks * FB_WIDTH);
+      draw_line(text, TAPE_BANKS - banks);
+   }
+}
+
+/**
+ * Draw the entry into the bottom bank of the back buffer; an entry
+ * too long for it shows its end, where the digits are typed
+ */
+void tape_entry(const char * text) {
+   int start = 0;
+   while (font_measure(&text[start], TAPE_TEXT) > FB_WIDTH) {
+      ++start;
+   }
+   memset(fb[TAPE_ENTRY], 0, FB_WIDTH);
+   font_render(&text[start], TAPE_TEXT, fb[TAPE_ENTRY]);
+}
+
+/**
+ * Something else was drawn over the tape banks (the big-integer page,
+ * a test); the next tape_render() draws the tape again from its text
+ */
+void tape_invalidate(void) {
+   redraw = 1;
+}
+
+/**
+ * Empty the tape
+ */
+void tape_clear(void) {
+   count = 0;
+   newest = -1;
+   pending = 0;
+   redraw = 1;
+}
@@ -0,0 +1,37 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: tape.h
+ * Description:
+ *      A paper tape on the GLCD: the bottom bank shows the entry (lhs,
+ *      operation and rhs) and the five banks above it the calculations
+ *      completed before, newest at the bottom, e.g. "12+34=46".
+ *      A completed calculation scrolls the tape: the rows of the
+ *      framebuffer move up in RAM by the banks it needs, and only the
+ *      new line is drawn in at the bottom. Older lines are never drawn
+ *      again from their numbers, so a calculation costs at most
+ *      TAPE_BANKS banks to draw and to flush, however long the tape.
+ *      The lines are kept as text too, to draw the tape again after
+ *      something else covered it (tape_invalidate()).
+ *      NOTE:
+ *              Lines are only drawn in tape_render(), between
+ *              GLCD_begin() and GLCD_present(), so a frame waiting for
+ *              the flush never changes under it.
+ */
+#ifndef TAPE_H
+#define TAPE_H
+
+#include "calc.h"
+#include "fb.h"
+
+#define TAPE_BANKS (FB_BANKS - 1) /* banks of completed lines */
+#define TAPE_ENTRY (FB_BANKS - 1) /* the bank of the entry */
+#define TAPE_TEXT  64             /* characters of a line kept */
+
+void tape_calculation(const calc_state_t *, const calc_state_t *, int);
+void tape_push(const char *);
+void tape_render(void);
+void tape_entry(const char *);
+void tape_invalidate(void);
+void tape_clear(void);
+
+#endif /* TAPE_H */
@@ -0,0 +1,60 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: timebase.c
+ * Description:
+ *      Timer32 module 1 as a free-running timestamp counter. The module
+ *      only counts down, so timebase_now() returns the ones' complement
+ *      of the count to get a counter that goes up, scaled to
+ *      TIMEBASE_HZ from the MCLK it counts.
+ */
+#include "msp.h"
+#include "timebase.h"
+
+/* the count when MCLK last changed, and the timestamp it was then */
+static uint32_t mark = 0;
+static uint32_t base = 0;
+static uint32_t scale = 1; // ticks per MCLK cycle
+
+/**
+ * Start Timer32 module 1 counting MCLK from 0xFFFFFFFF in free-running
+ * mode (no interrupt, wraps back to 0xFFFFFFFF)
+ */
+void timebase_init(void) {
+   mark = 0;
+   base = 0;
+   scale = TIMEBASE_HZ / SystemCoreClock;
+   TIMER32_1->CONTROL = 0;              /* stop while configuring */
+   TIMER32_1->LOAD = 0xFFFFFFFF;        /* full 32-bit range */
+   TIMER32_1->CONTROL = TIMER32_CONTROL_SIZE     /* 32-bit counter */
+                      | TIMER32_CONTROL_ENABLE;  /* free-running, prescale 1 */
+}
+
+/**
+ * The current timestamp in ticks of TIMEBASE_HZ
+ */
+uint32_t timebase_now(void) {
+   unsigned int state = _disable_interrupts(); // not torn by a retune
+   uint32_t count = ~TIMER32_1->VALUE; // count up instead of down
+   uint32_t now = base + (count - mark) * scale;
+   _restore_interrupts(state);
+   return now;
+}
+
+/**
+ * The timestamp rate in ticks per second
+ */
+uint32_t timebase_hz(void) {
+   return TIMEBASE_HZ;
+}
+
+/**
+ * MCLK is about to run at hz: count the cycles so far at the old rate
+ * and the ones from now on at the new one (modulo 2^32 either way)
+ * Call it with interrupts disabled, right before the switch.
+ */
+void timebase_retune(uint32_t hz) {
+   uint32_t count = ~TIMER32_1->VALUE;
+   base += (count - mark) * scale;
+   mark = count;
+   scale = TIMEBASE_HZ / hz;
+}
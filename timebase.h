@@ -0,0 +1,30 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: timebase.h
+ * Description:
+ *      A free-running 32-bit timestamp counter for the host link and
+ *      the measurements. It counts MCLK cycles on Timer32 module 1 and
+ *      wraps every 2^32 ticks, so take differences with unsigned
+ *      subtraction. timebase_hz() gives the tick rate.
+ *      At TIMEBASE_HZ the timestamps wrap after about 89 s (2^32 /
+ *      48 MHz), not the 1431 s they lasted when they were 3 MHz MCLK
+ *      cycles; nothing timed with them may take longer.
+ *      MCLK changes with the clock governor (see clock.h), so the
+ *      timestamps are in ticks of TIMEBASE_HZ whatever MCLK is: each
+ *      MCLK cycle counts TIMEBASE_HZ / MCLK ticks, and
+ *      timebase_retune() starts the new rate where the old one ended.
+ */
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+#define TIMEBASE_HZ 48000000 /* the tick rate: the fastest MCLK, which
+                                every other one divides */
+
+void timebase_init(void);
+uint32_t timebase_now(void);
+uint32_t timebase_hz(void);
+void timebase_retune(uint32_t);
+
+#endif /* TIMEBASE_H */
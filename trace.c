@@ -0,0 +1,129 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: trace.c
+ * Description:
+ *      The event trace ring and its dump over the host link. A dump
+ *      is sent a few records per LINK_TRACE frame from the main loop
+ *      (trace_service()), the same way batch results are, and ends
+ *      with a LINK_TRACE_END frame. Tracing pauses during the dump so
+ *      the records don't change under it.
+ */
+#include <stdint.h>
+#include "ramfunc.h"
+#include "timebase.h"
+#include "trace.h"
+#include "link.h"
+
+#ifdef __TI_COMPILER_VERSION__
+#include "msp.h"
+/* handlers of any priority record events */
+#define TRACE_LOCK(state) (state) = _disable_interrupts()
+#define TRACE_UNLOCK(state) _restore_interrupts(state)
+#else
+/* the host stand-in has a single thread */
+#define TRACE_LOCK(state) (void)(state)
+#define TRACE_UNLOCK(state) (void)(state)
+#endif
+
+#define TRACE_PER_FRAME 4 /* records per LINK_TRACE frame */
+
+volatile uint8_t trace_enabled = 1;
+volatile uint32_t trace_total = 0;
+
+static trace_record_t records[TRACE_RECORDS];
+static uint8_t dumping = 0;     // a dump is being sent
+static uint8_t resume = 0;      // trace_enabled to restore after the dump
+static uint32_t dump_next = 0;  // number of the next record to send
+static uint32_t dump_end = 0;   // one past the last record to send
+
+/**
+ * Append an event to the ring, overwriting the oldest one
+ * (use TRACE() so it costs nothing while tracing is off)
+ */
+RAMFUNC void trace_record(uint8_t event, uint8_t arg) {
+   unsigned int state;
+   trace_record_t * record;
+   TRACE_LOCK(state);
+   record = &records[trace_total & (TRACE_RECORDS - 1)];
+   ++trace_total;
+   record->time = timebase_now();
+   record->event = event;
+   record->arg = arg;
+   TRACE_UNLOCK(state);
+}
+
+/**
+ * Act on a TRACE_CMD_* from the host
+ */
+void trace_control(uint8_t command) {
+   unsigned int state;
+   switch (command) {
+      case TRACE_CMD_DUMP:
+         if (!dumping) {
+            resume = trace_enabled;
+            trace_enabled = 0;
+            dump_end = trace_total;
+            // only the last TRACE_RECORDS are still in the ring
+            dump_next = dump_end > TRACE_RECORDS ? dump_end - TRACE_RECORDS : 0;
+            dumping = 1;
+         }
+         break;
+      case TRACE_CMD_START:
+         TRACE_LOCK(state);
+         trace_total = 0;
+         TRACE_UNLOCK(state);
+         if (dumping) {
+            resume = 1; // once the dump is out
+         }
+         else {
+            trace_enabled = 1;
+         }
+         break;
+      case TRACE_CMD_STOP:
+         resume = 0;
+         trace_enabled = 0;
+         break;
+      default: /* ignore what we don't know */
+         break;
+   }
+}
+
+/**
+ * Send the next frame of a dump, if one is going
+ * Returns 1 if a frame was sent, else 0 (also when the link is busy;
+ * the frame goes out on a later call)
+ */
+int trace_service(void) {
+   uint8_t payload[4 + 6 * TRACE_PER_FRAME];
+   uint8_t count = 0;
+   const trace_record_t * record;
+
+   if (!dumping) {
+      return 0;
+   }
+   // the last frame: how many events there were and the tick rate
+   if (dump_next == dump_end) {
+      link_put_u32(&payload[0], dump_end);
+      link_put_u32(&payload[4], timebase_hz());
+      if (!link_send(LINK_TRACE_END, payload, 8)) {
+         return 0;
+      }
+      dumping = 0;
+      trace_enabled = resume;
+      return 1;
+   }
+   // the number of the first record, then the records
+   link_put_u32(&payload[0], dump_next);
+   while (count < TRACE_PER_FRAME && dump_next + count < dump_end) {
+      record = &records[(dump_next + count) & (TRACE_RECORDS - 1)];
+      link_put_u32(&payload[4 + 6 * count], record->time);
+      payload[8 + 6 * count] = record->event;
+      payload[9 + 6 * count] = record->arg;
+      ++count;
+   }
+   if (!link_send(LINK_TRACE, payload, 4 + 6 * count)) {
+      return 0;
+   }
+   dump_next += count;
+   return 1;
+}
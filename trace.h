@@ -0,0 +1,66 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: trace.h
+ * Description:
+ *      Event trace: a ring of timestamped records in SRAM, for finding
+ *      out afterwards why a key press went missing. Each record is a
+ *      timebase_now() timestamp, an event and one byte of argument; the
+ *      ring keeps the last TRACE_RECORDS events.
+ *      The host dumps the ring with LINK_TRACE_CTL (see link.h) and
+ *      host/tracedump renders it as a latency timeline.
+ *      NOTE:
+ *              TRACE() costs a load and a branch while tracing is off;
+ *              define TRACE_DISABLE to compile it out altogether.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#define TRACE_RECORDS 128 /* ring size, a power of two */
+
+/* events and their argument */
+#define TRACE_PORT1_ENTER 1 /* PORT1_IRQHandler entered */
+#define TRACE_PORT1_EXIT  2 /* PORT1_IRQHandler left */
+#define TRACE_PORT3_ENTER 3 /* PORT3_IRQHandler entered */
+#define TRACE_PORT3_EXIT  4 /* PORT3_IRQHandler left */
+#define TRACE_KEY         5 /* key, | TRACE_KEY_HOST if injected */
+#define TRACE_OPERATION   6 /* new operation character ('\0' for none) */
+#define TRACE_FOCUS       7 /* new focus: 0 lhs, 1 rhs */
+#define TRACE_FLUSH_START 8 /* display_current_state() started */
+#define TRACE_FLUSH_END   9 /* display_current_state() done */
+#define TRACE_RENDER_ENTER 10 /* PendSV_Handler entered */
+#define TRACE_RENDER_EXIT  11 /* PendSV_Handler left */
+
+#define TRACE_KEY_HOST 0x80
+
+/* commands of LINK_TRACE_CTL */
+#define TRACE_CMD_DUMP  0 /* send the ring, then carry on tracing */
+#define TRACE_CMD_START 1 /* empty the ring and start tracing */
+#define TRACE_CMD_STOP  2 /* stop tracing, keep the ring */
+
+/* one event */
+typedef struct {
+   uint32_t time;  // timebase_now()
+   uint8_t event;  // TRACE_*
+   uint8_t arg;
+} trace_record_t;
+
+extern volatile uint8_t trace_enabled;
+extern volatile uint32_t trace_total; // events recorded since TRACE_CMD_START
+
+void trace_record(uint8_t, uint8_t);
+void trace_control(uint8_t);
+int trace_service(void);
+
+#ifdef TRACE_DISABLE
+#define TRACE(event, arg)
+#else
+#define TRACE(event, arg) do {                   \
+      if (trace_enabled) {                       \
+         trace_record((event), (arg));           \
+      }                                          \
+   } while (0)
+#endif
+
+#endif /* TRACE_H */
@@ -0,0 +1,161 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: uart.c
+ * Description:
+ *      eUSCI_A0 UART driver. The receive interrupt moves each byte into
+ *      the RX ring; the transmit interrupt feeds the TX ring to the line
+ *      and turns itself off once the ring runs dry.
+ *      NOTE:
+ *              uart_write() may be called from the main loop and from
+ *              ISRs (e.g. key events from PORT3_IRQHandler). It disables
+ *              interrupts while it copies one message into the TX ring
+ *              so messages are never interleaved. If the whole message
+ *              doesn't fit it is dropped instead of waiting for room.
+ */
+#include "msp.h"
+#include "uart.h"
+#include "clock.h"
+#include "ring.h"
+#include "stackmon.h"
+
+/* rings between the ISR and the rest of the program */
+static ring_t tx_ring; // main/ISRs -> line
+static ring_t rx_ring; // line -> main
+
+volatile uint32_t uart_tx_dropped = 0;
+volatile uint32_t uart_rx_dropped = 0;
+
+/*
+ * UCBRSx settings for the fractional part of the clock divider
+ * (in 1/10000ths), see table 24-4 of the MSP432P4xx technical
+ * reference manual
+ */
+static const struct {
+   uint16_t fraction;
+   uint8_t brs;
+} brs_table[] = {
+   {0, 0x00},    {529, 0x01},  {715, 0x02},  {835, 0x04},  {1001, 0x08},
+   {1252, 0x10}, {1430, 0x20}, {1670, 0x11}, {2147, 0x21}, {2224, 0x22},
+   {2503, 0x44}, {3000, 0x25}, {3335, 0x49}, {3575, 0x4A}, {3753, 0x52},
+   {4003, 0x92}, {4286, 0x53}, {4378, 0x55}, {5002, 0xAA}, {5715, 0x6B},
+   {6003, 0xAD}, {6254, 0xB5}, {6432, 0xB6}, {6667, 0xD6}, {7001, 0xB7},
+   {7147, 0xBB}, {7503, 0xDD}, {7861, 0xED}, {8004, 0xEE}, {8333, 0xBF},
+   {8464, 0xDF}, {8572, 0xEF}, {8751, 0xF7}, {9004, 0xFB}, {9170, 0xFD},
+   {9288, 0xFE},
+};
+
+static uint32_t baud_rate; // of uart_init()
+
+/*
+ * Set the clock divider of eUSCI_A0 (held in reset) for baud_rate
+ * from an SMCLK of hz
+ */
+static void set_divider(uint32_t hz) {
+   uint32_t n = hz / baud_rate; // whole part of the divider
+   uint32_t fraction = (hz % baud_rate) * 10000 / baud_rate;
+   uint8_t brs = 0;
+   int k; // used in for loop
+
+   // pick the modulation pattern for the fractional part
+   for (k = 0; k < sizeof(brs_table) / sizeof(brs_table[0]); ++k) {
+      if (brs_table[k].fraction <= fraction) {
+         brs = brs_table[k].brs;
+      }
+   }
+   if (n >= 16) {
+      // oversampling: BRW = N / 16, BRF = N % 16
+      EUSCI_A0->BRW = n >> 4;
+      EUSCI_A0->MCTLW = ((uint16_t)brs << 8) | ((n & 0xF) << 4)
+                      | EUSCI_A_MCTLW_OS16;
+   }
+   else {
+      // low-frequency mode
+      EUSCI_A0->BRW = n;
+      EUSCI_A0->MCTLW = (uint16_t)brs << 8;
+   }
+}
+
+/**
+ * Configure eUSCI_A0 for 8N1 at the given baud rate from SMCLK
+ * (CLOCK_SMCLK_HZ, whatever the clock governor does to MCLK)
+ * and enable its interrupt
+ */
+void uart_init(uint32_t baud) {
+   baud_rate = baud;
+   EUSCI_A0->CTLW0 = EUSCI_A_CTLW0_SWRST;   /* put UCA0 in reset mode */
+   EUSCI_A0->CTLW0 = EUSCI_A_CTLW0_SWRST
+                   | EUSCI_A_CTLW0_SSEL__SMCLK; /* 8N1, LSB first, SMCLK */
+   set_divider(CLOCK_SMCLK_HZ);
+
+   P1->SEL0 |= (BIT2 | BIT3);  /* P1.2, P1.3 for UCA0 */
+   P1->SEL1 &= ~(BIT2 | BIT3);
+
+   EUSCI_A0->CTLW0 &= ~EUSCI_A_CTLW0_SWRST; /* enable UCA0 after config */
+   EUSCI_A0->IFG &= ~EUSCI_A_IFG_RXIFG;     /* clear any stale byte */
+   EUSCI_A0->IE |= EUSCI_A_IE_RXIE;         /* interrupt on every byte */
+
+   NVIC->ISER[0] |= 1 << EUSCIA0_IRQn; /* enable eUSCI_A0 interrupts */
+}
+
+/**
+ * Queue a whole message for transmission
+ * Returns 1 if it was queued, 0 if the TX ring had no room for it
+ */
+int uart_write(const uint8_t * data, uint16_t length) {
+   unsigned int state;
+   uint16_t k; // used in for loop
+   int queued = 0;
+
+   state = _disable_interrupts(); // keep messages whole
+   if (ring_space(&tx_ring) >= length) {
+      for (k = 0; k < length; ++k) {
+         ring_put(&tx_ring, data[k]);
+      }
+      queued = 1;
+   }
+   else {
+      ++uart_tx_dropped; // never wait for the line
+   }
+   _restore_interrupts(state);
+
+   if (queued) {
+      EUSCI_A0->IE |= EUSCI_A_IE_TXIE; // TXIFG is set while TXBUF is empty
+   }
+   return queued;
+}
+
+/**
+ * Take one received byte
+ * Returns 1 if a byte was available, else 0
+ */
+int uart_read(uint8_t * byte) {
+   return ring_get(&rx_ring, byte);
+}
+
+/***
+* IRQ handler for eUSCI_A0
+***/
+void EUSCIA0_IRQHandler(void) {
+   uint8_t byte;
+
+   STACK_ISR_ENTER(STACK_ISR_UART);
+
+   /* a byte arrived (reading RXBUF clears the flag) */
+   if (EUSCI_A0->IFG & EUSCI_A_IFG_RXIFG) {
+      if (!ring_put(&rx_ring, EUSCI_A0->RXBUF)) {
+         ++uart_rx_dropped;
+      }
+   }
+
+   /* TXBUF is empty (writing TXBUF clears the flag) */
+   if ((EUSCI_A0->IE & EUSCI_A_IE_TXIE) && (EUSCI_A0->IFG & EUSCI_A_IFG_TXIFG)) {
+      if (ring_get(&tx_ring, &byte)) {
+         EUSCI_A0->TXBUF = byte;
+      }
+      else {
+         EUSCI_A0->IE &= ~EUSCI_A_IE_TXIE; // nothing left to send
+      }
+   }
+
+   STACK_ISR_EXIT(STACK_ISR_UART);
+}
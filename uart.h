@@ -0,0 +1,26 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: uart.h
+ * Description:
+ *      Interrupt-driven UART on eUSCI_A0 (P1.2 RXD, P1.3 TXD), the
+ *      LaunchPad's backchannel UART to the host over the XDS110 USB
+ *      link. Both directions go through ring buffers, so neither
+ *      uart_write() nor the ISR ever waits on the line.
+ */
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+
+#define UART_BAUD 115200 /* backchannel UART baud rate */
+
+/* error counters */
+extern volatile uint32_t uart_tx_dropped; // writes refused, TX ring full
+extern volatile uint32_t uart_rx_dropped; // bytes dropped, RX ring full
+
+/* prototypes */
+void uart_init(uint32_t);
+int uart_write(const uint8_t *, uint16_t);
+int uart_read(uint8_t *);
+
+#endif /* UART_H */
@@ -0,0 +1,490 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: vm.c
+ * Description:
+ *      The compiler and the interpreter of the key programs (see vm.h).
+ */
+#include <string.h>
+#include "vm.h"
+
+#if defined(__GNUC__) && !defined(VM_SWITCH)
+#define VM_THREADED /* dispatch by computed goto */
+#endif
+
+/* global variables */
+vm_program_t vm_programs[VM_PROGRAMS];
+
+/* statistics */
+uint32_t vm_runs = 0;
+uint32_t vm_steps = 0;
+
+/* the program vm_request() compiled, waiting for vm_install() */
+static vm_program_t staged;
+static int staged_slot;
+static volatile uint8_t ready = 0;
+static char source[VM_SOURCE];
+static int source_length = 0;
+
+/* vm_run()'s registers and stack: 25 numbers are too many for the
+   512-byte stack PendSV runs programs on */
+static CALC_TYPE regs[VM_REGS];
+static CALC_TYPE stack[VM_STACK + 1]; // stack[0] is never a number
+
+/* the words without an operand, and their opcodes */
+static const struct {
+   const char * word;
+   uint8_t op;
+} words[] = {
+   { "+", VM_ADD }, { "-", VM_SUB }, { "*", VM_MUL }, { "/", VM_DIV },
+   { "neg", VM_NEG }, { "dup", VM_DUP }, { "drop", VM_DROP },
+   { "swap", VM_SWAP }, { "over", VM_OVER },
+   { "<", VM_LT }, { ">", VM_GT }, { "=", VM_EQ },
+};
+
+/* what each opcode takes off the stack and puts back */
+static const int8_t pops[VM_OPS] = {
+   0, 0, 0, 1, 2, 2, 2, 2, 1, 1, 1, 2, 2, 2, 2, 2, 1, 0
+};
+static const int8_t pushes[VM_OPS] = {
+   0, 1, 1, 0, 1, 1, 1, 1, 1, 2, 0, 2, 3, 1, 1, 1, 0, 0
+};
+
+/* an if, else or begin waiting for its end */
+#define OPEN_IF    0
+#define OPEN_ELSE  1
+#define OPEN_BEGIN 2
+typedef struct {
+   uint8_t kind;
+   uint8_t address; // the operand to patch, or where begin is
+   int8_t depth;    // the depth of the stack at if or begin, or at else
+                    // the depth the first part ended with
+} open_t;
+
+/* the compiler's state */
+typedef struct {
+   vm_program_t * program;
+   int depth; // of the stack after the code so far
+} compiler_t;
+
+/*
+ * Add an instruction, and its operand if it has one (operand >= 0),
+ * checking the stack depth it leaves
+ * Returns CALC_OK or the error
+ */
+static int emit(compiler_t * c, uint8_t op, int operand) {
+   vm_program_t * p = c->program;
+   if (p->length + (operand >= 0 ? 2 : 1) > VM_CODE - 1) {
+      return VM_TOO_BIG; // room for the VM_HALT at the end
+   }
+   if (c->depth < pops[op] || c->depth - pops[op] + pushes[op] > VM_STACK) {
+      return VM_DEPTH;
+   }
+   c->depth += pushes[op] - pops[op];
+   p->code[p->length++] = op;
+   if (operand >= 0) {
+      p->code[p->length++] = (uint8_t)operand;
+   }
+   return CALC_OK;
+}
+
+/*
+ * The index of a number in the program, added if it's new, or -1 if
+ * there is no room
+ */
+static int number_of(vm_program_t * p, CALC_TYPE value) {
+   int k; // used in for loop
+   for (k = 0; k < p->consts; ++k) {
+      if (memcmp(&p->numbers[k], &value, sizeof(value)) == 0) {
+         return k;
+      }
+   }
+   if (p->consts == VM_CONSTS) {
+      return -1;
+   }
+   p->numbers[p->consts] = value;
+   return p->consts++;
+}
+
+/*
+ * Whether a word is these characters
+ */
+static int is(const char * word, int length, const char * text) {
+   return (int)strlen(text) == length && memcmp(word, text, length) == 0;
+}
+
+/*
+ * Compile one word
+ * Returns CALC_OK or the error
+ */
+static int compile_word(compiler_t * c, const char * word, int length,
+                        open_t * open, int * opened) {
+   vm_program_t * p = c->program;
+   open_t * last = *opened ? &open[*opened - 1] : 0;
+   int status, k;
+
+   // a number
+   if ((word[0] >= '0' && word[0] <= '9') || word[0] == '.') {
+      CALC_TYPE value = calc_eval(word, length, &status);
+      if (status != CALC_OK) {
+         return VM_UNKNOWN;
+      }
+      k = number_of(p, value);
+      return k < 0 ? VM_TOO_BIG : emit(c, VM_CONST, k);
+   }
+   // a register, or a store into one
+   if (length == 1 && word[0] >= 'a' && word[0] < 'a' + VM_REGS) {
+      return emit(c, VM_LOAD, word[0] - 'a');
+   }
+   if (length == 2 && word[0] == '=' && word[1] >= 'a'
+       && word[1] < 'a' + VM_REGS) {
+      return emit(c, VM_STORE, word[1] - 'a');
+   }
+   for (k = 0; k < (int)(sizeof(words) / sizeof(words[0])); ++k) {
+      if (is(word, length, words[k].word)) {
+         return emit(c, words[k].op, -1);
+      }
+   }
+
+   // the structure: jumps whose addresses are patched at the end
+   if (is(word, length, "if") || is(word, length, "begin")) {
+      int begin = word[0] == 'b';
+      if (*opened == VM_NEST) {
+         return VM_NESTING;
+      }
+      if (!begin) {
+         status = emit(c, VM_JZ, 0);
+         if (status != CALC_OK) {
+            return status;
+         }
+      }
+      open[*opened].kind = begin ? OPEN_BEGIN : OPEN_IF;
+      open[*opened].address = begin ? p->length : p->length - 1;
+      open[*opened].depth = c->depth;
+      ++*opened;
+      return CALC_OK;
+   }
+   if (is(word, length, "else")) {
+      int at_if;
+      if (!last || last->kind != OPEN_IF) {
+         return VM_NESTING;
+      }
+      at_if = last->depth;
+      status = emit(c, VM_JMP, 0);
+      if (status != CALC_OK) {
+         return status;
+      }
+      p->code[last->address] = p->length; // if jumps to the second part
+      last->kind = OPEN_ELSE;
+      last->address = p->length - 1;
+      last->depth = c->depth;             // the first part's depth
+      c->depth = at_if;                   // the second part starts over
+      return CALC_OK;
+   }
+   if (is(word, length, "then")) {
+      if (!last || last->kind == OPEN_BEGIN) {
+         return VM_NESTING;
+      }
+      // both ways through leave the stack as deep
+      if (c->depth != last->depth) {
+         return VM_DEPTH;
+      }
+      p->code[last->address] = p->length;
+      --*opened;
+      return CALC_OK;
+   }
+   if (is(word, length, "until")) {
+      if (!last || last->kind != OPEN_BEGIN) {
+         return VM_NESTING;
+      }
+      status = emit(c, VM_JZ, last->address);
+      if (status != CALC_OK) {
+         return status;
+      }
+      // each time round leaves the stack as it found it
+      if (c->depth != last->depth) {
+         return VM_DEPTH;
+      }
+      --*opened;
+      return CALC_OK;
+   }
+   return VM_UNKNOWN;
+}
+
+/**
+ * Compile length characters of source (see vm.h) into a program; the
+ * program isn't bound to a key
+ * Returns CALC_OK, or the error and in *at where its word starts
+ */
+int vm_compile(const char * text, int length, vm_program_t * program,
+               int * at) {
+   open_t open[VM_NEST];
+   int opened = 0;
+   compiler_t c;
+   int k = 0, status = CALC_OK;
+
+   memset(program, 0, sizeof(*program));
+   program->key = VM_UNBOUND;
+   c.program = program;
+   c.depth = 0;
+   *at = 0;
+   while (k < length) {
+      int start;
+      if (text[k] == ' ') {
+         ++k;
+         continue;
+      }
+      start = k;
+      while (k < length && text[k] != ' ') {
+         ++k;
+      }
+      status = compile_word(&c, &text[start], k - start, open, &opened);
+      if (status != CALC_OK) {
+         *at = start;
+         break;
+      }
+   }
+   if (status == CALC_OK && opened > 0) {
+      *at = length;
+      status = VM_NESTING; // an if or a begin never ended
+   }
+   if (status != CALC_OK) {
+      program->length = 0;
+      return status;
+   }
+   program->code[program->length++] = VM_HALT;
+   return CALC_OK;
+}
+
+/**
+ * Run a program with lhs in register a and rhs in register b
+ * Returns the top of the stack (a if it's empty), and sets status to
+ * CALC_OK, the error of the arithmetic, or VM_LIMIT
+ */
+CALC_TYPE vm_run(const vm_program_t * program, CALC_TYPE lhs, CALC_TYPE rhs,
+                 int * status) {
+   CALC_TYPE * sp = stack; // the top, stack[0] when it's empty
+   const CALC_TYPE * numbers = program->numbers;
+   const uint8_t * code = program->code;
+   const uint8_t * ip = code;
+   CALC_TYPE zero = num_from_int(0), one = num_from_int(1);
+   CALC_TYPE t;
+   uint32_t budget = VM_STEPS; // instructions left
+   int k; // used in for loop
+
+   regs[0] = lhs;
+   regs[1] = rhs;
+   for (k = 2; k < VM_REGS; ++k) {
+      regs[k] = zero;
+   }
+   *status = CALC_OK;
+   if (program->length == 0) {
+      return lhs;
+   }
+
+   // the compiler checked the depth of every instruction, so sp stays
+   // in the stack without a check here
+#define ARITH(c) \
+   t = calc_op(sp[-1], c, sp[0], status); \
+   if (*status != CALC_OK) { goto done; } \
+   *--sp = t;
+#define COMPARE(test) \
+   t = calc_op(sp[-1], '-', sp[0], status); \
+   if (*status != CALC_OK) { goto done; } \
+   *--sp = (test) ? one : zero;
+
+#ifdef VM_THREADED
+   static const void * const labels[VM_OPS] = {
+      &&op_HALT, &&op_CONST, &&op_LOAD, &&op_STORE, &&op_ADD, &&op_SUB,
+      &&op_MUL, &&op_DIV, &&op_NEG, &&op_DUP, &&op_DROP, &&op_SWAP,
+      &&op_OVER, &&op_LT, &&op_GT, &&op_EQ, &&op_JZ, &&op_JMP,
+   };
+#define CASE(op) op_##op:
+#define NEXT() \
+   if (budget == 0) { *status = VM_LIMIT; goto done; } \
+   --budget; \
+   goto *labels[*ip++]
+   NEXT();
+#else
+#define CASE(op) case VM_##op:
+#define NEXT() break
+   for (;;) {
+      if (budget == 0) {
+         *status = VM_LIMIT;
+         goto done;
+      }
+      --budget;
+      switch (*ip++) {
+#endif
+      CASE(HALT)
+         goto done;
+      CASE(CONST)
+         *++sp = numbers[*ip++];
+         NEXT();
+      CASE(LOAD)
+         *++sp = regs[*ip++];
+         NEXT();
+      CASE(STORE)
+         regs[*ip++] = *sp--;
+         NEXT();
+      CASE(ADD)
+         ARITH('+');
+         NEXT();
+      CASE(SUB)
+         ARITH('-');
+         NEXT();
+      CASE(MUL)
+         ARITH('*');
+         NEXT();
+      CASE(DIV)
+         ARITH('/');
+         NEXT();
+      CASE(NEG)
+         *sp = num_negate(*sp);
+         NEXT();
+      CASE(DUP)
+         sp[1] = sp[0];
+         ++sp;
+         NEXT();
+      CASE(DROP)
+         --sp;
+         NEXT();
+      CASE(SWAP)
+         t = sp[0];
+         sp[0] = sp[-1];
+         sp[-1] = t;
+         NEXT();
+      CASE(OVER)
+         sp[1] = sp[-1];
+         ++sp;
+         NEXT();
+      CASE(LT)
+         COMPARE(num_is_negative(t) && !num_is_zero(t));
+         NEXT();
+      CASE(GT)
+         COMPARE(!num_is_negative(t) && !num_is_zero(t));
+         NEXT();
+      CASE(EQ)
+         COMPARE(num_is_zero(t));
+         NEXT();
+      CASE(JZ)
+         ip = num_is_zero(*sp--) ? code + *ip : ip + 1;
+         NEXT();
+      CASE(JMP)
+         ip = code + *ip;
+         NEXT();
+#ifndef VM_THREADED
+      }
+   }
+#endif
+#undef ARITH
+#undef COMPARE
+#undef CASE
+#undef NEXT
+
+done:
+   ++vm_runs;
+   vm_steps += VM_STEPS - budget;
+   if (*status != CALC_OK) {
+      return zero;
+   }
+   return sp > stack ? *sp : regs[0];
+}
+
+/**
+ * The slot of the program bound to a key, or -1
+ */
+int vm_bound(uint8_t key) {
+   int slot; // used in for loop
+   for (slot = 0; slot < VM_PROGRAMS; ++slot) {
+      if (vm_programs[slot].length > 0 && vm_programs[slot].key == key) {
+         return slot;
+      }
+   }
+   return -1;
+}
+
+/**
+ * Run the program in a slot on a calculator state: the result becomes
+ * lhs, as after "=", and an error sets off the alarm like math_op()
+ * Returns the status of the run.
+ */
+int vm_calc(int slot, calc_state_t * s) {
+   int status;
+   CALC_TYPE result = vm_run(&vm_programs[slot], s->lhs, s->rhs, &status);
+   s->status = status;
+   s->lhs = result; // 0 after an error, as after math_op()
+   s->rhs = num_from_int(0);
+   s->operation = '=';
+   s->state = CALC_LHS_WHOLE;
+   s->fractional_pow10 = 10;
+   assert(status != VM_LIMIT, "PROG TOO LONG");
+   assert(status == CALC_OK || status == VM_LIMIT, "PROG MATH ERR");
+   return status;
+}
+
+/**
+ * Take a LINK_PROGRAM payload from the host (see link.h): u8 slot,
+ * u8 key, u8 more, then source; the source of frames with more set is
+ * kept until the last one, which compiles the program
+ * Returns VM_MORE, CALC_OK when it compiled (vm_ready() until it's
+ * installed), or the error; *slot is the slot it was for, and *detail
+ * the bytes of code, or where the error is in the source
+ */
+int vm_request(const uint8_t * payload, int length, int * slot,
+               int * detail) {
+   int status;
+
+   *slot = length >= 1 ? payload[0] : 0;
+   *detail = 0;
+   if (length < 3 || payload[0] >= VM_PROGRAMS) {
+      source_length = 0;
+      return VM_UNKNOWN;
+   }
+   if (ready) {
+      return VM_BUSY;
+   }
+   length -= 3;
+   if (source_length + length > VM_SOURCE) {
+      source_length = 0;
+      return VM_TOO_BIG;
+   }
+   memcpy(&source[source_length], &payload[3], length);
+   source_length += length;
+   if (payload[2]) {
+      return VM_MORE;
+   }
+   status = vm_compile(source, source_length, &staged, detail);
+   source_length = 0;
+   if (status == CALC_OK) {
+      *detail = staged.length;
+      staged.key = payload[1];
+      staged_slot = payload[0];
+      ready = 1;
+   }
+   return status;
+}
+
+/**
+ * Whether a compiled program waits for vm_install()
+ */
+int vm_ready(void) {
+   return ready;
+}
+
+/**
+ * Put the compiled program into its slot, and take its key from any
+ * other program
+ */
+void vm_install(void) {
+   int slot; // used in for loop
+   if (!ready) {
+      return;
+   }
+   for (slot = 0; slot < VM_PROGRAMS; ++slot) {
+      if (vm_programs[slot].key == staged.key) {
+         vm_programs[slot].key = VM_UNBOUND;
+      }
+   }
+   vm_programs[staged_slot] = staged;
+   ready = 0;
+}
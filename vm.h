@@ -0,0 +1,109 @@
+/*
+ * Program: Number-pad Calculator using the MSP432 LaunchPad
+ * File: vm.h
+ * Description:
+ *      Small user programs bound to keys. The host sends a program's
+ *      source (LINK_PROGRAM, see link.h); the device compiles it into
+ *      bytecode and binds it to a key of the normal mode. The key then
+ *      runs the program on lhs and rhs instead of what it usually does,
+ *      and the result becomes lhs, like "=".
+ *      The source is a list of words, Forth-style (postfix):
+ *              12.5            push a number
+ *              a ... h         push a register; a and b start as lhs
+ *                              and rhs, the others as 0
+ *              =a ... =h       pop into a register
+ *              + - * /         the arithmetic of math_op() (calc_op())
+ *              neg dup drop swap over
+ *              < > =           compare, 1 if true else 0
+ *              if ... [else ...] then      pop; the first part if not 0
+ *              begin ... until             pop at until; again if 0
+ *      The result is the top of the stack, or a if the stack is empty,
+ *      e.g. "a a * b b * +" is lhs^2 + rhs^2 and
+ *      "1 =c begin c a * =c a 1 - =a a 1 < until c" is lhs factorial.
+ *      The compiler works out the depth of the stack at every word, so
+ *      a program that could under- or overflow the VM_STACK numbers of
+ *      the stack (or whose branches leave it uneven) is refused, and
+ *      the interpreter doesn't check. A run stops after VM_STEPS
+ *      instructions (VM_LIMIT), so a loop can't hang the calculator.
+ *      The interpreter dispatches through a table of label addresses
+ *      (computed goto) when the compiler has them (GCC, Clang),
+ *      otherwise, or with VM_SWITCH defined, through a switch.
+ *      NOTE:
+ *              vm_request() compiles in the main loop, into a staging
+ *              program; vm_install() moves it into its slot in PendSV,
+ *              which is where the programs run. The registers and the
+ *              stack of vm_run() are static, so it mustn't run in two
+ *              places at once (the boot tests run before any key).
+ */
+#ifndef VM_H
+#define VM_H
+
+#include <stdint.h>
+#include "calc.h"
+
+#define VM_PROGRAMS 4    /* program slots */
+#define VM_CODE     64   /* bytes of bytecode a program holds */
+#define VM_CONSTS   8    /* numbers a program holds */
+#define VM_REGS     8    /* registers a to h */
+#define VM_STACK    16   /* numbers on the stack at most */
+#define VM_NEST     8    /* if and begin open at once */
+#define VM_SOURCE   128  /* characters of source */
+#define VM_STEPS    10000 /* instructions a run may take */
+#define VM_UNBOUND  0xFF /* the key of a program no key runs */
+
+/* status of the compiler and of a run, past the CALC_* codes */
+#define VM_LIMIT    16 /* the run took VM_STEPS instructions */
+#define VM_UNKNOWN  17 /* a word the compiler doesn't know */
+#define VM_TOO_BIG  18 /* more code, numbers or source than fit */
+#define VM_DEPTH    19 /* the stack could under- or overflow */
+#define VM_NESTING  20 /* if/else/then or begin/until don't match */
+#define VM_BUSY     21 /* the program before isn't installed yet */
+#define VM_MORE     22 /* vm_request(): waiting for the rest */
+
+/* opcodes; those with an operand take one more byte */
+#define VM_HALT   0
+#define VM_CONST  1  /* the index of the number */
+#define VM_LOAD   2  /* the register */
+#define VM_STORE  3  /* the register */
+#define VM_ADD    4
+#define VM_SUB    5
+#define VM_MUL    6
+#define VM_DIV    7
+#define VM_NEG    8
+#define VM_DUP    9
+#define VM_DROP   10
+#define VM_SWAP   11
+#define VM_OVER   12
+#define VM_LT     13
+#define VM_GT     14
+#define VM_EQ     15
+#define VM_JZ     16 /* the address to go to if the popped number is 0 */
+#define VM_JMP    17 /* the address */
+#define VM_OPS    18
+
+/* a compiled program */
+typedef struct {
+   uint8_t code[VM_CODE];
+   uint8_t length;  // bytes of code, 0 for an empty slot
+   uint8_t consts;  // numbers used
+   uint8_t key;     // the key that runs it, or VM_UNBOUND
+   CALC_TYPE numbers[VM_CONSTS];
+} vm_program_t;
+
+/* state */
+extern vm_program_t vm_programs[VM_PROGRAMS];
+
+/* statistics */
+extern uint32_t vm_runs;  // programs run
+extern uint32_t vm_steps; // instructions they took
+
+/* prototypes */
+int vm_compile(const char *, int, vm_program_t *, int *);
+CALC_TYPE vm_run(const vm_program_t *, CALC_TYPE, CALC_TYPE, int *);
+int vm_bound(uint8_t);
+int vm_calc(int, calc_state_t *);
+int vm_request(const uint8_t *, int, int *, int *);
+int vm_ready(void);
+void vm_install(void);
+
+#endif /* VM_H */